@@ -0,0 +1,418 @@
+// Micro-benchmarks for the UX test game's hot kernels.
+//
+// Every kernel runs for each (entity count, resolution) pair and the results are
+// written as JSON (default) or CSV so they can be diffed between builds.
+//
+//   ./ux_game_bench
+//   ./ux_game_bench --entities 16,4096 --resolution 1920x1080 --filter fill --format csv
+//   ./ux_game_bench --simd scalar,sse2,avx2 --resolution 3840x2160,7680x4320 --filter clear
+//
+// Build with: ./build_game.sh bench
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ux_game/cvd.h"
+#include "ux_game/hud.h"
+#include "ux_game/raster.h"
+#include "ux_game/sim.h"
+#include "ux_game/simd_fill.h"
+#include "ux_game/ui_audit.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+struct Resolution {
+    int32_t width, height;
+};
+
+struct Options {
+    std::vector<int> entities = {16, 256, 4096};
+    std::vector<Resolution> resolutions = {{640, 480}, {1920, 1080}, {3840, 2160}};
+    std::vector<ux::simd::Level> simdLevels = {ux::simd::ActiveLevel()};
+    std::string filter;
+    double minTime = 0.2;
+    bool csv = false;
+};
+
+// Shared state for one (entities, resolution) configuration
+struct Fixture {
+    int entities = 0;
+    int32_t width = 0, height = 0;
+    std::vector<uint32_t> framebuffer;
+    ux::Canvas canvas;
+
+    std::vector<ux::Enemy> enemyTemplate;
+    std::vector<ux::Enemy> enemies;
+    std::vector<ux::Button> buttons;
+    std::vector<std::pair<float, float>> points;
+    std::vector<std::pair<int32_t, int32_t>> positions;
+    std::vector<int> values;
+    std::vector<std::string> strings;
+    std::vector<uint32_t> cvdBuffers[ux::kCvdCount]; // allocated by the cvd kernels
+    ux::Canvas cvdTargets[ux::kCvdCount];
+
+    Fixture(int n, Resolution res) : entities(n), width(res.width), height(res.height)
+    {
+        framebuffer.assign(size_t(width) * size_t(height), ux::BLACK);
+        canvas = {framebuffer.data(), width, height};
+
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> xs(0.0f, float(width));
+        // ~5% of enemies sit below the screen so culling has work to do
+        std::uniform_real_distribution<float> ys(0.0f, float(height) * 1.05f);
+        std::uniform_int_distribution<int32_t> px(-20, width), py(-20, height);
+        std::uniform_int_distribution<int> vs(0, 99999);
+
+        for (int i = 0; i < n; i++) {
+            enemyTemplate.push_back({xs(rng), ys(rng), 0.0f, 80.0f, 3, ux::RED});
+            positions.push_back({px(rng), py(rng)});
+            values.push_back(vs(rng));
+            strings.push_back("Score: " + std::to_string(vs(rng)));
+        }
+        enemies = enemyTemplate;
+
+        // Buttons on a grid covering the screen, like a large menu
+        int cols = std::max(1, int(std::sqrt(float(n))));
+        float bw = float(width) / float(cols), bh = float(height) / float((n + cols - 1) / cols);
+        for (int i = 0; i < n; i++) {
+            buttons.push_back({(i % cols) * bw, (i / cols) * bh, bw * 0.8f, bh * 0.8f,
+                               "Button", ux::GREEN, true});
+        }
+        for (int i = 0; i < 64; i++) points.push_back({xs(rng), ys(rng)});
+    }
+
+    void EnsureCvdTargets()
+    {
+        for (int k = 0; k < ux::kCvdCount; k++) {
+            cvdBuffers[k].resize(framebuffer.size());
+            cvdTargets[k] = {cvdBuffers[k].data(), width, height};
+        }
+    }
+};
+
+struct Kernel {
+    const char* name;
+    // Runs one operation and returns the number of items it processed
+    std::function<uint64_t(Fixture&)> run;
+};
+
+std::vector<Kernel> MakeKernels()
+{
+    return {
+        {"enemy_integrate", [](Fixture& f) {
+            ux::IntegrateEnemies(f.enemies, 1.0f / 60.0f);
+            DoNotOptimize(f.enemies.front());
+            return uint64_t(f.entities);
+        }},
+        // Cull and collide mutate the list, so each op restores it from the template first
+        {"enemy_cull", [](Fixture& f) {
+            f.enemies.assign(f.enemyTemplate.begin(), f.enemyTemplate.end());
+            int removed = ux::CullEnemies(f.enemies, float(f.height));
+            DoNotOptimize(removed);
+            return uint64_t(f.entities);
+        }},
+        {"player_collide", [](Fixture& f) {
+            f.enemies.assign(f.enemyTemplate.begin(), f.enemyTemplate.end());
+            int hits = ux::CollideWithPlayer(f.enemies, f.width * 0.5f, f.height * 0.5f, 20.0f, 3);
+            DoNotOptimize(hits);
+            return uint64_t(f.entities);
+        }},
+        {"button_hit_test", [](Fixture& f) {
+            int sum = 0;
+            for (auto& p : f.points) sum += ux::HitTest(f.buttons, p.first, p.second);
+            DoNotOptimize(sum);
+            return uint64_t(f.entities) * f.points.size();
+        }},
+        {"clear", [](Fixture& f) {
+            ux::Clear(f.canvas, ux::DARK_BLUE);
+            DoNotOptimize(f.framebuffer.front());
+            return uint64_t(f.width) * uint64_t(f.height);
+        }},
+        {"fill_rect", [](Fixture& f) {
+            for (auto& p : f.positions) ux::FillRect(f.canvas, p.first, p.second, 150, 40, ux::GREEN);
+            DoNotOptimize(f.framebuffer.front());
+            return uint64_t(f.entities);
+        }},
+        {"draw_rect", [](Fixture& f) {
+            for (auto& p : f.positions) ux::DrawRect(f.canvas, p.first, p.second, 150, 40, ux::WHITE);
+            DoNotOptimize(f.framebuffer.front());
+            return uint64_t(f.entities);
+        }},
+        {"draw_line", [](Fixture& f) {
+            for (size_t i = 0; i < f.positions.size(); i++) {
+                auto& p = f.positions[i];
+                if (i & 1) ux::DrawLine(f.canvas, p.first, p.second, p.first, p.second + 100, ux::WHITE);
+                else ux::DrawLine(f.canvas, p.first, p.second, p.first + 100, p.second, ux::WHITE);
+            }
+            DoNotOptimize(f.framebuffer.front());
+            return uint64_t(f.entities);
+        }},
+        {"fill_circle", [](Fixture& f) {
+            for (auto& p : f.positions) ux::FillCircle(f.canvas, p.first, p.second, 6, ux::RED);
+            DoNotOptimize(f.framebuffer.front());
+            return uint64_t(f.entities);
+        }},
+        {"draw_circle", [](Fixture& f) {
+            for (auto& p : f.positions) ux::DrawCircle(f.canvas, p.first, p.second, 6, ux::WHITE);
+            DoNotOptimize(f.framebuffer.front());
+            return uint64_t(f.entities);
+        }},
+        {"draw_string", [](Fixture& f) {
+            for (size_t i = 0; i < f.positions.size(); i++) {
+                auto& p = f.positions[i];
+                ux::DrawString(f.canvas, p.first, p.second, f.strings[i], ux::YELLOW);
+            }
+            DoNotOptimize(f.framebuffer.front());
+            return uint64_t(f.entities);
+        }},
+        // WCAG contrast of a text run against the pixels under its glyph bounds
+        {"text_contrast", [](Fixture& f) {
+            float worst = 21.0f;
+            for (auto& p : f.positions)
+                worst = std::min(worst, ux::TextContrast(f.canvas, {p.first, p.second, 160, 8}, ux::YELLOW));
+            DoNotOptimize(worst);
+            return uint64_t(f.entities);
+        }},
+        // Colour-vision-deficiency simulation of a whole frame: one variant, then all three from one pass
+        {"cvd_simulate", [](Fixture& f) {
+            f.EnsureCvdTargets();
+            ux::SimulateCvd(f.canvas, f.cvdTargets[0], ux::Cvd::Protanopia);
+            DoNotOptimize(f.cvdBuffers[0].front());
+            return uint64_t(f.width) * uint64_t(f.height);
+        }},
+        {"cvd_simulate_all", [](Fixture& f) {
+            f.EnsureCvdTargets();
+            ux::SimulateCvdAll(f.canvas, f.cvdTargets);
+            DoNotOptimize(f.cvdBuffers[0].front());
+            return uint64_t(f.width) * uint64_t(f.height);
+        }},
+        {"hud_format", [](Fixture& f) {
+            char buf[64];
+            size_t total = 0;
+            for (int v : f.values) total += ux::FormatLabel(buf, "Score: ", v).size();
+            DoNotOptimize(total);
+            return uint64_t(f.entities);
+        }},
+        // Reference for the std::string concatenation the HUD used before FormatLabel
+        {"hud_format_std_string", [](Fixture& f) {
+            size_t total = 0;
+            for (int v : f.values) total += ("Score: " + std::to_string(v)).size();
+            DoNotOptimize(total);
+            return uint64_t(f.entities);
+        }},
+    };
+}
+
+struct Result {
+    std::string kernel;
+    const char* simd;
+    int entities;
+    Resolution resolution;
+    uint64_t iterations;
+    double nsPerOpMin;
+    double nsPerOpMedian;
+    double nsPerItem;
+    double itemsPerSecond;
+};
+
+// Calibrates a batch size to roughly minTime / kSamples, then reports the best and
+// median of kSamples batches.
+Result Measure(const Kernel& kernel, Fixture& fixture, double minTime)
+{
+    constexpr int kSamples = 10;
+    const double batchTarget = minTime / kSamples;
+
+    uint64_t items = kernel.run(fixture); // warm-up
+    uint64_t batch = 1;
+    while (true) {
+        auto t0 = Clock::now();
+        for (uint64_t i = 0; i < batch; i++) kernel.run(fixture);
+        double elapsed = std::chrono::duration<double>(Clock::now() - t0).count();
+        if (elapsed >= batchTarget || batch >= (uint64_t(1) << 30)) break;
+        batch = elapsed > 0 ? std::max(batch * 2, uint64_t(batch * batchTarget / elapsed * 1.2)) : batch * 10;
+    }
+
+    std::vector<double> samples;
+    for (int s = 0; s < kSamples; s++) {
+        auto t0 = Clock::now();
+        for (uint64_t i = 0; i < batch; i++) kernel.run(fixture);
+        double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+        samples.push_back(elapsed / double(batch));
+    }
+    std::sort(samples.begin(), samples.end());
+
+    Result r;
+    r.kernel = kernel.name;
+    r.simd = ux::simd::LevelName(ux::simd::ActiveLevel());
+    r.entities = fixture.entities;
+    r.resolution = {fixture.width, fixture.height};
+    r.iterations = batch * kSamples;
+    r.nsPerOpMin = samples.front();
+    r.nsPerOpMedian = samples[kSamples / 2];
+    r.nsPerItem = items ? r.nsPerOpMedian / double(items) : 0.0;
+    r.itemsPerSecond = r.nsPerOpMedian > 0 ? double(items) * 1e9 / r.nsPerOpMedian : 0.0;
+    return r;
+}
+
+void PrintJson(const Options& opts, const std::vector<Result>& results)
+{
+    std::printf("{\n  \"benchmark\": \"ux_game_bench\",\n  \"min_time_s\": %g,\n  \"results\": [\n", opts.minTime);
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        std::printf("    {\"kernel\": \"%s\", \"simd\": \"%s\", \"entities\": %d, \"width\": %d, \"height\": %d, "
+                    "\"iterations\": %llu, \"ns_per_op_min\": %.1f, \"ns_per_op_median\": %.1f, "
+                    "\"ns_per_item\": %.3f, \"items_per_second\": %.0f}%s\n",
+                    r.kernel.c_str(), r.simd, r.entities, r.resolution.width, r.resolution.height,
+                    (unsigned long long)r.iterations, r.nsPerOpMin, r.nsPerOpMedian,
+                    r.nsPerItem, r.itemsPerSecond, i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+}
+
+void PrintCsv(const std::vector<Result>& results)
+{
+    std::printf("kernel,simd,entities,width,height,iterations,ns_per_op_min,ns_per_op_median,ns_per_item,items_per_second\n");
+    for (const Result& r : results) {
+        std::printf("%s,%s,%d,%d,%d,%llu,%.1f,%.1f,%.3f,%.0f\n", r.kernel.c_str(), r.simd, r.entities,
+                    r.resolution.width, r.resolution.height, (unsigned long long)r.iterations,
+                    r.nsPerOpMin, r.nsPerOpMedian, r.nsPerItem, r.itemsPerSecond);
+    }
+}
+
+std::vector<std::string> Split(const std::string& s, char sep)
+{
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (start <= s.size()) {
+        size_t end = s.find(sep, start);
+        if (end == std::string::npos) end = s.size();
+        if (end > start) parts.push_back(s.substr(start, end - start));
+        start = end + 1;
+    }
+    return parts;
+}
+
+void PrintUsage()
+{
+    std::fprintf(stderr,
+        "Usage: ux_game_bench [options]\n"
+        "  --entities N[,N...]         entity counts (default 16,256,4096)\n"
+        "  --resolution WxH[,WxH...]   framebuffer sizes (default 640x480,1920x1080,3840x2160)\n"
+        "  --filter TEXT               only run kernels whose name contains TEXT\n"
+        "  --simd LEVEL[,LEVEL...]     SIMD kernel paths: scalar, sse2, avx2 (default: best supported)\n"
+        "  --min-time SECONDS          measuring time per case (default 0.2)\n"
+        "  --format json|csv           output format (default json)\n"
+        "  --list                      list kernel names and exit\n");
+}
+
+bool ParseArgs(int argc, char** argv, Options& opts)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : nullptr; };
+        const char* value = nullptr;
+
+        if (arg == "--list") {
+            for (auto& k : MakeKernels()) std::printf("%s\n", k.name);
+            std::exit(0);
+        } else if (arg == "--help" || arg == "-h") {
+            PrintUsage();
+            std::exit(0);
+        } else if ((arg == "--entities") && (value = next())) {
+            opts.entities.clear();
+            for (auto& p : Split(value, ',')) opts.entities.push_back(std::max(1, std::atoi(p.c_str())));
+        } else if ((arg == "--resolution") && (value = next())) {
+            opts.resolutions.clear();
+            for (auto& p : Split(value, ',')) {
+                int w = 0, h = 0;
+                if (std::sscanf(p.c_str(), "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0) {
+                    std::fprintf(stderr, "Invalid resolution: %s\n", p.c_str());
+                    return false;
+                }
+                opts.resolutions.push_back({w, h});
+            }
+        } else if ((arg == "--simd") && (value = next())) {
+            opts.simdLevels.clear();
+            for (auto& p : Split(value, ',')) {
+                ux::simd::Level level;
+                if (p == "scalar") level = ux::simd::Level::Scalar;
+                else if (p == "sse2") level = ux::simd::Level::SSE2;
+                else if (p == "avx2") level = ux::simd::Level::AVX2;
+                else {
+                    std::fprintf(stderr, "Invalid SIMD level: %s\n", p.c_str());
+                    return false;
+                }
+                if (level > ux::simd::DetectLevel()) {
+                    std::fprintf(stderr, "SIMD level not supported by this CPU: %s\n", p.c_str());
+                    return false;
+                }
+                opts.simdLevels.push_back(level);
+            }
+        } else if ((arg == "--filter") && (value = next())) {
+            opts.filter = value;
+        } else if ((arg == "--min-time") && (value = next())) {
+            opts.minTime = std::max(0.001, std::atof(value));
+        } else if ((arg == "--format") && (value = next())) {
+            opts.csv = std::strcmp(value, "csv") == 0;
+        } else {
+            std::fprintf(stderr, "Unknown or incomplete option: %s\n", arg.c_str());
+            PrintUsage();
+            return false;
+        }
+    }
+    return !opts.entities.empty() && !opts.resolutions.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options opts;
+    if (!ParseArgs(argc, argv, opts)) return 1;
+
+    std::vector<Kernel> kernels = MakeKernels();
+    std::vector<Result> results;
+
+    for (const Resolution& res : opts.resolutions) {
+        for (int n : opts.entities) {
+            Fixture fixture(n, res);
+            for (const Kernel& kernel : kernels) {
+                if (!opts.filter.empty() && std::string(kernel.name).find(opts.filter) == std::string::npos)
+                    continue;
+                for (ux::simd::Level level : opts.simdLevels) {
+                    ux::simd::SetLevel(level);
+                    fixture.enemies = fixture.enemyTemplate;
+                    results.push_back(Measure(kernel, fixture, opts.minTime));
+                    std::fprintf(stderr, "%-22s %-6s n=%-6d %5dx%-5d %12.1f ns/op\n", kernel.name,
+                                 results.back().simd, n, res.width, res.height, results.back().nsPerOpMedian);
+                }
+            }
+        }
+    }
+
+    if (opts.csv) PrintCsv(results);
+    else PrintJson(opts, results);
+    return 0;
+}
@@ -1,4 +1,8 @@
 @echo off
+REM Usage: build_game.bat [game^|bench^|replay^|native^|pgo^|all]   (default: game)
+set TARGET=%1
+if "%TARGET%"=="" set TARGET=game
+
 echo Building UX Test Game (C++ Edition)...
 
 REM Check if g++ is available
@@ -30,11 +34,100 @@ if %errorlevel% neq 0 (
     )
 )
 
+if /i "%TARGET%"=="game" goto build_game
+if /i "%TARGET%"=="all" goto build_game
+if /i "%TARGET%"=="bench" goto build_bench
+if /i "%TARGET%"=="replay" goto build_replay
+if /i "%TARGET%"=="native" goto build_native
+if /i "%TARGET%"=="pgo" goto build_pgo
+echo Unknown target: %TARGET% (expected game, bench, replay, native, pgo or all)
+exit /b 1
+
+:build_replay
+REM Headless replay runner (no window or GL needed)
+echo Compiling replay runner...
+g++ -std=c++17 -O2 -Wall -Wextra -pthread ^
+    -I. ^
+    replay_cpp_game.cpp ux_game/game.cpp ^
+    -o ux_game_replay.exe
+if %errorlevel% neq 0 (
+    echo ✗ Replay runner build failed! Check the error messages above.
+    exit /b 1
+)
+echo ✓ Replay runner created: ux_game_replay.exe
+echo   Run: ux_game_replay.exe replays\menu_navigation.uxr replays\gameplay_hard.uxr
+if /i "%TARGET%"=="replay" exit /b 0
+if /i "%TARGET%"=="all" goto build_native
+goto done
+
+:build_native
+REM Native image kernels for the Python analysis pipeline (loaded through ctypes)
+echo Compiling native kernels...
+g++ -std=c++17 -O2 -Wall -Wextra -pthread -shared ^
+    -I. ^
+    native/ux_native.cpp ^
+    -o ux_native.dll
+if %errorlevel% neq 0 (
+    echo ✗ Native kernel build failed! Check the error messages above.
+    exit /b 1
+)
+echo ✓ Native kernels created: ux_native.dll
+if /i "%TARGET%"=="native" exit /b 0
+goto done
+
+:build_pgo
+REM Profile-guided + link-time optimized build trained on the recorded replays
+set PGO_FLAGS=-std=c++17 -O2 -Wall -Wextra -pthread -I.
+set PGO_REPLAYS=replays\menu_navigation.uxr replays\gameplay_easy.uxr replays\gameplay_hard.uxr replays\gameplay_1080p.uxr replays\long_session.uxr
+if exist _pgo rmdir /s /q _pgo
+mkdir _pgo
+echo [1/4] Plain build (baseline)...
+g++ %PGO_FLAGS% replay_cpp_game.cpp ux_game/game.cpp -o _pgo\ux_game_replay_plain.exe || exit /b 1
+echo [2/4] Instrumented build...
+g++ %PGO_FLAGS% -fprofile-generate -c ux_game/game.cpp -o _pgo\game.o || exit /b 1
+g++ %PGO_FLAGS% -fprofile-generate -c replay_cpp_game.cpp -o _pgo\replay.o || exit /b 1
+g++ -pthread -fprofile-generate _pgo\replay.o _pgo\game.o -o _pgo\ux_game_replay_instrumented.exe || exit /b 1
+echo [3/4] Collecting profile from replays...
+_pgo\ux_game_replay_instrumented.exe --repeat 1 %PGO_REPLAYS% >nul || exit /b 1
+echo [4/4] Optimized build (PGO + LTO)...
+g++ %PGO_FLAGS% -fprofile-use -Wno-missing-profile -flto=auto -c ux_game/game.cpp -o _pgo\game.o || exit /b 1
+g++ %PGO_FLAGS% -fprofile-use -Wno-missing-profile -flto=auto -c replay_cpp_game.cpp -o _pgo\replay.o || exit /b 1
+g++ -O2 -pthread -flto=auto _pgo\replay.o _pgo\game.o -o ux_game_replay.exe || exit /b 1
+g++ %PGO_FLAGS% -flto=auto -c test_cpp_game.cpp -o _pgo\test_cpp_game.o && ^
+g++ -O2 -pthread -flto=auto _pgo\test_cpp_game.o _pgo\game.o -o ux_test_game.exe ^
+    -lgdi32 -luser32 -lopengl32 -lgdiplus -lShlwapi -ldwmapi -lstdc++fs
+if %errorlevel% equ 0 (echo ✓ Executable created: ux_test_game.exe ^(PGO + LTO^))
+echo.
+echo Plain build (ns_per_frame_min is column 6):
+_pgo\ux_game_replay_plain.exe --format csv %PGO_REPLAYS% 2>nul
+echo.
+echo PGO + LTO build:
+ux_game_replay.exe --format csv %PGO_REPLAYS% 2>nul
+exit /b 0
+
+:build_bench
+REM Headless micro-benchmarks for the game kernels (no window or GL needed)
+echo Compiling benchmarks...
+g++ -std=c++17 -O2 -Wall -Wextra ^
+    -I. ^
+    bench_cpp_game.cpp ^
+    -o ux_game_bench.exe
+if %errorlevel% neq 0 (
+    echo ✗ Benchmark build failed! Check the error messages above.
+    exit /b 1
+)
+echo ✓ Benchmarks created: ux_game_bench.exe
+echo   Run: ux_game_bench.exe --format json ^> bench_results.json
+if /i "%TARGET%"=="bench" exit /b 0
+if /i "%TARGET%"=="all" goto build_replay
+goto done
+
+:build_game
 REM Compile the game
 echo Compiling...
-g++ -std=c++17 -O2 -Wall -Wextra ^
+g++ -std=c++17 -O2 -Wall -Wextra -pthread ^
     -I. ^
-    test_cpp_game.cpp ^
+    test_cpp_game.cpp ux_game/game.cpp ^
     -o ux_test_game.exe ^
     -lgdi32 -luser32 -lopengl32 -lgdiplus -lShlwapi -ldwmapi -lstdc++fs
 
@@ -60,4 +153,8 @@ if %errorlevel% equ 0 (
     echo.
 )
 
+if /i "%TARGET%"=="all" goto build_bench
+
+:done
+
 pause 
\ No newline at end of file
@@ -25,6 +25,7 @@ from dataclasses import dataclass
 from agents.visual_analysis_agent import VisualAnalysisAgent, VisualAnalysisResult
 from agents.core_orchestrator import CoreOrchestrator
 from core.screenshot_analyzer import ScreenshotAnalyzer
+from src.capture import native_capture
 
 # Set up logging
 logging.basicConfig(level=logging.INFO)
@@ -84,6 +85,10 @@ class GameUXTestingController:
         self.current_screenshot: Optional[np.ndarray] = None
         self.display_size = (800, 600)  # For screenshot display
         
+        # Captures the game window when it is drawn to (None: capture on the timer)
+        self.damage_capture: Optional[native_capture.NativeCapture] = None
+        self._damage_frames = None
+        
         logger.info("Game UX Testing Controller initialized")
     
     def _load_config(self) -> Dict:
@@ -102,7 +107,8 @@ class GameUXTestingController:
                 "session_config": {
                     "feedback_ratio": "3:1",
                     "session_duration": 60,
-                    "analysis_intervals": [15, 30, 45, 60]
+                    "analysis_intervals": [15, 30, 45, 60],
+                    "capture_on_damage": True
                 },
                 "game_specific_metrics": {
                     "ui_responsiveness": {"target_fps": 60},
@@ -172,6 +178,7 @@ class GameUXTestingController:
         
         self.running = True
         logger.info(f"Running game testing session: {self.session.session_id}")
+        self._start_damage_capture()
         
         try:
             while (self.session.current_iteration < self.session.total_iterations 
@@ -185,8 +192,10 @@ class GameUXTestingController:
                     and self.session.current_iteration > 0):
                     await self._conduct_user_feedback_session()
                 
-                # Brief pause between iterations
-                await asyncio.sleep(2)
+                # Brief pause between iterations; with damage tracking the
+                # next iteration waits for the game to draw instead
+                if not self.damage_capture:
+                    await asyncio.sleep(2)
             
             # Final session summary
             await self._generate_session_summary()
@@ -232,18 +241,69 @@ class GameUXTestingController:
         if result.accessibility_issues:
             logger.warning(f"  - Accessibility Issues: {len(result.accessibility_issues)}")
     
+    def _start_damage_capture(self):
+        """Capture the game window only when it changes, if X DAMAGE is available"""
+        game_config = self.config.get("game_ux_testing", {})
+        if not game_config.get("session_config", {}).get("capture_on_damage", True):
+            return
+        
+        try:
+            capture = native_capture.NativeCapture(native_capture.GAME_WINDOW_NAME)
+        except RuntimeError as e:
+            logger.info(f"Capturing on the timer: {e}")
+            return
+        
+        target_fps = (game_config.get("game_specific_metrics", {})
+                      .get("ui_responsiveness", {}).get("target_fps", 60))
+        if not capture.tracks_damage or not capture.start(target_fps, on_damage=True):
+            logger.info("Capturing on the timer: X DAMAGE is not available")
+            capture.close()
+            return
+        
+        self.damage_capture = capture
+        self._damage_frames = capture.frames()
+        logger.info(f"Capturing the game window on damage (at most {target_fps} fps)")
+    
+    def _stop_damage_capture(self):
+        """Stop the damage-driven capture; later iterations use the timer"""
+        if self.damage_capture:
+            self.damage_capture.close()
+            self.damage_capture = None
+            self._damage_frames = None
+    
+    async def _capture_next_change(self, screenshot_path: Path) -> Optional[str]:
+        """Wait until the game window is drawn to and save that frame"""
+        loop = asyncio.get_running_loop()
+        frame = await loop.run_in_executor(None, next, self._damage_frames, None)
+        if frame is None:
+            # The capture was stopped or the window went away
+            logger.warning("Damage-driven capture ended, capturing on the timer")
+            self._stop_damage_capture()
+            return None
+        
+        with frame:
+            cv2.imwrite(str(screenshot_path), frame.bgr())
+            regions = frame.regions
+        
+        logger.info(f"Screenshot saved: {screenshot_path} ({len(regions)} changed regions)")
+        return str(screenshot_path)
+    
     async def _capture_screenshot(self, iteration_num: int) -> str:
         """Capture screenshot and save it"""
+        session_screenshot_path = (
+            Path(self.session.screenshots_dir) / 
+            f"{self.session.session_id}_iter_{iteration_num:03d}.png"
+        )
+        
+        if self.damage_capture:
+            screenshot_path = await self._capture_next_change(session_screenshot_path)
+            if screenshot_path or not self.running:
+                return screenshot_path
+        
         try:
             # Use the screenshot analyzer to take screenshot
             image_path = await self.screenshot_analyzer.capture_screenshot()
             
-            # Copy to session-specific location
-            session_screenshot_path = (
-                Path(self.session.screenshots_dir) / 
-                f"{self.session.session_id}_iter_{iteration_num:03d}.png"
-            )
-            
             # Copy the file
             import shutil
             shutil.copy2(image_path, session_screenshot_path)
@@ -613,11 +673,16 @@ GAME UX ANALYSIS - Iteration {self.session.current_iteration}
             # Stop orchestrator if running
             self.orchestrator.running = False
         
+        self._stop_damage_capture()
+        
         logger.info("Session cleanup completed")
     
     def stop_session(self):
         """Stop the current testing session"""
         self.running = False
+        if self.damage_capture:
+            # Wakes an iteration that is waiting for the game to draw
+            self.damage_capture.stop()
         logger.info("Testing session stop requested")
 
 # Main execution
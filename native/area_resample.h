@@ -0,0 +1,203 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "native/image_diff.h"
+#include "ux_game/simd_fill.h"
+
+// Area-averaging downscale (cv2.INTER_AREA) behind the image encoder
+// (image_encode.h).
+//
+// Every destination pixel is the mean of the source rectangle it covers, with
+// fractional weights for partly covered edge pixels, from the same weight
+// tables cv2's resizeArea builds. Rows are resampled vertically first: the
+// covered source rows are accumulated into one float row with a single
+// multiply-add per byte (the AVX2 path converts and accumulates eight bytes
+// at a time), then each destination pixel sums a few taps of that row. The
+// result is packed RGB whatever the source order, which is what the encoders
+// take.
+namespace ux::native {
+
+constexpr int32_t kResampleBandRows = 32;
+
+// Largest size with the longest side at most maxSize, keeping the aspect
+// ratio (int(side * maxSize / longest), as the Python callers compute it).
+// Frames that already fit, and maxSize <= 0, keep their size.
+inline void FitSize(int32_t width, int32_t height, int32_t maxSize, int32_t& outWidth, int32_t& outHeight)
+{
+    const int32_t longest = std::max(width, height);
+    outWidth = width;
+    outHeight = height;
+    if (maxSize <= 0 || longest <= maxSize) return;
+    const double ratio = double(maxSize) / double(longest);
+    outWidth = std::max(int32_t(width * ratio), 1);
+    outHeight = std::max(int32_t(height * ratio), 1);
+}
+
+// Source taps of every destination pixel along one axis:
+// taps[start[d]] .. taps[start[d + 1]]
+struct AreaTable {
+    struct Tap {
+        int32_t index;
+        float weight;
+    };
+    std::vector<int32_t> start;
+    std::vector<Tap> taps;
+};
+
+// cv2's computeResizeAreaTab for a source of size src shrunk to dst
+inline void BuildAreaTable(int32_t src, int32_t dst, AreaTable& table)
+{
+    const double scale = double(src) / dst;
+    table.start.assign(1, 0);
+    table.taps.clear();
+    for (int32_t d = 0; d < dst; d++) {
+        const double f1 = d * scale, f2 = f1 + scale;
+        const double cell = std::min(scale, src - f1);
+        int32_t s2 = std::min(int32_t(std::floor(f2)), src - 1);
+        int32_t s1 = std::min(int32_t(std::ceil(f1)), s2);
+        if (s1 - f1 > 1e-3) table.taps.push_back({s1 - 1, float((s1 - f1) / cell)});
+        for (int32_t s = s1; s < s2; s++) table.taps.push_back({s, float(1.0 / cell)});
+        if (f2 - s2 > 1e-3) table.taps.push_back({s2, float(std::min(std::min(f2 - s2, 1.0), cell) / cell)});
+        table.start.push_back(int32_t(table.taps.size()));
+    }
+}
+
+namespace detail {
+
+// acc[i] += weight * row[i] over n bytes
+inline void AccumulateRowScalar(const uint8_t* row, int32_t begin, int32_t n, float weight, float* acc)
+{
+    for (int32_t i = begin; i < n; i++) acc[i] += weight * row[i];
+}
+
+#if UX_SIMD_X86
+UX_TARGET_AVX2 inline int32_t AccumulateRowAVX2(const uint8_t* row, int32_t n, float weight, float* acc)
+{
+    const __m256 w = _mm256_set1_ps(weight);
+    int32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 v = _mm256_cvtepi32_ps(
+            _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + i))));
+        _mm256_storeu_ps(acc + i, _mm256_add_ps(_mm256_loadu_ps(acc + i), _mm256_mul_ps(v, w)));
+    }
+    return i;
+}
+#endif
+
+inline void AccumulateRow(const uint8_t* row, int32_t n, float weight, float* acc)
+{
+    int32_t i = 0;
+#if UX_SIMD_X86
+    if (simd::ActiveLevel() == simd::Level::AVX2) i = AccumulateRowAVX2(row, n, weight, acc);
+#endif
+    AccumulateRowScalar(row, i, n, weight, acc);
+}
+
+inline uint8_t SaturateRound(float v)
+{
+    return uint8_t(std::clamp(std::lrint(v), 0L, 255L));
+}
+
+// Destination pixels [begin, end) of one row (out points at the row) from the
+// taps of the accumulated row
+inline void HorizontalTapsScalar(const float* acc, const AreaTable& xs, int32_t channels, bool bgr, int32_t begin,
+                                 int32_t end, uint8_t* out)
+{
+    const int32_t r = bgr ? 2 : 0, b = 2 - r;
+    out += size_t(begin) * 3;
+    for (int32_t x = begin; x < end; x++, out += 3) {
+        float sum[3] = {0.0f, 0.0f, 0.0f};
+        for (int32_t t = xs.start[x]; t < xs.start[x + 1]; t++) {
+            const float* p = acc + size_t(xs.taps[t].index) * channels;
+            const float w = xs.taps[t].weight;
+            sum[0] += w * p[0];
+            sum[1] += w * p[1];
+            sum[2] += w * p[2];
+        }
+        out[0] = SaturateRound(sum[r]);
+        out[1] = SaturateRound(sum[1]);
+        out[2] = SaturateRound(sum[b]);
+    }
+}
+
+#if UX_SIMD_X86
+// The same sums with one pixel per 128-bit register (the fourth lane reads
+// the next pixel, or one float of padding, and is dropped); cvtps rounds to
+// nearest even like lrint and the packs saturate. Each pixel is stored as 4
+// bytes, the last of which the next pixel overwrites, so end must be short of
+// the row end. Returns end.
+inline int32_t HorizontalTapsSSE2(const float* acc, const AreaTable& xs, int32_t channels, bool bgr, int32_t end,
+                                  uint8_t* out)
+{
+    for (int32_t x = 0; x < end; x++, out += 3) {
+        __m128 sum = _mm_setzero_ps();
+        for (int32_t t = xs.start[x]; t < xs.start[x + 1]; t++) {
+            const __m128 p = _mm_loadu_ps(acc + size_t(xs.taps[t].index) * channels);
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(xs.taps[t].weight), p));
+        }
+        if (bgr) sum = _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(3, 0, 1, 2));
+        __m128i v = _mm_cvtps_epi32(sum);
+        v = _mm_packus_epi16(_mm_packs_epi32(v, v), v);
+        const uint32_t pixel = uint32_t(_mm_cvtsi128_si32(v));
+        std::memcpy(out, &pixel, 4);
+    }
+    return end;
+}
+#endif
+
+} // namespace detail
+
+inline int32_t ResampleBandCount(int32_t height)
+{
+    return (height + kResampleBandRows - 1) / kResampleBandRows;
+}
+
+// Rows [band * kResampleBandRows, ...) of the xs.start.size() - 1 by
+// ys.start.size() - 1 result, packed RGB (dst points at row 0). acc is
+// scratch space for one source row. Tables of equal size (no resize) copy
+// the pixels.
+inline void AreaResampleBand(const ImageView& img, const AreaTable& xs, const AreaTable& ys, int32_t band,
+                             std::vector<float>& acc, uint8_t* dst)
+{
+    const int32_t dw = int32_t(xs.start.size()) - 1, dh = int32_t(ys.start.size()) - 1;
+    const int32_t y0 = band * kResampleBandRows, y1 = std::min(dh, y0 + kResampleBandRows);
+    const int32_t ch = img.channels, r = img.bgr ? 2 : 0, b = 2 - r;
+    const int32_t n = img.width * ch;
+
+    if (dw == img.width && dh == img.height) {
+        for (int32_t y = y0; y < y1; y++) {
+            const uint8_t* p = img.Row(y);
+            uint8_t* out = dst + size_t(y) * dw * 3;
+            for (int32_t x = 0; x < dw; x++, p += ch, out += 3) {
+                out[0] = p[r];
+                out[1] = p[1];
+                out[2] = p[b];
+            }
+        }
+        return;
+    }
+
+    // One float of padding for the vector loads of the last pixel
+    acc.resize(size_t(n) + 1);
+    for (int32_t y = y0; y < y1; y++) {
+        std::fill(acc.begin(), acc.end(), 0.0f);
+        for (int32_t t = ys.start[y]; t < ys.start[y + 1]; t++) {
+            detail::AccumulateRow(img.Row(ys.taps[t].index), n, ys.taps[t].weight, acc.data());
+        }
+        uint8_t* out = dst + size_t(y) * dw * 3;
+        int32_t x = 0;
+#if UX_SIMD_X86
+        if (simd::ActiveLevel() != simd::Level::Scalar)
+            x = detail::HorizontalTapsSSE2(acc.data(), xs, ch, img.bgr, dw - 1, out);
+#endif
+        detail::HorizontalTapsScalar(acc.data(), xs, ch, img.bgr, x, dw, out);
+    }
+}
+
+} // namespace ux::native
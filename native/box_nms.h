@@ -0,0 +1,324 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "ux_game/simd_fill.h"
+
+// Greedy non-maximum suppression behind UIElementDetector._filter_and_deduplicate.
+//
+// Boxes are visited in order of decreasing score (ties keep input order). A
+// box nobody suppressed is kept and suppresses every later box whose IoU with
+// it exceeds the threshold -- the same result as checking each box against
+// all kept ones, but only kept boxes ever search. The search goes through a
+// static R-tree packed with Sort-Tile-Recursive over all boxes: leaves of 16
+// boxes, ordered by centre x into vertical slices and by centre y within a
+// slice. Nodes count their undecided boxes, so settled parts of the frame
+// drop out of later searches. Leaf boxes are stored as coordinate arrays so
+// IoU is tested eight at a time. IoU > t is evaluated as
+// intersection > t * union in float.
+namespace ux::native {
+
+namespace detail {
+
+constexpr int32_t kNmsNode = 16;
+
+// Bounds of a tree level and the number of undecided boxes below each node:
+// node i covers children [i * kNmsNode, ...) of the level below
+struct NmsLevel {
+    std::vector<float> x0, y0, x1, y1;
+    std::vector<int32_t> live;
+
+    void Resize(size_t n)
+    {
+        x0.assign(n, 0.0f);
+        y0.assign(n, 0.0f);
+        x1.assign(n, 0.0f);
+        y1.assign(n, 0.0f);
+        live.assign(n, 0);
+    }
+};
+
+// Sort key and box index
+struct NmsKey {
+    uint64_t key;
+    int32_t index;
+};
+
+// Order-preserving unsigned image of a float / double
+inline uint32_t OrderedBits(float v)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return bits & 0x80000000u ? ~bits : bits | 0x80000000u;
+}
+
+inline uint64_t OrderedBits(double v)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return bits & 0x8000000000000000ull ? ~bits : bits | 0x8000000000000000ull;
+}
+
+// Stable LSD radix sort on 16-bit digits; digits every key shares are
+// skipped, so 32-bit keys take two passes
+inline void RadixSort(std::vector<NmsKey>& keys)
+{
+    constexpr int kDigitBits = 16;
+    constexpr size_t kBuckets = size_t(1) << kDigitBits;
+    if (keys.size() < 2048) {
+        std::stable_sort(keys.begin(), keys.end(), [](const NmsKey& a, const NmsKey& b) { return a.key < b.key; });
+        return;
+    }
+    std::vector<NmsKey> scratch(keys.size());
+    std::vector<uint32_t> counts(kBuckets);
+    for (int shift = 0; shift < 64; shift += kDigitBits) {
+        const uint64_t first = keys[0].key >> shift & (kBuckets - 1);
+        bool shared = true;
+        std::fill(counts.begin(), counts.end(), 0u);
+        for (const NmsKey& k : keys) {
+            const uint64_t digit = k.key >> shift & (kBuckets - 1);
+            counts[digit]++;
+            shared &= digit == first;
+        }
+        if (shared) continue;
+        uint32_t offset = 0;
+        for (uint32_t& c : counts) {
+            const uint32_t n = c;
+            c = offset;
+            offset += n;
+        }
+        for (const NmsKey& k : keys) scratch[counts[k.key >> shift & (kBuckets - 1)]++] = k;
+        keys.swap(scratch);
+    }
+}
+
+class NmsTree {
+public:
+    // boxes are n x (x, y, w, h)
+    NmsTree(const float* boxes, const double* scores, int32_t n) : n(n)
+    {
+        // Visiting order: score descending, ties by index
+        std::vector<NmsKey> sorted(size_t(std::max(n, 0)));
+        for (int32_t i = 0; i < n; i++) sorted[i] = {~OrderedBits(scores[i]), i};
+        RadixSort(sorted);
+        order.resize(sorted.size());
+        std::vector<int32_t> rankOf(order.size());
+        for (int32_t r = 0; r < n; r++) {
+            order[r] = sorted[r].index;
+            rankOf[order[r]] = r;
+        }
+
+        // Sort-Tile-Recursive leaf order: by centre x, then by centre y within
+        // each vertical slice of `slices` leaves
+        std::vector<NmsKey>& packed = sorted;
+        for (int32_t i = 0; i < n; i++) packed[i] = {OrderedBits(boxes[4 * i] * 2 + boxes[4 * i + 2]), i};
+        RadixSort(packed);
+        const int32_t leaves = (n + kNmsNode - 1) / kNmsNode;
+        const int32_t slices = std::max(1, int32_t(std::ceil(std::sqrt(double(leaves)))));
+        const size_t sliceSize = size_t(slices) * kNmsNode;
+        for (size_t s = 0; s < packed.size(); s++) {
+            const int32_t i = packed[s].index;
+            packed[s].key = uint64_t(s / sliceSize) << 32 | OrderedBits(boxes[4 * i + 1] * 2 + boxes[4 * i + 3]);
+        }
+        RadixSort(packed);
+
+        // Entries, padded to whole leaves with empty boxes that never overlap
+        const size_t slots = size_t(leaves) * kNmsNode;
+        entries.Resize(slots);
+        area.assign(slots, 0.0f);
+        decided.assign(slots, 1);
+        slotOfRank.resize(size_t(n));
+        for (size_t s = 0; s < packed.size(); s++) {
+            const float* b = boxes + 4 * size_t(packed[s].index);
+            entries.x0[s] = b[0];
+            entries.y0[s] = b[1];
+            entries.x1[s] = b[0] + b[2];
+            entries.y1[s] = b[1] + b[3];
+            area[s] = b[2] * b[3];
+            decided[s] = 0;
+            slotOfRank[rankOf[packed[s].index]] = int32_t(s);
+        }
+
+        // Internal levels up to a single root
+        size_t count = packed.size();
+        while (count > 1 || levels.empty()) {
+            const size_t nodes = (count + kNmsNode - 1) / kNmsNode;
+            NmsLevel level;
+            // Whole groups of children, padding nodes have no live boxes
+            level.Resize((nodes + kNmsNode - 1) / kNmsNode * kNmsNode);
+            const NmsLevel* below = levels.empty() ? &entries : &levels.back();
+            for (size_t i = 0; i < nodes; i++) {
+                const size_t begin = i * kNmsNode, end = std::min(count, begin + kNmsNode);
+                level.x0[i] = *std::min_element(below->x0.begin() + begin, below->x0.begin() + end);
+                level.y0[i] = *std::min_element(below->y0.begin() + begin, below->y0.begin() + end);
+                level.x1[i] = *std::max_element(below->x1.begin() + begin, below->x1.begin() + end);
+                level.y1[i] = *std::max_element(below->y1.begin() + begin, below->y1.begin() + end);
+                level.live[i] = levels.empty() ? int32_t(end - begin)
+                                               : std::accumulate(below->live.begin() + begin,
+                                                                 below->live.begin() + end, 0);
+            }
+            levels.push_back(std::move(level));
+            count = nodes;
+        }
+    }
+
+    // Indices of the kept boxes in visiting order
+    void Run(float threshold, std::vector<int32_t>& keep)
+    {
+        // IoU > t needs the boxes to overlap by more than t times the kept
+        // box's width and height, so only nodes reaching into the kept box's
+        // core are searched (slightly widened against float rounding)
+        const float core = threshold > 0.0f ? std::min(threshold, 1.0f) * 0.999f : 0.0f;
+        for (int32_t r = 0; r < n; r++) {
+            const size_t slot = size_t(slotOfRank[r]);
+            if (decided[slot]) continue;
+            Decide(slot);
+            keep.push_back(order[r]);
+            const float w = entries.x1[slot] - entries.x0[slot], h = entries.y1[slot] - entries.y0[slot];
+            const Window window{entries.x0[slot] + core * w, entries.y0[slot] + core * h,
+                                entries.x1[slot] - core * w, entries.y1[slot] - core * h};
+            if (ChildMask(levels.back(), 0, window) & 1) Search(int32_t(levels.size()) - 1, 0, slot, window, threshold);
+        }
+    }
+
+private:
+    struct Window {
+        float x0, y0, x1, y1;
+    };
+
+    // Marks a box kept or suppressed and takes it out of the live counts
+    void Decide(size_t slot)
+    {
+        decided[slot] = 1;
+        size_t node = slot;
+        for (NmsLevel& level : levels) {
+            node /= kNmsNode;
+            level.live[node]--;
+        }
+    }
+
+    // Suppresses the undecided boxes of a leaf (kNmsNode slots from first)
+    // whose IoU with the kept box exceeds threshold
+    void SuppressLeafScalar(size_t first, size_t slot, float threshold)
+    {
+        for (size_t s = first; s < first + kNmsNode; s++) {
+            const float ix = std::min(entries.x1[s], entries.x1[slot]) - std::max(entries.x0[s], entries.x0[slot]);
+            const float iy = std::min(entries.y1[s], entries.y1[slot]) - std::max(entries.y0[s], entries.y0[slot]);
+            if (ix <= 0.0f || iy <= 0.0f) continue;
+            const float inter = ix * iy;
+            if (inter > threshold * (area[s] + area[slot] - inter) && !decided[s]) Decide(s);
+        }
+    }
+
+#if UX_SIMD_X86
+    UX_TARGET_AVX2 void SuppressLeafAVX2(size_t first, size_t slot, float threshold)
+    {
+        const __m256 kx0 = _mm256_set1_ps(entries.x0[slot]), ky0 = _mm256_set1_ps(entries.y0[slot]);
+        const __m256 kx1 = _mm256_set1_ps(entries.x1[slot]), ky1 = _mm256_set1_ps(entries.y1[slot]);
+        const __m256 karea = _mm256_set1_ps(area[slot]), t = _mm256_set1_ps(threshold);
+        const __m256 zero = _mm256_setzero_ps();
+        for (size_t s = first; s < first + kNmsNode; s += 8) {
+            const __m256 ix = _mm256_sub_ps(_mm256_min_ps(_mm256_loadu_ps(&entries.x1[s]), kx1),
+                                            _mm256_max_ps(_mm256_loadu_ps(&entries.x0[s]), kx0));
+            const __m256 iy = _mm256_sub_ps(_mm256_min_ps(_mm256_loadu_ps(&entries.y1[s]), ky1),
+                                            _mm256_max_ps(_mm256_loadu_ps(&entries.y0[s]), ky0));
+            const __m256 inter = _mm256_mul_ps(ix, iy);
+            const __m256 uni = _mm256_sub_ps(_mm256_add_ps(_mm256_loadu_ps(&area[s]), karea), inter);
+            const __m256 hit = _mm256_and_ps(
+                _mm256_and_ps(_mm256_cmp_ps(ix, zero, _CMP_GT_OQ), _mm256_cmp_ps(iy, zero, _CMP_GT_OQ)),
+                _mm256_cmp_ps(inter, _mm256_mul_ps(t, uni), _CMP_GT_OQ));
+            for (uint32_t bits = uint32_t(_mm256_movemask_ps(hit)); bits; bits &= bits - 1) {
+                const size_t hitSlot = s + size_t(__builtin_ctz(bits));
+                if (!decided[hitSlot]) Decide(hitSlot);
+            }
+        }
+    }
+#endif
+
+    // Bit i set if node first + i still holds undecided boxes and reaches
+    // into window
+    static uint32_t ChildMaskScalar(const NmsLevel& l, size_t first, const Window& window)
+    {
+        uint32_t mask = 0;
+        for (size_t i = first; i < first + kNmsNode; i++) {
+            const bool hit = (l.live[i] > 0) & (l.x0[i] < window.x1) & (l.x1[i] > window.x0) & (l.y0[i] < window.y1) &
+                             (l.y1[i] > window.y0);
+            mask |= uint32_t(hit) << (i - first);
+        }
+        return mask;
+    }
+
+#if UX_SIMD_X86
+    UX_TARGET_AVX2 static uint32_t ChildMaskAVX2(const NmsLevel& l, size_t first, const Window& window)
+    {
+        const __m256 wx0 = _mm256_set1_ps(window.x0), wy0 = _mm256_set1_ps(window.y0);
+        const __m256 wx1 = _mm256_set1_ps(window.x1), wy1 = _mm256_set1_ps(window.y1);
+        uint32_t mask = 0;
+        for (size_t half = 0; half < kNmsNode; half += 8) {
+            const size_t i = first + half;
+            const __m256 live = _mm256_castsi256_ps(_mm256_cmpgt_epi32(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&l.live[i])), _mm256_setzero_si256()));
+            const __m256 x = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(&l.x0[i]), wx1, _CMP_LT_OQ),
+                                           _mm256_cmp_ps(_mm256_loadu_ps(&l.x1[i]), wx0, _CMP_GT_OQ));
+            const __m256 y = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(&l.y0[i]), wy1, _CMP_LT_OQ),
+                                           _mm256_cmp_ps(_mm256_loadu_ps(&l.y1[i]), wy0, _CMP_GT_OQ));
+            mask |= uint32_t(_mm256_movemask_ps(_mm256_and_ps(live, _mm256_and_ps(x, y)))) << half;
+        }
+        return mask;
+    }
+#endif
+
+    static uint32_t ChildMask(const NmsLevel& l, size_t first, const Window& window)
+    {
+#if UX_SIMD_X86
+        if (simd::ActiveLevel() == simd::Level::AVX2) return ChildMaskAVX2(l, first, window);
+#endif
+        return ChildMaskScalar(l, first, window);
+    }
+
+    // Descends into the children of a matching node that reach into window
+    void Search(int32_t level, size_t node, size_t slot, const Window& window, float threshold)
+    {
+        if (level == 0) {
+#if UX_SIMD_X86
+            if (simd::ActiveLevel() == simd::Level::AVX2) {
+                SuppressLeafAVX2(node * kNmsNode, slot, threshold);
+                return;
+            }
+#endif
+            SuppressLeafScalar(node * kNmsNode, slot, threshold);
+            return;
+        }
+        const size_t first = node * kNmsNode;
+        for (uint32_t bits = ChildMask(levels[level - 1], first, window); bits; bits &= bits - 1)
+            Search(level - 1, first + size_t(__builtin_ctz(bits)), slot, window, threshold);
+    }
+
+    int32_t n;
+    std::vector<int32_t> order;       // rank -> box index
+    std::vector<int32_t> slotOfRank;  // rank -> leaf slot
+    NmsLevel entries;                 // leaf slots: box corners
+    std::vector<float> area;
+    std::vector<uint8_t> decided;     // kept, suppressed or padding
+    std::vector<NmsLevel> levels;     // levels[0] bounds the leaves; back() is the root
+};
+
+} // namespace detail
+
+// Greedy NMS over n boxes (x, y, w, h); appends the indices of the kept boxes
+// to keep in order of decreasing score
+inline void NonMaxSuppression(const float* boxes, const double* scores, int32_t n, float iouThreshold,
+                              std::vector<int32_t>& keep)
+{
+    detail::NmsTree tree(boxes, scores, n);
+    tree.Run(iouThreshold, keep);
+}
+
+} // namespace ux::native
@@ -0,0 +1,468 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#include "native/mapped_file.h"
+
+// Catalog of the screenshots stored in a capture directory.
+//
+// Two memory-mapped, append-only logs replace the JSON sidecar per image: the
+// index log (<path>.idx) is a 64-byte header followed by fixed-size 128-byte
+// records - timestamp, label, dimensions, hashes and the offset of the file's
+// name - and the data log (<path>.dat) holds the names and any free-form JSON
+// metadata the records point to. A record is committed by bumping the count
+// in the index header after its bytes are written, so a crash loses at most
+// the record being appended.
+//
+// Records are appended in timestamp order, which makes the index itself a
+// sorted array: the latest capture with a given label at or before a time is
+// a binary search over that label's record numbers, and retention pruning
+// walks forward from the oldest live record. Names map to record numbers
+// through an in-memory table rebuilt on Open. Removing a capture flags its
+// record; once flagged records outnumber live ones, Open rewrites both logs
+// into temporary files and renames them into place (the index last, with a
+// generation number tying it to its data log).
+namespace ux::native {
+
+constexpr uint32_t kCatalogRemoved = 1;
+constexpr uint32_t kCatalogPerceptual = 2;  // phash and dhash are set
+constexpr size_t kCatalogLabelBytes = 32;
+
+struct CatalogRecord {
+    uint32_t magic;
+    uint32_t flags;             // kCatalogRemoved, kCatalogPerceptual
+    int64_t timestampNs;        // wall clock, nondecreasing in log order
+    int32_t width, height, channels;
+    uint32_t nameLength;
+    uint64_t nameOffset;        // of the image file's name in the data log
+    uint64_t extraOffset;       // of the JSON metadata in the data log
+    uint64_t extraLength;       // 0 without metadata
+    uint64_t fileBytes;         // size of the image file
+    uint64_t contentHash;       // content_hash.h of the pixels
+    uint64_t phash, dhash;
+    char label[kCatalogLabelBytes];  // NUL-terminated
+    uint8_t reserved[8];
+};
+
+static_assert(sizeof(CatalogRecord) == 128, "CatalogRecord is part of the log format");
+
+class CaptureCatalog {
+public:
+    static constexpr uint32_t kIndexMagic = 0x49435855;   // "UXCI"
+    static constexpr uint32_t kDataMagic = 0x44435855;    // "UXCD"
+    static constexpr uint32_t kRecordMagic = 0x52435855;  // "UXCR"
+    static constexpr uint32_t kVersion = 1;
+    static constexpr int64_t kCompactMinRemoved = 256;
+
+    CaptureCatalog() = default;
+    CaptureCatalog(const CaptureCatalog&) = delete;
+    CaptureCatalog& operator=(const CaptureCatalog&) = delete;
+
+    // Opens (creating if needed) the catalog stored at path.idx / path.dat
+    bool Open(const std::string& path, std::string& error)
+    {
+        Close();
+        base = path;
+        Recover();
+        if (!OpenLogs(error)) return false;
+        if (removed >= kCompactMinRemoved && removed > live && !Compact(error)) return false;
+        return true;
+    }
+
+    void Close()
+    {
+        index.Close();
+        data.Close();
+        count = 0;
+        live = removed = 0;
+        firstLive = 0;
+        lastTimestampNs = 0;
+        byName.clear();
+        byLabel.clear();
+        liveByLabel.clear();
+    }
+
+    bool IsOpen() const { return index.IsOpen() && index.Data() && data.Data(); }
+
+    // Records in the log, removed ones included; record numbers run below this
+    int64_t Size() const { return count; }
+
+    const CatalogRecord* Record(int64_t i) const
+    {
+        return i >= 0 && i < count ? reinterpret_cast<const CatalogRecord*>(index.Data() + kHeaderBytes) + i
+                                   : nullptr;
+    }
+
+    const char* Name(const CatalogRecord& record) const
+    {
+        return reinterpret_cast<const char*>(data.Data() + record.nameOffset);
+    }
+
+    const uint8_t* Extra(const CatalogRecord& record) const { return data.Data() + record.extraOffset; }
+
+    // Appends a capture (label, dimensions, hashes and size from fields) and
+    // returns its record number, or -1 if the logs cannot grow. A live capture
+    // of the same name is replaced. A timestamp of 0 means now; earlier
+    // timestamps than the last record's are raised to it.
+    int64_t Append(const CatalogRecord& fields, const char* name, size_t nameLength, const uint8_t* extra,
+                   size_t extraLength)
+    {
+        if (!IsOpen() || nameLength == 0 || nameLength > UINT32_MAX) return -1;
+        const uint64_t dataEnd = IndexHeader()->dataEnd;
+        if (!Reserve(data, dataEnd + nameLength + extraLength) ||
+            !Reserve(index, kHeaderBytes + uint64_t(count + 1) * sizeof(CatalogRecord)))
+            return -1;
+
+        const int64_t existing = Find(name, nameLength);
+        if (existing >= 0) Remove(existing);
+
+        std::memcpy(data.Data() + dataEnd, name, nameLength);
+        if (extraLength > 0) std::memcpy(data.Data() + dataEnd + nameLength, extra, extraLength);
+
+        CatalogRecord record = fields;
+        record.magic = kRecordMagic;
+        record.flags &= kCatalogPerceptual;
+        record.timestampNs = std::max(fields.timestampNs > 0 ? fields.timestampNs : NowNs(), lastTimestampNs);
+        record.nameOffset = dataEnd;
+        record.nameLength = uint32_t(nameLength);
+        record.extraOffset = dataEnd + nameLength;
+        record.extraLength = extraLength;
+        record.label[kCatalogLabelBytes - 1] = '\0';
+        const size_t labelLength = std::strlen(record.label);
+        std::memset(record.label + labelLength, 0, kCatalogLabelBytes - labelLength);
+        std::memset(record.reserved, 0, sizeof(record.reserved));
+        std::memcpy(Records() + count, &record, sizeof(record));
+
+        // Commit: the data first, then the record count
+        IndexHeader()->dataEnd = dataEnd + nameLength + extraLength;
+        IndexHeader()->count = uint64_t(count + 1);
+        Track(count++);
+        return count - 1;
+    }
+
+    // Record number of the live capture with this name, or -1
+    int64_t Find(const char* name, size_t nameLength) const
+    {
+        auto it = byName.find(std::string(name, nameLength));
+        return it == byName.end() ? -1 : it->second;
+    }
+
+    // Replaces the JSON metadata of a live capture
+    bool SetExtra(int64_t i, const uint8_t* extra, size_t extraLength)
+    {
+        const CatalogRecord* record = Record(i);
+        if (!record || (record->flags & kCatalogRemoved)) return false;
+        const uint64_t dataEnd = IndexHeader()->dataEnd;
+        if (!Reserve(data, dataEnd + extraLength)) return false;
+        if (extraLength > 0) std::memcpy(data.Data() + dataEnd, extra, extraLength);
+        IndexHeader()->dataEnd = dataEnd + extraLength;
+        CatalogRecord& target = Records()[i];
+        target.extraLength = 0;
+        target.extraOffset = dataEnd;
+        target.extraLength = extraLength;
+        return true;
+    }
+
+    // Flags a live capture as removed; false if it was not live
+    bool Remove(int64_t i)
+    {
+        const CatalogRecord* record = Record(i);
+        if (!record || (record->flags & kCatalogRemoved)) return false;
+        Records()[i].flags |= kCatalogRemoved;
+        auto it = byName.find(std::string(Name(*record), record->nameLength));
+        if (it != byName.end() && it->second == i) byName.erase(it);
+        liveByLabel[record->label]--;
+        live--;
+        removed++;
+        return true;
+    }
+
+    // Record number of the newest live capture with label (any label when
+    // empty) taken at or before beforeNs, or -1
+    int64_t Latest(const char* label, int64_t beforeNs) const
+    {
+        auto after = [&](int64_t i) { return Record(i)->timestampNs > beforeNs; };
+        if (!label || !*label) {
+            // The log itself is sorted by time
+            int64_t lo = firstLive, hi = count;
+            while (lo < hi) {
+                const int64_t mid = lo + (hi - lo) / 2;
+                if (after(mid)) hi = mid;
+                else lo = mid + 1;
+            }
+            for (int64_t i = lo - 1; i >= firstLive; i--)
+                if (!(Record(i)->flags & kCatalogRemoved)) return i;
+            return -1;
+        }
+        auto it = byLabel.find(LabelKey(label));
+        if (it == byLabel.end()) return -1;
+        const std::vector<int64_t>& records = it->second;
+        auto end = std::partition_point(records.begin(), records.end(), [&](int64_t i) { return !after(i); });
+        for (auto r = std::make_reverse_iterator(end); r != records.rend(); ++r)
+            if (!(Record(*r)->flags & kCatalogRemoved)) return *r;
+        return -1;
+    }
+
+    // Removes the oldest live captures until at most keep remain, calling
+    // pruned(record number) for each
+    template <typename F>
+    void Prune(int64_t keep, F&& pruned)
+    {
+        while (live > std::max<int64_t>(keep, 0)) {
+            while (Record(firstLive)->flags & kCatalogRemoved) firstLive++;
+            Remove(firstLive);
+            pruned(firstLive);
+        }
+    }
+
+    // Live captures with label (all when empty)
+    int64_t Count(const char* label) const
+    {
+        if (!label || !*label) return live;
+        auto it = liveByLabel.find(LabelKey(label));
+        return it == liveByLabel.end() ? 0 : it->second;
+    }
+
+    // Calls visit(record number) for every live capture with label (any when
+    // empty), newest or oldest first
+    template <typename F>
+    void List(const char* label, bool newestFirst, F&& visit) const
+    {
+        auto each = [&](int64_t i) {
+            if (!(Record(i)->flags & kCatalogRemoved)) visit(i);
+        };
+        if (!label || !*label) {
+            if (newestFirst) {
+                for (int64_t i = count - 1; i >= firstLive; i--) each(i);
+            } else {
+                for (int64_t i = firstLive; i < count; i++) each(i);
+            }
+            return;
+        }
+        auto it = byLabel.find(LabelKey(label));
+        if (it == byLabel.end()) return;
+        if (newestFirst) std::for_each(it->second.rbegin(), it->second.rend(), each);
+        else std::for_each(it->second.begin(), it->second.end(), each);
+    }
+
+    static int64_t NowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+private:
+    static constexpr uint64_t kHeaderBytes = 64;
+    static constexpr uint64_t kInitialRecords = 256;
+    static constexpr uint64_t kInitialDataBytes = 64 * 1024;
+
+    struct IndexLogHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t count;         // committed records
+        uint64_t dataEnd;       // bytes of the data log in use
+        uint64_t generation;    // must match the data log's
+        uint8_t reserved[32];
+    };
+
+    struct DataLogHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t generation;
+        uint8_t reserved[48];
+    };
+
+    static_assert(sizeof(IndexLogHeader) == kHeaderBytes && sizeof(DataLogHeader) == kHeaderBytes,
+                  "log headers are part of the log format");
+
+    IndexLogHeader* IndexHeader() const { return reinterpret_cast<IndexLogHeader*>(index.Data()); }
+    DataLogHeader* DataHeader() const { return reinterpret_cast<DataLogHeader*>(data.Data()); }
+    CatalogRecord* Records() const { return reinterpret_cast<CatalogRecord*>(index.Data() + kHeaderBytes); }
+
+    static std::string LabelKey(const char* label)
+    {
+        return std::string(label, strnlen(label, kCatalogLabelBytes - 1));
+    }
+
+    std::string IndexPath() const { return base + ".idx"; }
+    std::string DataPath() const { return base + ".dat"; }
+
+    static bool ReadHeader(const std::string& path, void* header)
+    {
+        std::FILE* f = std::fopen(path.c_str(), "rb");
+        if (!f) return false;
+        const bool ok = std::fread(header, kHeaderBytes, 1, f) == 1;
+        std::fclose(f);
+        return ok;
+    }
+
+    // Finishes or rolls back a compaction interrupted between its renames
+    void Recover()
+    {
+        std::error_code ec;
+        const std::string indexTmp = IndexPath() + ".tmp", dataTmp = DataPath() + ".tmp";
+        if (std::filesystem::exists(indexTmp, ec)) {
+            IndexLogHeader pending;
+            DataLogHeader current;
+            if (!std::filesystem::exists(dataTmp, ec) && ReadHeader(indexTmp, &pending) &&
+                ReadHeader(DataPath(), &current) && pending.magic == kIndexMagic && current.magic == kDataMagic &&
+                pending.generation == current.generation) {
+                // The data log was already replaced
+                std::filesystem::rename(indexTmp, IndexPath(), ec);
+                return;
+            }
+            std::filesystem::remove(indexTmp, ec);
+        }
+        std::filesystem::remove(dataTmp, ec);
+    }
+
+    bool OpenLogs(std::string& error)
+    {
+        if (!index.Open(IndexPath(), error) || !data.Open(DataPath(), error)) {
+            Close();
+            return false;
+        }
+        const IndexLogHeader* header = index.Size() >= kHeaderBytes ? IndexHeader() : nullptr;
+        const DataLogHeader* dataHeader = data.Size() >= kHeaderBytes ? DataHeader() : nullptr;
+        if (!header || !dataHeader || header->magic != kIndexMagic || header->version != kVersion ||
+            dataHeader->magic != kDataMagic || dataHeader->version != kVersion ||
+            header->generation != dataHeader->generation) {
+            // New, foreign or mismatched logs: start an empty catalog
+            const uint64_t generation = header && header->magic == kIndexMagic ? header->generation + 1 : 1;
+            if (!Initialize(generation)) {
+                error = "cannot size the catalog";
+                Close();
+                return false;
+            }
+        }
+        Scan();
+        return true;
+    }
+
+    bool Initialize(uint64_t generation)
+    {
+        if (!index.Resize(kHeaderBytes + kInitialRecords * sizeof(CatalogRecord)) || !index.Data() ||
+            !data.Resize(kInitialDataBytes) || !data.Data())
+            return false;
+        std::memset(index.Data(), 0, kHeaderBytes);
+        std::memset(data.Data(), 0, kHeaderBytes);
+        *DataHeader() = {kDataMagic, kVersion, generation, {}};
+        *IndexHeader() = {kIndexMagic, kVersion, 0, kHeaderBytes, generation, {}};
+        return true;
+    }
+
+    // Rebuilds the in-memory tables, cutting the log at the first bad record
+    void Scan()
+    {
+        const uint64_t capacity = (index.Size() - kHeaderBytes) / sizeof(CatalogRecord);
+        const uint64_t dataEnd = std::min(IndexHeader()->dataEnd, data.Size());
+        const uint64_t committed = std::min(IndexHeader()->count, capacity);
+        IndexHeader()->dataEnd = std::max(dataEnd, kHeaderBytes);
+        count = 0;
+        while (uint64_t(count) < committed) {
+            const CatalogRecord& record = Records()[count];
+            if (record.magic != kRecordMagic || record.nameLength == 0 || record.nameOffset < kHeaderBytes ||
+                record.nameOffset + record.nameLength > dataEnd || record.extraLength > dataEnd ||
+                record.extraOffset + record.extraLength > dataEnd || record.timestampNs < lastTimestampNs ||
+                record.label[kCatalogLabelBytes - 1] != '\0')
+                break;
+            Track(count++);
+        }
+        IndexHeader()->count = uint64_t(count);
+    }
+
+    // Files a committed record in the in-memory tables
+    void Track(int64_t i)
+    {
+        const CatalogRecord& record = Records()[i];
+        lastTimestampNs = record.timestampNs;
+        byLabel[record.label].push_back(i);
+        if (record.flags & kCatalogRemoved) {
+            removed++;
+            if (firstLive == i) firstLive = i + 1;
+            return;
+        }
+        const std::string name(Name(record), record.nameLength);
+        auto it = byName.find(name);
+        if (it != byName.end()) Remove(it->second);  // a replaced capture whose removal was not flushed
+        byName[name] = i;
+        liveByLabel[record.label]++;
+        live++;
+    }
+
+    // Grows a log geometrically to at least bytes
+    static bool Reserve(MappedFile& file, uint64_t bytes)
+    {
+        if (bytes <= file.Size()) return true;
+        return file.Resize(std::max(bytes, file.Size() * 2)) && file.Data();
+    }
+
+    // Rewrites both logs without the removed records
+    bool Compact(std::string& error)
+    {
+        const std::string indexTmp = IndexPath() + ".tmp", dataTmp = DataPath() + ".tmp";
+        const uint64_t generation = IndexHeader()->generation + 1;
+        std::FILE* dataOut = std::fopen(dataTmp.c_str(), "wb");
+        std::FILE* indexOut = dataOut ? std::fopen(indexTmp.c_str(), "wb") : nullptr;
+        bool ok = indexOut != nullptr;
+
+        const DataLogHeader dataHeader = {kDataMagic, kVersion, generation, {}};
+        IndexLogHeader indexHeader = {kIndexMagic, kVersion, uint64_t(live), kHeaderBytes, generation, {}};
+        ok = ok && std::fwrite(&dataHeader, sizeof(dataHeader), 1, dataOut) == 1 &&
+             std::fwrite(&indexHeader, sizeof(indexHeader), 1, indexOut) == 1;
+        for (int64_t i = firstLive; ok && i < count; i++) {
+            CatalogRecord record = Records()[i];
+            if (record.flags & kCatalogRemoved) continue;
+            ok = std::fwrite(data.Data() + record.nameOffset, record.nameLength, 1, dataOut) == 1 &&
+                 (record.extraLength == 0 ||
+                  std::fwrite(data.Data() + record.extraOffset, record.extraLength, 1, dataOut) == 1);
+            record.nameOffset = indexHeader.dataEnd;
+            record.extraOffset = indexHeader.dataEnd + record.nameLength;
+            indexHeader.dataEnd += record.nameLength + record.extraLength;
+            ok = ok && std::fwrite(&record, sizeof(record), 1, indexOut) == 1;
+        }
+        ok = ok && std::fseek(indexOut, 0, SEEK_SET) == 0 &&
+             std::fwrite(&indexHeader, sizeof(indexHeader), 1, indexOut) == 1;
+        if (indexOut && std::fclose(indexOut) != 0) ok = false;
+        if (dataOut && std::fclose(dataOut) != 0) ok = false;
+
+        std::error_code ec;
+        if (!ok) {
+            // Keep using the uncompacted logs
+            std::filesystem::remove(indexTmp, ec);
+            std::filesystem::remove(dataTmp, ec);
+            return true;
+        }
+        Close();
+        // The index goes last: until it is renamed, Recover() can roll back
+        std::filesystem::rename(dataTmp, DataPath(), ec);
+        if (!ec) std::filesystem::rename(indexTmp, IndexPath(), ec);
+        Recover();
+        return OpenLogs(error);
+    }
+
+    std::string base;
+    MappedFile index;
+    MappedFile data;
+    int64_t count = 0;
+    int64_t live = 0;
+    int64_t removed = 0;
+    int64_t firstLive = 0;          // every record before it is removed
+    int64_t lastTimestampNs = 0;
+    std::unordered_map<std::string, int64_t> byName;                 // live captures
+    std::unordered_map<std::string, std::vector<int64_t>> byLabel;   // all records, in log order
+    std::unordered_map<std::string, int64_t> liveByLabel;
+};
+
+} // namespace ux::native
@@ -0,0 +1,323 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "native/image_diff.h"
+#include "ux_game/simd_fill.h"
+
+// Per-box colour profiles for UIElementDetector._analyze_colors.
+//
+// A profile needs only integer moments of the box: pixel count, colour sums
+// and luma sum / sum of squares, plus the same moments of the box's border
+// ring. Those come either from a direct SIMD walk over each box or, when the
+// boxes cover the frame several times over (MSER text candidates overlap
+// heavily), from integral images built once over the rectangle that holds
+// all boxes, after which every box costs four lookups. The integral colour
+// and luma sums are kept modulo 2^32: differences of wrapped prefix sums are
+// exact as long as a single box sums to less than 2^32, which holds up to
+// 16 million pixels. Both ways produce the same integers.
+//
+// Foreground/background: the ring is taken as background (colour Cb, luma
+// Lb). Treating the box as background plus a single foreground colour
+// covering a share p, its luma mean m and variance v give
+//   d = m - Lb,  p = d^2 / (v + d^2),  Lf = Lb + d / p,  Cf = Cb + (C - Cb) / p
+// (two-level mixture moments), clamped to the byte range.
+namespace ux::native {
+
+struct BoxMoments {
+    uint64_t pixels = 0;
+    uint64_t colour[3] = {};
+    uint64_t luma = 0, lumaSquared = 0;
+
+    void Add(const BoxMoments& o, int64_t sign = 1)
+    {
+        pixels += uint64_t(sign) * o.pixels;
+        for (int c = 0; c < 3; c++) colour[c] += uint64_t(sign) * o.colour[c];
+        luma += uint64_t(sign) * o.luma;
+        lumaSquared += uint64_t(sign) * o.lumaSquared;
+    }
+};
+
+struct ColourProfile {
+    float meanColour[3];        // byte order
+    float lumaMean, lumaStd;
+    float background[3];
+    float backgroundLuma;
+    float foreground[3];
+    float foregroundLuma;
+    float foregroundShare;
+};
+
+struct Box {
+    int32_t x, y, width, height;
+};
+
+namespace detail {
+
+inline void BoxRowScalar(const uint8_t* p, int32_t n, int32_t channels, const LumaWeights& w, BoxMoments& m)
+{
+    for (int32_t x = 0; x < n; x++, p += channels) {
+        const uint32_t l = uint32_t(Luma(p, w));
+        for (int c = 0; c < 3; c++) m.colour[c] += p[c];
+        m.luma += l;
+        m.lumaSquared += l * l;
+    }
+    m.pixels += uint64_t(std::max(n, 0));
+}
+
+#if UX_SIMD_X86
+// Eight pixels per step: colour bytes summed with SAD against zero (64-bit
+// lanes), luma and its square in 32-bit lanes (< 2^25 per lane for up to
+// 8 * 512 pixels, flushed per block). Returns the first pixel not covered.
+template <int Channels>
+UX_TARGET_AVX2 inline int32_t BoxRowAVX2(const uint8_t* p, int32_t n, const LumaWeights& w, BoxMoments& m)
+{
+    const __m256i w02 = _mm256_set1_epi32(w.w0 | w.w2 << 16);
+    const __m256i w1 = _mm256_set1_epi32(w.w1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i byte0 = _mm256_set1_epi32(0xFF);
+    // 3-channel loads read 28 bytes for 8 pixels
+    const int32_t vectorEnd = Channels == 4 ? n - 8 : n - 10;
+
+    int32_t i = 0;
+    __m256i c0 = zero, c1 = zero, c2 = zero;
+    while (i <= vectorEnd) {
+        __m256i l = zero, sq = zero;
+        const int32_t blockEnd = std::min(vectorEnd, i + 8 * 511);
+        for (; i <= blockEnd; i += 8) {
+            const __m256i px = LoadPixelsAVX2<Channels>(p + size_t(i) * Channels);
+            const __m256i y = LumaAVX2(px, w02, w1);
+            l = _mm256_add_epi32(l, y);
+            sq = _mm256_add_epi32(sq, _mm256_madd_epi16(y, y));
+            c0 = _mm256_add_epi64(c0, _mm256_sad_epu8(_mm256_and_si256(px, byte0), zero));
+            c1 = _mm256_add_epi64(c1, _mm256_sad_epu8(_mm256_and_si256(_mm256_srli_epi32(px, 8), byte0), zero));
+            c2 = _mm256_add_epi64(c2, _mm256_sad_epu8(_mm256_and_si256(_mm256_srli_epi32(px, 16), byte0), zero));
+        }
+        alignas(32) uint32_t lumaLanes[8], squareLanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lumaLanes), l);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(squareLanes), sq);
+        for (int k = 0; k < 8; k++) {
+            m.luma += lumaLanes[k];
+            m.lumaSquared += squareLanes[k];
+        }
+    }
+    alignas(32) uint64_t lanes[3][4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[0]), c0);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[1]), c1);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[2]), c2);
+    for (int c = 0; c < 3; c++) m.colour[c] += lanes[c][0] + lanes[c][1] + lanes[c][2] + lanes[c][3];
+    m.pixels += uint64_t(i);
+    return i;
+}
+#endif
+
+// Moments of n pixels of one row
+inline void BoxRow(const uint8_t* p, int32_t n, int32_t channels, const LumaWeights& w, BoxMoments& m)
+{
+    int32_t x = 0;
+#if UX_SIMD_X86
+    if (simd::ActiveLevel() == simd::Level::AVX2)
+        x = channels == 4 ? BoxRowAVX2<4>(p, n, w, m) : BoxRowAVX2<3>(p, n, w, m);
+#endif
+    BoxRowScalar(p + size_t(x) * channels, n - x, channels, w, m);
+}
+
+// Summed-area tables over rect: entry (x, y) holds the moments of
+// [rect.x, rect.x + x) x [rect.y, rect.y + y)
+class IntegralMoments {
+public:
+    IntegralMoments(const ImageView& img, const Box& rect)
+        : rect(rect), cols(size_t(rect.width) + 1), sums(cols * (size_t(rect.height) + 1)),
+          squares(sums.size())
+    {
+        const LumaWeights w(img.bgr);
+        for (int32_t y = 0; y < rect.height; y++) {
+            const uint8_t* p = img.Row(rect.y + y) + size_t(rect.x) * img.channels;
+            const Sums* above = &sums[size_t(y) * cols];
+            Sums* row = &sums[size_t(y + 1) * cols];
+            const uint64_t* aboveSq = &squares[size_t(y) * cols];
+            uint64_t* rowSq = &squares[size_t(y + 1) * cols];
+            Sums run{};
+            uint64_t runSq = 0;
+            for (int32_t x = 0; x < rect.width; x++, p += img.channels) {
+                const uint32_t l = uint32_t(Luma(p, w));
+                run.v[0] += p[0];
+                run.v[1] += p[1];
+                run.v[2] += p[2];
+                run.v[3] += l;
+                runSq += l * l;
+                for (int c = 0; c < 4; c++) row[x + 1].v[c] = above[x + 1].v[c] + run.v[c];
+                rowSq[x + 1] = aboveSq[x + 1] + runSq;
+            }
+        }
+    }
+
+    // Moments of a box inside rect (image coordinates)
+    BoxMoments Moments(const Box& b) const
+    {
+        const size_t x0 = size_t(b.x - rect.x), y0 = size_t(b.y - rect.y);
+        const size_t x1 = x0 + size_t(b.width), y1 = y0 + size_t(b.height);
+        const size_t a = y0 * cols + x0, bb = y0 * cols + x1, c = y1 * cols + x0, d = y1 * cols + x1;
+        BoxMoments m;
+        m.pixels = uint64_t(b.width) * uint64_t(b.height);
+        for (int k = 0; k < 3; k++) m.colour[k] = uint32_t(sums[d].v[k] - sums[bb].v[k] - sums[c].v[k] + sums[a].v[k]);
+        m.luma = uint32_t(sums[d].v[3] - sums[bb].v[3] - sums[c].v[3] + sums[a].v[3]);
+        m.lumaSquared = squares[d] - squares[bb] - squares[c] + squares[a];
+        return m;
+    }
+
+private:
+    struct Sums {
+        uint32_t v[4];  // colour bytes and luma, modulo 2^32
+    };
+
+    Box rect;
+    size_t cols;
+    std::vector<Sums> sums;
+    std::vector<uint64_t> squares;
+};
+
+// Border ring width of a box; boxes too small for an interior are all ring
+inline int32_t RingWidth(const Box& b)
+{
+    return std::max(1, std::min(b.width, b.height) / 8);
+}
+
+inline Box Interior(const Box& b)
+{
+    const int32_t r = RingWidth(b);
+    if (b.width <= 2 * r || b.height <= 2 * r) return {b.x, b.y, 0, 0};
+    return {b.x + r, b.y + r, b.width - 2 * r, b.height - 2 * r};
+}
+
+inline BoxMoments ScanMoments(const ImageView& img, const Box& b)
+{
+    const LumaWeights w(img.bgr);
+    BoxMoments m;
+    for (int32_t y = b.y; y < b.y + b.height; y++)
+        BoxRow(img.Row(y) + size_t(b.x) * img.channels, b.width, img.channels, w, m);
+    return m;
+}
+
+// Walks a box once, splitting its moments into the border ring and the interior
+inline void ScanRing(const ImageView& img, const Box& b, BoxMoments& ring, BoxMoments& inner)
+{
+    const Box in = Interior(b);
+    if (in.width == 0) {
+        ring = ScanMoments(img, b);
+        return;
+    }
+    const LumaWeights w(img.bgr);
+    const int32_t r = in.x - b.x;
+    for (int32_t y = b.y; y < b.y + b.height; y++) {
+        const uint8_t* row = img.Row(y) + size_t(b.x) * img.channels;
+        if (y < in.y || y >= in.y + in.height) {
+            BoxRow(row, b.width, img.channels, w, ring);
+            continue;
+        }
+        BoxRow(row, r, img.channels, w, ring);
+        BoxRow(row + size_t(r) * img.channels, in.width, img.channels, w, inner);
+        BoxRow(row + size_t(r + in.width) * img.channels, b.width - r - in.width, img.channels, w, ring);
+    }
+}
+
+inline float ToByte(double v)
+{
+    return float(std::min(255.0, std::max(0.0, v)));
+}
+
+inline ColourProfile ProfileFromMoments(const BoxMoments& box, const BoxMoments& ring)
+{
+    ColourProfile p{};
+    if (box.pixels == 0) return p;
+    const double n = double(box.pixels), rn = double(std::max<uint64_t>(ring.pixels, 1));
+    const double mean = box.luma / n;
+    const double variance = std::max(0.0, box.lumaSquared / n - mean * mean);
+    p.lumaMean = float(mean);
+    p.lumaStd = float(std::sqrt(variance));
+    p.backgroundLuma = float(ring.luma / rn);
+    for (int c = 0; c < 3; c++) {
+        p.meanColour[c] = float(box.colour[c] / n);
+        p.background[c] = float(ring.colour[c] / rn);
+    }
+
+    const double d = mean - ring.luma / rn;
+    const double share = variance + d * d > 0.0 ? d * d / (variance + d * d) : 0.0;
+    if (share < 0.01) {
+        // No distinguishable foreground
+        std::copy(p.meanColour, p.meanColour + 3, p.foreground);
+        p.foregroundLuma = p.lumaMean;
+        p.foregroundShare = 0.0f;
+        return p;
+    }
+    p.foregroundShare = float(share);
+    p.foregroundLuma = ToByte(ring.luma / rn + d / share);
+    for (int c = 0; c < 3; c++)
+        p.foreground[c] = ToByte(ring.colour[c] / rn + (box.colour[c] / n - ring.colour[c] / rn) / share);
+    return p;
+}
+
+} // namespace detail
+
+// Clips a box to the frame (as numpy slicing does for the far edges)
+inline Box ClipBox(const Box& b, int32_t width, int32_t height)
+{
+    const int32_t x0 = std::clamp(b.x, 0, width), y0 = std::clamp(b.y, 0, height);
+    const int32_t x1 = std::clamp(int64_t(b.x) + std::max(b.width, 0), int64_t(x0), int64_t(width));
+    const int32_t y1 = std::clamp(int64_t(b.y) + std::max(b.height, 0), int64_t(y0), int64_t(height));
+    return {x0, y0, x1 - x0, y1 - y0};
+}
+
+// Profiles of count boxes. Integral images are built when the boxes cover
+// their bounding rectangle more than twice (counting rings), otherwise each
+// box is walked directly.
+inline void ColourProfiles(const ImageView& img, const Box* boxes, int32_t count, ColourProfile* out)
+{
+    std::vector<Box> clipped(size_t(std::max(count, 0)));
+    int32_t rx0 = img.width, ry0 = img.height, rx1 = 0, ry1 = 0;
+    uint64_t covered = 0;
+    for (int32_t i = 0; i < count; i++) {
+        const Box b = ClipBox(boxes[i], img.width, img.height);
+        clipped[i] = b;
+        if (b.width == 0 || b.height == 0) continue;
+        rx0 = std::min(rx0, b.x);
+        ry0 = std::min(ry0, b.y);
+        rx1 = std::max(rx1, b.x + b.width);
+        ry1 = std::max(ry1, b.y + b.height);
+        covered += 2 * uint64_t(b.width) * uint64_t(b.height);
+    }
+    const uint64_t rectArea = rx1 > rx0 ? uint64_t(rx1 - rx0) * uint64_t(ry1 - ry0) : 0;
+
+    if (rectArea && covered > 2 * rectArea) {
+        const detail::IntegralMoments integral(img, {rx0, ry0, rx1 - rx0, ry1 - ry0});
+        for (int32_t i = 0; i < count; i++) {
+            const Box& b = clipped[i];
+            if (b.width == 0 || b.height == 0) {
+                out[i] = {};
+                continue;
+            }
+            const BoxMoments box = integral.Moments(b);
+            BoxMoments ring = box;
+            ring.Add(integral.Moments(detail::Interior(b)), -1);
+            out[i] = detail::ProfileFromMoments(box, ring);
+        }
+        return;
+    }
+    for (int32_t i = 0; i < count; i++) {
+        const Box& b = clipped[i];
+        if (b.width == 0 || b.height == 0) {
+            out[i] = {};
+            continue;
+        }
+        BoxMoments ring, box;
+        detail::ScanRing(img, b, ring, box);
+        box.Add(ring);
+        out[i] = detail::ProfileFromMoments(box, ring);
+    }
+}
+
+} // namespace ux::native
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// 64-bit content hash of byte buffers (XXH64).
+//
+// Four independent multiply-rotate lanes consume 32 bytes per step, so
+// hashing a frame runs at memory bandwidth rather than at the speed of a
+// cryptographic digest. The value is stable across runs and platforms, which
+// lets the result cache (result_cache.h) persist keys derived from it. Input
+// is streamed, so strided frames hash row by row without a packed copy.
+namespace ux::native {
+
+class ContentHasher {
+public:
+    explicit ContentHasher(uint64_t seed = 0)
+        : lanes{seed + kPrime1 + kPrime2, seed + kPrime2, seed, seed - kPrime1}, seed(seed)
+    {
+    }
+
+    void Update(const uint8_t* data, size_t length)
+    {
+        total += length;
+        if (buffered + length < 32) {
+            std::memcpy(buffer + buffered, data, length);
+            buffered += length;
+            return;
+        }
+        if (buffered > 0) {
+            const size_t fill = 32 - buffered;
+            std::memcpy(buffer + buffered, data, fill);
+            Stripe(buffer);
+            data += fill;
+            length -= fill;
+            buffered = 0;
+        }
+        for (; length >= 32; data += 32, length -= 32) Stripe(data);
+        std::memcpy(buffer, data, length);
+        buffered = length;
+    }
+
+    uint64_t Digest() const
+    {
+        uint64_t h;
+        if (total >= 32) {
+            h = Rotl(lanes[0], 1) + Rotl(lanes[1], 7) + Rotl(lanes[2], 12) + Rotl(lanes[3], 18);
+            for (uint64_t lane : lanes) h = (h ^ Round(0, lane)) * kPrime1 + kPrime4;
+        } else {
+            h = seed + kPrime5;
+        }
+        h += total;
+
+        const uint8_t* p = buffer;
+        size_t length = buffered;
+        for (; length >= 8; p += 8, length -= 8) h = Rotl(h ^ Round(0, Load64(p)), 27) * kPrime1 + kPrime4;
+        if (length >= 4) {
+            h = Rotl(h ^ (uint64_t(Load32(p)) * kPrime1), 23) * kPrime2 + kPrime3;
+            p += 4;
+            length -= 4;
+        }
+        for (; length > 0; p++, length--) h = Rotl(h ^ (*p * kPrime5), 11) * kPrime1;
+
+        h ^= h >> 33;
+        h *= kPrime2;
+        h ^= h >> 29;
+        h *= kPrime3;
+        h ^= h >> 32;
+        return h;
+    }
+
+private:
+    static constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+    static constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+    static constexpr uint64_t kPrime3 = 0x165667B19E3779F9ull;
+    static constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ull;
+    static constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ull;
+
+    static uint64_t Rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+    static uint64_t Round(uint64_t acc, uint64_t input) { return Rotl(acc + input * kPrime2, 31) * kPrime1; }
+
+    // Little-endian loads (every supported target is little-endian)
+    static uint64_t Load64(const uint8_t* p)
+    {
+        uint64_t v;
+        std::memcpy(&v, p, 8);
+        return v;
+    }
+
+    static uint32_t Load32(const uint8_t* p)
+    {
+        uint32_t v;
+        std::memcpy(&v, p, 4);
+        return v;
+    }
+
+    void Stripe(const uint8_t* p)
+    {
+        for (int i = 0; i < 4; i++) lanes[i] = Round(lanes[i], Load64(p + 8 * i));
+    }
+
+    uint64_t lanes[4];
+    uint64_t seed;
+    uint64_t total = 0;
+    uint8_t buffer[32];
+    size_t buffered = 0;
+};
+
+inline uint64_t ContentHash(const void* data, size_t length, uint64_t seed = 0)
+{
+    ContentHasher hasher(seed);
+    hasher.Update(static_cast<const uint8_t*>(data), length);
+    return hasher.Digest();
+}
+
+} // namespace ux::native
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Hamming-radius index over 64-bit perceptual hashes (multi-index hashing).
+//
+// Each hash is split into four 16-bit chunks and filed in one table per
+// chunk. Two hashes within distance r agree to within r / 4 bits on at least
+// one chunk (pigeonhole), so a query probes every chunk value within that
+// radius in each table and verifies the candidates with a popcount. With
+// 10^6 uniformly spread hashes a bucket holds ~15 entries, so a radius-7
+// query checks a few hundred candidates instead of the whole store.
+namespace ux::native {
+
+class HashIndex {
+public:
+    static constexpr int kChunks = 4;
+    static constexpr int kChunkBits = 16;
+
+    HashIndex()
+    {
+        for (auto& table : heads) table.assign(size_t(1) << kChunkBits, kNone);
+    }
+
+    size_t Size() const { return byId.size(); }
+
+    // Adds (or re-files) an id
+    void Add(int64_t id, uint64_t hash)
+    {
+        Remove(id);
+        const uint32_t entry = uint32_t(hashes.size());
+        hashes.push_back(hash);
+        ids.push_back(id);
+        alive.push_back(1);
+        stamp.push_back(0);
+        for (int c = 0; c < kChunks; c++) {
+            uint32_t& head = heads[c][Chunk(hash, c)];
+            next[c].push_back(head);
+            head = entry;
+        }
+        byId[id] = entry;
+    }
+
+    // Removed entries stay in the chains as tombstones until Compact
+    bool Remove(int64_t id)
+    {
+        auto it = byId.find(id);
+        if (it == byId.end()) return false;
+        alive[it->second] = 0;
+        byId.erase(it);
+        if (hashes.size() > 1024 && byId.size() < hashes.size() / 2) Compact();
+        return true;
+    }
+
+    // Calls found(id, distance) for every entry within radius of hash
+    template <typename F>
+    void Query(uint64_t hash, int32_t radius, F&& found)
+    {
+        if (radius < 0) return;
+        if (++query == 0) {
+            std::fill(stamp.begin(), stamp.end(), 0u);
+            query = 1;
+        }
+        const int32_t chunkRadius = std::min(radius / kChunks, kChunkBits);
+        for (int c = 0; c < kChunks; c++) {
+            Probe(c, Chunk(hash, c), 0, chunkRadius, [&](uint32_t entry) {
+                if (!alive[entry] || stamp[entry] == query) return;
+                stamp[entry] = query;
+                const int32_t distance = __builtin_popcountll(hashes[entry] ^ hash);
+                if (distance <= radius) found(ids[entry], distance);
+            });
+        }
+    }
+
+private:
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    static uint32_t Chunk(uint64_t hash, int c) { return uint32_t(hash >> (c * kChunkBits)) & 0xFFFF; }
+
+    // Walks the chains of every chunk value that differs from value in at most
+    // `left` bits at positions >= bit
+    template <typename F>
+    void Probe(int c, uint32_t value, int bit, int32_t left, F&& visit)
+    {
+        for (uint32_t e = heads[c][value]; e != kNone; e = next[c][e]) visit(e);
+        if (left == 0) return;
+        for (int b = bit; b < kChunkBits; b++) Probe(c, value ^ (1u << b), b + 1, left - 1, visit);
+    }
+
+    // Rebuilds the tables from the live entries
+    void Compact()
+    {
+        std::vector<uint64_t> liveHashes;
+        std::vector<int64_t> liveIds;
+        for (size_t e = 0; e < hashes.size(); e++) {
+            if (!alive[e]) continue;
+            liveHashes.push_back(hashes[e]);
+            liveIds.push_back(ids[e]);
+        }
+        hashes.clear();
+        ids.clear();
+        alive.clear();
+        stamp.clear();
+        byId.clear();
+        for (int c = 0; c < kChunks; c++) {
+            heads[c].assign(heads[c].size(), kNone);
+            next[c].clear();
+        }
+        for (size_t i = 0; i < liveIds.size(); i++) Add(liveIds[i], liveHashes[i]);
+    }
+
+    std::vector<uint32_t> heads[kChunks];  // chunk value -> newest entry
+    std::vector<uint32_t> next[kChunks];   // entry -> older entry with the same chunk value
+    std::vector<uint64_t> hashes;
+    std::vector<int64_t> ids;
+    std::vector<uint8_t> alive;
+    std::vector<uint32_t> stamp;           // last query that visited the entry
+    uint32_t query = 0;
+    std::unordered_map<int64_t, uint32_t> byId;
+};
+
+} // namespace ux::native
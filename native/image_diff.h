@@ -0,0 +1,359 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include "ux_game/simd_fill.h"
+
+// Frame comparison kernels behind the analysis pipeline (src/analysis/native.py).
+//
+// Both frames are read straight from the caller's 3- or 4-channel buffers
+// (numpy arrays, any row stride). Each pixel is converted to luma, differenced
+// and thresholded in registers, and the changed count, squared error and
+// per-tile change counts are accumulated in the same pass. No grayscale or diff
+// image is materialized. Luma uses OpenCV's fixed-point BT.601 weights and
+// rounding, so the counts match the cv2.cvtColor/absdiff path exactly.
+namespace ux::native {
+
+constexpr int kLumaShift = 15;
+constexpr int32_t kLumaR = 9798, kLumaG = 19235, kLumaB = 3735;
+
+struct ImageView {
+    const uint8_t* data = nullptr;
+    int64_t stride = 0;     // bytes per row
+    int32_t width = 0, height = 0;
+    int32_t channels = 3;   // 3 or 4 (the fourth byte is ignored)
+    bool bgr = true;        // byte order of the colour channels
+
+    const uint8_t* Row(int32_t y) const { return data + y * stride; }
+};
+
+struct DiffStats {
+    uint64_t changed = 0;     // pixels whose luma differs by more than the threshold
+    uint64_t sumSquared = 0;  // sum of squared luma differences
+    uint64_t pixels = 0;
+};
+
+// Extent of the changed pixels in one tile, half-open; empty when x0 >= x1
+struct TileBounds {
+    int32_t x0, y0, x1, y1;
+};
+
+namespace detail {
+
+// Luma weights in byte order (first, second, third colour byte)
+struct LumaWeights {
+    int32_t w0, w1, w2;
+
+    explicit LumaWeights(bool bgr)
+        : w0(bgr ? kLumaB : kLumaR), w1(kLumaG), w2(bgr ? kLumaR : kLumaB) {}
+};
+
+inline int32_t Luma(const uint8_t* p, const LumaWeights& w)
+{
+    return (p[0] * w.w0 + p[1] * w.w1 + p[2] * w.w2 + (1 << (kLumaShift - 1))) >> kLumaShift;
+}
+
+// Changed-pixel count and squared error over n pixels of one row segment
+inline void DiffSpanScalar(const uint8_t* a, const uint8_t* b, int32_t n, int32_t channels,
+                           const LumaWeights& w, int32_t threshold, uint32_t& changed, uint64_t& sumSquared)
+{
+    for (int32_t i = 0; i < n; i++, a += channels, b += channels) {
+        const int32_t d = std::abs(Luma(a, w) - Luma(b, w));
+        changed += d > threshold;
+        sumSquared += uint64_t(d * d);
+    }
+}
+
+#if UX_SIMD_X86
+// Eight pixels as 32-bit lanes with the colour bytes in the low three bytes.
+// 3-channel rows are widened with one byte shuffle per 128-bit half, which
+// reads 4 bytes past the eighth pixel (the caller keeps that inside the row).
+template <int Channels>
+UX_TARGET_AVX2 inline __m256i LoadPixelsAVX2(const uint8_t* p)
+{
+    if constexpr (Channels == 4) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    } else {
+        const __m256i spread = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                                0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m256i raw = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12)), 1);
+        return _mm256_shuffle_epi8(raw, spread);
+    }
+}
+
+// Luma of eight pixels: bytes 0 and 2 and bytes 1 and 3 as 16-bit pairs, one
+// multiply-add each (the weight for byte 3 is zero)
+UX_TARGET_AVX2 inline __m256i LumaAVX2(__m256i px, __m256i w02, __m256i w1)
+{
+    const __m256i lowBytes = _mm256_set1_epi32(0x00FF00FF);
+    const __m256i even = _mm256_and_si256(px, lowBytes);
+    const __m256i odd = _mm256_and_si256(_mm256_srli_epi32(px, 8), lowBytes);
+    const __m256i sum = _mm256_add_epi32(_mm256_madd_epi16(even, w02), _mm256_madd_epi16(odd, w1));
+    return _mm256_srli_epi32(_mm256_add_epi32(sum, _mm256_set1_epi32(1 << (kLumaShift - 1))), kLumaShift);
+}
+
+template <int Channels>
+UX_TARGET_AVX2 inline void DiffSpanAVX2(const uint8_t* a, const uint8_t* b, int32_t n, const LumaWeights& w,
+                                        int32_t threshold, uint32_t& changed, uint64_t& sumSquared)
+{
+    const __m256i w02 = _mm256_set1_epi32(w.w0 | w.w2 << 16);
+    const __m256i w1 = _mm256_set1_epi32(w.w1);
+    const __m256i thr = _mm256_set1_epi32(threshold);
+    // 3-channel loads read 28 bytes for 8 pixels
+    const int32_t vectorEnd = Channels == 4 ? n - 8 : n - 10;
+
+    int32_t i = 0;
+    while (i <= vectorEnd) {
+        // Squared error stays in 32-bit lanes for at most 4096 steps (< 2^32)
+        __m256i sq = _mm256_setzero_si256();
+        const int32_t blockEnd = std::min(vectorEnd, i + 8 * 4095);
+        for (; i <= blockEnd; i += 8) {
+            const __m256i la = LumaAVX2(LoadPixelsAVX2<Channels>(a + size_t(i) * Channels), w02, w1);
+            const __m256i lb = LumaAVX2(LoadPixelsAVX2<Channels>(b + size_t(i) * Channels), w02, w1);
+            const __m256i d = _mm256_abs_epi32(_mm256_sub_epi32(la, lb));
+            changed += uint32_t(__builtin_popcount(
+                _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(d, thr)))));
+            sq = _mm256_add_epi32(sq, _mm256_madd_epi16(d, d));
+        }
+        alignas(32) uint32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sq);
+        for (uint32_t v : lanes) sumSquared += v;
+    }
+    DiffSpanScalar(a + size_t(i) * Channels, b + size_t(i) * Channels, n - i, Channels, w, threshold,
+                   changed, sumSquared);
+}
+#endif
+
+inline void DiffSpan(const uint8_t* a, const uint8_t* b, int32_t n, int32_t channels, const LumaWeights& w,
+                     int32_t threshold, uint32_t& changed, uint64_t& sumSquared)
+{
+#if UX_SIMD_X86
+    if (simd::ActiveLevel() == simd::Level::AVX2) {
+        if (channels == 4) DiffSpanAVX2<4>(a, b, n, w, threshold, changed, sumSquared);
+        else DiffSpanAVX2<3>(a, b, n, w, threshold, changed, sumSquared);
+        return;
+    }
+#endif
+    DiffSpanScalar(a, b, n, channels, w, threshold, changed, sumSquared);
+}
+
+// Per-span result of the colour comparison: changed count, first/last changed
+// pixel (-1 if none) and squared per-channel error
+struct ColourSpan {
+    uint32_t changed = 0;
+    int32_t first = -1, last = -1;
+    uint64_t sumSquared = 0;
+};
+
+// Diff overlay: the second frame at half brightness with changed pixels tinted
+// red. Written as packed 3-byte pixels in the frames' channel order.
+constexpr int32_t kOverlayTint = 128;
+
+inline void ColourDiffSpanScalar(const uint8_t* a, int32_t channelsA, const uint8_t* b, int32_t channelsB,
+                                 int32_t begin, int32_t n, const LumaWeights& w, int32_t threshold, ColourSpan& span,
+                                 uint8_t* overlay = nullptr, int32_t redIndex = 2)
+{
+    a += size_t(begin) * channelsA;
+    b += size_t(begin) * channelsB;
+    if (overlay) overlay += size_t(begin) * 3;
+    for (int32_t i = begin; i < n; i++, a += channelsA, b += channelsB) {
+        const uint8_t d[3] = {uint8_t(std::abs(a[0] - b[0])), uint8_t(std::abs(a[1] - b[1])),
+                              uint8_t(std::abs(a[2] - b[2]))};
+        span.sumSquared += uint32_t(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+        const bool changed = Luma(d, w) > threshold;
+        if (changed) {
+            span.changed++;
+            if (span.first < 0) span.first = i;
+            span.last = i;
+        }
+        if (overlay) {
+            for (int c = 0; c < 3; c++) overlay[c] = uint8_t(b[c] >> 1);
+            if (changed) overlay[redIndex] = uint8_t(overlay[redIndex] + kOverlayTint);
+            overlay += 3;
+        }
+    }
+}
+
+#if UX_SIMD_X86
+// Per-channel absolute difference of eight pixels, luma of that difference
+// (cvtColor(absdiff(a, b))) and the per-pixel sum of squared channel errors,
+// all in 32-bit lanes. Frames may mix 3- and 4-channel rows; the fourth byte
+// is masked off. With Overlay, the overlay pixels are packed back to 3 bytes
+// and stored 12 bytes per half; each store spills 4 bytes that the next one
+// overwrites, so the bound is the same as for 3-channel loads.
+template <int ChannelsA, int ChannelsB, bool Overlay>
+UX_TARGET_AVX2 inline void ColourDiffSpanAVX2(const uint8_t* a, const uint8_t* b, int32_t n, const LumaWeights& w,
+                                              int32_t threshold, ColourSpan& span, uint8_t* overlay, int32_t redIndex)
+{
+    const __m256i w02 = _mm256_set1_epi32(w.w0 | w.w2 << 16);
+    const __m256i w1 = _mm256_set1_epi32(w.w1);
+    const __m256i thr = _mm256_set1_epi32(threshold);
+    const __m256i colour = _mm256_set1_epi32(0x00FFFFFF);
+    const __m256i lowBytes = _mm256_set1_epi32(0x00FF00FF);
+    const __m256i halfMask = _mm256_set1_epi32(0x007F7F7F);
+    const __m256i tint = _mm256_set1_epi32(kOverlayTint << (8 * redIndex));
+    const __m256i pack = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                          0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    const int32_t vectorEnd = ChannelsA == 4 && ChannelsB == 4 && !Overlay ? n - 8 : n - 10;
+
+    int32_t i = 0;
+    while (i <= vectorEnd) {
+        // At most 3 * 255^2 per lane and step: 4096 steps stay below 2^32
+        __m256i sq = _mm256_setzero_si256();
+        const int32_t blockEnd = std::min(vectorEnd, i + 8 * 4095);
+        for (; i <= blockEnd; i += 8) {
+            const __m256i pa = LoadPixelsAVX2<ChannelsA>(a + size_t(i) * ChannelsA);
+            const __m256i pb = LoadPixelsAVX2<ChannelsB>(b + size_t(i) * ChannelsB);
+            const __m256i d = _mm256_and_si256(
+                _mm256_or_si256(_mm256_subs_epu8(pa, pb), _mm256_subs_epu8(pb, pa)), colour);
+            const __m256i even = _mm256_and_si256(d, lowBytes);
+            const __m256i odd = _mm256_and_si256(_mm256_srli_epi32(d, 8), lowBytes);
+            sq = _mm256_add_epi32(sq, _mm256_add_epi32(_mm256_madd_epi16(even, even), _mm256_madd_epi16(odd, odd)));
+            const __m256i changedLanes = _mm256_cmpgt_epi32(LumaAVX2(d, w02, w1), thr);
+            const uint32_t mask = uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(changedLanes)));
+            if (mask) {
+                span.changed += uint32_t(__builtin_popcount(mask));
+                if (span.first < 0) span.first = i + __builtin_ctz(mask);
+                span.last = i + 31 - __builtin_clz(mask);
+            }
+            if constexpr (Overlay) {
+                const __m256i dim = _mm256_and_si256(_mm256_srli_epi32(pb, 1), halfMask);
+                const __m256i px = _mm256_shuffle_epi8(
+                    _mm256_add_epi8(dim, _mm256_and_si256(tint, changedLanes)), pack);
+                uint8_t* o = overlay + size_t(i) * 3;
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(o), _mm256_castsi256_si128(px));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(o + 12), _mm256_extracti128_si256(px, 1));
+            }
+        }
+        alignas(32) uint32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sq);
+        for (uint32_t v : lanes) span.sumSquared += v;
+    }
+    ColourDiffSpanScalar(a, ChannelsA, b, ChannelsB, i, n, w, threshold, span, overlay, redIndex);
+}
+
+template <bool Overlay>
+UX_TARGET_AVX2 inline void ColourDiffSpanAVX2(const uint8_t* a, int32_t channelsA, const uint8_t* b,
+                                              int32_t channelsB, int32_t n, const LumaWeights& w, int32_t threshold,
+                                              ColourSpan& span, uint8_t* overlay, int32_t redIndex)
+{
+    if (channelsA == 4 && channelsB == 4)
+        ColourDiffSpanAVX2<4, 4, Overlay>(a, b, n, w, threshold, span, overlay, redIndex);
+    else if (channelsA == 4)
+        ColourDiffSpanAVX2<4, 3, Overlay>(a, b, n, w, threshold, span, overlay, redIndex);
+    else if (channelsB == 4)
+        ColourDiffSpanAVX2<3, 4, Overlay>(a, b, n, w, threshold, span, overlay, redIndex);
+    else
+        ColourDiffSpanAVX2<3, 3, Overlay>(a, b, n, w, threshold, span, overlay, redIndex);
+}
+#endif
+
+// overlay (optional) receives n packed 3-byte overlay pixels
+inline void ColourDiffSpan(const uint8_t* a, int32_t channelsA, const uint8_t* b, int32_t channelsB, int32_t n,
+                           const LumaWeights& w, int32_t threshold, ColourSpan& span, uint8_t* overlay,
+                           int32_t redIndex)
+{
+#if UX_SIMD_X86
+    if (simd::ActiveLevel() == simd::Level::AVX2) {
+        if (overlay) ColourDiffSpanAVX2<true>(a, channelsA, b, channelsB, n, w, threshold, span, overlay, redIndex);
+        else ColourDiffSpanAVX2<false>(a, channelsA, b, channelsB, n, w, threshold, span, nullptr, redIndex);
+        return;
+    }
+#endif
+    ColourDiffSpanScalar(a, channelsA, b, channelsB, 0, n, w, threshold, span, overlay, redIndex);
+}
+
+} // namespace detail
+
+inline int32_t TileCount(int32_t size, int32_t tile)
+{
+    return tile > 0 ? (size + tile - 1) / tile : 1;
+}
+
+// Compares two frames of the same size and format. A pixel counts as changed
+// when its luma differs by more than threshold. tileChanged (optional) receives
+// the changed count of every tileW x tileH tile, row-major; a tile size <= 0
+// makes the whole frame one tile along that axis.
+inline DiffStats DiffLuma(const ImageView& a, const ImageView& b, int32_t threshold, int32_t tileW, int32_t tileH,
+                          uint32_t* tileChanged)
+{
+    DiffStats stats;
+    const int32_t w = a.width, h = a.height;
+    const int32_t tilesX = TileCount(w, tileW), tilesY = TileCount(h, tileH);
+    const int32_t spanW = tileW > 0 ? tileW : w, spanH = tileH > 0 ? tileH : h;
+    if (tileChanged) std::fill(tileChanged, tileChanged + size_t(tilesX) * tilesY, 0u);
+
+    const detail::LumaWeights weights(a.bgr);
+    for (int32_t y = 0; y < h; y++) {
+        const uint8_t* ra = a.Row(y);
+        const uint8_t* rb = b.Row(y);
+        uint32_t* tileRow = tileChanged ? tileChanged + size_t(y / spanH) * tilesX : nullptr;
+        for (int32_t tx = 0; tx < tilesX; tx++) {
+            const int32_t x0 = tx * spanW, n = std::min(spanW, w - x0);
+            uint32_t changed = 0;
+            detail::DiffSpan(ra + size_t(x0) * a.channels, rb + size_t(x0) * b.channels, n, a.channels, weights,
+                             threshold, changed, stats.sumSquared);
+            stats.changed += changed;
+            if (tileRow) tileRow[tx] += changed;
+        }
+    }
+    stats.pixels = uint64_t(w) * uint64_t(h);
+    return stats;
+}
+
+// Compares two frames of the same size the way cvtColor(absdiff(a, b)) does:
+// a pixel counts as changed when the luma of its per-channel difference
+// exceeds threshold. sumSquared covers the three colour channels. The frames
+// may have different channel counts, so a baseline kept in a prepared
+// 4-channel layout compares directly against 3-channel captures. tileChanged
+// and tileBounds (both optional) receive per-tile changed counts and extents;
+// overlay (optional, 3 bytes per pixel, overlayStride bytes per row) receives
+// the diff overlay of b in the same pass.
+inline DiffStats DiffColour(const ImageView& a, const ImageView& b, int32_t threshold, int32_t tileW, int32_t tileH,
+                            uint32_t* tileChanged, TileBounds* tileBounds, uint8_t* overlay = nullptr,
+                            int64_t overlayStride = 0)
+{
+    DiffStats stats;
+    const int32_t w = a.width, h = a.height;
+    const int32_t tilesX = TileCount(w, tileW), tilesY = TileCount(h, tileH);
+    const int32_t spanW = tileW > 0 ? tileW : w, spanH = tileH > 0 ? tileH : h;
+    const size_t tiles = size_t(tilesX) * tilesY;
+    if (tileChanged) std::fill(tileChanged, tileChanged + tiles, 0u);
+    if (tileBounds) std::fill(tileBounds, tileBounds + tiles, TileBounds{w, h, 0, 0});
+
+    const detail::LumaWeights weights(a.bgr);
+    const int32_t redIndex = a.bgr ? 2 : 0;
+    for (int32_t y = 0; y < h; y++) {
+        const uint8_t* ra = a.Row(y);
+        const uint8_t* rb = b.Row(y);
+        uint8_t* ro = overlay ? overlay + y * overlayStride : nullptr;
+        const size_t tileRow = size_t(y / spanH) * tilesX;
+        for (int32_t tx = 0; tx < tilesX; tx++) {
+            const int32_t x0 = tx * spanW, n = std::min(spanW, w - x0);
+            detail::ColourSpan span;
+            detail::ColourDiffSpan(ra + size_t(x0) * a.channels, a.channels, rb + size_t(x0) * b.channels,
+                                   b.channels, n, weights, threshold, span, ro ? ro + size_t(x0) * 3 : nullptr,
+                                   redIndex);
+            stats.changed += span.changed;
+            stats.sumSquared += span.sumSquared;
+            if (!span.changed) continue;
+            if (tileChanged) tileChanged[tileRow + tx] += span.changed;
+            if (tileBounds) {
+                TileBounds& tb = tileBounds[tileRow + tx];
+                tb.x0 = std::min(tb.x0, x0 + span.first);
+                tb.x1 = std::max(tb.x1, x0 + span.last + 1);
+                tb.y0 = std::min(tb.y0, y);
+                tb.y1 = y + 1;
+            }
+        }
+    }
+    stats.pixels = uint64_t(w) * uint64_t(h);
+    return stats;
+}
+
+} // namespace ux::native
@@ -0,0 +1,999 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "native/image_diff.h"
+#include "ux_game/simd_fill.h"
+
+// In-memory PNG/JPEG encoding and base64 behind ContentValidator's vision API
+// requests (src/analysis/content_validation.py).
+//
+// Both encoders take packed RGB (area_resample.h) and split the image into
+// bands of rows that are compressed independently on the worker pool and
+// concatenated:
+//   - PNG: each row gets the filter (none, sub, up, average, Paeth) with the
+//     smallest sum of absolute residuals; each band is an LZ77 stream (hash
+//     chains, 32 KiB window, no matches across bands) in fixed-Huffman
+//     deflate blocks, closed with an empty stored block so the next band
+//     starts on a byte boundary (zlib's sync flush). The Adler-32 of the
+//     bands is combined, not recomputed.
+//   - JPEG: baseline, 4:2:0 YCbCr, the Annex K quantization tables scaled by
+//     quality, the standard Huffman tables and the AAN float DCT. Every band
+//     is one restart interval, ending with an RSTn marker.
+// Base64 is encoded 24 bytes per step with AVX2 (byte shuffle, two 16-bit
+// multiplies to spread 6-bit fields, and an offset lookup to ASCII).
+namespace ux::native {
+
+enum class ImageFormat : int32_t { Png = 0, Jpeg = 1 };
+
+struct EncodeOptions {
+    int32_t maxSize;    // longest side of the encoded image; 0 keeps the frame size
+    int32_t format;     // ImageFormat
+    int32_t quality;    // JPEG quality 1-100
+};
+
+constexpr int32_t kPngBandRows = 128;
+constexpr int32_t kJpegBandMcuRows = 4;     // 64 pixel rows
+constexpr size_t kBase64BandBytes = 3 << 16;
+
+namespace detail {
+
+// ---- Base64 ---------------------------------------------------------------
+
+constexpr char kBase64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+inline void Base64Scalar(const uint8_t* src, size_t n, char* dst)
+{
+    size_t i = 0;
+    for (; i + 3 <= n; i += 3, dst += 4) {
+        const uint32_t v = uint32_t(src[i]) << 16 | uint32_t(src[i + 1]) << 8 | src[i + 2];
+        dst[0] = kBase64Alphabet[v >> 18];
+        dst[1] = kBase64Alphabet[v >> 12 & 63];
+        dst[2] = kBase64Alphabet[v >> 6 & 63];
+        dst[3] = kBase64Alphabet[v & 63];
+    }
+    if (i < n) {
+        const uint32_t v = uint32_t(src[i]) << 16 | (i + 1 < n ? uint32_t(src[i + 1]) << 8 : 0);
+        dst[0] = kBase64Alphabet[v >> 18];
+        dst[1] = kBase64Alphabet[v >> 12 & 63];
+        dst[2] = i + 1 < n ? kBase64Alphabet[v >> 6 & 63] : '=';
+        dst[3] = '=';
+    }
+}
+
+#if UX_SIMD_X86
+// 24 input bytes per step, as 12 per 128-bit half; each half load reads 16
+// bytes, so the loop stops 4 bytes early. Returns the bytes consumed.
+UX_TARGET_AVX2 inline size_t Base64AVX2(const uint8_t* src, size_t n, char* dst)
+{
+    // Bytes (a, b, c) of each group into one 32-bit lane as b, a, c, b
+    const __m256i spread = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                            1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    // ASCII offset of each 6-bit value class: A-Z, a-z, 0-9, '+', '/'
+    const __m256i offsets = _mm256_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0,
+                                             65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+    size_t i = 0;
+    for (; i + 28 <= n; i += 24, dst += 32) {
+        const __m256i raw = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 12)), 1);
+        const __m256i in = _mm256_shuffle_epi8(raw, spread);
+        // Fields 1 and 3 shifted down, fields 0 and 2 shifted up, into bytes
+        const __m256i hi = _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0FC0FC00)),
+                                              _mm256_set1_epi32(0x04000040));
+        const __m256i lo = _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003F03F0)),
+                                              _mm256_set1_epi32(0x01000010));
+        const __m256i fields = _mm256_or_si256(hi, lo);
+        // Class index: 0 for 0-25, 1 for 26-51, 2-11 for 52-61, 12 for 62, 13 for 63
+        __m256i index = _mm256_subs_epu8(fields, _mm256_set1_epi8(51));
+        index = _mm256_sub_epi8(index, _mm256_cmpgt_epi8(fields, _mm256_set1_epi8(25)));
+        const __m256i ascii = _mm256_add_epi8(fields, _mm256_shuffle_epi8(offsets, index));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), ascii);
+    }
+    return i;
+}
+#endif
+
+// ---- PNG ------------------------------------------------------------------
+
+inline const std::array<uint32_t, 256>& CrcTable()
+{
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+    return table;
+}
+
+inline uint32_t Crc32(const uint8_t* p, size_t n, uint32_t crc = 0)
+{
+    const std::array<uint32_t, 256>& t = CrcTable();
+    crc = ~crc;
+    for (size_t i = 0; i < n; i++) crc = t[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+constexpr uint32_t kAdlerBase = 65521;
+
+inline uint32_t Adler32(const uint8_t* p, size_t n)
+{
+    uint32_t a = 1, b = 0;
+    while (n > 0) {
+        // Largest run whose sums cannot overflow before the reduction
+        const size_t run = std::min<size_t>(n, 5552);
+        for (size_t i = 0; i < run; i++) {
+            a += p[i];
+            b += a;
+        }
+        a %= kAdlerBase;
+        b %= kAdlerBase;
+        p += run;
+        n -= run;
+    }
+    return b << 16 | a;
+}
+
+// Adler-32 of the concatenation, given that of each part (zlib's adler32_combine)
+inline uint32_t Adler32Combine(uint32_t first, uint32_t second, size_t secondLength)
+{
+    const uint32_t rem = uint32_t(secondLength % kAdlerBase);
+    uint32_t a = first & 0xFFFF;
+    uint32_t b = uint32_t((uint64_t(rem) * a) % kAdlerBase);
+    a += (second & 0xFFFF) + kAdlerBase - 1;
+    b += (first >> 16) + (second >> 16) + kAdlerBase - rem;
+    if (a >= kAdlerBase) a -= kAdlerBase;
+    if (a >= kAdlerBase) a -= kAdlerBase;
+    if (b >= kAdlerBase * 2) b -= kAdlerBase * 2;
+    if (b >= kAdlerBase) b -= kAdlerBase;
+    return b << 16 | a;
+}
+
+inline uint8_t Paeth(int32_t a, int32_t b, int32_t c)
+{
+    const int32_t pa = std::abs(b - c), pb = std::abs(a - c), pc = std::abs(a + b - 2 * c);
+    return uint8_t(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+}
+
+constexpr int32_t kFilterCount = 5;  // none, sub, up, average, Paeth
+
+inline uint8_t Residual(int32_t filter, uint8_t x, uint8_t a, uint8_t b, uint8_t c)
+{
+    switch (filter) {
+    case 1: return uint8_t(x - a);
+    case 2: return uint8_t(x - b);
+    case 3: return uint8_t(x - ((a + b) >> 1));
+    case 4: return uint8_t(x - Paeth(a, b, c));
+    default: return x;
+    }
+}
+
+// Sums of absolute (signed) residuals of every filter over bytes
+// [begin, end) of a row with 3 bytes per pixel
+inline void FilterCostScalar(const uint8_t* row, const uint8_t* prev, int32_t begin, int32_t end,
+                             uint64_t cost[kFilterCount])
+{
+    for (int32_t i = begin; i < end; i++) {
+        const uint8_t a = i >= 3 ? row[i - 3] : 0, c = i >= 3 ? prev[i - 3] : 0;
+        for (int32_t f = 0; f < kFilterCount; f++) {
+            cost[f] += uint32_t(std::abs(int32_t(int8_t(Residual(f, row[i], a, prev[i], c)))));
+        }
+    }
+}
+
+inline void FilterWriteScalar(int32_t filter, const uint8_t* row, const uint8_t* prev, int32_t begin, int32_t end,
+                              uint8_t* out)
+{
+    for (int32_t i = begin; i < end; i++) {
+        out[i] = Residual(filter, row[i], i >= 3 ? row[i - 3] : 0, prev[i], i >= 3 ? prev[i - 3] : 0);
+    }
+}
+
+#if UX_SIMD_X86
+// Residuals of 32 bytes at i >= 3. Paeth picks its predictor in 16-bit lanes:
+// a where |b - c| is the smallest distance, else b where |a - c| is, else c.
+UX_TARGET_AVX2 inline __m256i ResidualAVX2(int32_t filter, const uint8_t* row, const uint8_t* prev, int32_t i)
+{
+    const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+    const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i - 3));
+    const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev + i));
+    switch (filter) {
+    case 1: return _mm256_sub_epi8(x, a);
+    case 2: return _mm256_sub_epi8(x, b);
+    case 3: {
+        // avg_epu8 rounds up; the filter rounds down
+        const __m256i odd = _mm256_and_si256(_mm256_xor_si256(a, b), _mm256_set1_epi8(1));
+        return _mm256_sub_epi8(x, _mm256_sub_epi8(_mm256_avg_epu8(a, b), odd));
+    }
+    case 4: {
+        const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev + i - 3));
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i half[2];
+        for (int k = 0; k < 2; k++) {
+            const __m256i a16 = k ? _mm256_unpackhi_epi8(a, zero) : _mm256_unpacklo_epi8(a, zero);
+            const __m256i b16 = k ? _mm256_unpackhi_epi8(b, zero) : _mm256_unpacklo_epi8(b, zero);
+            const __m256i c16 = k ? _mm256_unpackhi_epi8(c, zero) : _mm256_unpacklo_epi8(c, zero);
+            const __m256i bc = _mm256_sub_epi16(b16, c16), ac = _mm256_sub_epi16(a16, c16);
+            const __m256i pa = _mm256_abs_epi16(bc), pb = _mm256_abs_epi16(ac);
+            const __m256i pc = _mm256_abs_epi16(_mm256_add_epi16(bc, ac));
+            const __m256i smallest = _mm256_min_epi16(pa, _mm256_min_epi16(pb, pc));
+            __m256i pred = _mm256_blendv_epi8(c16, b16, _mm256_cmpeq_epi16(pb, smallest));
+            half[k] = _mm256_blendv_epi8(pred, a16, _mm256_cmpeq_epi16(pa, smallest));
+        }
+        return _mm256_sub_epi8(x, _mm256_packus_epi16(half[0], half[1]));
+    }
+    default: return x;
+    }
+}
+
+// Returns the first byte not covered
+UX_TARGET_AVX2 inline int32_t FilterCostAVX2(const uint8_t* row, const uint8_t* prev, int32_t n,
+                                             uint64_t cost[kFilterCount])
+{
+    __m256i sums[kFilterCount];
+    for (__m256i& v : sums) v = _mm256_setzero_si256();
+    int32_t i = 3;
+    for (; i + 32 <= n; i += 32) {
+        for (int32_t f = 0; f < kFilterCount; f++) {
+            const __m256i magnitude = _mm256_abs_epi8(ResidualAVX2(f, row, prev, i));
+            sums[f] = _mm256_add_epi64(sums[f], _mm256_sad_epu8(magnitude, _mm256_setzero_si256()));
+        }
+    }
+    for (int32_t f = 0; f < kFilterCount; f++) {
+        alignas(32) uint64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sums[f]);
+        cost[f] += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+    return i;
+}
+
+UX_TARGET_AVX2 inline int32_t FilterWriteAVX2(int32_t filter, const uint8_t* row, const uint8_t* prev, int32_t n,
+                                              uint8_t* out)
+{
+    int32_t i = 3;
+    for (; i + 32 <= n; i += 32) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), ResidualAVX2(filter, row, prev, i));
+    }
+    return i;
+}
+#endif
+
+// One filtered row (filter byte first) of n bytes with 3 bytes per pixel,
+// with the filter whose residuals have the smallest absolute sum (libpng's
+// heuristic); prev is null for the first row
+inline void FilterRow(const uint8_t* row, const uint8_t* prev, int32_t n, uint8_t* out)
+{
+    thread_local std::vector<uint8_t> zeros;
+    if (!prev) {
+        zeros.assign(size_t(n), 0);
+        prev = zeros.data();
+    }
+    uint64_t cost[kFilterCount] = {};
+    const int32_t head = std::min(n, 3);
+    FilterCostScalar(row, prev, 0, head, cost);
+    int32_t i = head;
+#if UX_SIMD_X86
+    const bool avx2 = simd::ActiveLevel() == simd::Level::AVX2;
+    if (avx2) i = std::max(i, FilterCostAVX2(row, prev, n, cost));
+#endif
+    FilterCostScalar(row, prev, i, n, cost);
+
+    const int32_t best = int32_t(std::min_element(cost, cost + kFilterCount) - cost);
+    out[0] = uint8_t(best);
+    FilterWriteScalar(best, row, prev, 0, head, out + 1);
+    i = head;
+#if UX_SIMD_X86
+    if (avx2) i = std::max(i, FilterWriteAVX2(best, row, prev, n, out + 1));
+#endif
+    FilterWriteScalar(best, row, prev, i, n, out + 1);
+}
+
+// LSB-first bit stream of deflate
+struct DeflateWriter {
+    std::vector<uint8_t>& out;
+    uint64_t bits = 0;
+    int32_t count = 0;
+
+    void Put(uint32_t value, int32_t n)
+    {
+        bits |= uint64_t(value) << count;
+        count += n;
+        while (count >= 8) {
+            out.push_back(uint8_t(bits));
+            bits >>= 8;
+            count -= 8;
+        }
+    }
+
+    void AlignByte()
+    {
+        if (count > 0) Put(0, 8 - count);
+    }
+};
+
+// Fixed-Huffman codes (RFC 1951 3.2.6), bit-reversed for the LSB-first stream
+struct FixedHuffman {
+    uint16_t literal[288];
+    uint8_t literalBits[288];
+    uint8_t distance[30];
+
+    FixedHuffman()
+    {
+        auto reverse = [](uint32_t code, int32_t n) {
+            uint32_t r = 0;
+            for (int32_t i = 0; i < n; i++) r |= (code >> i & 1) << (n - 1 - i);
+            return uint16_t(r);
+        };
+        for (int32_t s = 0; s < 288; s++) {
+            uint32_t code;
+            int32_t n;
+            if (s < 144) code = 0x30 + s, n = 8;
+            else if (s < 256) code = 0x190 + s - 144, n = 9;
+            else if (s < 280) code = s - 256, n = 7;
+            else code = 0xC0 + s - 280, n = 8;
+            literal[s] = reverse(code, n);
+            literalBits[s] = uint8_t(n);
+        }
+        for (int32_t d = 0; d < 30; d++) distance[d] = uint8_t(reverse(uint32_t(d), 5));
+    }
+};
+
+constexpr uint16_t kLengthBase[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                      31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr uint8_t kLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                      2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr uint16_t kDistanceBase[30] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+                                        193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+
+constexpr int32_t kMinMatch = 3, kMaxMatch = 258;
+constexpr int32_t kWindow = 32768;
+constexpr int32_t kHashBits = 15;
+constexpr int32_t kMaxChain = 8;    // candidates tried per position
+constexpr int32_t kMaxInsertLength = 64;
+
+inline void PutMatch(DeflateWriter& w, const FixedHuffman& h, int32_t length, int32_t distance)
+{
+    const int32_t lc = int32_t(std::upper_bound(kLengthBase, kLengthBase + 29, length) - kLengthBase) - 1;
+    w.Put(h.literal[257 + lc], h.literalBits[257 + lc]);
+    if (kLengthExtra[lc]) w.Put(uint32_t(length - kLengthBase[lc]), kLengthExtra[lc]);
+    const int32_t dc = int32_t(std::upper_bound(kDistanceBase, kDistanceBase + 30, distance) - kDistanceBase) - 1;
+    w.Put(h.distance[dc], 5);
+    if (dc >= 4) w.Put(uint32_t(distance - kDistanceBase[dc]), dc / 2 - 1);
+}
+
+// One fixed-Huffman block of n bytes; last closes the stream, otherwise an
+// empty stored block aligns it to a byte boundary
+inline void DeflateFixed(const uint8_t* data, size_t n, bool last, std::vector<uint8_t>& out)
+{
+    static const FixedHuffman huffman;
+    thread_local std::vector<int32_t> head, chain;
+    head.assign(size_t(1) << kHashBits, -1);
+    chain.resize(kWindow);
+    auto hash = [&](size_t i) {
+        const uint32_t v = uint32_t(data[i]) | uint32_t(data[i + 1]) << 8 | uint32_t(data[i + 2]) << 16;
+        return (v * 2654435761u) >> (32 - kHashBits);
+    };
+    auto insert = [&](size_t i) {
+        const uint32_t h = hash(i);
+        chain[i & (kWindow - 1)] = head[h];
+        head[h] = int32_t(i);
+    };
+
+    DeflateWriter w{out};
+    w.Put(last ? 3 : 2, 3);
+    size_t i = 0;
+    while (i < n) {
+        int32_t bestLength = 0, bestDistance = 0;
+        if (i + kMinMatch <= n) {
+            const int32_t limit = int32_t(std::min<size_t>(kMaxMatch, n - i));
+            int32_t candidate = head[hash(i)];
+            for (int32_t tries = 0; candidate >= 0 && tries < kMaxChain; tries++) {
+                const int32_t distance = int32_t(i) - candidate;
+                if (distance > kWindow - 1) break;
+                const uint8_t* a = data + i;
+                const uint8_t* b = data + candidate;
+                if (b[bestLength] == a[bestLength]) {
+                    int32_t length = 0;
+                    while (length < limit && a[length] == b[length]) length++;
+                    if (length > bestLength) {
+                        bestLength = length;
+                        bestDistance = distance;
+                        if (length == limit) break;
+                    }
+                }
+                candidate = chain[size_t(candidate) & (kWindow - 1)];
+            }
+            insert(i);
+        }
+        if (bestLength >= kMinMatch) {
+            PutMatch(w, huffman, bestLength, bestDistance);
+            const size_t end = i + size_t(bestLength);
+            if (bestLength <= kMaxInsertLength) {
+                for (i++; i < end; i++) {
+                    if (i + kMinMatch <= n) insert(i);
+                }
+            }
+            i = end;
+        } else {
+            w.Put(huffman.literal[data[i]], huffman.literalBits[data[i]]);
+            i++;
+        }
+    }
+    w.Put(huffman.literal[256], huffman.literalBits[256]);
+    if (!last) w.Put(0, 3);
+    w.AlignByte();
+    if (!last) {
+        const uint8_t sync[4] = {0x00, 0x00, 0xFF, 0xFF};
+        out.insert(out.end(), sync, sync + 4);
+    }
+}
+
+inline void PutBE32(std::vector<uint8_t>& out, uint32_t v)
+{
+    const uint8_t b[4] = {uint8_t(v >> 24), uint8_t(v >> 16), uint8_t(v >> 8), uint8_t(v)};
+    out.insert(out.end(), b, b + 4);
+}
+
+inline void PutBE16(std::vector<uint8_t>& out, uint32_t v)
+{
+    out.push_back(uint8_t(v >> 8));
+    out.push_back(uint8_t(v));
+}
+
+inline void PutChunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t n)
+{
+    PutBE32(out, uint32_t(n));
+    const size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    if (n > 0) out.insert(out.end(), data, data + n);
+    PutBE32(out, Crc32(out.data() + start, n + 4));
+}
+
+// ---- JPEG -----------------------------------------------------------------
+
+constexpr uint8_t kZigzag[64] = {0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,
+                                 12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6,  7,  14, 21, 28,
+                                 35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+                                 58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63};
+
+constexpr uint8_t kLumaQuant[64] = {16, 11, 10, 16, 24,  40,  51,  61,  12, 12, 14, 19, 26,  58,  60,  55,
+                                    14, 13, 16, 24, 40,  57,  69,  56,  14, 17, 22, 29, 51,  87,  80,  62,
+                                    18, 22, 37, 56, 68,  109, 103, 77,  24, 35, 55, 64, 81,  104, 113, 92,
+                                    49, 64, 78, 87, 103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99};
+
+constexpr uint8_t kChromaQuant[64] = {17, 18, 24, 47, 99, 99, 99, 99, 18, 21, 26, 66, 99, 99, 99, 99,
+                                      24, 26, 56, 99, 99, 99, 99, 99, 47, 66, 99, 99, 99, 99, 99, 99,
+                                      99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+                                      99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99};
+
+// Annex K.3 Huffman tables: code counts per length 1-16, then the symbols
+constexpr uint8_t kDcLumaBits[16] = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+constexpr uint8_t kDcChromaBits[16] = {0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0};
+constexpr uint8_t kDcSymbols[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+constexpr uint8_t kAcLumaBits[16] = {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7D};
+constexpr uint8_t kAcLumaSymbols[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07, 0x22, 0x71,
+    0x14, 0x32, 0x81, 0x91, 0xA1, 0x08, 0x23, 0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0, 0x24, 0x33, 0x62, 0x72,
+    0x82, 0x09, 0x0A, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x34, 0x35, 0x36, 0x37,
+    0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+    0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x83,
+    0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3,
+    0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3,
+    0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2,
+    0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA};
+constexpr uint8_t kAcChromaBits[16] = {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77};
+constexpr uint8_t kAcChromaSymbols[162] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71, 0x13, 0x22,
+    0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xA1, 0xB1, 0xC1, 0x09, 0x23, 0x33, 0x52, 0xF0, 0x15, 0x62, 0x72, 0xD1,
+    0x0A, 0x16, 0x24, 0x34, 0xE1, 0x25, 0xF1, 0x17, 0x18, 0x19, 0x1A, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x35, 0x36,
+    0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58,
+    0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A,
+    0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A,
+    0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA,
+    0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA,
+    0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA};
+
+// AAN DCT output scale per frequency
+constexpr float kAanScale[8] = {1.0f, 1.387039845f, 1.306562965f, 1.175875602f,
+                                1.0f, 0.785694958f, 0.541196100f, 0.275899379f};
+
+struct HuffmanCode {
+    uint16_t code = 0;
+    uint8_t length = 0;
+};
+
+// Canonical codes of a table, indexed by symbol
+inline void BuildHuffman(const uint8_t bits[16], const uint8_t* symbols, HuffmanCode* codes)
+{
+    uint16_t code = 0;
+    int32_t k = 0;
+    for (int32_t length = 1; length <= 16; length++, code <<= 1) {
+        for (int32_t i = 0; i < bits[length - 1]; i++, k++, code++) codes[symbols[k]] = {code, uint8_t(length)};
+    }
+}
+
+} // namespace detail
+
+// Scaled quantization tables and Huffman codes of one quality
+struct JpegTables {
+    uint8_t quant[2][64];   // zigzag order, as written to DQT
+    float divisor[2][64];   // natural order reciprocals, AAN scale folded in
+    detail::HuffmanCode dc[2][12];
+    detail::HuffmanCode ac[2][256];
+
+    explicit JpegTables(int32_t quality)
+    {
+        quality = std::clamp(quality, 1, 100);
+        const int32_t scale = quality < 50 ? 5000 / quality : 200 - 2 * quality;
+        const uint8_t* base[2] = {detail::kLumaQuant, detail::kChromaQuant};
+        for (int t = 0; t < 2; t++) {
+            for (int32_t k = 0; k < 64; k++) {
+                const int32_t i = detail::kZigzag[k];
+                const int32_t q = std::clamp((base[t][i] * scale + 50) / 100, 1, 255);
+                quant[t][k] = uint8_t(q);
+                divisor[t][i] = 1.0f / (q * detail::kAanScale[i / 8] * detail::kAanScale[i % 8] * 8.0f);
+            }
+        }
+        detail::BuildHuffman(detail::kDcLumaBits, detail::kDcSymbols, dc[0]);
+        detail::BuildHuffman(detail::kDcChromaBits, detail::kDcSymbols, dc[1]);
+        detail::BuildHuffman(detail::kAcLumaBits, detail::kAcLumaSymbols, ac[0]);
+        detail::BuildHuffman(detail::kAcChromaBits, detail::kAcChromaSymbols, ac[1]);
+    }
+};
+
+namespace detail {
+
+// MSB-first bit stream with 0xFF byte stuffing
+struct JpegWriter {
+    std::vector<uint8_t>& out;
+    uint32_t bits = 0;
+    int32_t count = 0;
+
+    void Put(uint32_t value, int32_t n)
+    {
+        bits = bits << n | (value & ((1u << n) - 1));
+        count += n;
+        while (count >= 8) {
+            const uint8_t byte = uint8_t(bits >> (count - 8));
+            out.push_back(byte);
+            if (byte == 0xFF) out.push_back(0);
+            count -= 8;
+        }
+        bits &= (1u << count) - 1;
+    }
+
+    // Fills the last byte with one bits
+    void Pad()
+    {
+        if (count > 0) Put((1u << (8 - count)) - 1, 8 - count);
+    }
+};
+
+// jpeg_fdct_float on rows, then columns
+inline void ForwardDctScalar(float* d)
+{
+    for (int pass = 0; pass < 2; pass++) {
+        const int step = pass == 0 ? 1 : 8, next = pass == 0 ? 8 : 1;
+        for (int line = 0; line < 8; line++) {
+            float* p = d + line * next;
+            const float t0 = p[0] + p[7 * step], t7 = p[0] - p[7 * step];
+            const float t1 = p[step] + p[6 * step], t6 = p[step] - p[6 * step];
+            const float t2 = p[2 * step] + p[5 * step], t5 = p[2 * step] - p[5 * step];
+            const float t3 = p[3 * step] + p[4 * step], t4 = p[3 * step] - p[4 * step];
+
+            float t10 = t0 + t3, t13 = t0 - t3, t11 = t1 + t2, t12 = t1 - t2;
+            p[0] = t10 + t11;
+            p[4 * step] = t10 - t11;
+            const float z1 = (t12 + t13) * 0.707106781f;
+            p[2 * step] = t13 + z1;
+            p[6 * step] = t13 - z1;
+
+            t10 = t4 + t5;
+            t11 = t5 + t6;
+            t12 = t6 + t7;
+            const float z5 = (t10 - t12) * 0.382683433f;
+            const float z2 = 0.541196100f * t10 + z5;
+            const float z4 = 1.306562965f * t12 + z5;
+            const float z3 = t11 * 0.707106781f;
+            const float z11 = t7 + z3, z13 = t7 - z3;
+            p[5 * step] = z13 + z2;
+            p[3 * step] = z13 - z2;
+            p[step] = z11 + z4;
+            p[7 * step] = z11 - z4;
+        }
+    }
+}
+
+#if UX_SIMD_X86
+// The same butterfly on eight lines at once (one per lane)
+UX_TARGET_AVX2 inline void DctLinesAVX2(__m256 p[8])
+{
+    const __m256 t0 = _mm256_add_ps(p[0], p[7]), t7 = _mm256_sub_ps(p[0], p[7]);
+    const __m256 t1 = _mm256_add_ps(p[1], p[6]), t6 = _mm256_sub_ps(p[1], p[6]);
+    const __m256 t2 = _mm256_add_ps(p[2], p[5]), t5 = _mm256_sub_ps(p[2], p[5]);
+    const __m256 t3 = _mm256_add_ps(p[3], p[4]), t4 = _mm256_sub_ps(p[3], p[4]);
+
+    __m256 t10 = _mm256_add_ps(t0, t3), t13 = _mm256_sub_ps(t0, t3);
+    __m256 t11 = _mm256_add_ps(t1, t2), t12 = _mm256_sub_ps(t1, t2);
+    p[0] = _mm256_add_ps(t10, t11);
+    p[4] = _mm256_sub_ps(t10, t11);
+    const __m256 z1 = _mm256_mul_ps(_mm256_add_ps(t12, t13), _mm256_set1_ps(0.707106781f));
+    p[2] = _mm256_add_ps(t13, z1);
+    p[6] = _mm256_sub_ps(t13, z1);
+
+    t10 = _mm256_add_ps(t4, t5);
+    t11 = _mm256_add_ps(t5, t6);
+    t12 = _mm256_add_ps(t6, t7);
+    const __m256 z5 = _mm256_mul_ps(_mm256_sub_ps(t10, t12), _mm256_set1_ps(0.382683433f));
+    const __m256 z2 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(0.541196100f), t10), z5);
+    const __m256 z4 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(1.306562965f), t12), z5);
+    const __m256 z3 = _mm256_mul_ps(t11, _mm256_set1_ps(0.707106781f));
+    const __m256 z11 = _mm256_add_ps(t7, z3), z13 = _mm256_sub_ps(t7, z3);
+    p[5] = _mm256_add_ps(z13, z2);
+    p[3] = _mm256_sub_ps(z13, z2);
+    p[1] = _mm256_add_ps(z11, z4);
+    p[7] = _mm256_sub_ps(z11, z4);
+}
+
+UX_TARGET_AVX2 inline void Transpose8x8AVX2(__m256 r[8])
+{
+    __m256 t[8], u[8];
+    for (int k = 0; k < 8; k += 2) {
+        t[k] = _mm256_unpacklo_ps(r[k], r[k + 1]);
+        t[k + 1] = _mm256_unpackhi_ps(r[k], r[k + 1]);
+    }
+    for (int k = 0; k < 8; k += 4) {
+        u[k] = _mm256_shuffle_ps(t[k], t[k + 2], 0x44);
+        u[k + 1] = _mm256_shuffle_ps(t[k], t[k + 2], 0xEE);
+        u[k + 2] = _mm256_shuffle_ps(t[k + 1], t[k + 3], 0x44);
+        u[k + 3] = _mm256_shuffle_ps(t[k + 1], t[k + 3], 0xEE);
+    }
+    for (int k = 0; k < 4; k++) {
+        r[k] = _mm256_permute2f128_ps(u[k], u[k + 4], 0x20);
+        r[k + 4] = _mm256_permute2f128_ps(u[k], u[k + 4], 0x31);
+    }
+}
+
+// Rows, then columns, as in the scalar version (and with the same rounding);
+// the block is transposed so that each lane holds one row for the row pass
+UX_TARGET_AVX2 inline void ForwardDctAVX2(float* d)
+{
+    __m256 r[8];
+    for (int k = 0; k < 8; k++) r[k] = _mm256_loadu_ps(d + k * 8);
+    Transpose8x8AVX2(r);
+    DctLinesAVX2(r);
+    Transpose8x8AVX2(r);
+    DctLinesAVX2(r);
+    for (int k = 0; k < 8; k++) _mm256_storeu_ps(d + k * 8, r[k]);
+}
+#endif
+
+inline void ForwardDct(float* d)
+{
+#if UX_SIMD_X86
+    if (simd::ActiveLevel() == simd::Level::AVX2) {
+        ForwardDctAVX2(d);
+        return;
+    }
+#endif
+    ForwardDctScalar(d);
+}
+
+// Level-shifted Y and full-resolution Cb and Cr (JFIF) of pixels [begin, n)
+// of a packed RGB row
+inline void YccRowScalar(const uint8_t* p, int32_t begin, int32_t n, float* y, float* cb, float* cr)
+{
+    for (int32_t i = begin; i < n; i++) {
+        const float r = p[i * 3], g = p[i * 3 + 1], b = p[i * 3 + 2];
+        y[i] = 0.299f * r + 0.587f * g + 0.114f * b - 128.0f;
+        cb[i] = -0.168736f * r - 0.331264f * g + 0.5f * b;
+        cr[i] = 0.5f * r - 0.418688f * g - 0.081312f * b;
+    }
+}
+
+#if UX_SIMD_X86
+// Eight pixels per step through LoadPixelsAVX2 (image_diff.h), which reads 4
+// bytes past them. Returns the first pixel not converted.
+UX_TARGET_AVX2 inline int32_t YccRowAVX2(const uint8_t* p, int32_t n, float* y, float* cb, float* cr)
+{
+    const __m256i byte = _mm256_set1_epi32(0xFF);
+    const __m256 yr = _mm256_set1_ps(0.299f), yg = _mm256_set1_ps(0.587f), yb = _mm256_set1_ps(0.114f);
+    const __m256 cbr = _mm256_set1_ps(-0.168736f), cbg = _mm256_set1_ps(0.331264f), half = _mm256_set1_ps(0.5f);
+    const __m256 crg = _mm256_set1_ps(0.418688f), crb = _mm256_set1_ps(0.081312f), shift = _mm256_set1_ps(128.0f);
+    int32_t i = 0;
+    for (; i + 10 <= n; i += 8) {
+        const __m256i px = LoadPixelsAVX2<3>(p + size_t(i) * 3);
+        const __m256 r = _mm256_cvtepi32_ps(_mm256_and_si256(px, byte));
+        const __m256 g = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 8), byte));
+        const __m256 b = _mm256_cvtepi32_ps(_mm256_srli_epi32(px, 16));
+        const __m256 yv = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(yr, r), _mm256_mul_ps(yg, g)),
+                                        _mm256_mul_ps(yb, b));
+        _mm256_storeu_ps(y + i, _mm256_sub_ps(yv, shift));
+        const __m256 cbv = _mm256_sub_ps(_mm256_mul_ps(cbr, r), _mm256_mul_ps(cbg, g));
+        _mm256_storeu_ps(cb + i, _mm256_add_ps(cbv, _mm256_mul_ps(half, b)));
+        const __m256 crv = _mm256_sub_ps(_mm256_mul_ps(half, r), _mm256_mul_ps(crg, g));
+        _mm256_storeu_ps(cr + i, _mm256_sub_ps(crv, _mm256_mul_ps(crb, b)));
+    }
+    return i;
+}
+#endif
+
+inline void YccRow(const uint8_t* p, int32_t n, float* y, float* cb, float* cr)
+{
+    int32_t i = 0;
+#if UX_SIMD_X86
+    if (simd::ActiveLevel() == simd::Level::AVX2) i = YccRowAVX2(p, n, y, cb, cr);
+#endif
+    YccRowScalar(p, i, n, y, cb, cr);
+}
+
+inline int32_t BitLength(int32_t v)
+{
+    v = std::abs(v);
+    int32_t n = 0;
+    for (; v; v >>= 1) n++;
+    return n;
+}
+
+// One 8x8 block of level-shifted samples (natural order)
+inline void EncodeBlock(float* block, const JpegTables& tables, int32_t table, int32_t& dcPrediction, JpegWriter& w)
+{
+    ForwardDct(block);
+    int32_t q[64];
+    for (int32_t k = 0; k < 64; k++) {
+        const int32_t i = kZigzag[k];
+        const float v = block[i] * tables.divisor[table][i];
+        // AC values are coded in at most 10 bits
+        q[k] = std::clamp(int32_t(v + (v >= 0 ? 0.5f : -0.5f)), k ? -1023 : -2048, k ? 1023 : 2047);
+    }
+
+    auto putValue = [&](int32_t v, int32_t n) { w.Put(uint32_t(v >= 0 ? v : v - 1), n); };
+    const int32_t diff = q[0] - dcPrediction;
+    dcPrediction = q[0];
+    const int32_t dcBits = BitLength(diff);
+    w.Put(tables.dc[table][dcBits].code, tables.dc[table][dcBits].length);
+    if (dcBits) putValue(diff, dcBits);
+
+    const HuffmanCode* ac = tables.ac[table];
+    int32_t run = 0;
+    for (int32_t k = 1; k < 64; k++) {
+        if (q[k] == 0) {
+            run++;
+            continue;
+        }
+        for (; run >= 16; run -= 16) w.Put(ac[0xF0].code, ac[0xF0].length);
+        const int32_t n = BitLength(q[k]);
+        const HuffmanCode& c = ac[run << 4 | n];
+        w.Put(c.code, c.length);
+        putValue(q[k], n);
+        run = 0;
+    }
+    if (run > 0) w.Put(ac[0x00].code, ac[0x00].length);
+}
+
+inline void PutMarker(std::vector<uint8_t>& out, uint8_t marker, uint32_t length)
+{
+    out.push_back(0xFF);
+    out.push_back(marker);
+    if (length) PutBE16(out, length);
+}
+
+inline void PutHuffmanTable(std::vector<uint8_t>& out, uint8_t id, const uint8_t bits[16], const uint8_t* symbols)
+{
+    out.push_back(id);
+    out.insert(out.end(), bits, bits + 16);
+    int32_t n = 0;
+    for (int32_t i = 0; i < 16; i++) n += bits[i];
+    out.insert(out.end(), symbols, symbols + n);
+}
+
+} // namespace detail
+
+// ---- Base64 ---------------------------------------------------------------
+
+inline size_t Base64Length(size_t n)
+{
+    return (n + 2) / 3 * 4;
+}
+
+inline size_t Base64BandCount(size_t n)
+{
+    return std::max<size_t>((n + kBase64BandBytes - 1) / kBase64BandBytes, 1);
+}
+
+// Base64 of bytes [band * kBase64BandBytes, ...) of src into the matching
+// part of dst (Base64Length(n) characters in all, '=' padded)
+inline void Base64Band(const uint8_t* src, size_t n, size_t band, char* dst)
+{
+    const size_t begin = band * kBase64BandBytes, end = std::min(n, begin + kBase64BandBytes);
+    if (begin >= end) return;
+    src += begin;
+    dst += begin / 3 * 4;
+    size_t i = 0;
+#if UX_SIMD_X86
+    if (simd::ActiveLevel() == simd::Level::AVX2) i = detail::Base64AVX2(src, end - begin, dst);
+#endif
+    detail::Base64Scalar(src + i, end - begin - i, dst + i / 3 * 4);
+}
+
+// ---- PNG ------------------------------------------------------------------
+
+inline int32_t PngBandCount(int32_t height)
+{
+    return (height + kPngBandRows - 1) / kPngBandRows;
+}
+
+// Filtered and deflated rows [band * kPngBandRows, ...) of a packed RGB
+// image; adler is the Adler-32 of the filtered bytes
+inline void PngBand(const uint8_t* rgb, int32_t width, int32_t height, int32_t band, std::vector<uint8_t>& out,
+                    uint32_t& adler, size_t& filteredSize)
+{
+    thread_local std::vector<uint8_t> filtered;
+    const int32_t y0 = band * kPngBandRows, y1 = std::min(height, y0 + kPngBandRows);
+    const size_t rowBytes = size_t(width) * 3;
+    filtered.resize((rowBytes + 1) * size_t(y1 - y0));
+    for (int32_t y = y0; y < y1; y++) {
+        const uint8_t* row = rgb + size_t(y) * rowBytes;
+        detail::FilterRow(row, y > 0 ? row - rowBytes : nullptr, int32_t(rowBytes),
+                          &filtered[(rowBytes + 1) * size_t(y - y0)]);
+    }
+    out.clear();
+    detail::DeflateFixed(filtered.data(), filtered.size(), y1 == height, out);
+    adler = detail::Adler32(filtered.data(), filtered.size());
+    filteredSize = filtered.size();
+}
+
+// The PNG file around the bands' deflate streams
+inline void AssemblePng(int32_t width, int32_t height, const std::vector<std::vector<uint8_t>>& bands,
+                        const std::vector<uint32_t>& adlers, const std::vector<size_t>& sizes,
+                        std::vector<uint8_t>& out)
+{
+    const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    out.assign(signature, signature + 8);
+
+    std::vector<uint8_t> header;
+    detail::PutBE32(header, uint32_t(width));
+    detail::PutBE32(header, uint32_t(height));
+    const uint8_t format[5] = {8, 2, 0, 0, 0};  // 8-bit RGB, deflate, adaptive filters, no interlace
+    header.insert(header.end(), format, format + 5);
+    detail::PutChunk(out, "IHDR", header.data(), header.size());
+
+    // One IDAT: zlib header, the bands, Adler-32 of everything filtered
+    size_t length = 2 + 4;
+    for (const std::vector<uint8_t>& b : bands) length += b.size();
+    detail::PutBE32(out, uint32_t(length));
+    const size_t start = out.size();
+    const uint8_t idat[6] = {'I', 'D', 'A', 'T', 0x78, 0x01};
+    out.insert(out.end(), idat, idat + 6);
+    uint32_t adler = 1;
+    for (size_t i = 0; i < bands.size(); i++) {
+        out.insert(out.end(), bands[i].begin(), bands[i].end());
+        adler = detail::Adler32Combine(adler, adlers[i], sizes[i]);
+    }
+    detail::PutBE32(out, adler);
+    detail::PutBE32(out, detail::Crc32(out.data() + start, out.size() - start));
+    detail::PutChunk(out, "IEND", nullptr, 0);
+}
+
+// ---- JPEG -----------------------------------------------------------------
+
+inline int32_t JpegMcuRows(int32_t width)
+{
+    // A restart interval holds at most 65535 MCUs
+    const int32_t mcusPerRow = (width + 15) / 16;
+    return std::clamp(65535 / mcusPerRow, 1, kJpegBandMcuRows);
+}
+
+inline int32_t JpegBandCount(int32_t width, int32_t height)
+{
+    const int32_t rows = JpegMcuRows(width) * 16;
+    return (height + rows - 1) / rows;
+}
+
+// Entropy-coded data of one restart interval (band) of a packed RGB image,
+// followed by its RSTn marker unless it is the last. Each MCU row (16 pixel
+// rows, edges replicated to whole MCUs) is converted to a Y plane and 2x2
+// averaged Cb and Cr planes first, then cut into blocks.
+inline void JpegBand(const JpegTables& tables, const uint8_t* rgb, int32_t width, int32_t height,
+                     int32_t band, std::vector<uint8_t>& out)
+{
+    const int32_t rows = JpegMcuRows(width) * 16;
+    const int32_t y0 = band * rows, y1 = std::min(height, y0 + rows);
+    const int32_t pw = (width + 15) / 16 * 16, cw = pw / 2;
+    thread_local std::vector<float> luma, cb, cr, cbRows, crRows;
+    luma.resize(size_t(pw) * 16);
+    cb.resize(size_t(cw) * 8);
+    cr.resize(size_t(cw) * 8);
+    cbRows.resize(size_t(pw) * 2);
+    crRows.resize(size_t(pw) * 2);
+
+    out.clear();
+    detail::JpegWriter w{out};
+    int32_t dc[3] = {0, 0, 0};
+    float block[64];
+    auto encode = [&](const float* plane, int32_t planeWidth, int32_t x, int32_t y, int32_t table, int32_t& pred) {
+        for (int32_t r = 0; r < 8; r++) std::memcpy(block + r * 8, plane + size_t(y + r) * planeWidth + x, 32);
+        detail::EncodeBlock(block, tables, table, pred, w);
+    };
+    for (int32_t my = y0; my < y1; my += 16) {
+        for (int32_t py = 0; py < 16; py++) {
+            float* yRow = &luma[size_t(py) * pw];
+            float* cbRow = &cbRows[size_t(py % 2) * pw];
+            float* crRow = &crRows[size_t(py % 2) * pw];
+            detail::YccRow(rgb + size_t(std::min(my + py, height - 1)) * width * 3, width, yRow, cbRow, crRow);
+            std::fill(yRow + width, yRow + pw, yRow[width - 1]);
+            std::fill(cbRow + width, cbRow + pw, cbRow[width - 1]);
+            std::fill(crRow + width, crRow + pw, crRow[width - 1]);
+            if (py % 2 == 0) continue;
+            float* cbOut = &cb[size_t(py / 2) * cw];
+            float* crOut = &cr[size_t(py / 2) * cw];
+            for (int32_t x = 0; x < cw; x++) {
+                const int32_t a = 2 * x, b = pw + 2 * x;
+                cbOut[x] = 0.25f * (cbRows[a] + cbRows[a + 1] + cbRows[b] + cbRows[b + 1]);
+                crOut[x] = 0.25f * (crRows[a] + crRows[a + 1] + crRows[b] + crRows[b + 1]);
+            }
+        }
+        for (int32_t mx = 0; mx < pw; mx += 16) {
+            encode(luma.data(), pw, mx, 0, 0, dc[0]);
+            encode(luma.data(), pw, mx + 8, 0, 0, dc[0]);
+            encode(luma.data(), pw, mx, 8, 0, dc[0]);
+            encode(luma.data(), pw, mx + 8, 8, 0, dc[0]);
+            encode(cb.data(), cw, mx / 2, 0, 1, dc[1]);
+            encode(cr.data(), cw, mx / 2, 0, 1, dc[2]);
+        }
+    }
+    w.Pad();
+    if (y1 < height) detail::PutMarker(out, uint8_t(0xD0 + band % 8), 0);
+}
+
+// The JPEG file around the bands' entropy-coded data
+inline void AssembleJpeg(const JpegTables& tables, int32_t width, int32_t height,
+                         const std::vector<std::vector<uint8_t>>& bands, std::vector<uint8_t>& out)
+{
+    out.clear();
+    detail::PutMarker(out, 0xD8, 0);
+    detail::PutMarker(out, 0xE0, 16);
+    const uint8_t jfif[14] = {'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0};
+    out.insert(out.end(), jfif, jfif + 14);
+
+    detail::PutMarker(out, 0xDB, 2 + 2 * 65);
+    for (uint8_t t = 0; t < 2; t++) {
+        out.push_back(t);
+        out.insert(out.end(), tables.quant[t], tables.quant[t] + 64);
+    }
+
+    // Y sampled 2x2, Cb and Cr 1x1
+    detail::PutMarker(out, 0xC0, 17);
+    out.push_back(8);
+    detail::PutBE16(out, uint32_t(height));
+    detail::PutBE16(out, uint32_t(width));
+    const uint8_t components[10] = {3, 1, 0x22, 0, 2, 0x11, 1, 3, 0x11, 1};
+    out.insert(out.end(), components, components + 10);
+
+    detail::PutMarker(out, 0xC4, 2 + 2 * (17 + 12) + 2 * (17 + 162));
+    detail::PutHuffmanTable(out, 0x00, detail::kDcLumaBits, detail::kDcSymbols);
+    detail::PutHuffmanTable(out, 0x10, detail::kAcLumaBits, detail::kAcLumaSymbols);
+    detail::PutHuffmanTable(out, 0x01, detail::kDcChromaBits, detail::kDcSymbols);
+    detail::PutHuffmanTable(out, 0x11, detail::kAcChromaBits, detail::kAcChromaSymbols);
+
+    detail::PutMarker(out, 0xDD, 4);
+    detail::PutBE16(out, uint32_t(JpegMcuRows(width) * ((width + 15) / 16)));
+
+    detail::PutMarker(out, 0xDA, 12);
+    const uint8_t scan[10] = {3, 1, 0x00, 2, 0x11, 3, 0x11, 0, 63, 0};
+    out.insert(out.end(), scan, scan + 10);
+    for (const std::vector<uint8_t>& b : bands) out.insert(out.end(), b.begin(), b.end());
+    detail::PutMarker(out, 0xD9, 0);
+}
+
+} // namespace ux::native
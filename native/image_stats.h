@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "native/image_diff.h"
+#include "ux_game/simd_fill.h"
+
+// Whole-frame quality statistics behind VisualAnalyzer.check_visual_quality.
+//
+// One walk over the frame yields luma mean/variance, a 256-bin luma
+// histogram, an 8x8x8 colour histogram, Hasler-Suesstrunk colourfulness
+// moments and the variance of the 4-neighbour Laplacian of luma (the blur
+// metric). The frame is processed in bands of rows; each band keeps a rolling
+// window of three luma rows, so the Laplacian reads luma that is still in
+// cache and no grayscale image is materialized. Everything is accumulated as
+// integer sums, so the result does not depend on how bands are scheduled
+// across threads and is identical from run to run.
+namespace ux::native {
+
+constexpr int32_t kStatsBandRows = 32;
+
+struct ImageStats {
+    uint64_t pixels = 0;
+    uint64_t lumaSum = 0, lumaSumSquared = 0;
+    int64_t laplacianSum = 0;
+    uint64_t laplacianSumSquared = 0;
+    // Opponent channels rg = R - G and yb2 = R + G - 2B (twice the usual yb)
+    int64_t rgSum = 0, yb2Sum = 0;
+    uint64_t rgSumSquared = 0, yb2SumSquared = 0;
+    uint32_t lumaHistogram[256] = {};
+    // 8 bins per channel, index (c0 >> 5) << 6 | (c1 >> 5) << 3 | c2 >> 5 in byte order
+    uint32_t colourHistogram[512] = {};
+
+    void Merge(const ImageStats& o)
+    {
+        pixels += o.pixels;
+        lumaSum += o.lumaSum;
+        lumaSumSquared += o.lumaSumSquared;
+        laplacianSum += o.laplacianSum;
+        laplacianSumSquared += o.laplacianSumSquared;
+        rgSum += o.rgSum;
+        yb2Sum += o.yb2Sum;
+        rgSumSquared += o.rgSumSquared;
+        yb2SumSquared += o.yb2SumSquared;
+        for (int i = 0; i < 256; i++) lumaHistogram[i] += o.lumaHistogram[i];
+        for (int i = 0; i < 512; i++) colourHistogram[i] += o.colourHistogram[i];
+    }
+};
+
+namespace detail {
+
+// BORDER_REFLECT_101, as cv2.Laplacian uses: -1 -> 1, n -> n - 2
+inline int32_t Reflect101(int32_t i, int32_t n)
+{
+    if (n == 1) return 0;
+    if (i < 0) return -i;
+    if (i >= n) return 2 * n - 2 - i;
+    return i;
+}
+
+// Luma of one row into out, accumulating the per-pixel colour statistics
+inline void LumaRowStats(const uint8_t* p, int32_t width, int32_t channels, const LumaWeights& w, bool bgr,
+                         uint8_t* out, ImageStats& s)
+{
+    uint64_t lumaSum = 0, lumaSq = 0, rgSq = 0, ybSq = 0;
+    int64_t rgSum = 0, ybSum = 0;
+    for (int32_t x = 0; x < width; x++, p += channels) {
+        const int32_t y = Luma(p, w);
+        const int32_t r = bgr ? p[2] : p[0], g = p[1], b = bgr ? p[0] : p[2];
+        const int32_t rg = r - g, yb2 = r + g - 2 * b;
+        out[x] = uint8_t(y);
+        lumaSum += uint32_t(y);
+        lumaSq += uint32_t(y * y);
+        rgSum += rg;
+        ybSum += yb2;
+        rgSq += uint32_t(rg * rg);
+        ybSq += uint32_t(yb2 * yb2);
+        s.lumaHistogram[y]++;
+        s.colourHistogram[(p[0] >> 5) << 6 | (p[1] >> 5) << 3 | p[2] >> 5]++;
+    }
+    s.lumaSum += lumaSum;
+    s.lumaSumSquared += lumaSq;
+    s.rgSum += rgSum;
+    s.yb2Sum += ybSum;
+    s.rgSumSquared += rgSq;
+    s.yb2SumSquared += ybSq;
+}
+
+inline void LumaRow(const uint8_t* p, int32_t width, int32_t channels, const LumaWeights& w, uint8_t* out)
+{
+    for (int32_t x = 0; x < width; x++, p += channels) out[x] = uint8_t(Luma(p, w));
+}
+
+inline int32_t LaplacianAt(const uint8_t* up, const uint8_t* mid, const uint8_t* down, int32_t x, int32_t width)
+{
+    return up[x] + down[x] + mid[Reflect101(x - 1, width)] + mid[Reflect101(x + 1, width)] - 4 * mid[x];
+}
+
+inline void LaplacianRowScalar(const uint8_t* up, const uint8_t* mid, const uint8_t* down, int32_t begin,
+                               int32_t end, int32_t width, int64_t& sum, uint64_t& sumSquared)
+{
+    for (int32_t x = begin; x < end; x++) {
+        const int32_t lap = LaplacianAt(up, mid, down, x, width);
+        sum += lap;
+        sumSquared += uint32_t(lap * lap);
+    }
+}
+
+#if UX_SIMD_X86
+UX_TARGET_AVX2 inline __m256i LoadWidenAVX2(const uint8_t* p)
+{
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+
+// Interior pixels [1, width - 1) sixteen at a time as 16-bit lanes. A lane
+// of the squared sum gains at most 2 * 1020^2 per step, so the 32-bit
+// accumulators are flushed every 512 steps.
+UX_TARGET_AVX2 inline int32_t LaplacianRowAVX2(const uint8_t* up, const uint8_t* mid, const uint8_t* down,
+                                               int32_t width, int64_t& sum, uint64_t& sumSquared)
+{
+    const __m256i ones = _mm256_set1_epi16(1);
+    int32_t x = 1;
+    while (x + 17 <= width) {
+        __m256i s = _mm256_setzero_si256(), sq = _mm256_setzero_si256();
+        const int32_t blockEnd = std::min(width - 17, x + 16 * 511);
+        for (; x <= blockEnd; x += 16) {
+            const __m256i centre = LoadWidenAVX2(mid + x);
+            const __m256i around =
+                _mm256_add_epi16(_mm256_add_epi16(LoadWidenAVX2(up + x), LoadWidenAVX2(down + x)),
+                                 _mm256_add_epi16(LoadWidenAVX2(mid + x - 1), LoadWidenAVX2(mid + x + 1)));
+            const __m256i lap = _mm256_sub_epi16(around, _mm256_slli_epi16(centre, 2));
+            s = _mm256_add_epi32(s, _mm256_madd_epi16(lap, ones));
+            sq = _mm256_add_epi32(sq, _mm256_madd_epi16(lap, lap));
+        }
+        alignas(32) int32_t sums[8];
+        alignas(32) uint32_t squares[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(sums), s);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(squares), sq);
+        for (int i = 0; i < 8; i++) {
+            sum += sums[i];
+            sumSquared += squares[i];
+        }
+    }
+    return x;
+}
+#endif
+
+// Laplacian moments of one luma row given its neighbours
+inline void LaplacianRow(const uint8_t* up, const uint8_t* mid, const uint8_t* down, int32_t width, int64_t& sum,
+                         uint64_t& sumSquared)
+{
+    int32_t x = 0;
+#if UX_SIMD_X86
+    if (simd::ActiveLevel() == simd::Level::AVX2 && width > 2) {
+        LaplacianRowScalar(up, mid, down, 0, 1, width, sum, sumSquared);
+        x = LaplacianRowAVX2(up, mid, down, width, sum, sumSquared);
+    }
+#endif
+    LaplacianRowScalar(up, mid, down, x, width, width, sum, sumSquared);
+}
+
+} // namespace detail
+
+inline int32_t StatsBandCount(int32_t height)
+{
+    return (height + kStatsBandRows - 1) / kStatsBandRows;
+}
+
+// Statistics of rows [band * kStatsBandRows, ...) of the frame. Colour
+// statistics cover the band's own rows; the Laplacian of each of those rows
+// reads luma of the rows above and below (reflected at the frame edges), which
+// the band computes itself. luma is scratch space for three rows.
+inline void ImageStatsBand(const ImageView& img, int32_t band, std::vector<uint8_t>& luma, ImageStats& out)
+{
+    const int32_t w = img.width, h = img.height;
+    const int32_t y0 = band * kStatsBandRows, y1 = std::min(h, y0 + kStatsBandRows);
+    const detail::LumaWeights weights(img.bgr);
+    luma.resize(size_t(w) * 3);
+    auto slot = [&](int32_t y) { return luma.data() + size_t((y % 3 + 3) % 3) * w; };
+
+    // Rows of the band add colour statistics; neighbour rows outside it only luma
+    auto fillRow = [&](int32_t y) {
+        const uint8_t* row = img.Row(detail::Reflect101(y, h));
+        if (y >= y0 && y < y1) detail::LumaRowStats(row, w, img.channels, weights, img.bgr, slot(y), out);
+        else detail::LumaRow(row, w, img.channels, weights, slot(y));
+    };
+    fillRow(y0 - 1);
+    fillRow(y0);
+    for (int32_t y = y0; y < y1; y++) {
+        fillRow(y + 1);
+        detail::LaplacianRow(slot(y - 1), slot(y), slot(y + 1), w, out.laplacianSum, out.laplacianSumSquared);
+    }
+    out.pixels += uint64_t(y1 - y0) * uint64_t(w);
+}
+
+} // namespace ux::native
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// A read-write file mapped into memory, for the append-only logs of the
+// native stores (result_cache.h, capture_catalog.h).
+//
+// The file is opened exclusively: a second process opening the same log fails
+// instead of interleaving appends. Resize() grows or shrinks the file and maps
+// it again, so pointers into Data() are invalidated by it.
+namespace ux::native {
+
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { Close(); }
+
+    bool IsOpen() const { return open; }
+    uint8_t* Data() const { return data; }
+    uint64_t Size() const { return size; }
+
+    // Opens (creating if needed) path and maps its current contents
+    bool Open(const std::string& path, std::string& error)
+    {
+        Close();
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            error = GetLastError() == ERROR_SHARING_VIOLATION ? "in use by another process" : "cannot open";
+            return false;
+        }
+        LARGE_INTEGER length;
+        if (!GetFileSizeEx(file, &length)) {
+            error = "cannot stat";
+            CloseHandle(file);
+            file = INVALID_HANDLE_VALUE;
+            return false;
+        }
+        size = uint64_t(length.QuadPart);
+#else
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            error = "cannot open";
+            return false;
+        }
+        if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            error = "in use by another process";
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            error = "cannot stat";
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+        size = uint64_t(st.st_size);
+#endif
+        open = true;
+        if (!Map()) {
+            error = "cannot map";
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    // Sets the file length to bytes and maps it again; the contents up to the
+    // smaller of the two lengths are kept, the rest reads as zeros
+    bool Resize(uint64_t bytes)
+    {
+        if (!open) return false;
+        Unmap();
+#ifdef _WIN32
+        LARGE_INTEGER length;
+        length.QuadPart = LONGLONG(bytes);
+        if (!SetFilePointerEx(file, length, nullptr, FILE_BEGIN) || !SetEndOfFile(file)) {
+            Map();
+            return false;
+        }
+#else
+        if (ftruncate(fd, off_t(bytes)) != 0) {
+            Map();
+            return false;
+        }
+#endif
+        size = bytes;
+        return Map();
+    }
+
+    void Close()
+    {
+        if (!open) return;
+        Unmap();
+#ifdef _WIN32
+        CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+#else
+        ::close(fd); // also drops the flock
+        fd = -1;
+#endif
+        open = false;
+        size = 0;
+    }
+
+private:
+    bool Map()
+    {
+        if (size == 0) return true;
+#ifdef _WIN32
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, DWORD(size >> 32), DWORD(size), nullptr);
+        if (!mapping) return false;
+        data = static_cast<uint8_t*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size_t(size)));
+        if (!data) {
+            CloseHandle(mapping);
+            mapping = nullptr;
+            return false;
+        }
+#else
+        void* base = mmap(nullptr, size_t(size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) return false;
+        data = static_cast<uint8_t*>(base);
+#endif
+        return true;
+    }
+
+    void Unmap()
+    {
+        if (!data) return;
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+        CloseHandle(mapping);
+        mapping = nullptr;
+#else
+        munmap(data, size_t(size));
+#endif
+        data = nullptr;
+    }
+
+    uint8_t* data = nullptr;
+    uint64_t size = 0;
+    bool open = false;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+} // namespace ux::native
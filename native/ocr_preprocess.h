@@ -0,0 +1,257 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "native/colour_profile.h"
+#include "native/image_diff.h"
+#include "native/image_stats.h"
+
+// OCR preprocessing of UI text crops behind src/analysis/ocr_engine.py.
+//
+// Every crop of the frame becomes a binary image (0 text, 255 paper) that is
+// handed to Tesseract's SetImage as is:
+//   1. luma, and a 3x3 median (salt-and-pepper noise of scaled captures)
+//   2. inversion when the text is lighter than its surroundings (the crop is
+//      brighter on average than its one-pixel border)
+//   3. integer nearest-neighbour upscaling of crops shorter than
+//      targetHeight: pixel fonts keep their hard edges, and Tesseract wants
+//      text about 30 px tall
+//   4. mean-C adaptive thresholding, exactly as
+//      cv2.adaptiveThreshold(ADAPTIVE_THRESH_MEAN_C, THRESH_BINARY) does it
+//   5. a vertical shear undoing skew of up to maxSkew degrees, the angle
+//      whose row projection of the text pixels is sharpest
+// and a white border around the result. Output sizes follow from the box and
+// the options alone (OcrLayout), so the caller allocates one buffer for the
+// whole batch and the crops are filled in parallel.
+namespace ux::native {
+
+struct OcrOptions {
+    int32_t targetHeight;   // shorter crops are upscaled towards this height
+    int32_t maxScale;       // largest upscaling factor
+    int32_t blockSize;      // odd adaptive-threshold window
+    int32_t offset;         // a pixel is text when at most window mean - offset
+    int32_t border;         // paper pixels around the result
+    int32_t denoise;        // 3x3 median
+    float maxSkew;          // degrees; 0 disables deskewing
+};
+
+struct OcrCrop {
+    int64_t offset;         // of the crop's pixels in the batch buffer
+    int32_t width, height;  // of the result (rows are packed)
+    int32_t scale;
+    int32_t inverted;       // light text was inverted
+    float skew;             // degrees undone (positive: descending to the right)
+};
+
+namespace detail {
+
+constexpr double kSkewStep = 0.5;   // degrees between tried angles
+constexpr double kRadiansPerDegree = 3.14159265358979323846 / 180.0;
+
+inline int32_t OcrScale(int32_t height, const OcrOptions& o)
+{
+    if (height <= 0 || height >= o.targetHeight) return 1;
+    return std::clamp((o.targetHeight + height - 1) / height, 1, o.maxScale);
+}
+
+// Rows added above and below so a shear of up to maxSkew stays in the image
+inline int32_t SkewPad(int32_t width, const OcrOptions& o)
+{
+    if (o.maxSkew <= 0) return 0;
+    return int32_t(std::ceil(width * 0.5 * std::tan(o.maxSkew * kRadiansPerDegree)));
+}
+
+// Median of nine values (Paeth's exchange network)
+inline uint8_t Median9(uint8_t p[9])
+{
+    auto sort2 = [](uint8_t& a, uint8_t& b) {
+        if (a > b) std::swap(a, b);
+    };
+    sort2(p[1], p[2]); sort2(p[4], p[5]); sort2(p[7], p[8]);
+    sort2(p[0], p[1]); sort2(p[3], p[4]); sort2(p[6], p[7]);
+    sort2(p[1], p[2]); sort2(p[4], p[5]); sort2(p[7], p[8]);
+    sort2(p[0], p[3]); sort2(p[5], p[8]); sort2(p[4], p[7]);
+    sort2(p[3], p[6]); sort2(p[1], p[4]); sort2(p[2], p[5]);
+    sort2(p[4], p[7]); sort2(p[4], p[2]); sort2(p[6], p[4]);
+    sort2(p[4], p[2]);
+    return p[4];
+}
+
+// 3x3 median with replicated edges (cv2.medianBlur(src, 3))
+inline void Median3x3(const uint8_t* src, int32_t w, int32_t h, uint8_t* dst)
+{
+    for (int32_t y = 0; y < h; y++) {
+        const uint8_t* rows[3] = {src + size_t(std::max(y - 1, 0)) * w, src + size_t(y) * w,
+                                  src + size_t(std::min(y + 1, h - 1)) * w};
+        for (int32_t x = 0; x < w; x++) {
+            const int32_t xs[3] = {std::max(x - 1, 0), x, std::min(x + 1, w - 1)};
+            uint8_t p[9];
+            for (int r = 0; r < 3; r++) {
+                for (int c = 0; c < 3; c++) p[r * 3 + c] = rows[r][xs[c]];
+            }
+            dst[size_t(y) * w + x] = Median9(p);
+        }
+    }
+}
+
+// Whether the crop is brighter on average than its one-pixel border
+inline bool LightText(const uint8_t* g, int32_t w, int32_t h)
+{
+    uint64_t all = 0, edge = 0, edgeCount = 0;
+    for (int32_t y = 0; y < h; y++) {
+        const uint8_t* row = g + size_t(y) * w;
+        for (int32_t x = 0; x < w; x++) {
+            all += row[x];
+            if (y == 0 || y == h - 1 || x == 0 || x == w - 1) {
+                edge += row[x];
+                edgeCount++;
+            }
+        }
+    }
+    return all * edgeCount > edge * uint64_t(w) * h;
+}
+
+// Window sums of block x block with replicated edges, one running sum per
+// direction; sums holds w * h values
+inline void BoxSums(const uint8_t* src, int32_t w, int32_t h, int32_t block, std::vector<int32_t>& rowSums,
+                    std::vector<int32_t>& sums)
+{
+    const int32_t r = block / 2;
+    rowSums.resize(size_t(w) * h);
+    sums.resize(size_t(w) * h);
+    for (int32_t y = 0; y < h; y++) {
+        const uint8_t* row = src + size_t(y) * w;
+        int32_t* out = &rowSums[size_t(y) * w];
+        int32_t s = 0;
+        for (int32_t k = -r; k <= r; k++) s += row[std::clamp(k, 0, w - 1)];
+        for (int32_t x = 0; x < w; x++) {
+            out[x] = s;
+            s += row[std::min(x + r + 1, w - 1)] - row[std::max(x - r, 0)];
+        }
+    }
+    std::vector<int32_t> column(w, 0);
+    for (int32_t k = -r; k <= r; k++) {
+        const int32_t* row = &rowSums[size_t(std::clamp(k, 0, h - 1)) * w];
+        for (int32_t x = 0; x < w; x++) column[x] += row[x];
+    }
+    for (int32_t y = 0; y < h; y++) {
+        std::copy(column.begin(), column.end(), &sums[size_t(y) * w]);
+        const int32_t* add = &rowSums[size_t(std::min(y + r + 1, h - 1)) * w];
+        const int32_t* drop = &rowSums[size_t(std::max(y - r, 0)) * w];
+        for (int32_t x = 0; x < w; x++) column[x] += add[x] - drop[x];
+    }
+}
+
+// Tangent of the skew whose row projection of the text pixels is sharpest
+// (largest sum of squared row counts), or 0 if no angle beats level by 1%
+inline double SkewTangent(const uint8_t* bin, int32_t w, int32_t h, int32_t pad, double maxSkew,
+                          std::vector<int32_t>& bins)
+{
+    std::vector<int32_t> xs, ys;
+    for (int32_t y = 0; y < h; y++) {
+        for (int32_t x = 0; x < w; x++) {
+            if (bin[size_t(y) * w + x] == 0) {
+                xs.push_back(x);
+                ys.push_back(y);
+            }
+        }
+    }
+    if (xs.size() < 16) return 0.0;
+
+    const double centre = (w - 1) * 0.5;
+    const int32_t steps = int32_t(maxSkew / kSkewStep);
+    double best = 0.0, levelScore = 0.0, bestScore = -1.0;
+    for (int32_t i = -steps; i <= steps; i++) {
+        const double t = std::tan(i * kSkewStep * kRadiansPerDegree);
+        bins.assign(size_t(h) + 2 * pad + 1, 0);
+        for (size_t k = 0; k < xs.size(); k++) bins[ys[k] + pad - std::lround((xs[k] - centre) * t)]++;
+        double score = 0.0;
+        for (int32_t b : bins) score += double(b) * b;
+        if (i == 0) levelScore = score;
+        if (score > bestScore) {
+            bestScore = score;
+            best = t;
+        }
+    }
+    return bestScore > levelScore * 1.01 ? best : 0.0;
+}
+
+} // namespace detail
+
+// Result sizes and buffer offsets of count boxes; returns the bytes needed
+inline int64_t OcrLayout(int32_t width, int32_t height, const Box* boxes, int32_t count, const OcrOptions& o,
+                         OcrCrop* crops)
+{
+    int64_t offset = 0;
+    for (int32_t i = 0; i < count; i++) {
+        const Box b = ClipBox(boxes[i], width, height);
+        OcrCrop& c = crops[i];
+        c = {offset, 0, 0, 1, 0, 0.0f};
+        if (b.width == 0 || b.height == 0) continue;
+        c.scale = detail::OcrScale(b.height, o);
+        const int32_t w = b.width * c.scale, h = b.height * c.scale;
+        c.width = w + 2 * o.border;
+        c.height = h + 2 * detail::SkewPad(w, o) + 2 * o.border;
+        offset += int64_t(c.width) * c.height;
+    }
+    return offset;
+}
+
+// Fills one crop laid out by OcrLayout (out points at its pixels)
+inline void PrepareOcrCrop(const ImageView& img, const Box& box, const OcrOptions& o, OcrCrop& crop, uint8_t* out)
+{
+    const Box b = ClipBox(box, img.width, img.height);
+    if (b.width == 0 || b.height == 0) return;
+    thread_local std::vector<uint8_t> grey, smooth, scaled, binary;
+    thread_local std::vector<int32_t> rowSums, sums, bins;
+
+    const int32_t w = b.width, h = b.height;
+    grey.resize(size_t(w) * h);
+    const detail::LumaWeights weights(img.bgr);
+    for (int32_t y = 0; y < h; y++) {
+        detail::LumaRow(img.Row(b.y + y) + size_t(b.x) * img.channels, w, img.channels, weights, &grey[size_t(y) * w]);
+    }
+    const uint8_t* g = grey.data();
+    if (o.denoise) {
+        smooth.resize(grey.size());
+        detail::Median3x3(g, w, h, smooth.data());
+        g = smooth.data();
+    }
+
+    // Dark text on paper, upscaled
+    crop.inverted = detail::LightText(g, w, h);
+    const uint8_t flip = crop.inverted ? 0xFF : 0;
+    const int32_t s = crop.scale, uw = w * s, uh = h * s;
+    scaled.resize(size_t(uw) * uh);
+    for (int32_t y = 0; y < uh; y++) {
+        const uint8_t* src = g + size_t(y / s) * w;
+        uint8_t* dst = &scaled[size_t(y) * uw];
+        for (int32_t x = 0; x < uw; x++) dst[x] = src[x / s] ^ flip;
+    }
+
+    detail::BoxSums(scaled.data(), uw, uh, o.blockSize, rowSums, sums);
+    const double scale = 1.0 / (double(o.blockSize) * o.blockSize);
+    binary.resize(scaled.size());
+    for (size_t i = 0; i < scaled.size(); i++) {
+        const int32_t mean = int32_t(std::lrint(sums[i] * scale));
+        binary[i] = scaled[i] - mean > -o.offset ? 255 : 0;
+    }
+
+    // Shear each column back by its share of the skew onto white paper
+    const int32_t pad = detail::SkewPad(uw, o);
+    const double t = o.maxSkew > 0 ? detail::SkewTangent(binary.data(), uw, uh, pad, o.maxSkew, bins) : 0.0;
+    crop.skew = float(std::atan(t) / detail::kRadiansPerDegree);
+    std::fill(out, out + size_t(crop.width) * crop.height, uint8_t(255));
+    const double centre = (uw - 1) * 0.5;
+    for (int32_t x = 0; x < uw; x++) {
+        const int32_t top = o.border + pad - int32_t(std::lround((x - centre) * t));
+        uint8_t* dst = out + size_t(top) * crop.width + o.border + x;
+        for (int32_t y = 0; y < uh; y++, dst += crop.width) *dst = binary[size_t(y) * uw + x];
+    }
+}
+
+} // namespace ux::native
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "native/image_diff.h"
+
+// 64-bit perceptual hashes for near-duplicate screenshot detection.
+//
+// One pass converts every pixel to luma (the same weights as the diff
+// kernels) and adds it to two cell grids: 32x32 for pHash and 9x8 for dHash.
+// Pixel (x, y) falls in cell (x * cols / width, y * rows / height). The
+// rest is integer arithmetic on the grids, so src/analysis/native.py
+// reproduces the same bits in numpy when the library is not built:
+//   dHash  bit set where a 9x8 cell is brighter than its right neighbour
+//   pHash  2-D DCT-II (Q14 cosines) of the 32x32 cell means; the 8x8
+//          lowest frequencies are thresholded at their median
+// Bits are row-major from the most significant bit.
+namespace ux::native {
+
+constexpr int kPHashGrid = 32, kPHashBlock = 8;
+constexpr int kDHashCols = 9, kDHashRows = 8;
+constexpr int kDctShift = 14;
+
+struct PerceptualHashes {
+    uint64_t phash = 0;
+    uint64_t dhash = 0;
+};
+
+namespace detail {
+
+// Cell sums and pixel counts of a rows x cols grid
+struct CellGrid {
+    int32_t rows, cols;
+    std::vector<uint64_t> sums;
+    std::vector<uint64_t> counts;
+
+    CellGrid(int32_t rows, int32_t cols) : rows(rows), cols(cols), sums(size_t(rows) * cols), counts(sums.size()) {}
+
+    // Integer mean; empty cells (frames smaller than the grid) are 0
+    int64_t Mean(size_t i) const { return counts[i] ? int64_t(sums[i] / counts[i]) : 0; }
+};
+
+// Q14 DCT-II basis: cos((2x + 1) u pi / 64) for the lowest 8 frequencies
+struct DctTable {
+    int32_t v[kPHashBlock][kPHashGrid];
+
+    DctTable()
+    {
+        const double pi = 3.14159265358979323846;
+        for (int u = 0; u < kPHashBlock; u++)
+            for (int x = 0; x < kPHashGrid; x++)
+                v[u][x] = int32_t(std::lround(std::cos((2 * x + 1) * u * pi / (2 * kPHashGrid)) * (1 << kDctShift)));
+    }
+};
+
+inline const DctTable& Dct()
+{
+    static const DctTable table;
+    return table;
+}
+
+inline uint64_t DHashFromGrid(const CellGrid& g)
+{
+    uint64_t bits = 0;
+    for (int32_t r = 0; r < kDHashRows; r++) {
+        for (int32_t c = 0; c < kDHashCols - 1; c++) {
+            const size_t left = size_t(r) * kDHashCols + c, right = left + 1;
+            // mean(left) > mean(right) without dividing
+            bits = bits << 1 | uint64_t(g.sums[left] * g.counts[right] > g.sums[right] * g.counts[left]);
+        }
+    }
+    return bits;
+}
+
+inline uint64_t PHashFromGrid(const CellGrid& g)
+{
+    const auto& dct = Dct().v;
+    // Rows first: t[y][u] = sum_x mean[y][x] * cos_u(x)
+    int64_t t[kPHashGrid][kPHashBlock] = {};
+    for (int32_t y = 0; y < kPHashGrid; y++)
+        for (int32_t x = 0; x < kPHashGrid; x++) {
+            const int64_t m = g.Mean(size_t(y) * kPHashGrid + x);
+            for (int u = 0; u < kPHashBlock; u++) t[y][u] += m * dct[u][x];
+        }
+    int64_t f[kPHashBlock * kPHashBlock] = {};
+    for (int v = 0; v < kPHashBlock; v++)
+        for (int u = 0; u < kPHashBlock; u++)
+            for (int32_t y = 0; y < kPHashGrid; y++) f[v * kPHashBlock + u] += int64_t(dct[v][y]) * t[y][u];
+
+    int64_t sorted[kPHashBlock * kPHashBlock];
+    std::copy(std::begin(f), std::end(f), sorted);
+    std::nth_element(sorted, sorted + 31, sorted + 64);
+    const int64_t lower = sorted[31];
+    const int64_t upper = *std::min_element(sorted + 32, sorted + 64);
+    uint64_t bits = 0;
+    for (int64_t c : f) bits = bits << 1 | uint64_t(2 * c > lower + upper);  // c > median
+    return bits;
+}
+
+} // namespace detail
+
+inline PerceptualHashes PerceptualHash(const ImageView& img)
+{
+    const int32_t w = img.width, h = img.height;
+    detail::CellGrid p(kPHashGrid, kPHashGrid), d(kDHashRows, kDHashCols);
+    std::vector<int32_t> pCol(w), dCol(w);
+    for (int32_t x = 0; x < w; x++) {
+        pCol[x] = int32_t(int64_t(x) * kPHashGrid / w);
+        dCol[x] = int32_t(int64_t(x) * kDHashCols / w);
+    }
+
+    const detail::LumaWeights weights(img.bgr);
+    for (int32_t y = 0; y < h; y++) {
+        uint64_t* pRow = p.sums.data() + size_t(int64_t(y) * kPHashGrid / h) * kPHashGrid;
+        uint64_t* dRow = d.sums.data() + size_t(int64_t(y) * kDHashRows / h) * kDHashCols;
+        const uint8_t* px = img.Row(y);
+        for (int32_t x = 0; x < w; x++, px += img.channels) {
+            const uint32_t l = uint32_t(detail::Luma(px, weights));
+            pRow[pCol[x]] += l;
+            dRow[dCol[x]] += l;
+        }
+    }
+    // Pixel counts are products of the row and column spans of each cell
+    auto fillCounts = [&](detail::CellGrid& g, const std::vector<int32_t>& col) {
+        std::vector<uint64_t> colSpan(size_t(g.cols)), rowSpan(size_t(g.rows));
+        for (int32_t x = 0; x < w; x++) colSpan[col[x]]++;
+        for (int32_t y = 0; y < h; y++) rowSpan[size_t(int64_t(y) * g.rows / h)]++;
+        for (int32_t r = 0; r < g.rows; r++)
+            for (int32_t c = 0; c < g.cols; c++) g.counts[size_t(r) * g.cols + c] = rowSpan[r] * colSpan[c];
+    };
+    fillCounts(p, pCol);
+    fillCounts(d, dCol);
+
+    return {detail::PHashFromGrid(p), detail::DHashFromGrid(d)};
+}
+
+} // namespace ux::native
@@ -0,0 +1,283 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+#include "native/colour_profile.h"
+#include "native/image_diff.h"
+#include "ux_game/simd_fill.h"
+
+// Colour-region UI element detector behind UIElementDetector.
+//
+// Flat-shaded UI (the game's buttons, panels and text fields) is made of
+// regions of near-constant colour, so the rectangles can be found directly
+// instead of via edges and contours. One raster pass splits every row into
+// runs of similar pixels and unions each run with the runs above it that
+// touch it with a similar colour (union-find). Bounding box, area and colour
+// sums are accumulated per run label during the pass and folded into the
+// component roots afterwards, so only two rows of labels are ever kept. A run
+// contributes its first pixel's colour times its length: within tolerance
+// that is the region colour, and the run scan never has to add pixels up.
+// Components are then classified with the same size/aspect rules as the
+// Python detectors, and candidates get the bbox colour/luma statistics
+// _analyze_colors reports.
+namespace ux::native {
+
+enum class RegionType : int32_t {
+    Button = 1,
+    Input = 2,
+    Container = 3,
+};
+
+struct Region {
+    RegionType type;
+    int32_t x, y, width, height;
+    int32_t area;               // pixels of the component itself
+    float confidence;
+    float meanColour[3];        // over the bbox, in byte order
+    float lumaMean, lumaStd;    // over the bbox
+};
+
+namespace detail {
+
+struct ComponentStats {
+    int32_t x0, y0, x1, y1;     // half-open bbox
+    uint32_t area = 0;
+    uint64_t colour[3] = {};
+
+    void Add(int32_t x, int32_t y, int32_t n, const uint64_t sums[3])
+    {
+        if (area == 0) {
+            x0 = x;
+            y0 = y;
+            x1 = x + n;
+            y1 = y + 1;
+        } else {
+            x0 = std::min(x0, x);
+            y0 = std::min(y0, y);
+            x1 = std::max(x1, x + n);
+            y1 = std::max(y1, y + 1);
+        }
+        area += uint32_t(n);
+        for (int c = 0; c < 3; c++) colour[c] += sums[c];
+    }
+
+    void Merge(const ComponentStats& o)
+    {
+        if (o.area == 0) return;
+        if (area == 0) {
+            *this = o;
+            return;
+        }
+        x0 = std::min(x0, o.x0);
+        y0 = std::min(y0, o.y0);
+        x1 = std::max(x1, o.x1);
+        y1 = std::max(y1, o.y1);
+        area += o.area;
+        for (int c = 0; c < 3; c++) colour[c] += o.colour[c];
+    }
+};
+
+inline bool Similar(const uint8_t* a, const uint8_t* b, int32_t tolerance)
+{
+    return std::abs(a[0] - b[0]) <= tolerance && std::abs(a[1] - b[1]) <= tolerance &&
+           std::abs(a[2] - b[2]) <= tolerance;
+}
+
+inline int32_t RunEndScalar(const uint8_t* row, int32_t x, int32_t width, int32_t channels, int32_t tolerance)
+{
+    while (x < width && Similar(row + size_t(x) * channels, row + size_t(x - 1) * channels, tolerance)) x++;
+    return x;
+}
+
+#if UX_SIMD_X86
+// Compares pixels [x, ...) with their left neighbours 32 bytes at a time and
+// returns the first that differs by more than tolerance in a colour byte, or
+// the point where fewer than 32 bytes of the row remain.
+UX_TARGET_AVX2 inline int32_t RunEndAVX2(const uint8_t* row, int32_t x, int32_t width, int32_t channels,
+                                         int32_t tolerance)
+{
+    // 3 channels: ten whole pixels per load; 4: eight, ignoring the 4th byte
+    const int32_t step = channels == 3 ? 10 : 8;
+    const uint32_t colourBytes = channels == 3 ? 0x3FFFFFFFu : 0x77777777u;
+    const __m256i tol = _mm256_set1_epi8(char(std::min(tolerance, 255)));
+    const __m256i zero = _mm256_setzero_si256();
+    const int64_t lastLoad = int64_t(width) * channels - 32;
+    for (; int64_t(x) * channels <= lastLoad; x += step) {
+        const uint8_t* p = row + size_t(x) * channels;
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p - channels));
+        const __m256i diff = _mm256_or_si256(_mm256_subs_epu8(a, b), _mm256_subs_epu8(b, a));
+        const __m256i within = _mm256_cmpeq_epi8(_mm256_subs_epu8(diff, tol), zero);
+        const uint32_t over = ~uint32_t(_mm256_movemask_epi8(within)) & colourBytes;
+        if (over) return x + int32_t(__builtin_ctz(over)) / channels;
+    }
+    return x;
+}
+#endif
+
+// End of the run of similar pixels that starts at x
+inline int32_t RunEnd(const uint8_t* row, int32_t x, int32_t width, int32_t channels, int32_t tolerance)
+{
+    x++;
+#if UX_SIMD_X86
+    if (simd::ActiveLevel() == simd::Level::AVX2) {
+        x = RunEndAVX2(row, x, width, channels, tolerance);
+        if (x < width && !Similar(row + size_t(x) * channels, row + size_t(x - 1) * channels, tolerance)) return x;
+    }
+#endif
+    return RunEndScalar(row, x, width, channels, tolerance);
+}
+
+class UnionFind {
+public:
+    int32_t Make()
+    {
+        parent.push_back(int32_t(parent.size()));
+        return parent.back();
+    }
+
+    int32_t Find(int32_t i)
+    {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+
+    void Union(int32_t a, int32_t b)
+    {
+        a = Find(a);
+        b = Find(b);
+        if (a != b) parent[std::max(a, b)] = std::min(a, b);
+    }
+
+    size_t Size() const { return parent.size(); }
+
+private:
+    std::vector<int32_t> parent;
+};
+
+// Labels the frame and returns the merged statistics of every component
+inline std::vector<ComponentStats> LabelComponents(const ImageView& img, int32_t tolerance)
+{
+    const int32_t w = img.width, h = img.height, ch = img.channels;
+    UnionFind sets;
+    std::vector<ComponentStats> stats;
+    std::vector<int32_t> above(w, -1), current(w);
+
+    for (int32_t y = 0; y < h; y++) {
+        const uint8_t* row = img.Row(y);
+        const uint8_t* up = y > 0 ? img.Row(y - 1) : nullptr;
+        for (int32_t x = 0; x < w;) {
+            // Run of horizontally similar pixels
+            const int32_t end = RunEnd(row, x, w, ch, tolerance);
+            const uint8_t* seed = row + size_t(x) * ch;
+            const uint64_t sums[3] = {uint64_t(seed[0]) * (end - x), uint64_t(seed[1]) * (end - x),
+                                      uint64_t(seed[2]) * (end - x)};
+            // Join every component above that touches the run with a similar colour
+            int32_t label = -1;
+            if (up) {
+                for (int32_t i = x; i < end; i++) {
+                    if (above[i] < 0 || !Similar(row + size_t(i) * ch, up + size_t(i) * ch, tolerance)) continue;
+                    if (label < 0) label = above[i];
+                    else if (above[i] != label) sets.Union(label, above[i]);
+                    // Runs above are contiguous; skip to the end of this one
+                    while (i + 1 < end && above[i + 1] == above[i]) i++;
+                }
+            }
+            if (label < 0) {
+                label = sets.Make();
+                stats.emplace_back();
+            }
+            stats[label].Add(x, y, end - x, sums);
+            std::fill(current.begin() + x, current.begin() + end, label);
+            x = end;
+        }
+        std::swap(above, current);
+    }
+
+    for (int32_t i = int32_t(sets.Size()) - 1; i >= 0; i--) {
+        const int32_t root = sets.Find(i);
+        if (root != i) {
+            stats[root].Merge(stats[i]);
+            stats[i].area = 0;
+        }
+    }
+    stats.erase(std::remove_if(stats.begin(), stats.end(), [](const ComponentStats& s) { return s.area == 0; }),
+                stats.end());
+    return stats;
+}
+
+// Colour and luma statistics of a bbox, as _analyze_colors computes them
+inline void BoxStatistics(const ImageView& img, Region& r)
+{
+    const BoxMoments m = ScanMoments(img, {r.x, r.y, r.width, r.height});
+    const double n = double(m.pixels);
+    for (int c = 0; c < 3; c++) r.meanColour[c] = float(m.colour[c] / n);
+    const double mean = m.luma / n;
+    r.lumaMean = float(mean);
+    r.lumaStd = float(std::sqrt(std::max(0.0, m.lumaSquared / n - mean * mean)));
+}
+
+} // namespace detail
+
+// Size and shape rules of UIElementDetector._detect_buttons /
+// _detect_input_fields / _detect_containers, applied to a component. fill is
+// the share of the bbox the component covers (text on a button leaves holes).
+// Light fields (mean luma >= 200) of input-field proportions are inputs.
+inline bool ClassifyComponent(const detail::ComponentStats& s, int32_t frameW, int32_t frameH, Region& r)
+{
+    const int32_t w = s.x1 - s.x0, h = s.y1 - s.y0;
+    if (w >= frameW && h >= frameH) return false;  // background
+    const double boxArea = double(w) * h, fill = s.area / boxArea, aspect = double(w) / h;
+    const double luma = (kLumaB * double(s.colour[0]) + kLumaG * double(s.colour[1]) +
+                         kLumaR * double(s.colour[2])) / (double(1 << kLumaShift) * s.area);
+    if (fill < 0.6) return false;
+
+    r = {};
+    r.x = s.x0;
+    r.y = s.y0;
+    r.width = w;
+    r.height = h;
+    r.area = int32_t(s.area);
+    const bool inputShape = w > 50 && h > 15 && aspect > 2.0 && w < 400 && h < 60;
+    const bool buttonShape = w >= 30 && w <= 300 && h >= 20 && h <= 80 && s.area > 600 && aspect >= 1.2 &&
+                             aspect <= 8.0;
+    if (inputShape && luma >= 200) {
+        r.type = RegionType::Input;
+        r.confidence = float(std::min(0.9, 0.3 + fill * 0.6));
+    } else if (buttonShape) {
+        r.type = RegionType::Button;
+        r.confidence = float(std::min(1.0, fill));
+    } else if (w > 100 && h > 100 && s.area > 10000) {
+        r.type = RegionType::Container;
+        r.confidence = float(std::min(0.8, s.area / (double(frameW) * frameH)));
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Detects button, input and container candidates; tolerance is the largest
+// per-channel difference between neighbouring pixels of one region
+inline std::vector<Region> DetectRegions(const ImageView& img, int32_t tolerance)
+{
+    std::vector<Region> regions;
+    for (const detail::ComponentStats& s : detail::LabelComponents(img, tolerance)) {
+        Region r;
+        if (!ClassifyComponent(s, img.width, img.height, r)) continue;
+        detail::BoxStatistics(img, r);
+        regions.push_back(r);
+    }
+    std::sort(regions.begin(), regions.end(),
+              [](const Region& a, const Region& b) { return a.y != b.y ? a.y < b.y : a.x < b.x; });
+    return regions;
+}
+
+} // namespace ux::native
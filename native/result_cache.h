@@ -0,0 +1,339 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "native/content_hash.h"
+#include "native/mapped_file.h"
+
+// Persistent key/value cache for pipeline stage results.
+//
+// Entries live in one memory-mapped, append-only log: a 64-byte header and a
+// sequence of records (header, key bytes, value bytes, padded to 8 bytes),
+// each stamped with its expiry time and a checksum. An in-memory hash table
+// maps the 64-bit hash of a key to the offset of its newest record; it is
+// rebuilt by scanning the log on Open, which also drops a torn tail left by a
+// crash. A lookup is one table probe plus a key comparison in the mapping -
+// no file is opened and nothing is parsed.
+//
+// Overwritten, removed and expired records stay in the log as dead bytes.
+// When an append would take the log past its size bound, the log is
+// compacted in place: expired entries are dropped, then the least recently
+// used ones until a quarter of the bound is free, and the survivors slide
+// down over the gaps in log order.
+namespace ux::native {
+
+struct ResultCacheStats {
+    uint64_t entries;
+    uint64_t liveBytes;     // bytes of the records the index points to
+    uint64_t logBytes;      // bytes of the log in use, live or dead
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;     // entries dropped as expired or to make room
+    uint64_t compactions;
+};
+
+class ResultCache {
+public:
+    static constexpr uint32_t kLogMagic = 0x43525855;      // "UXRC"
+    static constexpr uint32_t kLogVersion = 1;
+    static constexpr uint32_t kEntryMagic = 0x45525855;    // "UXRE"
+    static constexpr uint32_t kRemovedMagic = 0x44525855;  // "UXRD"
+    static constexpr uint64_t kMinLogBytes = 64 * 1024;
+
+    ResultCache() = default;
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    // Opens (creating if needed) the log at path, bounded to maxBytes
+    bool Open(const std::string& path, uint64_t maxBytes, std::string& error)
+    {
+        Close();
+        if (!file.Open(path, error)) return false;
+        limit = std::max(maxBytes, kMinLogBytes);
+        const LogHeader* existing = reinterpret_cast<const LogHeader*>(file.Data());
+        if (file.Size() < sizeof(LogHeader) || existing->magic != kLogMagic || existing->version != kLogVersion) {
+            // Empty, foreign or from another format version: start over
+            if (!Reset()) {
+                error = "cannot size the log";
+                file.Close();
+                return false;
+            }
+        } else {
+            Scan();
+        }
+        if (Header()->end > limit) Compact(limit - limit / 4);
+        if (file.Size() > limit) file.Resize(limit);
+        return true;
+    }
+
+    void Close()
+    {
+        file.Close();
+        index.clear();
+        stats = {};
+    }
+
+    bool IsOpen() const { return file.IsOpen(); }
+
+    // The value stored under key, or null when it is missing or expired. The
+    // pointer is valid until the next Put, Remove or Clear. A peek (to size a
+    // buffer before the real lookup) is not counted as a use.
+    const uint8_t* Find(const uint8_t* key, size_t keyLength, uint64_t& valueLength, bool peek = false)
+    {
+        auto it = index.find(ContentHash(key, keyLength));
+        if (it == index.end() || !file.Data()) {
+            stats.misses++;
+            return nullptr;
+        }
+        const RecordHeader* record = RecordAt(it->second.offset);
+        if (record->keyLength != keyLength || std::memcmp(record + 1, key, keyLength) != 0) {
+            stats.misses++;
+            return nullptr;
+        }
+        if (record->expiresNs <= NowNs()) {
+            Drop(it);
+            stats.evictions++;
+            stats.misses++;
+            return nullptr;
+        }
+        if (!peek) {
+            it->second.tick = ++tick;
+            stats.hits++;
+        }
+        valueLength = record->valueLength;
+        return reinterpret_cast<const uint8_t*>(record + 1) + keyLength;
+    }
+
+    // Stores value under key for ttlSeconds, replacing any earlier value.
+    // Values larger than half the size bound are not cached.
+    bool Put(const uint8_t* key, size_t keyLength, const uint8_t* value, size_t valueLength, double ttlSeconds)
+    {
+        const uint64_t size = RecordSize(keyLength, valueLength);
+        if (!file.Data() || size > limit / 2 || !(ttlSeconds > 0)) return false;
+        const uint64_t hash = ContentHash(key, keyLength);
+        auto it = index.find(hash);
+        if (it != index.end()) Drop(it);
+
+        if (Header()->end + size > limit) Compact(limit - limit / 4 - size);
+        if (!Reserve(size)) return false;
+
+        const int64_t ttlNs = int64_t(std::min(ttlSeconds, 1e9) * 1e9);
+        const uint64_t offset = Header()->end;
+        Append(offset, kEntryMagic, key, keyLength, value, valueLength, NowNs() + ttlNs);
+        index[hash] = {offset, ++tick};
+        stats.liveBytes += size;
+        return true;
+    }
+
+    // Drops key; false if it was not cached
+    bool Remove(const uint8_t* key, size_t keyLength)
+    {
+        auto it = index.find(ContentHash(key, keyLength));
+        if (it == index.end() || !file.Data()) return false;
+        const RecordHeader* record = RecordAt(it->second.offset);
+        if (record->keyLength != keyLength || std::memcmp(record + 1, key, keyLength) != 0) return false;
+        Drop(it);
+        // Record the removal so that a reopened log does not bring it back
+        const uint64_t size = RecordSize(keyLength, 0);
+        if (Header()->end + size > limit) {
+            Compact(limit - limit / 4 - size);
+            return true; // the compacted log no longer holds the entry
+        }
+        if (Reserve(size)) Append(Header()->end, kRemovedMagic, key, keyLength, nullptr, 0, 0);
+        return true;
+    }
+
+    void Clear()
+    {
+        if (!file.IsOpen()) return;
+        index.clear();
+        Reset();
+    }
+
+    ResultCacheStats Stats() const
+    {
+        ResultCacheStats out = stats;
+        out.entries = index.size();
+        out.logBytes = file.Data() ? Header()->end : 0;
+        return out;
+    }
+
+    static int64_t NowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+private:
+    struct LogHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t end;           // offset just past the last complete record
+        uint8_t reserved[48];
+    };
+
+    struct RecordHeader {
+        uint32_t magic;
+        uint32_t keyLength;
+        uint64_t valueLength;
+        int64_t expiresNs;      // wall clock, so that entries expire across runs
+        uint64_t checksum;      // of key and value
+    };
+
+    static_assert(sizeof(LogHeader) == 64, "LogHeader is part of the log format");
+    static_assert(sizeof(RecordHeader) == 32, "RecordHeader is part of the log format");
+
+    struct Slot {
+        uint64_t offset;
+        uint64_t tick;          // last use, for eviction
+    };
+
+    static uint64_t RecordSize(uint64_t keyLength, uint64_t valueLength)
+    {
+        return (sizeof(RecordHeader) + keyLength + valueLength + 7) & ~uint64_t(7);
+    }
+
+    static uint64_t Checksum(const uint8_t* key, size_t keyLength, const uint8_t* value, size_t valueLength)
+    {
+        ContentHasher hasher;
+        hasher.Update(key, keyLength);
+        hasher.Update(value, valueLength);
+        return hasher.Digest();
+    }
+
+    LogHeader* Header() const { return reinterpret_cast<LogHeader*>(file.Data()); }
+
+    RecordHeader* RecordAt(uint64_t offset) const { return reinterpret_cast<RecordHeader*>(file.Data() + offset); }
+
+    bool Reset()
+    {
+        if (!file.Resize(kMinLogBytes)) return false;
+        std::memset(file.Data(), 0, sizeof(LogHeader));
+        Header()->magic = kLogMagic;
+        Header()->version = kLogVersion;
+        Header()->end = sizeof(LogHeader);
+        stats.liveBytes = 0;
+        return true;
+    }
+
+    // Rebuilds the index from the log, cutting it at the first damaged record
+    void Scan()
+    {
+        const int64_t now = NowNs();
+        const uint64_t end = std::min(Header()->end, file.Size());
+        uint64_t offset = sizeof(LogHeader);
+        while (offset + sizeof(RecordHeader) <= end) {
+            const RecordHeader* record = RecordAt(offset);
+            if (record->magic != kEntryMagic && record->magic != kRemovedMagic) break;
+            const uint64_t size = RecordSize(record->keyLength, record->valueLength);
+            if (record->valueLength > end || offset + size > end) break;
+            const uint8_t* key = reinterpret_cast<const uint8_t*>(record + 1);
+            if (Checksum(key, record->keyLength, key + record->keyLength, record->valueLength) != record->checksum)
+                break;
+
+            const uint64_t hash = ContentHash(key, record->keyLength);
+            auto it = index.find(hash);
+            if (it != index.end()) Drop(it);
+            if (record->magic == kEntryMagic && record->expiresNs > now) {
+                index[hash] = {offset, ++tick};
+                stats.liveBytes += size;
+            }
+            offset += size;
+        }
+        Header()->end = offset;
+    }
+
+    void Drop(std::unordered_map<uint64_t, Slot>::iterator it)
+    {
+        const RecordHeader* record = RecordAt(it->second.offset);
+        stats.liveBytes -= RecordSize(record->keyLength, record->valueLength);
+        index.erase(it);
+    }
+
+    // Grows the file (geometrically, up to the bound) to fit size more bytes
+    bool Reserve(uint64_t size)
+    {
+        const uint64_t needed = Header()->end + size;
+        if (needed > limit) return false;
+        if (needed <= file.Size()) return true;
+        const uint64_t grown = std::min(limit, std::max(needed, file.Size() * 2));
+        return file.Resize(grown) && file.Data();
+    }
+
+    void Append(uint64_t offset, uint32_t magic, const uint8_t* key, size_t keyLength, const uint8_t* value,
+                size_t valueLength, int64_t expiresNs)
+    {
+        RecordHeader* record = RecordAt(offset);
+        uint8_t* payload = reinterpret_cast<uint8_t*>(record + 1);
+        std::memcpy(payload, key, keyLength);
+        if (valueLength > 0) std::memcpy(payload + keyLength, value, valueLength);
+        const uint64_t size = RecordSize(keyLength, valueLength);
+        std::memset(payload + keyLength + valueLength, 0, size - sizeof(RecordHeader) - keyLength - valueLength);
+        record->keyLength = uint32_t(keyLength);
+        record->valueLength = valueLength;
+        record->expiresNs = expiresNs;
+        record->checksum = Checksum(payload, keyLength, payload + keyLength, valueLength);
+        record->magic = magic;
+        Header()->end = offset + size;
+    }
+
+    // Drops expired entries, then the least recently used ones until at most
+    // target live bytes remain, and slides the survivors to the front
+    void Compact(uint64_t target)
+    {
+        struct Live {
+            uint64_t hash, offset, size, tick;
+        };
+        const int64_t now = NowNs();
+        std::vector<Live> live;
+        live.reserve(index.size());
+        for (const auto& [hash, slot] : index) {
+            const RecordHeader* record = RecordAt(slot.offset);
+            if (record->expiresNs <= now) {
+                stats.evictions++;
+                continue;
+            }
+            live.push_back({hash, slot.offset, RecordSize(record->keyLength, record->valueLength), slot.tick});
+        }
+
+        uint64_t kept = 0;
+        for (const Live& entry : live) kept += entry.size;
+        std::sort(live.begin(), live.end(), [](const Live& a, const Live& b) { return a.tick < b.tick; });
+        size_t first = 0;
+        while (first < live.size() && kept > target) kept -= live[first++].size;
+        stats.evictions += first;
+        live.erase(live.begin(), live.begin() + ptrdiff_t(first));
+
+        // Moving in log order only ever copies a record to a lower offset, and
+        // publishing the new end first means a crash mid-way loses entries
+        // rather than leaving duplicates behind
+        std::sort(live.begin(), live.end(), [](const Live& a, const Live& b) { return a.offset < b.offset; });
+        index.clear();
+        uint64_t end = sizeof(LogHeader);
+        Header()->end = end;
+        for (const Live& entry : live) {
+            if (entry.offset != end) std::memmove(file.Data() + end, file.Data() + entry.offset, entry.size);
+            index[entry.hash] = {end, entry.tick};
+            end += entry.size;
+            Header()->end = end;
+        }
+        stats.liveBytes = kept;
+        stats.compactions++;
+    }
+
+    MappedFile file;
+    std::unordered_map<uint64_t, Slot> index;
+    ResultCacheStats stats = {};
+    uint64_t limit = kMinLogBytes;
+    uint64_t tick = 0;
+};
+
+} // namespace ux::native
@@ -0,0 +1,728 @@
+#pragma once
+
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <unistd.h>
+
+// Damage tracking needs libXdamage and libXfixes; ./build_game.sh capture
+// defines this when pkg-config finds them
+#ifndef UX_CAPTURE_DAMAGE
+#define UX_CAPTURE_DAMAGE 0
+#endif
+#if UX_CAPTURE_DAMAGE
+#include <X11/extensions/Xdamage.h>
+#include <X11/extensions/Xfixes.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Screen capture through the MIT-SHM extension.
+//
+// XGetImage sends every frame through the X socket; XShmGetImage asks the
+// server to copy the pixels into a System V shared segment this process has
+// attached, so a 1080p grab is one server-side memcpy and no socket traffic.
+// Segments are created once per slot and reused until the target is resized.
+//
+// Frames land in a small ring of slots. A slot is pinned while a reader holds
+// it (Python wraps it in a numpy view without copying) and the writer only
+// fills slots that are neither pinned nor the latest frame, so a reader never
+// sees a slot being rewritten. Captures are dropped only while every other
+// slot is pinned.
+//
+// With the DAMAGE extension, the server accumulates the area drawn into the
+// target since the last capture (reported once per non-empty cycle, so a
+// burst of drawing costs one event). Every capture takes that region in the
+// same round trip order as the grab (subtract, then XShmGetImage, so nothing
+// drawn in between is lost) and carries its rectangles, coalesced, as the
+// frame's changed regions. Without it every frame reports the whole target.
+//
+// Capture runs on the calling thread (Grab) or on a background thread (Start)
+// either at a fixed rate or whenever damage arrives, at most fps times a
+// second; an idle target then costs no wakeups at all. Xlib calls are
+// serialized by one mutex, so both can be used on the same capture.
+namespace ux::native {
+
+constexpr int32_t kCaptureSlots = 4;
+constexpr int32_t kMaxCaptureRegions = 32;
+// Damage rectangles closer than this are reported as one region
+constexpr int32_t kRegionMergeGap = 8;
+
+enum class CaptureStatus : int32_t {
+    Ok = 0,
+    Timeout = 1,   // no new frame before the deadline
+    Busy = 2,      // every slot is pinned
+    XError = 3,    // the grab failed (target unmapped, off screen or destroyed)
+    Stopped = 4,
+};
+
+struct CaptureRect {
+    int32_t x, y, width, height;
+};
+
+struct CapturedFrame {
+    int32_t slot;
+    int32_t width, height;
+    int32_t stride;
+    uint64_t sequence;       // 1 for the first frame
+    uint64_t timestampNs;    // steady clock (CLOCK_MONOTONIC) after the grab
+    const uint8_t* data;     // BGRX rows
+    int32_t regionCount;     // changed since the previous frame (0: nothing drawn)
+    CaptureRect regions[kMaxCaptureRegions];
+};
+
+struct CaptureCounters {
+    uint64_t frames;
+    uint64_t dropped;        // ticks skipped because every slot was pinned
+    uint64_t failed;         // grabs the server rejected
+};
+
+namespace detail {
+
+// Xlib reports protocol errors through one process-wide handler, called on
+// the thread that waits for the failing request's reply. Errors raised inside
+// an XErrorScope are recorded for that thread; any other error goes to the
+// handler that was installed before (Tk's, or Xlib's default).
+struct XErrorState {
+    bool active = false;
+    int code = 0;
+};
+
+inline XErrorState& ThreadXErrors()
+{
+    static thread_local XErrorState state;
+    return state;
+}
+
+inline XErrorHandler& PreviousXErrorHandler()
+{
+    static XErrorHandler handler = nullptr;
+    return handler;
+}
+
+inline int RecordXError(Display* display, XErrorEvent* event)
+{
+    XErrorState& state = ThreadXErrors();
+    if (state.active) {
+        state.code = event->error_code;
+        return 0;
+    }
+    XErrorHandler previous = PreviousXErrorHandler();
+    return previous ? previous(display, event) : 0;
+}
+
+// Installed again by every Open, in case a toolkit replaced it since
+inline void InstallXErrorHandler()
+{
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    XErrorHandler current = XSetErrorHandler(RecordXError);
+    if (current != RecordXError) PreviousXErrorHandler() = current;
+}
+
+class XErrorScope {
+public:
+    XErrorScope() : outer(ThreadXErrors().active)
+    {
+        ThreadXErrors().active = true;
+        ThreadXErrors().code = 0;
+    }
+    ~XErrorScope() { ThreadXErrors().active = outer; }
+    bool Failed() const { return ThreadXErrors().code != 0; }
+
+private:
+    bool outer;
+};
+
+inline uint64_t SteadyNs()
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count());
+}
+
+inline bool Contains(const char* text, const char* needle)
+{
+    return text && std::strstr(text, needle) != nullptr;
+}
+
+// Merges rectangles within gap pixels of each other into their bounding box,
+// then the pairs whose bounding box adds the least area until at most
+// maxRects remain; sorted top to bottom
+inline void CoalesceRects(std::vector<CaptureRect>& rects, int32_t gap, size_t maxRects)
+{
+    const auto unite = [](const CaptureRect& a, const CaptureRect& b) {
+        const int32_t x0 = std::min(a.x, b.x), y0 = std::min(a.y, b.y);
+        const int32_t x1 = std::max(a.x + a.width, b.x + b.width), y1 = std::max(a.y + a.height, b.y + b.height);
+        return CaptureRect{x0, y0, x1 - x0, y1 - y0};
+    };
+    const auto area = [](const CaptureRect& r) { return int64_t(r.width) * r.height; };
+    // Pathological regions (thousands of scattered pixels) become their bounding box
+    if (rects.size() > 4096) {
+        CaptureRect box = rects[0];
+        for (const CaptureRect& r : rects) box = unite(box, r);
+        rects.assign(1, box);
+    }
+    for (bool merged = true; merged;) {
+        merged = false;
+        for (size_t i = 0; i < rects.size(); i++) {
+            for (size_t j = i + 1; j < rects.size();) {
+                const CaptureRect& a = rects[i];
+                const CaptureRect& b = rects[j];
+                if (a.x <= b.x + b.width + gap && b.x <= a.x + a.width + gap && a.y <= b.y + b.height + gap &&
+                    b.y <= a.y + a.height + gap) {
+                    rects[i] = unite(a, b);
+                    rects[j] = rects.back();
+                    rects.pop_back();
+                    merged = true;
+                } else {
+                    j++;
+                }
+            }
+        }
+    }
+    while (rects.size() > maxRects) {
+        size_t bestI = 0, bestJ = 1;
+        int64_t best = INT64_MAX;
+        for (size_t i = 0; i < rects.size(); i++) {
+            for (size_t j = i + 1; j < rects.size(); j++) {
+                const int64_t cost = area(unite(rects[i], rects[j])) - area(rects[i]) - area(rects[j]);
+                if (cost < best) {
+                    best = cost;
+                    bestI = i;
+                    bestJ = j;
+                }
+            }
+        }
+        rects[bestI] = unite(rects[bestI], rects[bestJ]);
+        rects[bestJ] = rects.back();
+        rects.pop_back();
+    }
+    std::sort(rects.begin(), rects.end(),
+              [](const CaptureRect& a, const CaptureRect& b) { return a.y != b.y ? a.y < b.y : a.x < b.x; });
+}
+
+// True if the window's title (WM_NAME or _NET_WM_NAME) or WM_CLASS contains name
+inline bool WindowMatches(Display* display, Window window, const char* name)
+{
+    bool match = false;
+    char* title = nullptr;
+    if (XFetchName(display, window, &title) && title) {
+        match = Contains(title, name);
+        XFree(title);
+    }
+    if (!match) {
+        const Atom netName = XInternAtom(display, "_NET_WM_NAME", True);
+        const Atom utf8 = XInternAtom(display, "UTF8_STRING", True);
+        Atom type = 0;
+        int format = 0;
+        unsigned long items = 0, after = 0;
+        unsigned char* value = nullptr;
+        if (netName != 0 && utf8 != 0 &&
+            XGetWindowProperty(display, window, netName, 0, 1024, False, utf8, &type, &format, &items, &after,
+                               &value) == Success &&
+            value) {
+            match = type == utf8 && Contains(reinterpret_cast<const char*>(value), name);
+            XFree(value);
+        }
+    }
+    if (!match) {
+        XClassHint hint{};
+        if (XGetClassHint(display, window, &hint)) {
+            match = Contains(hint.res_name, name) || Contains(hint.res_class, name);
+            if (hint.res_name) XFree(hint.res_name);
+            if (hint.res_class) XFree(hint.res_class);
+        }
+    }
+    return match;
+}
+
+// Depth-first search for a viewable window whose name contains name, or 0
+inline Window FindWindow(Display* display, Window parent, const char* name)
+{
+    Window root = 0, parentOut = 0, *children = nullptr;
+    unsigned int count = 0;
+    if (!XQueryTree(display, parent, &root, &parentOut, &children, &count)) return 0;
+    Window found = 0;
+    // Children are listed bottom to top; the topmost match wins
+    for (unsigned int i = count; i-- > 0 && !found;) {
+        XWindowAttributes attributes;
+        if (!XGetWindowAttributes(display, children[i], &attributes) || attributes.map_state != IsViewable) continue;
+        if (WindowMatches(display, children[i], name))
+            found = children[i];
+        else
+            found = FindWindow(display, children[i], name);
+    }
+    if (children) XFree(children);
+    return found;
+}
+
+} // namespace detail
+
+class ShmCapture {
+public:
+    ShmCapture() = default;
+    ShmCapture(const ShmCapture&) = delete;
+    ShmCapture& operator=(const ShmCapture&) = delete;
+
+    ~ShmCapture()
+    {
+        Stop();
+        for (Slot& slot : slots) DestroySlot(slot);
+#if UX_CAPTURE_DAMAGE
+        if (damage) XDamageDestroy(display, damage);
+        if (parts) XFixesDestroyRegion(display, parts);
+#endif
+        if (display) XCloseDisplay(display);
+        for (int fd : wakeFds) {
+            if (fd >= 0) close(fd);
+        }
+    }
+
+    // Connects to displayName (null: $DISPLAY) and targets the topmost
+    // viewable window whose title or class contains windowName (null or
+    // empty: the whole screen). On failure error says why.
+    bool Open(const char* displayName, const char* windowName, std::string& error)
+    {
+        detail::InstallXErrorHandler();
+        display = XOpenDisplay(displayName);
+        if (!display) {
+            error = "cannot open X display";
+            return false;
+        }
+        int major = 0, minor = 0;
+        Bool pixmaps = False;
+        if (!XShmQueryVersion(display, &major, &minor, &pixmaps)) {
+            error = "X server has no MIT-SHM extension";
+            return false;
+        }
+        // Windows may vanish while the tree is searched
+        detail::XErrorScope errors;
+        window = DefaultRootWindow(display);
+        if (windowName && *windowName) {
+            window = detail::FindWindow(display, window, windowName);
+            if (!window) {
+                error = std::string("no window named '") + windowName + "'";
+                return false;
+            }
+        }
+        XWindowAttributes attributes;
+        if (!XGetWindowAttributes(display, window, &attributes)) {
+            error = "cannot query the target window";
+            return false;
+        }
+        Visual* v = attributes.visual;
+        if ((attributes.depth != 24 && attributes.depth != 32) || v->red_mask != 0xff0000 ||
+            v->green_mask != 0x00ff00 || v->blue_mask != 0x0000ff) {
+            error = "unsupported visual (expected 24/32-bit TrueColor)";
+            return false;
+        }
+        visual = v;
+        depth = attributes.depth;
+        width = attributes.width;
+        height = attributes.height;
+        // Resizes and destruction arrive as events, drained before each grab
+        XSelectInput(display, window, StructureNotifyMask);
+        OpenDamage();
+        pendingRegions.assign(1, CaptureRect{0, 0, width, height});
+        if (pipe2(wakeFds, O_CLOEXEC | O_NONBLOCK) != 0) {
+            error = "cannot create the wakeup pipe";
+            return false;
+        }
+
+        // Fails early on remote displays, where the server cannot attach the segment
+        if (!CreateSlot(slots[0], width, height)) {
+            error = "cannot share memory with the X server (remote display?)";
+            return false;
+        }
+        return true;
+    }
+
+    // Captures now on the calling thread and pins the frame
+    CaptureStatus Grab(CapturedFrame& out)
+    {
+        std::lock_guard<std::mutex> xLock(xMutex);
+        const CaptureStatus status = CaptureOnce(&out);
+        // Events read while waiting for the image are queued, not on the
+        // socket the background thread polls
+        if (running && XEventsQueued(display, QueuedAlready) > 0) Wake();
+        return status;
+    }
+
+    // Captures on a background thread until Stop: every 1 / fps seconds, or
+    // with onDamage whenever the target is drawn to, at most fps times a second
+    bool Start(double fps, bool onDamage)
+    {
+        if (!(fps > 0.0) || (onDamage && !tracking) || running.exchange(true)) return false;
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            stopRequested = false;
+        }
+        if (onDamage) {
+            // The first frame is taken straight away, as a reference
+            std::lock_guard<std::mutex> xLock(xMutex);
+            damaged = true;
+        }
+        const auto period = std::chrono::nanoseconds(int64_t(1e9 / fps));
+        worker = std::thread([this, period, onDamage] { onDamage ? RunOnDamage(period) : Run(period); });
+        return true;
+    }
+
+    void Stop()
+    {
+        if (!running) return;
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            stopRequested = true;
+        }
+        wake.notify_all();
+        Wake();
+        if (worker.joinable()) worker.join();
+        running = false;
+    }
+
+    // Pins the latest frame once its sequence exceeds afterSequence (any frame
+    // when negative), waiting up to timeoutMs
+    CaptureStatus Acquire(int64_t afterSequence, int32_t timeoutMs, CapturedFrame& out)
+    {
+        std::unique_lock<std::mutex> lock(stateMutex);
+        const auto ready = [&] {
+            return stopRequested || (latest >= 0 && int64_t(slots[latest].sequence) > afterSequence);
+        };
+        if (!wake.wait_for(lock, std::chrono::milliseconds(std::max(timeoutMs, 0)), ready))
+            return CaptureStatus::Timeout;
+        if (latest < 0 || int64_t(slots[latest].sequence) <= afterSequence) return CaptureStatus::Stopped;
+        Pin(latest, out);
+        return CaptureStatus::Ok;
+    }
+
+    void Release(int32_t slot)
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        if (slot >= 0 && slot < kCaptureSlots && slots[slot].pins > 0) slots[slot].pins--;
+    }
+
+    CaptureCounters Counters() const
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        return counters;
+    }
+
+    bool Running() const { return running; }
+
+    // True when frames carry the damaged regions rather than the whole target
+    bool TracksDamage() const { return tracking; }
+
+private:
+    struct Slot {
+        XImage* image = nullptr;
+        XShmSegmentInfo shm{};
+        int32_t pins = 0;
+        uint64_t sequence = 0;
+        uint64_t timestampNs = 0;
+        int32_t regionCount = 0;
+        CaptureRect regions[kMaxCaptureRegions];
+    };
+
+    void OpenDamage()
+    {
+#if UX_CAPTURE_DAMAGE
+        int errorBase = 0, fixesEvent = 0, fixesError = 0;
+        if (!XDamageQueryExtension(display, &damageEventBase, &errorBase) ||
+            !XFixesQueryExtension(display, &fixesEvent, &fixesError))
+            return;
+        // Both extensions expect the client's version before any other request
+        int major = 1, minor = 1;
+        XDamageQueryVersion(display, &major, &minor);
+        major = 2, minor = 0;
+        XFixesQueryVersion(display, &major, &minor);
+        detail::XErrorScope errors;
+        damage = XDamageCreate(display, window, XDamageReportNonEmpty);
+        parts = XFixesCreateRegion(display, nullptr, 0);
+        XSync(display, False);
+        tracking = damage != 0 && parts != 0 && !errors.Failed();
+#endif
+    }
+
+    // Moves the area drawn since the last call into pendingRegions; without
+    // damage tracking that is the whole target
+    void TakeDamage()
+    {
+        if (!tracking) {
+            pendingRegions.assign(1, CaptureRect{0, 0, width, height});
+            return;
+        }
+#if UX_CAPTURE_DAMAGE
+        XDamageSubtract(display, damage, None, parts);
+        int count = 0;
+        XRectangle* rects = XFixesFetchRegion(display, parts, &count);
+        for (int i = 0; i < count; i++)
+            pendingRegions.push_back(CaptureRect{rects[i].x, rects[i].y, rects[i].width, rects[i].height});
+        if (rects) XFree(rects);
+        damaged = false;
+#endif
+    }
+
+    void Wake()
+    {
+        const char byte = 1;
+        if (wakeFds[1] >= 0 && write(wakeFds[1], &byte, 1) < 0) {
+            // Full pipe: a wakeup is pending anyway
+        }
+    }
+
+    bool CreateSlot(Slot& slot, int32_t w, int32_t h)
+    {
+        DestroySlot(slot);
+        slot.image = XShmCreateImage(display, visual, unsigned(depth), ZPixmap, nullptr, &slot.shm, unsigned(w),
+                                     unsigned(h));
+        if (!slot.image || slot.image->bits_per_pixel != 32) {
+            DestroySlot(slot);
+            return false;
+        }
+        slot.shm.shmid = shmget(IPC_PRIVATE, size_t(slot.image->bytes_per_line) * h, IPC_CREAT | 0600);
+        if (slot.shm.shmid < 0) {
+            DestroySlot(slot);
+            return false;
+        }
+        slot.shm.shmaddr = slot.image->data = static_cast<char*>(shmat(slot.shm.shmid, nullptr, 0));
+        slot.shm.readOnly = False;
+        if (slot.shm.shmaddr == reinterpret_cast<char*>(-1)) {
+            slot.shm.shmaddr = slot.image->data = nullptr;
+            DestroySlot(slot);
+            return false;
+        }
+        bool attached = false;
+        {
+            detail::XErrorScope errors;
+            attached = XShmAttach(display, &slot.shm) && (XSync(display, False), !errors.Failed());
+        }
+        // Marked for removal now, so the segment goes away with the last
+        // process attached to it even if this one is killed
+        shmctl(slot.shm.shmid, IPC_RMID, nullptr);
+        if (!attached) {
+            slot.shm.shmid = -1;
+            DestroySlot(slot);
+            return false;
+        }
+        return true;
+    }
+
+    void DestroySlot(Slot& slot)
+    {
+        if (slot.image) {
+            if (slot.shm.shmaddr) {
+                if (slot.shm.shmid >= 0) {
+                    XShmDetach(display, &slot.shm);
+                    XSync(display, False);
+                }
+                shmdt(slot.shm.shmaddr);
+            }
+            // The pixels belong to the segment, not to Xlib's allocator
+            slot.image->data = nullptr;
+            XDestroyImage(slot.image);
+        }
+        slot.image = nullptr;
+        slot.shm = XShmSegmentInfo{};
+        slot.shm.shmid = -1;
+    }
+
+    // Applies resizes; returns false once the target window is destroyed
+    bool DrainEvents()
+    {
+        while (XPending(display)) {
+            XEvent event;
+            XNextEvent(display, &event);
+            if (event.type == ConfigureNotify && event.xconfigure.window == window) {
+                if (event.xconfigure.width != width || event.xconfigure.height != height) {
+                    width = event.xconfigure.width;
+                    height = event.xconfigure.height;
+                    pendingRegions.assign(1, CaptureRect{0, 0, width, height});
+                }
+            } else if (event.type == DestroyNotify && event.xdestroywindow.window == window) {
+                destroyed = true;
+            }
+#if UX_CAPTURE_DAMAGE
+            else if (tracking && event.type == damageEventBase + XDamageNotify) {
+                damaged = true;
+            }
+#endif
+        }
+        return !destroyed;
+    }
+
+    void Pin(int32_t index, CapturedFrame& out)
+    {
+        Slot& slot = slots[index];
+        slot.pins++;
+        out.slot = index;
+        out.width = slot.image->width;
+        out.height = slot.image->height;
+        out.stride = slot.image->bytes_per_line;
+        out.sequence = slot.sequence;
+        out.timestampNs = slot.timestampNs;
+        out.data = reinterpret_cast<const uint8_t*>(slot.image->data);
+        out.regionCount = slot.regionCount;
+        std::copy(slot.regions, slot.regions + slot.regionCount, out.regions);
+    }
+
+    // One grab into a free slot, published as the latest frame (and pinned
+    // into *out when given). Called with xMutex held.
+    CaptureStatus CaptureOnce(CapturedFrame* out)
+    {
+        if (!DrainEvents()) return CaptureStatus::XError;
+        int32_t index = -1;
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            for (int32_t i = 0; i < kCaptureSlots && index < 0; i++) {
+                if (i != latest && slots[i].pins == 0) index = i;
+            }
+            if (index < 0) {
+                counters.dropped++;
+                return CaptureStatus::Busy;
+            }
+        }
+        // Unpinned and not the latest, so no reader can reach it until it is published
+        Slot& slot = slots[index];
+        if (!slot.image || slot.image->width != width || slot.image->height != height) {
+            if (!CreateSlot(slot, width, height)) {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                counters.failed++;
+                return CaptureStatus::XError;
+            }
+        }
+        // Damage is taken before the grab: drawing that lands in between is
+        // both in this image and reported again with the next one
+        TakeDamage();
+        bool ok = false;
+        {
+            detail::XErrorScope errors;
+            ok = XShmGetImage(display, window, slot.image, 0, 0, AllPlanes) && !errors.Failed();
+        }
+        const uint64_t now = detail::SteadyNs();
+        if (ok) {
+            // Clipped to the image; regions of failed grabs carry over
+            std::vector<CaptureRect> regions;
+            for (const CaptureRect& r : pendingRegions) {
+                const int32_t x0 = std::max(r.x, 0), y0 = std::max(r.y, 0);
+                const int32_t x1 = std::min(r.x + r.width, width), y1 = std::min(r.y + r.height, height);
+                if (x1 > x0 && y1 > y0) regions.push_back(CaptureRect{x0, y0, x1 - x0, y1 - y0});
+            }
+            pendingRegions.clear();
+            detail::CoalesceRects(regions, kRegionMergeGap, kMaxCaptureRegions);
+            slot.regionCount = int32_t(regions.size());
+            std::copy(regions.begin(), regions.end(), slot.regions);
+        }
+
+        std::lock_guard<std::mutex> lock(stateMutex);
+        if (!ok) {
+            counters.failed++;
+            return CaptureStatus::XError;
+        }
+        slot.sequence = ++counters.frames;
+        slot.timestampNs = now;
+        latest = index;
+        if (out) Pin(index, *out);
+        wake.notify_all();
+        return CaptureStatus::Ok;
+    }
+
+    void Run(std::chrono::nanoseconds period)
+    {
+        auto next = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(stateMutex);
+        while (!stopRequested) {
+            lock.unlock();
+            {
+                std::lock_guard<std::mutex> xLock(xMutex);
+                CaptureOnce(nullptr);
+            }
+            // Ticks missed while a grab overran are skipped, not caught up
+            const auto now = std::chrono::steady_clock::now();
+            next += period;
+            if (next < now) next = now + period;
+            lock.lock();
+            wake.wait_until(lock, next, [this] { return stopRequested; });
+        }
+    }
+
+    // Sleeps in poll() on the X connection until damage is reported, then
+    // captures, no sooner than minInterval after the previous capture
+    void RunOnDamage(std::chrono::nanoseconds minInterval)
+    {
+        const int xfd = ConnectionNumber(display);
+        auto earliest = std::chrono::steady_clock::now();
+        for (;;) {
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                if (stopRequested) return;
+            }
+            int timeoutMs = -1;
+            {
+                std::lock_guard<std::mutex> xLock(xMutex);
+                DrainEvents();
+                if (damaged && !destroyed) {
+                    const auto now = std::chrono::steady_clock::now();
+                    if (now >= earliest) {
+                        // A busy ring or failed grab is retried at the frame rate
+                        CaptureOnce(nullptr);
+                        earliest = now + minInterval;
+                        continue;
+                    }
+                    timeoutMs = int32_t(std::chrono::ceil<std::chrono::milliseconds>(earliest - now).count());
+                }
+                XFlush(display);
+                if (XEventsQueued(display, QueuedAlready) > 0) continue;
+            }
+            pollfd fds[2] = {{xfd, POLLIN, 0}, {wakeFds[0], POLLIN, 0}};
+            poll(fds, 2, timeoutMs);
+            if (fds[1].revents & POLLIN) {
+                char drain[64];
+                while (read(wakeFds[0], drain, sizeof(drain)) > 0) {}
+            }
+        }
+    }
+
+    Display* display = nullptr;
+    Visual* visual = nullptr;
+    Window window = 0;
+    int depth = 0;
+    int32_t width = 0, height = 0;
+    bool destroyed = false;
+    bool tracking = false;             // set once in Open
+    bool damaged = false;              // damage reported since the last TakeDamage
+    std::vector<CaptureRect> pendingRegions;
+#if UX_CAPTURE_DAMAGE
+    int damageEventBase = 0;
+    Damage damage = 0;
+    XserverRegion parts = 0;
+#endif
+    int wakeFds[2] = {-1, -1};         // wakes RunOnDamage out of poll()
+
+    Slot slots[kCaptureSlots];
+    int32_t latest = -1;
+    CaptureCounters counters{};
+
+    std::mutex xMutex;                 // Xlib calls and the fields above slots
+    mutable std::mutex stateMutex;     // pins, sequences, latest and counters
+    std::condition_variable wake;
+    std::thread worker;
+    std::atomic<bool> running{false};
+    bool stopRequested = true;         // no background capture: Acquire does not wait for one
+};
+
+} // namespace ux::native
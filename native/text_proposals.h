@@ -0,0 +1,484 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "native/image_diff.h"
+#include "native/image_stats.h"
+#include "native/region_detector.h"
+
+// Text-line proposals behind UIElementDetector._detect_text_regions.
+//
+// Glyphs are maximally stable extremal regions (MSER) of luma, found with the
+// linear-time component tree of Nister and Stewenius: a flood from one seed
+// pixel that always continues at the darkest accessible pixel, with the
+// boundary kept in one stack per grey level and the growing components on a
+// stack of their own. Each time a component is raised to a higher level or
+// merged into another, a tree node is emitted with its area and bbox, so
+// no pixel lists are kept. A node is stable when its area grows by at most
+// kMserMaxVariation within kMserDelta levels, by less than its parent's and
+// by no more than its largest child's. Luma and its inverse are searched (dark
+// and light text); glyph-shaped regions are chained into lines by vertical
+// overlap, similar height and horizontal gaps of at most a glyph height.
+//
+// A TextProposer keeps its buffers and the previous frame's glyphs between
+// calls. Incremental runs search only the kTextTile tiles whose luma changed,
+// each with a margin that holds any glyph touching them; glyphs elsewhere are
+// carried over.
+namespace ux::native {
+
+struct TextLine {
+    int32_t x, y, width, height;
+    int32_t glyphs;      // distinct glyphs of the line's polarity
+    int32_t polarity;    // 0 dark text on a light background, 1 light on dark
+    float confidence;
+};
+
+namespace detail {
+
+constexpr int32_t kMserDelta = 5;
+constexpr double kMserMaxVariation = 0.25;
+constexpr int32_t kGlyphMinArea = 10, kGlyphMinHeight = 6, kGlyphMaxHeight = 100;
+constexpr int32_t kTextTile = 64;
+// Margin searched around changed tiles, in tiles: a glyph is at most
+// kGlyphMaxHeight tall and 2 * height + 2 wide
+constexpr int32_t kTextMarginX = 4, kTextMarginY = 2;
+
+struct Glyph {
+    int32_t x0, y0, x1, y1;     // half-open, frame coordinates
+    int32_t area;
+    int32_t polarity;
+};
+
+struct TreeNode {
+    int32_t level, area;
+    int32_t x0, y0, x1, y1;     // inclusive, search-rectangle coordinates
+    int32_t parent;
+    int32_t next;               // sibling awaiting the same parent
+};
+
+struct Component {
+    int32_t level;
+    int32_t area = 0;
+    int32_t x0 = INT32_MAX, y0 = INT32_MAX, x1 = -1, y1 = -1;
+    int32_t pending = -1;       // nodes whose parent is this component's next node
+
+    void Add(int32_t x, int32_t y)
+    {
+        area++;
+        x0 = std::min(x0, x);
+        y0 = std::min(y0, y);
+        x1 = std::max(x1, x);
+        y1 = std::max(y1, y);
+    }
+};
+
+struct Rect {
+    int32_t x0, y0, x1, y1;     // half-open
+
+    bool Overlaps(const Rect& o) const { return x0 < o.x1 && o.x0 < x1 && y0 < o.y1 && o.y0 < y1; }
+};
+
+} // namespace detail
+
+class TextProposer {
+public:
+    // Text lines of the frame, top to bottom. An incremental run on a frame of
+    // the previous size searches only what changed since the previous run.
+    const std::vector<TextLine>& Run(const ImageView& img, bool incremental)
+    {
+        const int32_t w = img.width, h = img.height;
+        luma.resize(size_t(w) * h);
+        const detail::LumaWeights weights(img.bgr);
+        for (int32_t y = 0; y < h; y++) detail::LumaRow(img.Row(y), w, img.channels, weights, &luma[size_t(y) * w]);
+
+        const bool reuse = incremental && w == width && h == height;
+        width = w;
+        height = h;
+        searched = 0;
+        if (!reuse) {
+            glyphs.clear();
+            Search({0, 0, w, h}, false);
+        } else if (MarkChangedTiles()) {
+            std::vector<detail::Rect> rects = DirtyRects();
+            glyphs.erase(std::remove_if(glyphs.begin(), glyphs.end(),
+                                        [&](const detail::Glyph& g) { return TouchesDirty(g); }),
+                         glyphs.end());
+            for (const detail::Rect& r : rects) Search(r, true);
+        } else {
+            std::swap(luma, previous);
+            return lines;
+        }
+        ChainLines();
+        std::swap(luma, previous);
+        return lines;
+    }
+
+    // Pixels searched by the last run (twice that many were flooded, one pass
+    // per polarity)
+    int64_t Searched() const { return searched; }
+
+private:
+    // Searches rect for glyphs of both polarities. With onlyDirty, keeps the
+    // glyphs that touch a changed tile and lie clear of the rect's inner edges.
+    void Search(const detail::Rect& rect, bool onlyDirty)
+    {
+        searched += int64_t(rect.x1 - rect.x0) * (rect.y1 - rect.y0);
+        for (int32_t polarity = 0; polarity < 2; polarity++) {
+            Flood(rect, polarity);
+            CollectGlyphs(rect, polarity, onlyDirty);
+        }
+    }
+
+    // Component tree of rect's luma (inverted for polarity 1) into nodes
+    void Flood(const detail::Rect& rect, int32_t polarity)
+    {
+        const int32_t w = rect.x1 - rect.x0, h = rect.y1 - rect.y0, pw = w + 2;
+        const uint8_t flip = polarity ? 0xFF : 0;
+
+        // One-pixel border of already accessible cells, so neighbours need no
+        // bounds checks. edges: 0 not yet accessible, k in 1..4 next edge k - 1
+        levels.resize(size_t(pw) * (h + 2));
+        edges.assign(levels.size(), 5);
+        uint32_t histogram[256] = {};
+        for (int32_t y = 0; y < h; y++) {
+            const uint8_t* src = &luma[size_t(rect.y0 + y) * width + rect.x0];
+            uint8_t* dst = &levels[size_t(y + 1) * pw + 1];
+            for (int32_t x = 0; x < w; x++) {
+                dst[x] = src[x] ^ flip;
+                histogram[dst[x]]++;
+            }
+            std::memset(&edges[size_t(y + 1) * pw + 1], 0, size_t(w));
+        }
+
+        // Boundary stacks, one per level: a pixel is on at most one at a time
+        heap.resize(size_t(w) * h);
+        uint32_t offset = 0;
+        for (int level = 0; level < 256; level++) {
+            heapStart[level] = heapTop[level] = offset;
+            offset += histogram[level];
+        }
+        std::fill(std::begin(nonEmpty), std::end(nonEmpty), 0);
+
+        nodes.clear();
+        stack.clear();
+        stack.push_back(detail::Component{256});
+        const int32_t step[4] = {1, pw, -1, -pw};
+        int32_t p = pw + 1;
+        int32_t level = levels[p];
+        edges[p] = 1;
+        stack.push_back(detail::Component{level});
+        for (;;) {
+            while (edges[p] <= 4) {
+                const int32_t n = p + step[edges[p]++ - 1];
+                if (edges[n]) continue;
+                edges[n] = 1;
+                if (levels[n] >= level) {
+                    Push(n, levels[n]);
+                } else {
+                    // Descend: p resumes with its remaining edges later
+                    Push(p, level);
+                    p = n;
+                    level = levels[n];
+                    stack.push_back(detail::Component{level});
+                }
+            }
+            const int32_t y = p / pw;
+            stack.back().Add(p - y * pw - 1, y - 1);
+
+            const int32_t next = LowestLevel();
+            if (next < 0) break;
+            p = Pop(next);
+            if (next > level) {
+                Raise(next);
+                level = next;
+            }
+        }
+        Raise(256);
+    }
+
+    void Push(int32_t p, int32_t level)
+    {
+        heap[heapTop[level]++] = p;
+        nonEmpty[level >> 6] |= uint64_t(1) << (level & 63);
+    }
+
+    int32_t Pop(int32_t level)
+    {
+        const int32_t p = heap[--heapTop[level]];
+        if (heapTop[level] == heapStart[level]) nonEmpty[level >> 6] &= ~(uint64_t(1) << (level & 63));
+        return p;
+    }
+
+    int32_t LowestLevel() const
+    {
+        for (int i = 0; i < 4; i++) {
+            if (nonEmpty[i]) return i * 64 + __builtin_ctzll(nonEmpty[i]);
+        }
+        return -1;
+    }
+
+    // Emits the top components until the top is at level or above it
+    void Raise(int32_t level)
+    {
+        while (level > stack.back().level) {
+            detail::Component top = stack.back();
+            stack.pop_back();
+            const int32_t node = Emit(top);
+            if (level < stack.back().level) {
+                top.level = level;
+                stack.push_back(top);
+                return;
+            }
+            detail::Component& below = stack.back();
+            below.area += top.area;
+            below.x0 = std::min(below.x0, top.x0);
+            below.y0 = std::min(below.y0, top.y0);
+            below.x1 = std::max(below.x1, top.x1);
+            below.y1 = std::max(below.y1, top.y1);
+            nodes[node].next = below.pending;
+            below.pending = node;
+        }
+    }
+
+    // Records the component at its current level as a tree node
+    int32_t Emit(detail::Component& c)
+    {
+        const int32_t node = int32_t(nodes.size());
+        nodes.push_back({c.level, c.area, c.x0, c.y0, c.x1, c.y1, -1, -1});
+        for (int32_t child = c.pending; child >= 0; child = nodes[child].next) nodes[child].parent = node;
+        c.pending = node;
+        return node;
+    }
+
+    // Stable, glyph-shaped nodes of the last flood into glyphs
+    void CollectGlyphs(const detail::Rect& rect, int32_t polarity, bool onlyDirty)
+    {
+        const size_t count = nodes.size();
+        variation.resize(count);
+        largestChild.assign(count, -1);
+        for (size_t i = 0; i < count; i++) {
+            // Area kMserDelta levels up: the last ancestor at or below that level
+            int32_t up = int32_t(i);
+            const int32_t limit = nodes[i].level + detail::kMserDelta;
+            while (nodes[up].parent >= 0 && nodes[nodes[up].parent].level <= limit) up = nodes[up].parent;
+            variation[i] = float(nodes[up].area - nodes[i].area) / float(nodes[i].area);
+            const int32_t parent = nodes[i].parent;
+            if (parent >= 0 && (largestChild[parent] < 0 || nodes[i].area > nodes[largestChild[parent]].area)) {
+                largestChild[parent] = int32_t(i);
+            }
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            const detail::TreeNode& n = nodes[i];
+            if (n.parent < 0 || variation[i] > detail::kMserMaxVariation) continue;  // the root is the whole rect
+            if (variation[i] >= variation[n.parent]) continue;
+            if (largestChild[i] >= 0 && variation[i] > variation[largestChild[i]]) continue;
+
+            const int32_t w = n.x1 - n.x0 + 1, h = n.y1 - n.y0 + 1;
+            if (n.area < detail::kGlyphMinArea || h < detail::kGlyphMinHeight || h > detail::kGlyphMaxHeight ||
+                w > 2 * h + 2) {
+                continue;
+            }
+            // Solid blocks are not glyphs, unless thin strokes (l, I, 1)
+            const double fill = double(n.area) / (double(w) * h);
+            if (fill < 0.1 || (fill > 0.95 && 4 * w > h)) continue;
+
+            const detail::Glyph g{rect.x0 + n.x0, rect.y0 + n.y0, rect.x0 + n.x1 + 1, rect.y0 + n.y1 + 1, n.area,
+                                  polarity};
+            if (onlyDirty) {
+                const bool clipped = (g.x0 == rect.x0 && rect.x0 > 0) || (g.y0 == rect.y0 && rect.y0 > 0) ||
+                                     (g.x1 == rect.x1 && rect.x1 < width) || (g.y1 == rect.y1 && rect.y1 < height);
+                if (clipped || !TouchesDirty(g)) continue;
+            }
+            glyphs.push_back(g);
+        }
+    }
+
+    // Flags the tiles whose luma differs from the previous frame; false if none
+    bool MarkChangedTiles()
+    {
+        tilesX = TileCount(width, detail::kTextTile);
+        tilesY = TileCount(height, detail::kTextTile);
+        dirty.assign(size_t(tilesX) * tilesY, 0);
+        bool any = false;
+        for (int32_t y = 0; y < height; y++) {
+            const uint8_t* a = &luma[size_t(y) * width];
+            const uint8_t* b = &previous[size_t(y) * width];
+            uint8_t* row = &dirty[size_t(y / detail::kTextTile) * tilesX];
+            for (int32_t tx = 0; tx < tilesX; tx++) {
+                if (row[tx]) continue;
+                const int32_t x0 = tx * detail::kTextTile, n = std::min(detail::kTextTile, width - x0);
+                if (std::memcmp(a + x0, b + x0, size_t(n)) != 0) row[tx] = any = true;
+            }
+        }
+        return any;
+    }
+
+    bool TouchesDirty(const detail::Glyph& g) const
+    {
+        for (int32_t ty = g.y0 / detail::kTextTile; ty <= (g.y1 - 1) / detail::kTextTile; ty++) {
+            for (int32_t tx = g.x0 / detail::kTextTile; tx <= (g.x1 - 1) / detail::kTextTile; tx++) {
+                if (dirty[size_t(ty) * tilesX + tx]) return true;
+            }
+        }
+        return false;
+    }
+
+    // Disjoint pixel rectangles covering the changed tiles and their margins
+    std::vector<detail::Rect> DirtyRects()
+    {
+        // Grow the changed tiles by the margin, then take the bbox of every
+        // 4-connected group of grown tiles
+        grown.assign(dirty.size(), 0);
+        for (int32_t ty = 0; ty < tilesY; ty++) {
+            for (int32_t tx = 0; tx < tilesX; tx++) {
+                if (!dirty[size_t(ty) * tilesX + tx]) continue;
+                for (int32_t y = std::max(0, ty - detail::kTextMarginY); y <= std::min(tilesY - 1, ty + detail::kTextMarginY); y++) {
+                    std::fill(&grown[size_t(y) * tilesX + std::max(0, tx - detail::kTextMarginX)],
+                              &grown[size_t(y) * tilesX + std::min(tilesX - 1, tx + detail::kTextMarginX)] + 1, 1);
+                }
+            }
+        }
+        std::vector<detail::Rect> rects;
+        std::vector<int32_t> pending;
+        for (int32_t start = 0; start < int32_t(grown.size()); start++) {
+            if (grown[start] != 1) continue;
+            detail::Rect r{tilesX, tilesY, 0, 0};
+            grown[start] = 2;
+            pending.assign(1, start);
+            while (!pending.empty()) {
+                const int32_t t = pending.back();
+                pending.pop_back();
+                const int32_t tx = t % tilesX, ty = t / tilesX;
+                r = {std::min(r.x0, tx), std::min(r.y0, ty), std::max(r.x1, tx + 1), std::max(r.y1, ty + 1)};
+                const int32_t around[4][2] = {{tx - 1, ty}, {tx + 1, ty}, {tx, ty - 1}, {tx, ty + 1}};
+                for (const auto& a : around) {
+                    if (a[0] < 0 || a[1] < 0 || a[0] >= tilesX || a[1] >= tilesY) continue;
+                    const int32_t n = a[1] * tilesX + a[0];
+                    if (grown[n] == 1) {
+                        grown[n] = 2;
+                        pending.push_back(n);
+                    }
+                }
+            }
+            rects.push_back(r);
+        }
+        // Bboxes of separate groups can still overlap; merge until disjoint
+        for (bool merged = true; merged;) {
+            merged = false;
+            for (size_t i = 0; i < rects.size() && !merged; i++) {
+                for (size_t j = i + 1; j < rects.size(); j++) {
+                    if (!rects[i].Overlaps(rects[j])) continue;
+                    rects[i] = {std::min(rects[i].x0, rects[j].x0), std::min(rects[i].y0, rects[j].y0),
+                                std::max(rects[i].x1, rects[j].x1), std::max(rects[i].y1, rects[j].y1)};
+                    rects.erase(rects.begin() + j);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+        for (detail::Rect& r : rects) {
+            r = {r.x0 * detail::kTextTile, r.y0 * detail::kTextTile, std::min(width, r.x1 * detail::kTextTile),
+                 std::min(height, r.y1 * detail::kTextTile)};
+        }
+        return rects;
+    }
+
+    // Chains the glyphs into lines
+    void ChainLines()
+    {
+        const int32_t count = int32_t(glyphs.size());
+        order.resize(count);
+        for (int32_t i = 0; i < count; i++) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](int32_t a, int32_t b) { return glyphs[a].x0 < glyphs[b].x0; });
+        duplicate.assign(count, 0);
+
+        detail::UnionFind sets;
+        for (int32_t i = 0; i < count; i++) sets.Make();
+        for (int32_t i = 0; i < count; i++) {
+            const detail::Glyph& a = glyphs[order[i]];
+            const int32_t ha = a.y1 - a.y0;
+            // Partners are at most twice as tall, so at most 2 * ha away
+            for (int32_t j = i + 1; j < count && glyphs[order[j]].x0 <= a.x1 + 2 * ha; j++) {
+                const detail::Glyph& b = glyphs[order[j]];
+                const int32_t hb = b.y1 - b.y0, low = std::min(ha, hb), high = std::max(ha, hb);
+                const int32_t overlap = std::min(a.y1, b.y1) - std::max(a.y0, b.y0);
+                const int32_t gap = std::max(a.x0, b.x0) - std::min(a.x1, b.x1);
+                if (2 * overlap < low || high > 2 * low || gap > high) continue;
+                sets.Union(order[i], order[j]);
+                // The same glyph stable at two levels counts once
+                if (a.polarity == b.polarity && NearlySame(a, b)) duplicate[a.area < b.area ? order[i] : order[j]] = 1;
+            }
+        }
+
+        // Per chain: bbox, glyphs and area of each polarity
+        struct Chain {
+            detail::Rect box{INT32_MAX, INT32_MAX, INT32_MIN, INT32_MIN};
+            int32_t glyphs[2] = {};
+            int64_t area[2] = {};
+        };
+        chains.assign(count, -1);
+        std::vector<Chain> found;
+        for (int32_t i = 0; i < count; i++) {
+            const int32_t root = sets.Find(i);
+            if (chains[root] < 0) {
+                chains[root] = int32_t(found.size());
+                found.emplace_back();
+            }
+            Chain& c = found[chains[root]];
+            const detail::Glyph& g = glyphs[i];
+            c.box = {std::min(c.box.x0, g.x0), std::min(c.box.y0, g.y0), std::max(c.box.x1, g.x1),
+                     std::max(c.box.y1, g.y1)};
+            c.glyphs[g.polarity] += !duplicate[i];
+            c.area[g.polarity] += g.area;
+        }
+
+        lines.clear();
+        for (const Chain& c : found) {
+            const int32_t polarity = c.area[1] > c.area[0] ? 1 : 0;
+            const int32_t w = c.box.x1 - c.box.x0, h = c.box.y1 - c.box.y0;
+            if (c.glyphs[polarity] < 2 || w <= 10 || h <= 8) continue;
+            const float confidence = std::min(0.9f, 0.5f + 0.05f * float(c.glyphs[polarity]));
+            lines.push_back({c.box.x0, c.box.y0, w, h, c.glyphs[polarity], polarity, confidence});
+        }
+        std::sort(lines.begin(), lines.end(),
+                  [](const TextLine& a, const TextLine& b) { return a.y != b.y ? a.y < b.y : a.x < b.x; });
+    }
+
+    // One box holds the other and covers at least 70% of it
+    static bool NearlySame(const detail::Glyph& a, const detail::Glyph& b)
+    {
+        const detail::Glyph& outer = (a.x1 - a.x0) * (a.y1 - a.y0) >= (b.x1 - b.x0) * (b.y1 - b.y0) ? a : b;
+        const detail::Glyph& inner = &outer == &a ? b : a;
+        if (inner.x0 < outer.x0 || inner.y0 < outer.y0 || inner.x1 > outer.x1 || inner.y1 > outer.y1) return false;
+        return 10 * int64_t(inner.x1 - inner.x0) * (inner.y1 - inner.y0) >=
+               7 * int64_t(outer.x1 - outer.x0) * (outer.y1 - outer.y0);
+    }
+
+    int32_t width = 0, height = 0;
+    std::vector<uint8_t> luma, previous;       // this and the previous frame
+    int32_t tilesX = 0, tilesY = 0;
+    std::vector<uint8_t> dirty, grown;         // per tile
+    int64_t searched = 0;
+
+    // Flood state, reused across searches
+    std::vector<uint8_t> levels, edges;        // padded search rectangle
+    std::vector<int32_t> heap;
+    uint32_t heapStart[256] = {}, heapTop[256] = {};
+    uint64_t nonEmpty[4] = {};
+    std::vector<detail::Component> stack;
+    std::vector<detail::TreeNode> nodes;
+    std::vector<float> variation;
+    std::vector<int32_t> largestChild;
+
+    std::vector<detail::Glyph> glyphs;         // of the whole frame
+    std::vector<int32_t> order, chains;
+    std::vector<uint8_t> duplicate;
+    std::vector<TextLine> lines;
+};
+
+} // namespace ux::native
@@ -0,0 +1,167 @@
+// Screen capture for the Python capture code (X11 with MIT-SHM, Linux).
+//
+// A separate library from the image kernels so that they keep building
+// without X11 headers. The C ABI is loaded through ctypes
+// (src/capture/native_capture.py); frames stay in the shared segments of
+// native/shm_capture.h and Python maps them as numpy views, so no pixel is
+// copied between the X server's memcpy and the first kernel that reads them.
+// Functions return 0 on success and a negative UX_CAPTURE_E* code otherwise;
+// they never throw across the ABI.
+//
+// Build with: ./build_game.sh capture
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+
+#include "native/shm_capture.h"
+
+#if defined(_WIN32)
+#define UX_CAPTURE_API extern "C" __declspec(dllexport)
+#else
+#define UX_CAPTURE_API extern "C" __attribute__((visibility("default")))
+#endif
+
+// Bumped whenever a signature or struct below changes; native_capture.py checks it
+constexpr int32_t kCaptureAbiVersion = 2;
+
+enum : int32_t {
+    UX_CAPTURE_OK = 0,
+    UX_CAPTURE_EINVAL = -1,
+    UX_CAPTURE_ETIMEDOUT = -2,
+    UX_CAPTURE_EBUSY = -3,
+    UX_CAPTURE_EXERROR = -4,
+    UX_CAPTURE_ESTOPPED = -5,
+};
+
+struct UxCaptureRect {
+    int32_t x, y, width, height;
+};
+
+struct UxCaptureFrame {
+    int32_t slot;
+    int32_t width, height;
+    int32_t stride;
+    uint64_t sequence;
+    uint64_t timestampNs;
+    const uint8_t* data;
+    int32_t regionCount;
+    UxCaptureRect regions[32];
+};
+
+struct UxCaptureStats {
+    uint64_t frames;
+    uint64_t dropped;
+    uint64_t failed;
+};
+
+static_assert(sizeof(UxCaptureFrame) == sizeof(ux::native::CapturedFrame), "UxCaptureFrame mirrors CapturedFrame");
+static_assert(offsetof(UxCaptureFrame, regions) == offsetof(ux::native::CapturedFrame, regions) &&
+                  sizeof(UxCaptureFrame::regions) == sizeof(ux::native::CapturedFrame::regions),
+              "UxCaptureFrame mirrors CapturedFrame");
+static_assert(sizeof(UxCaptureStats) == sizeof(ux::native::CaptureCounters), "UxCaptureStats mirrors CaptureCounters");
+
+struct UxCapture {
+    ux::native::ShmCapture capture;
+};
+
+namespace {
+
+int32_t StatusCode(ux::native::CaptureStatus status)
+{
+    switch (status) {
+    case ux::native::CaptureStatus::Ok: return UX_CAPTURE_OK;
+    case ux::native::CaptureStatus::Timeout: return UX_CAPTURE_ETIMEDOUT;
+    case ux::native::CaptureStatus::Busy: return UX_CAPTURE_EBUSY;
+    case ux::native::CaptureStatus::XError: return UX_CAPTURE_EXERROR;
+    case ux::native::CaptureStatus::Stopped: return UX_CAPTURE_ESTOPPED;
+    }
+    return UX_CAPTURE_EINVAL;
+}
+
+} // namespace
+
+UX_CAPTURE_API int32_t ux_capture_abi_version()
+{
+    return kCaptureAbiVersion;
+}
+
+// Opens a capture of the screen (window_name null or empty) or of the topmost
+// window whose title or class contains window_name, on display (null:
+// $DISPLAY). Returns null on failure, with the reason in error (at most
+// error_capacity bytes, NUL-terminated).
+UX_CAPTURE_API UxCapture* ux_capture_open(const char* display, const char* window_name, char* error,
+                                          int32_t error_capacity)
+{
+    UxCapture* handle = new (std::nothrow) UxCapture;
+    std::string reason = "out of memory";
+    if (handle && handle->capture.Open(display, window_name, reason)) return handle;
+    delete handle;
+    if (error && error_capacity > 0) {
+        std::strncpy(error, reason.c_str(), size_t(error_capacity) - 1);
+        error[error_capacity - 1] = '\0';
+    }
+    return nullptr;
+}
+
+// Stops the background capture and frees every slot; pinned frames must have
+// been released
+UX_CAPTURE_API void ux_capture_close(UxCapture* handle)
+{
+    delete handle;
+}
+
+// Captures a frame on the calling thread and pins it
+UX_CAPTURE_API int32_t ux_capture_grab(UxCapture* handle, UxCaptureFrame* out)
+{
+    if (!handle || !out) return UX_CAPTURE_EINVAL;
+    return StatusCode(handle->capture.Grab(*reinterpret_cast<ux::native::CapturedFrame*>(out)));
+}
+
+// Starts capturing on a background thread: fps frames per second, or with
+// on_damage set whenever the target is drawn to (at most fps per second;
+// EINVAL without damage tracking)
+UX_CAPTURE_API int32_t ux_capture_start(UxCapture* handle, double fps, int32_t on_damage)
+{
+    if (!handle) return UX_CAPTURE_EINVAL;
+    return handle->capture.Start(fps, on_damage != 0) ? UX_CAPTURE_OK : UX_CAPTURE_EINVAL;
+}
+
+// 1 when frames carry the regions drawn since the previous frame (X DAMAGE),
+// 0 when they report the whole target
+UX_CAPTURE_API int32_t ux_capture_tracks_damage(UxCapture* handle)
+{
+    return handle && handle->capture.TracksDamage() ? 1 : 0;
+}
+
+UX_CAPTURE_API void ux_capture_stop(UxCapture* handle)
+{
+    if (handle) handle->capture.Stop();
+}
+
+// Pins the latest frame once its sequence exceeds after_sequence (any frame
+// when negative), waiting up to timeout_ms for the background capture
+UX_CAPTURE_API int32_t ux_capture_acquire(UxCapture* handle, int64_t after_sequence, int32_t timeout_ms,
+                                          UxCaptureFrame* out)
+{
+    if (!handle || !out) return UX_CAPTURE_EINVAL;
+    return StatusCode(
+        handle->capture.Acquire(after_sequence, timeout_ms, *reinterpret_cast<ux::native::CapturedFrame*>(out)));
+}
+
+UX_CAPTURE_API void ux_capture_release(UxCapture* handle, int32_t slot)
+{
+    if (handle) handle->capture.Release(slot);
+}
+
+UX_CAPTURE_API int32_t ux_capture_stats(UxCapture* handle, UxCaptureStats* out)
+{
+    if (!handle || !out) return UX_CAPTURE_EINVAL;
+    const ux::native::CaptureCounters counters = handle->capture.Counters();
+    out->frames = counters.frames;
+    out->dropped = counters.dropped;
+    out->failed = counters.failed;
+    return UX_CAPTURE_OK;
+}
@@ -0,0 +1,794 @@
+// Native image kernels for the Python analysis pipeline.
+//
+// A plain C ABI loaded through ctypes (src/analysis/native.py). ctypes drops
+// the GIL for the duration of every call, so other Python threads keep running
+// while a kernel walks a frame. Functions return 0 on success and a negative
+// UX_NATIVE_E* code for invalid arguments; they never throw across the ABI.
+//
+// Build with: ./build_game.sh native
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "native/area_resample.h"
+#include "native/box_nms.h"
+#include "native/capture_catalog.h"
+#include "native/colour_profile.h"
+#include "native/content_hash.h"
+#include "native/hash_index.h"
+#include "native/image_diff.h"
+#include "native/image_encode.h"
+#include "native/image_stats.h"
+#include "native/ocr_preprocess.h"
+#include "native/perceptual_hash.h"
+#include "native/region_detector.h"
+#include "native/result_cache.h"
+#include "native/text_proposals.h"
+#include "ux_game/simd_fill.h"
+#include "ux_game/worker_pool.h"
+
+#if defined(_WIN32)
+#define UX_NATIVE_API extern "C" __declspec(dllexport)
+#else
+#define UX_NATIVE_API extern "C" __attribute__((visibility("default")))
+#endif
+
+// Bumped whenever a signature or struct below changes; native.py checks it
+constexpr int32_t kNativeAbiVersion = 13;
+
+enum : int32_t {
+    UX_NATIVE_OK = 0,
+    UX_NATIVE_EINVAL = -1,
+    UX_NATIVE_ENOTFOUND = -2,
+};
+
+struct UxDiffStats {
+    uint64_t changed;
+    uint64_t sumSquared;
+    uint64_t pixels;
+};
+
+struct UxImageStats {
+    uint64_t pixels;
+    uint64_t lumaSum, lumaSumSquared;
+    int64_t laplacianSum;
+    uint64_t laplacianSumSquared;
+    int64_t rgSum, yb2Sum;
+    uint64_t rgSumSquared, yb2SumSquared;
+    uint32_t lumaHistogram[256];
+    uint32_t colourHistogram[512];
+};
+
+struct UxRegion {
+    int32_t type;  // 1 button, 2 input field, 3 container
+    int32_t x, y, width, height;
+    int32_t area;
+    float confidence;
+    float meanColour[3];
+    float lumaMean, lumaStd;
+};
+
+struct UxColourProfile {
+    float meanColour[3];
+    float lumaMean, lumaStd;
+    float background[3];
+    float backgroundLuma;
+    float foreground[3];
+    float foregroundLuma;
+    float foregroundShare;
+};
+
+struct UxTextLine {
+    int32_t x, y, width, height;
+    int32_t glyphs;
+    int32_t polarity;  // 0 dark text, 1 light text
+    float confidence;
+};
+
+struct UxOcrOptions {
+    int32_t targetHeight;
+    int32_t maxScale;
+    int32_t blockSize;
+    int32_t offset;
+    int32_t border;
+    int32_t denoise;
+    float maxSkew;
+};
+
+struct UxOcrCrop {
+    int64_t offset;
+    int32_t width, height;
+    int32_t scale;
+    int32_t inverted;
+    float skew;
+};
+
+struct UxEncodeOptions {
+    int32_t maxSize;
+    int32_t format;   // 0 PNG, 1 JPEG
+    int32_t quality;
+};
+
+struct UxCatalogRecord {
+    uint32_t magic;
+    uint32_t flags;   // 1 removed, 2 phash/dhash set
+    int64_t timestampNs;
+    int32_t width, height, channels;
+    uint32_t nameLength;
+    uint64_t nameOffset;
+    uint64_t extraOffset;
+    uint64_t extraLength;
+    uint64_t fileBytes;
+    uint64_t contentHash;
+    uint64_t phash, dhash;
+    char label[32];
+    uint8_t reserved[8];
+};
+
+struct UxResultCacheStats {
+    uint64_t entries;
+    uint64_t liveBytes;
+    uint64_t logBytes;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t compactions;
+};
+
+static_assert(sizeof(UxCatalogRecord) == sizeof(ux::native::CatalogRecord) &&
+                  offsetof(UxCatalogRecord, label) == offsetof(ux::native::CatalogRecord, label),
+              "UxCatalogRecord mirrors ux::native::CatalogRecord");
+static_assert(sizeof(UxResultCacheStats) == sizeof(ux::native::ResultCacheStats),
+              "UxResultCacheStats mirrors ux::native::ResultCacheStats");
+static_assert(sizeof(UxEncodeOptions) == sizeof(ux::native::EncodeOptions),
+              "UxEncodeOptions mirrors ux::native::EncodeOptions");
+static_assert(sizeof(UxOcrOptions) == sizeof(ux::native::OcrOptions), "UxOcrOptions mirrors ux::native::OcrOptions");
+static_assert(sizeof(UxOcrCrop) == sizeof(ux::native::OcrCrop), "UxOcrCrop mirrors ux::native::OcrCrop");
+static_assert(sizeof(UxTextLine) == sizeof(ux::native::TextLine), "UxTextLine mirrors ux::native::TextLine");
+static_assert(sizeof(UxColourProfile) == sizeof(ux::native::ColourProfile),
+              "UxColourProfile mirrors ux::native::ColourProfile");
+static_assert(sizeof(ux::native::Box) == 4 * sizeof(int32_t), "boxes are int32 x, y, w, h");
+static_assert(sizeof(UxRegion) == sizeof(ux::native::Region), "UxRegion mirrors ux::native::Region");
+static_assert(sizeof(ux::native::TileBounds) == 4 * sizeof(int32_t), "tile_bounds is int32 x0, y0, x1, y1");
+
+namespace {
+
+bool MakeView(const uint8_t* data, int64_t stride, int32_t width, int32_t height, int32_t channels, int32_t bgr,
+              ux::native::ImageView& view)
+{
+    if (!data || width <= 0 || height <= 0 || (channels != 3 && channels != 4) ||
+        stride < int64_t(width) * channels) {
+        return false;
+    }
+    view = {data, stride, width, height, channels, bgr != 0};
+    return true;
+}
+
+bool ValidOcrOptions(const UxOcrOptions* o)
+{
+    return o && o->targetHeight >= 0 && o->maxScale >= 1 && o->maxScale <= 16 && o->blockSize >= 3 &&
+           o->blockSize % 2 == 1 && o->border >= 0 && o->maxSkew >= 0 && o->maxSkew <= 30;
+}
+
+bool ValidEncodeOptions(const UxEncodeOptions* o)
+{
+    return o && o->maxSize >= 0 && (o->format == int32_t(ux::native::ImageFormat::Png) ||
+                                    (o->format == int32_t(ux::native::ImageFormat::Jpeg) && o->quality >= 1 &&
+                                     o->quality <= 100));
+}
+
+// A HashIndex behind the opaque handle; calls from different Python threads
+// are serialized
+struct UxHashIndex {
+    std::mutex mutex;
+    ux::native::HashIndex index;
+};
+
+// A TextProposer behind the opaque handle; calls are serialized
+struct UxTextProposer {
+    std::mutex mutex;
+    ux::native::TextProposer proposer;
+};
+
+// A CaptureCatalog behind the opaque handle; calls are serialized
+struct UxCaptureCatalog {
+    std::mutex mutex;
+    ux::native::CaptureCatalog catalog;
+};
+
+// A ResultCache behind the opaque handle; calls are serialized
+struct UxResultCache {
+    std::mutex mutex;
+    ux::native::ResultCache cache;
+};
+
+// Shared by every kernel that splits a frame into bands. Run is not
+// reentrant, so a call that finds the pool busy (another Python thread is
+// using it) runs its bands on the calling thread instead.
+std::mutex poolMutex;
+
+// UX_NATIVE_THREADS overrides the pool size (threads including the caller)
+ux::WorkerPool& Pool()
+{
+    static ux::WorkerPool pool([] {
+        const char* threads = std::getenv("UX_NATIVE_THREADS");
+        return threads ? unsigned(std::max(0, std::atoi(threads))) : 0u;
+    }());
+    return pool;
+}
+
+template <typename F>
+void RunBands(size_t count, int32_t threads, F&& task)
+{
+    std::unique_lock<std::mutex> lock(poolMutex, std::defer_lock);
+    if (threads != 1 && lock.try_lock()) {
+        Pool().Run(count, task);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) task(i);
+}
+
+} // namespace
+
+UX_NATIVE_API int32_t ux_native_abi_version()
+{
+    return kNativeAbiVersion;
+}
+
+UX_NATIVE_API const char* ux_native_simd_level()
+{
+    return ux::simd::LevelName(ux::simd::ActiveLevel());
+}
+
+// 0 = scalar, 1 = SSE2, 2 = AVX2; clamped to what the CPU supports (tests, benchmarks)
+UX_NATIVE_API void ux_native_set_simd_level(int32_t level)
+{
+    ux::simd::SetLevel(ux::simd::Level(std::min(std::max(level, 0), 2)));
+}
+
+// Changed-pixel count, squared luma error and per-tile change counts of two
+// frames with the same size and channel layout. tile_changed may be null;
+// otherwise it holds ceil(height / tile_h) * ceil(width / tile_w) counts.
+UX_NATIVE_API int32_t ux_diff_luma(const uint8_t* a, int64_t stride_a, const uint8_t* b, int64_t stride_b,
+                                   int32_t width, int32_t height, int32_t channels, int32_t bgr, int32_t threshold,
+                                   int32_t tile_w, int32_t tile_h, uint32_t* tile_changed, UxDiffStats* out)
+{
+    ux::native::ImageView va, vb;
+    if (!out || !MakeView(a, stride_a, width, height, channels, bgr, va) ||
+        !MakeView(b, stride_b, width, height, channels, bgr, vb)) {
+        return UX_NATIVE_EINVAL;
+    }
+    const ux::native::DiffStats stats = ux::native::DiffLuma(va, vb, threshold, tile_w, tile_h, tile_changed);
+    *out = {stats.changed, stats.sumSquared, stats.pixels};
+    return UX_NATIVE_OK;
+}
+
+// Per-channel comparison of two frames (cvtColor(absdiff(a, b)) > threshold),
+// squared error over the colour channels, and per-tile changed counts and
+// extents. The frames may differ in channel count (a prepared 4-channel
+// baseline against a 3-channel capture). tile_changed and tile_bounds may be
+// null; otherwise they hold one count / four int32 (x0, y0, x1, y1) per tile.
+// overlay may be null; otherwise it receives the diff overlay of b (3 bytes
+// per pixel, overlay_stride bytes per row): b at half brightness with changed
+// pixels tinted red.
+UX_NATIVE_API int32_t ux_diff_colour(const uint8_t* a, int64_t stride_a, int32_t channels_a, const uint8_t* b,
+                                     int64_t stride_b, int32_t channels_b, int32_t width, int32_t height, int32_t bgr,
+                                     int32_t threshold, int32_t tile_w, int32_t tile_h, uint32_t* tile_changed,
+                                     int32_t* tile_bounds, uint8_t* overlay, int64_t overlay_stride,
+                                     UxDiffStats* out)
+{
+    ux::native::ImageView va, vb;
+    if (!out || !MakeView(a, stride_a, width, height, channels_a, bgr, va) ||
+        !MakeView(b, stride_b, width, height, channels_b, bgr, vb) ||
+        (overlay && overlay_stride < int64_t(width) * 3)) {
+        return UX_NATIVE_EINVAL;
+    }
+    const ux::native::DiffStats stats =
+        ux::native::DiffColour(va, vb, threshold, tile_w, tile_h, tile_changed,
+                               reinterpret_cast<ux::native::TileBounds*>(tile_bounds), overlay, overlay_stride);
+    *out = {stats.changed, stats.sumSquared, stats.pixels};
+    return UX_NATIVE_OK;
+}
+
+// Luma moments and histogram, Laplacian moments, opponent-colour moments and
+// the 8x8x8 colour histogram of one frame, in a single banded pass. threads = 1
+// stays on the calling thread; anything else uses the shared pool. The sums
+// are integers, so the result is the same for every thread count.
+UX_NATIVE_API int32_t ux_image_stats(const uint8_t* data, int64_t stride, int32_t width, int32_t height,
+                                     int32_t channels, int32_t bgr, int32_t threads, UxImageStats* out)
+{
+    ux::native::ImageView view;
+    if (!out || !MakeView(data, stride, width, height, channels, bgr, view)) return UX_NATIVE_EINVAL;
+
+    std::vector<ux::native::ImageStats> bands(size_t(ux::native::StatsBandCount(height)));
+    RunBands(bands.size(), threads, [&](size_t band) {
+        thread_local std::vector<uint8_t> luma;
+        ux::native::ImageStatsBand(view, int32_t(band), luma, bands[band]);
+    });
+    ux::native::ImageStats total;
+    for (const ux::native::ImageStats& band : bands) total.Merge(band);
+
+    *out = {total.pixels, total.lumaSum, total.lumaSumSquared, total.laplacianSum, total.laplacianSumSquared,
+            total.rgSum, total.yb2Sum, total.rgSumSquared, total.yb2SumSquared, {}, {}};
+    std::copy(std::begin(total.lumaHistogram), std::end(total.lumaHistogram), out->lumaHistogram);
+    std::copy(std::begin(total.colourHistogram), std::end(total.colourHistogram), out->colourHistogram);
+    return UX_NATIVE_OK;
+}
+
+// pHash and dHash of one frame (see native/perceptual_hash.h)
+UX_NATIVE_API int32_t ux_perceptual_hash(const uint8_t* data, int64_t stride, int32_t width, int32_t height,
+                                         int32_t channels, int32_t bgr, uint64_t* phash, uint64_t* dhash)
+{
+    ux::native::ImageView view;
+    if (!phash || !dhash || !MakeView(data, stride, width, height, channels, bgr, view)) return UX_NATIVE_EINVAL;
+    const ux::native::PerceptualHashes hashes = ux::native::PerceptualHash(view);
+    *phash = hashes.phash;
+    *dhash = hashes.dhash;
+    return UX_NATIVE_OK;
+}
+
+// Content hash (see native/content_hash.h) of rows of row_bytes bytes each,
+// stride bytes apart
+UX_NATIVE_API int32_t ux_content_hash(const uint8_t* data, int64_t stride, int64_t row_bytes, int64_t rows,
+                                      uint64_t seed, uint64_t* out)
+{
+    if (!out || row_bytes < 0 || rows < 0 || (rows > 1 && stride < row_bytes) ||
+        (!data && row_bytes > 0 && rows > 0)) {
+        return UX_NATIVE_EINVAL;
+    }
+    ux::native::ContentHasher hasher(seed);
+    for (int64_t y = 0; y < rows; y++) hasher.Update(data + y * stride, size_t(row_bytes));
+    *out = hasher.Digest();
+    return UX_NATIVE_OK;
+}
+
+// Button / input field / container candidates from one colour-region
+// labelling pass (see native/region_detector.h), sorted top to bottom. The
+// first `capacity` regions are written to out; the return value is the total
+// count (so a caller can retry with a larger buffer) or UX_NATIVE_EINVAL.
+UX_NATIVE_API int64_t ux_detect_regions(const uint8_t* data, int64_t stride, int32_t width, int32_t height,
+                                        int32_t channels, int32_t bgr, int32_t tolerance, UxRegion* out,
+                                        int64_t capacity)
+{
+    ux::native::ImageView view;
+    if (tolerance < 0 || (capacity > 0 && !out) || !MakeView(data, stride, width, height, channels, bgr, view))
+        return UX_NATIVE_EINVAL;
+    const std::vector<ux::native::Region> regions = ux::native::DetectRegions(view, tolerance);
+    for (size_t i = 0; i < regions.size() && int64_t(i) < capacity; i++) {
+        const ux::native::Region& r = regions[i];
+        out[i] = {int32_t(r.type), r.x, r.y, r.width, r.height, r.area, r.confidence,
+                  {r.meanColour[0], r.meanColour[1], r.meanColour[2]}, r.lumaMean, r.lumaStd};
+    }
+    return int64_t(regions.size());
+}
+
+// Colour profiles of count boxes (int32 x, y, w, h; clipped to the frame) in
+// one call: mean colour, luma mean/std and ring-based background/foreground
+// estimates (see native/colour_profile.h). Empty boxes get zeros.
+UX_NATIVE_API int32_t ux_colour_profiles(const uint8_t* data, int64_t stride, int32_t width, int32_t height,
+                                         int32_t channels, int32_t bgr, const int32_t* boxes, int32_t count,
+                                         UxColourProfile* out)
+{
+    ux::native::ImageView view;
+    if (count < 0 || (count > 0 && (!boxes || !out)) || !MakeView(data, stride, width, height, channels, bgr, view))
+        return UX_NATIVE_EINVAL;
+    ux::native::ColourProfiles(view, reinterpret_cast<const ux::native::Box*>(boxes), count,
+                               reinterpret_cast<ux::native::ColourProfile*>(out));
+    return UX_NATIVE_OK;
+}
+
+// Sizes and offsets of the preprocessed OCR crops of count boxes (int32 x, y,
+// w, h; clipped to a width x height frame) in one packed buffer (see
+// native/ocr_preprocess.h). Returns the buffer size in bytes or
+// UX_NATIVE_EINVAL.
+UX_NATIVE_API int64_t ux_ocr_layout(int32_t width, int32_t height, const int32_t* boxes, int32_t count,
+                                    const UxOcrOptions* options, UxOcrCrop* crops)
+{
+    if (width <= 0 || height <= 0 || count < 0 || (count > 0 && (!boxes || !crops)) || !ValidOcrOptions(options))
+        return UX_NATIVE_EINVAL;
+    return ux::native::OcrLayout(width, height, reinterpret_cast<const ux::native::Box*>(boxes), count,
+                                 *reinterpret_cast<const ux::native::OcrOptions*>(options),
+                                 reinterpret_cast<ux::native::OcrCrop*>(crops));
+}
+
+// Binarized, upscaled and deskewed crops for OCR, one crop per pool task.
+// crops and size come from ux_ocr_layout with the same boxes and options;
+// inverted and skew are filled in.
+UX_NATIVE_API int32_t ux_ocr_preprocess(const uint8_t* data, int64_t stride, int32_t width, int32_t height,
+                                        int32_t channels, int32_t bgr, const int32_t* boxes, int32_t count,
+                                        const UxOcrOptions* options, UxOcrCrop* crops, uint8_t* out, int64_t size,
+                                        int32_t threads)
+{
+    ux::native::ImageView view;
+    if (count < 0 || (count > 0 && (!boxes || !crops || !out)) || !ValidOcrOptions(options) ||
+        !MakeView(data, stride, width, height, channels, bgr, view))
+        return UX_NATIVE_EINVAL;
+    const auto* b = reinterpret_cast<const ux::native::Box*>(boxes);
+    const auto& o = *reinterpret_cast<const ux::native::OcrOptions*>(options);
+    auto* c = reinterpret_cast<ux::native::OcrCrop*>(crops);
+    // The layout must be the one these boxes get; it decides where crops write
+    std::vector<ux::native::OcrCrop> expected(c, c + count);
+    if (ux::native::OcrLayout(width, height, b, count, o, expected.data()) > size) return UX_NATIVE_EINVAL;
+    for (int32_t i = 0; i < count; i++) {
+        if (expected[i].offset != c[i].offset || expected[i].width != c[i].width ||
+            expected[i].height != c[i].height)
+            return UX_NATIVE_EINVAL;
+    }
+    RunBands(size_t(count), threads,
+             [&](size_t i) { ux::native::PrepareOcrCrop(view, b[i], o, c[i], out + c[i].offset); });
+    return UX_NATIVE_OK;
+}
+
+// The frame area-resampled to fit options->maxSize (never enlarged), encoded
+// as PNG or JPEG and base64-encoded into out, without touching disk (see
+// native/area_resample.h and native/image_encode.h). Each stage is banded over
+// the shared pool. Returns the base64 length (nothing is written when it
+// exceeds capacity) or UX_NATIVE_EINVAL.
+UX_NATIVE_API int64_t ux_encode_image_base64(const uint8_t* data, int64_t stride, int32_t width, int32_t height,
+                                             int32_t channels, int32_t bgr, const UxEncodeOptions* options,
+                                             char* out, int64_t capacity, int32_t threads)
+{
+    ux::native::ImageView view;
+    if (capacity < 0 || (capacity > 0 && !out) || !ValidEncodeOptions(options) ||
+        !MakeView(data, stride, width, height, channels, bgr, view))
+        return UX_NATIVE_EINVAL;
+    int32_t w, h;
+    ux::native::FitSize(width, height, options->maxSize, w, h);
+    const bool jpeg = options->format == int32_t(ux::native::ImageFormat::Jpeg);
+    if (jpeg && (w > 65535 || h > 65535)) return UX_NATIVE_EINVAL;
+
+    // Reused across calls on this thread. The bands run on pool workers, which
+    // have thread_locals of their own, so they reach these through references.
+    thread_local std::vector<uint8_t> rgbBuffer, encodedBuffer;
+    thread_local std::vector<std::vector<uint8_t>> bandBuffers;
+    std::vector<uint8_t>& rgb = rgbBuffer;
+    std::vector<uint8_t>& encoded = encodedBuffer;
+    std::vector<std::vector<uint8_t>>& bands = bandBuffers;
+    ux::native::AreaTable xs, ys;
+    ux::native::BuildAreaTable(width, w, xs);
+    ux::native::BuildAreaTable(height, h, ys);
+    rgb.resize(size_t(w) * h * 3);
+    RunBands(size_t(ux::native::ResampleBandCount(h)), threads, [&](size_t band) {
+        thread_local std::vector<float> acc;
+        ux::native::AreaResampleBand(view, xs, ys, int32_t(band), acc, rgb.data());
+    });
+
+    if (jpeg) {
+        const ux::native::JpegTables tables(options->quality);
+        bands.resize(size_t(ux::native::JpegBandCount(w, h)));
+        RunBands(bands.size(), threads, [&](size_t band) {
+            ux::native::JpegBand(tables, rgb.data(), w, h, int32_t(band), bands[band]);
+        });
+        ux::native::AssembleJpeg(tables, w, h, bands, encoded);
+    } else {
+        bands.resize(size_t(ux::native::PngBandCount(h)));
+        std::vector<uint32_t> adlers(bands.size());
+        std::vector<size_t> sizes(bands.size());
+        RunBands(bands.size(), threads, [&](size_t band) {
+            ux::native::PngBand(rgb.data(), w, h, int32_t(band), bands[band], adlers[band], sizes[band]);
+        });
+        ux::native::AssemblePng(w, h, bands, adlers, sizes, encoded);
+    }
+
+    const int64_t length = int64_t(ux::native::Base64Length(encoded.size()));
+    if (length <= capacity) {
+        RunBands(ux::native::Base64BandCount(encoded.size()), threads,
+                 [&](size_t band) { ux::native::Base64Band(encoded.data(), encoded.size(), band, out); });
+    }
+    return length;
+}
+
+// Greedy non-maximum suppression (see native/box_nms.h). boxes is count x
+// (x, y, w, h); the indices of the kept boxes are written to keep (room for
+// count) in order of decreasing score. Returns the number kept or
+// UX_NATIVE_EINVAL.
+UX_NATIVE_API int32_t ux_nms(const float* boxes, const double* scores, int32_t count, float iou_threshold,
+                             int32_t* keep)
+{
+    if (count < 0 || (count > 0 && (!boxes || !scores || !keep))) return UX_NATIVE_EINVAL;
+    std::vector<int32_t> kept;
+    ux::native::NonMaxSuppression(boxes, scores, count, iou_threshold, kept);
+    std::copy(kept.begin(), kept.end(), keep);
+    return int32_t(kept.size());
+}
+
+UX_NATIVE_API UxHashIndex* ux_hash_index_create()
+{
+    return new (std::nothrow) UxHashIndex;
+}
+
+UX_NATIVE_API void ux_hash_index_destroy(UxHashIndex* index)
+{
+    delete index;
+}
+
+UX_NATIVE_API int64_t ux_hash_index_size(UxHashIndex* index)
+{
+    if (!index) return UX_NATIVE_EINVAL;
+    std::lock_guard<std::mutex> lock(index->mutex);
+    return int64_t(index->index.Size());
+}
+
+// Adds id with hash, replacing any earlier hash filed under the same id
+UX_NATIVE_API int32_t ux_hash_index_add(UxHashIndex* index, int64_t id, uint64_t hash)
+{
+    if (!index) return UX_NATIVE_EINVAL;
+    std::lock_guard<std::mutex> lock(index->mutex);
+    index->index.Add(id, hash);
+    return UX_NATIVE_OK;
+}
+
+// 1 if id was present
+UX_NATIVE_API int32_t ux_hash_index_remove(UxHashIndex* index, int64_t id)
+{
+    if (!index) return UX_NATIVE_EINVAL;
+    std::lock_guard<std::mutex> lock(index->mutex);
+    return index->index.Remove(id) ? 1 : 0;
+}
+
+// Ids within radius bits of hash. The first `capacity` matches are written
+// to ids/distances (in no particular order); the return value is the total
+// number of matches, so a caller can retry with a larger buffer.
+UX_NATIVE_API int64_t ux_hash_index_query(UxHashIndex* index, uint64_t hash, int32_t radius, int64_t* ids,
+                                          int32_t* distances, int64_t capacity)
+{
+    if (!index || capacity < 0 || (capacity > 0 && (!ids || !distances))) return UX_NATIVE_EINVAL;
+    std::lock_guard<std::mutex> lock(index->mutex);
+    int64_t count = 0;
+    index->index.Query(hash, radius, [&](int64_t id, int32_t distance) {
+        if (count < capacity) {
+            ids[count] = id;
+            distances[count] = distance;
+        }
+        count++;
+    });
+    return count;
+}
+
+UX_NATIVE_API UxTextProposer* ux_text_proposer_create()
+{
+    return new (std::nothrow) UxTextProposer;
+}
+
+UX_NATIVE_API void ux_text_proposer_destroy(UxTextProposer* proposer)
+{
+    delete proposer;
+}
+
+// Text lines of a frame (see native/text_proposals.h), top to bottom. With
+// incremental set, only the tiles that changed since the proposer's previous
+// frame are searched again. The first `capacity` lines are written to out;
+// the return value is the total count or UX_NATIVE_EINVAL. A retry with a
+// larger buffer on the same frame is cheap when incremental. searched (may be
+// null) receives the number of pixels searched.
+UX_NATIVE_API int64_t ux_text_proposals(UxTextProposer* proposer, const uint8_t* data, int64_t stride, int32_t width,
+                                        int32_t height, int32_t channels, int32_t bgr, int32_t incremental,
+                                        UxTextLine* out, int64_t capacity, int64_t* searched)
+{
+    ux::native::ImageView view;
+    if (!proposer || (capacity > 0 && !out) || !MakeView(data, stride, width, height, channels, bgr, view))
+        return UX_NATIVE_EINVAL;
+    std::lock_guard<std::mutex> lock(proposer->mutex);
+    const std::vector<ux::native::TextLine>& lines = proposer->proposer.Run(view, incremental != 0);
+    const size_t n = std::min(lines.size(), size_t(std::max<int64_t>(capacity, 0)));
+    std::copy(lines.begin(), lines.begin() + n, reinterpret_cast<ux::native::TextLine*>(out));
+    if (searched) *searched = proposer->proposer.Searched();
+    return int64_t(lines.size());
+}
+
+// Opens (creating if needed) the result cache log at path, bounded to
+// max_bytes. Returns null on failure, with the reason in error (at most
+// error_capacity bytes, NUL-terminated).
+UX_NATIVE_API UxResultCache* ux_result_cache_open(const char* path, uint64_t max_bytes, char* error,
+                                                  int32_t error_capacity)
+{
+    UxResultCache* handle = path ? new (std::nothrow) UxResultCache : nullptr;
+    std::string reason = path ? "out of memory" : "no path";
+    if (handle && handle->cache.Open(path, max_bytes, reason)) return handle;
+    delete handle;
+    if (error && error_capacity > 0) {
+        std::strncpy(error, reason.c_str(), size_t(error_capacity) - 1);
+        error[error_capacity - 1] = '\0';
+    }
+    return nullptr;
+}
+
+UX_NATIVE_API void ux_result_cache_close(UxResultCache* handle)
+{
+    delete handle;
+}
+
+// 1 on a hit, 0 on a miss (or an expired entry). On a hit *length receives
+// the size of the value, which is copied to out only if it fits in capacity,
+// so a caller can retry with a larger buffer.
+UX_NATIVE_API int32_t ux_result_cache_get(UxResultCache* handle, const uint8_t* key, int64_t key_length,
+                                          uint8_t* out, int64_t capacity, int64_t* length)
+{
+    if (!handle || !key || key_length <= 0 || !length || (capacity > 0 && !out)) return UX_NATIVE_EINVAL;
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    uint64_t size = 0;
+    ux::native::ResultCache& cache = handle->cache;
+    const uint8_t* value = cache.Find(key, size_t(key_length), size, true);
+    if (!value) return 0;
+    *length = int64_t(size);
+    if (int64_t(size) > capacity) return 1;
+    // The counted lookup; the entry may have expired since the peek
+    value = cache.Find(key, size_t(key_length), size);
+    if (!value) return 0;
+    *length = int64_t(size);
+    if (size > 0) std::memcpy(out, value, size);
+    return 1;
+}
+
+// Stores value under key for ttl_seconds; 1 if stored, 0 if the value is too
+// large for the cache's size bound
+UX_NATIVE_API int32_t ux_result_cache_put(UxResultCache* handle, const uint8_t* key, int64_t key_length,
+                                          const uint8_t* value, int64_t value_length, double ttl_seconds)
+{
+    if (!handle || !key || key_length <= 0 || key_length > INT32_MAX || value_length < 0 ||
+        (!value && value_length > 0)) {
+        return UX_NATIVE_EINVAL;
+    }
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->cache.Put(key, size_t(key_length), value, size_t(value_length), ttl_seconds) ? 1 : 0;
+}
+
+// 1 if key was cached
+UX_NATIVE_API int32_t ux_result_cache_remove(UxResultCache* handle, const uint8_t* key, int64_t key_length)
+{
+    if (!handle || !key || key_length <= 0) return UX_NATIVE_EINVAL;
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->cache.Remove(key, size_t(key_length)) ? 1 : 0;
+}
+
+UX_NATIVE_API void ux_result_cache_clear(UxResultCache* handle)
+{
+    if (!handle) return;
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    handle->cache.Clear();
+}
+
+UX_NATIVE_API int32_t ux_result_cache_stats(UxResultCache* handle, UxResultCacheStats* out)
+{
+    if (!handle || !out) return UX_NATIVE_EINVAL;
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    const ux::native::ResultCacheStats stats = handle->cache.Stats();
+    std::memcpy(out, &stats, sizeof(stats));
+    return UX_NATIVE_OK;
+}
+
+// Opens (creating if needed) the capture catalog stored at path.idx and
+// path.dat. Returns null on failure, with the reason in error (at most
+// error_capacity bytes, NUL-terminated).
+UX_NATIVE_API UxCaptureCatalog* ux_catalog_open(const char* path, char* error, int32_t error_capacity)
+{
+    UxCaptureCatalog* handle = path ? new (std::nothrow) UxCaptureCatalog : nullptr;
+    std::string reason = path ? "out of memory" : "no path";
+    if (handle && handle->catalog.Open(path, reason)) return handle;
+    delete handle;
+    if (error && error_capacity > 0) {
+        std::strncpy(error, reason.c_str(), size_t(error_capacity) - 1);
+        error[error_capacity - 1] = '\0';
+    }
+    return nullptr;
+}
+
+UX_NATIVE_API void ux_catalog_close(UxCaptureCatalog* handle)
+{
+    delete handle;
+}
+
+// Appends a capture described by fields (timestamp, dimensions, hashes,
+// file size, label) and returns its record number; a live capture of the same
+// name is replaced
+UX_NATIVE_API int64_t ux_catalog_append(UxCaptureCatalog* handle, const UxCatalogRecord* fields, const char* name,
+                                        int32_t name_length, const uint8_t* extra, int64_t extra_length)
+{
+    if (!handle || !fields || !name || name_length <= 0 || extra_length < 0 || (!extra && extra_length > 0))
+        return UX_NATIVE_EINVAL;
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    const int64_t i = handle->catalog.Append(*reinterpret_cast<const ux::native::CatalogRecord*>(fields), name,
+                                             size_t(name_length), extra, size_t(extra_length));
+    return i >= 0 ? i : int64_t(UX_NATIVE_EINVAL);
+}
+
+// Record number of the live capture with this name, or UX_NATIVE_ENOTFOUND
+UX_NATIVE_API int64_t ux_catalog_find(UxCaptureCatalog* handle, const char* name, int32_t name_length)
+{
+    if (!handle || !name || name_length < 0) return UX_NATIVE_EINVAL;
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    const int64_t i = handle->catalog.Find(name, size_t(name_length));
+    return i >= 0 ? i : int64_t(UX_NATIVE_ENOTFOUND);
+}
+
+// Copies a record (removed ones included) to out, and its name and JSON
+// metadata to name/extra when they fit in the given capacities (their lengths
+// are in out, so a caller can retry with larger buffers)
+UX_NATIVE_API int32_t ux_catalog_read(UxCaptureCatalog* handle, int64_t index, UxCatalogRecord* out, char* name,
+                                      int32_t name_capacity, uint8_t* extra, int64_t extra_capacity)
+{
+    if (!handle || !out || (name_capacity > 0 && !name) || (extra_capacity > 0 && !extra)) return UX_NATIVE_EINVAL;
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    const ux::native::CatalogRecord* record = handle->catalog.Record(index);
+    if (!record) return UX_NATIVE_ENOTFOUND;
+    std::memcpy(out, record, sizeof(*out));
+    if (int64_t(record->nameLength) <= name_capacity)
+        std::memcpy(name, handle->catalog.Name(*record), record->nameLength);
+    if (record->extraLength > 0 && int64_t(record->extraLength) <= extra_capacity)
+        std::memcpy(extra, handle->catalog.Extra(*record), record->extraLength);
+    return UX_NATIVE_OK;
+}
+
+// Replaces the JSON metadata of a live capture
+UX_NATIVE_API int32_t ux_catalog_set_extra(UxCaptureCatalog* handle, int64_t index, const uint8_t* extra,
+                                           int64_t extra_length)
+{
+    if (!handle || extra_length < 0 || (!extra && extra_length > 0)) return UX_NATIVE_EINVAL;
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->catalog.SetExtra(index, extra, size_t(extra_length)) ? UX_NATIVE_OK : UX_NATIVE_ENOTFOUND;
+}
+
+// 1 if the capture was live
+UX_NATIVE_API int32_t ux_catalog_remove(UxCaptureCatalog* handle, int64_t index)
+{
+    if (!handle) return UX_NATIVE_EINVAL;
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->catalog.Remove(index) ? 1 : 0;
+}
+
+// Record number of the newest live capture with label (any when null or
+// empty) taken at or before before_ns, or UX_NATIVE_ENOTFOUND
+UX_NATIVE_API int64_t ux_catalog_latest(UxCaptureCatalog* handle, const char* label, int64_t before_ns)
+{
+    if (!handle) return UX_NATIVE_EINVAL;
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    const int64_t i = handle->catalog.Latest(label, before_ns);
+    return i >= 0 ? i : int64_t(UX_NATIVE_ENOTFOUND);
+}
+
+// Live captures with label (all when null or empty)
+UX_NATIVE_API int64_t ux_catalog_count(UxCaptureCatalog* handle, const char* label)
+{
+    if (!handle) return UX_NATIVE_EINVAL;
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->catalog.Count(label);
+}
+
+// Removes the oldest live captures until at most keep remain. The record
+// numbers of the first `capacity` removed captures are written to removed;
+// the return value is how many were removed (size removed from
+// ux_catalog_count, as the removal cannot be repeated).
+UX_NATIVE_API int64_t ux_catalog_prune(UxCaptureCatalog* handle, int64_t keep, int64_t* removed, int64_t capacity)
+{
+    if (!handle || (capacity > 0 && !removed)) return UX_NATIVE_EINVAL;
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    int64_t n = 0;
+    handle->catalog.Prune(keep, [&](int64_t i) {
+        if (n < capacity) removed[n] = i;
+        n++;
+    });
+    return n;
+}
+
+// Record numbers of the live captures with label (all when null or empty),
+// newest or oldest first. The first `capacity` are written to out; the return
+// value is the total, so a caller can retry with a larger buffer.
+UX_NATIVE_API int64_t ux_catalog_list(UxCaptureCatalog* handle, const char* label, int32_t newest_first,
+                                      int64_t* out, int64_t capacity)
+{
+    if (!handle || (capacity > 0 && !out)) return UX_NATIVE_EINVAL;
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    int64_t n = 0;
+    handle->catalog.List(label, newest_first != 0, [&](int64_t i) {
+        if (n < capacity) out[n] = i;
+        n++;
+    });
+    return n;
+}
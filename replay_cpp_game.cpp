@@ -0,0 +1,270 @@
+// Headless replay runner for the UX test game.
+//
+// Plays recorded input replays (ux_game/input.h) through the game logic and
+// renderer without a window or GL context, and reports per-scenario frame times
+// as JSON or CSV. The final frame checksum makes it easy to confirm that two
+// builds (e.g. plain vs. PGO) produce identical output. The runner exits with
+// status 1 if the incrementally drawn final frame differs from a full redraw.
+//
+//   ./ux_game_replay replays/*.uxr
+//   ./ux_game_replay --repeat 10 --format csv replays/gameplay_hard.uxr
+//   ./ux_game_replay --targets 720p,1080p,4k replays/gameplay_easy.uxr
+//
+// Build with: ./build_game.sh replay   (./build_game.sh pgo uses it for training)
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ux_game/game.h"
+#include "ux_game/input.h"
+#include "ux_game/raster.h"
+#include "ux_game/resolution.h"
+#include "ux_game/worker_pool.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::vector<std::string> replays;
+    int repeat = 5;
+    bool render = true;
+    bool fullRedraw = false;
+    bool csv = false;
+    std::vector<ux::TargetSpec> targets;
+    unsigned threads = 0;
+};
+
+struct TargetResult {
+    ux::TargetSpec spec;
+    uint64_t checksum;
+    uint64_t drawnChecksum;     // of the last frame the timed loop drew
+};
+
+struct Result {
+    std::string scenario;
+    int32_t width, height;
+    size_t frames;
+    double msTotalMin;
+    double nsPerFrameMin;
+    double nsPerFrameMedian;
+    const char* finalState;
+    int score;
+    uint64_t checksum;
+    uint64_t drawnChecksum;     // of the last frame the timed loop drew
+    std::vector<TargetResult> targets;
+};
+
+uint64_t Fnv1a(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) hash = (hash ^ p[i]) * 0x100000001b3ull;
+    return hash;
+}
+
+std::string ScenarioName(const std::string& path)
+{
+    size_t slash = path.find_last_of("/\\");
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    size_t dot = name.rfind('.');
+    return dot == std::string::npos ? name : name.substr(0, dot);
+}
+
+Result Run(const std::string& path, const ux::Replay& replay, const Options& opts, ux::WorkerPool& pool)
+{
+    std::vector<uint32_t> pixels(size_t(replay.width) * replay.height);
+    const ux::Canvas canvas{pixels.data(), replay.width, replay.height};
+    std::vector<std::vector<uint32_t>> targetPixels;
+    for (const ux::TargetSpec& spec : opts.targets) targetPixels.emplace_back(size_t(spec.width) * spec.height);
+
+    std::vector<double> samples;
+    Result r{};
+    for (int rep = 0; rep < opts.repeat; rep++) {
+        ux::Game game(replay.width, replay.height, replay.seed);
+        ux::Game::RenderCache cache;
+        std::vector<ux::Game::RenderTarget> targets(opts.targets.size());
+        for (size_t i = 0; i < targets.size(); i++) {
+            targets[i].canvas = {targetPixels[i].data(), opts.targets[i].width, opts.targets[i].height};
+            targets[i].ui = opts.targets[i].ui;
+        }
+        auto t0 = Clock::now();
+        for (const ux::InputFrame& input : replay.frames) {
+            game.Update(input);
+            if (!opts.render) continue;
+            if (opts.fullRedraw) {
+                cache.Invalidate();
+                for (auto& target : targets) target.cache.Invalidate();
+            }
+            if (targets.empty()) game.Render(canvas, cache);
+            else game.Render(canvas, cache, targets, pool);
+        }
+        samples.push_back(std::chrono::duration<double, std::milli>(Clock::now() - t0).count());
+
+        if (rep == 0) {
+            // Hash what the timed loop drew, then redraw from scratch: the two
+            // differ only if incremental rendering has diverged
+            r.finalState = ux::Game::kStateNames[game.GetState()];
+            r.score = game.Score();
+            r.drawnChecksum = Fnv1a(pixels.data(), pixels.size() * sizeof(uint32_t));
+            game.Render(canvas);
+            r.checksum = Fnv1a(pixels.data(), pixels.size() * sizeof(uint32_t));
+            if (!opts.render) r.drawnChecksum = r.checksum;
+            for (size_t i = 0; i < targets.size(); i++) {
+                const size_t bytes = targetPixels[i].size() * sizeof(uint32_t);
+                const uint64_t drawn = Fnv1a(targetPixels[i].data(), bytes);
+                targets[i].cache.Invalidate();
+                game.Render(targets[i]);
+                const uint64_t full = Fnv1a(targetPixels[i].data(), bytes);
+                r.targets.push_back({opts.targets[i], full, opts.render ? drawn : full});
+            }
+        }
+    }
+    std::sort(samples.begin(), samples.end());
+
+    const double frames = double(std::max<size_t>(replay.frames.size(), 1));
+    r.scenario = ScenarioName(path);
+    r.width = replay.width;
+    r.height = replay.height;
+    r.frames = replay.frames.size();
+    r.msTotalMin = samples.front();
+    r.nsPerFrameMin = samples.front() * 1e6 / frames;
+    r.nsPerFrameMedian = samples[samples.size() / 2] * 1e6 / frames;
+    return r;
+}
+
+void PrintJson(const Options& opts, const std::vector<Result>& results)
+{
+    std::printf("{\n  \"benchmark\": \"ux_game_replay\",\n  \"repeat\": %d,\n  \"render\": %s,\n  \"results\": [\n",
+                opts.repeat, opts.render ? "true" : "false");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        std::printf("    {\"scenario\": \"%s\", \"width\": %d, \"height\": %d, \"frames\": %zu, "
+                    "\"ms_total_min\": %.3f, \"ns_per_frame_min\": %.1f, \"ns_per_frame_median\": %.1f, "
+                    "\"final_state\": \"%s\", \"score\": %d, \"checksum\": \"%016llx\", \"targets\": [",
+                    r.scenario.c_str(), r.width, r.height, r.frames, r.msTotalMin, r.nsPerFrameMin,
+                    r.nsPerFrameMedian, r.finalState, r.score, (unsigned long long)r.checksum);
+        for (size_t t = 0; t < r.targets.size(); t++) {
+            const TargetResult& target = r.targets[t];
+            std::printf("%s{\"width\": %d, \"height\": %d, \"ui\": %d, \"checksum\": \"%016llx\"}",
+                        t ? ", " : "", target.spec.width, target.spec.height, target.spec.ui,
+                        (unsigned long long)target.checksum);
+        }
+        std::printf("]}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+}
+
+void PrintCsv(const std::vector<Result>& results)
+{
+    std::printf("scenario,width,height,frames,ms_total_min,ns_per_frame_min,ns_per_frame_median,final_state,score,checksum,"
+                "target_checksums\n");
+    for (const Result& r : results) {
+        std::printf("%s,%d,%d,%zu,%.3f,%.1f,%.1f,%s,%d,%016llx,", r.scenario.c_str(), r.width, r.height,
+                    r.frames, r.msTotalMin, r.nsPerFrameMin, r.nsPerFrameMedian, r.finalState, r.score,
+                    (unsigned long long)r.checksum);
+        // "WxH[@UI]:checksum" per target, space separated
+        for (size_t t = 0; t < r.targets.size(); t++) {
+            std::printf("%s%s:%016llx", t ? " " : "", ux::TargetName(r.targets[t].spec).c_str(),
+                        (unsigned long long)r.targets[t].checksum);
+        }
+        std::printf("\n");
+    }
+}
+
+void PrintUsage()
+{
+    std::fprintf(stderr,
+        "Usage: ux_game_replay [options] REPLAY.uxr...\n"
+        "  --repeat N             plays per replay, best and median are reported (default 5)\n"
+        "  --no-render            run the simulation only\n"
+        "  --full-redraw          redraw every frame from scratch (no incremental rendering)\n"
+        "  --targets RES[@UI],... also render every frame at these resolutions (WxH, 720p, 1080p,\n"
+        "                         1440p, 4k; optional UI scale), in parallel across cores\n"
+        "  --threads N            render threads for --targets (default: all cores)\n"
+        "  --format json|csv      output format (default json)\n");
+}
+
+bool ParseArgs(int argc, char** argv, Options& opts)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : nullptr; };
+        const char* value = nullptr;
+
+        if (arg == "--help" || arg == "-h") {
+            PrintUsage();
+            std::exit(0);
+        } else if ((arg == "--repeat") && (value = next())) {
+            opts.repeat = std::max(1, std::atoi(value));
+        } else if (arg == "--no-render") {
+            opts.render = false;
+        } else if (arg == "--full-redraw") {
+            opts.fullRedraw = true;
+        } else if ((arg == "--targets") && (value = next())) {
+            if (!ux::ParseTargetSpecs(value, opts.targets)) {
+                std::fprintf(stderr, "Invalid render targets: %s\n", value);
+                return false;
+            }
+        } else if ((arg == "--threads") && (value = next())) {
+            opts.threads = unsigned(std::max(1, std::atoi(value)));
+        } else if ((arg == "--format") && (value = next())) {
+            opts.csv = std::strcmp(value, "csv") == 0;
+        } else if (!arg.empty() && arg[0] != '-') {
+            opts.replays.push_back(arg);
+        } else {
+            std::fprintf(stderr, "Unknown or incomplete option: %s\n", arg.c_str());
+            PrintUsage();
+            return false;
+        }
+    }
+    if (opts.replays.empty()) {
+        PrintUsage();
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options opts;
+    if (!ParseArgs(argc, argv, opts)) return 1;
+
+    ux::WorkerPool pool(opts.targets.empty() ? 1 : opts.threads);
+    std::vector<Result> results;
+    bool diverged = false;
+    for (const std::string& path : opts.replays) {
+        ux::Replay replay;
+        if (!ux::LoadReplay(path, replay)) {
+            std::fprintf(stderr, "Failed to load replay: %s\n", path.c_str());
+            return 1;
+        }
+        results.push_back(Run(path, replay, opts, pool));
+        const Result& r = results.back();
+        std::fprintf(stderr, "%-20s %6zu frames %5dx%-5d %10.1f ns/frame\n", r.scenario.c_str(), r.frames,
+                     r.width, r.height, r.nsPerFrameMin);
+        if (r.drawnChecksum != r.checksum) {
+            std::fprintf(stderr, "%s: incremental frame %016llx differs from full redraw %016llx\n",
+                         r.scenario.c_str(), (unsigned long long)r.drawnChecksum, (unsigned long long)r.checksum);
+            diverged = true;
+        }
+        for (const TargetResult& target : r.targets) {
+            if (target.drawnChecksum == target.checksum) continue;
+            std::fprintf(stderr, "%s@%s: incremental frame %016llx differs from full redraw %016llx\n",
+                         r.scenario.c_str(), ux::TargetName(target.spec).c_str(),
+                         (unsigned long long)target.drawnChecksum, (unsigned long long)target.checksum);
+            diverged = true;
+        }
+    }
+
+    if (opts.csv) PrintCsv(results);
+    else PrintJson(opts, results);
+    return diverged ? 1 : 0;
+}
@@ -0,0 +1,123 @@
+"""
+Generate the scripted input replays used for headless benchmarking and PGO training.
+
+Each scenario is a deterministic sequence of input frames at 60 fps written in the
+ux_game replay format (see ux_game/input.h). Sessions recorded from the windowed
+game with UX_GAME_RECORD=<path> can be dropped into this directory alongside them.
+
+    python replays/generate_replays.py
+"""
+import random
+from pathlib import Path
+
+DT = 1.0 / 60.0
+
+KEY_UP, KEY_DOWN, KEY_LEFT, KEY_RIGHT = 1 << 0, 1 << 1, 1 << 2, 1 << 3
+KEY_W, KEY_A, KEY_S, KEY_D = 1 << 4, 1 << 5, 1 << 6, 1 << 7
+KEY_ENTER, KEY_SPACE, KEY_ESCAPE = 1 << 8, 1 << 9, 1 << 10
+
+
+class Session:
+    """Builds a list of input frames."""
+
+    def __init__(self):
+        self.frames = []
+        self.mouse = (320, 240)
+
+    def idle(self, seconds, held=0):
+        for _ in range(int(seconds * 60)):
+            self.frames.append((DT, held, 0, *self.mouse, 0))
+
+    def press(self, key, hold_frames=4):
+        self.frames.append((DT, key, key, *self.mouse, 0))
+        for _ in range(hold_frames - 1):
+            self.frames.append((DT, key, 0, *self.mouse, 0))
+
+    def click(self, x, y):
+        self.mouse = (x, y)
+        self.frames.append((DT, 0, 0, x, y, 0))
+        self.frames.append((DT, 0, 0, x, y, 1))
+        self.idle(0.2)
+
+    def wander(self, seconds, rng, keys=(KEY_A, KEY_D, KEY_W, KEY_S)):
+        remaining = int(seconds * 60)
+        while remaining > 0:
+            held = rng.choice(keys) | (rng.choice(keys) if rng.random() < 0.3 else 0)
+            span = min(remaining, rng.randint(10, 50))
+            self.frames.extend((DT, held, 0, *self.mouse, 0) for _ in range(span))
+            remaining -= span
+
+    def write(self, path, width=640, height=480, seed=1):
+        # Mouse positions are in 640x480 design space; the game scales its layout
+        # by the same integer factor (ux::Game::UiScale)
+        ui = max(1, min(width // 640, height // 480))
+        lines = [f"uxreplay 1 {width} {height} {seed}"]
+        last, repeat = None, 0
+        for frame in self.frames + [None]:
+            if frame == last:
+                repeat += 1
+                continue
+            if last is not None:
+                dt, held, pressed, mx, my, mouse = last
+                lines.append(f"{repeat} {dt:.9g} {held} {pressed} {mx * ui} {my * ui} {mouse}")
+            last, repeat = frame, 1
+        Path(path).write_text("\n".join(lines) + "\n")
+
+
+def menu_navigation():
+    s = Session()
+    s.idle(1.0)
+    for key in (KEY_DOWN, KEY_DOWN, KEY_UP, KEY_UP, KEY_DOWN):
+        s.press(key)
+        s.idle(0.5)
+    s.press(KEY_ENTER)                    # Settings
+    s.idle(0.5)
+    for x, y in ((210, 115), (210, 115), (100, 115), (100, 215), (320, 215), (150, 165), (210, 215)):
+        s.click(x, y)
+        s.idle(0.3)
+    s.click(100, 295)                     # Back
+    s.click(125, 180)                     # Settings via mouse
+    s.press(KEY_ESCAPE)
+    s.idle(1.0)
+    return s
+
+
+def gameplay(difficulty_click, seconds, seed):
+    rng = random.Random(seed)
+    s = Session()
+    s.idle(0.5)
+    s.click(125, 180)                     # Settings
+    s.click(*difficulty_click)
+    s.press(KEY_ESCAPE)
+    s.press(KEY_UP)
+    s.press(KEY_ENTER)                    # Start Game
+    s.wander(seconds, rng)
+    return s
+
+
+def long_session():
+    rng = random.Random(7)
+    s = gameplay((320, 215), 60, seed=3)
+    s.idle(2.0)                           # Game over screen (or still playing)
+    s.press(KEY_SPACE)
+    s.wander(45, rng, keys=(KEY_LEFT, KEY_RIGHT, KEY_UP, KEY_DOWN))
+    s.press(KEY_ESCAPE)
+    s.idle(1.0)
+    s.press(KEY_ENTER)
+    s.wander(30, rng)
+    return s
+
+
+def main():
+    out = Path(__file__).resolve().parent
+    menu_navigation().write(out / "menu_navigation.uxr", seed=11)
+    gameplay((100, 215), 90, seed=1).write(out / "gameplay_easy.uxr", seed=21)
+    gameplay((320, 215), 90, seed=2).write(out / "gameplay_hard.uxr", seed=22)
+    gameplay((210, 215), 60, seed=4).write(out / "gameplay_1080p.uxr", width=1920, height=1080, seed=23)
+    gameplay((320, 215), 20, seed=5).write(out / "gameplay_1440p.uxr", width=2560, height=1440, seed=24)
+    menu_navigation().write(out / "menu_navigation_4k.uxr", width=3840, height=2160, seed=12)
+    long_session().write(out / "long_session.uxr", seed=31)
+
+
+if __name__ == "__main__":
+    main()
@@ -5,13 +5,16 @@ This module handles AI vision analysis using OpenAI and Anthropic Claude APIs.
 """
 import base64
 import json
-from io import BytesIO
 from pathlib import Path
-from typing import Dict, Any, Optional, List
+from typing import Dict, Any, Optional, List, Tuple, Union
 import logging
 
+import cv2
+import numpy as np
 from PIL import Image
 
+from . import native
+
 logger = logging.getLogger(__name__)
 
 # Optional AI imports
@@ -62,62 +65,53 @@ class ContentValidator:
             except Exception as e:
                 logger.warning(f"Failed to initialize Anthropic client: {e}")
     
-    def _encode_image_base64(self, image_path: Path) -> Optional[str]:
+    def _prepare_image_for_api(self, image: Union[Path, np.ndarray],
+                               max_size: int = 1024) -> Optional[Tuple[str, str]]:
         """
-        Encode image to base64 for API transmission.
+        Base64 image data for an API request, without temporary files.
         
-        Args:
-            image_path: Path to image file
-            
-        Returns:
-            Base64 encoded image string or None if failed
-        """
-        try:
-            with open(image_path, 'rb') as image_file:
-                return base64.b64encode(image_file.read()).decode('utf-8')
-        except Exception as e:
-            logger.error(f"Failed to encode image {image_path}: {e}")
-            return None
-    
-    def _resize_image_for_api(self, image_path: Path, max_size: int = 1024) -> Optional[Path]:
-        """
-        Resize image if too large for API limits.
+        Frames are resized and encoded in memory (native.encode_image_base64).
+        PNG and JPEG files that already fit are sent as they are; other files
+        are decoded and go the same way as frames.
         
         Args:
-            image_path: Path to original image
+            image: Path to an image file, or a BGR frame
             max_size: Maximum dimension in pixels
             
         Returns:
-            Path to resized image or original if no resize needed
+            (base64 data, media type), or None if failed
         """
         try:
-            with Image.open(image_path) as img:
-                # Check if resize is needed
-                if max(img.size) <= max_size:
-                    return image_path
-                
-                # Calculate new size maintaining aspect ratio
-                ratio = max_size / max(img.size)
-                new_size = tuple(int(dim * ratio) for dim in img.size)
-                
-                # Resize and save
-                resized_img = img.resize(new_size, Image.Resampling.LANCZOS)
-                resized_path = image_path.parent / f"resized_{image_path.name}"
-                resized_img.save(resized_path)
-                
-                logger.debug(f"Resized image from {img.size} to {new_size}")
-                return resized_path
+            if not isinstance(image, np.ndarray):
+                with Image.open(image) as img:
+                    size, file_format = img.size, img.format
+                if max(size) <= max_size and file_format in ('PNG', 'JPEG'):
+                    with open(image, 'rb') as image_file:
+                        data = base64.b64encode(image_file.read()).decode('ascii')
+                    return data, f"image/{file_format.lower()}"
+                frame = cv2.imread(str(image), cv2.IMREAD_COLOR)
+                if frame is None:
+                    raise ValueError(f"could not decode {image}")
+                image = frame
+            
+            encoded = native.encode_image_base64(image, max_size=max_size)
+            if encoded is None:
+                raise ValueError(f"unsupported frame {getattr(image, 'shape', None)}")
+            if (encoded['width'], encoded['height']) != (image.shape[1], image.shape[0]):
+                logger.debug(f"Resized image from {image.shape[1]}x{image.shape[0]} "
+                             f"to {encoded['width']}x{encoded['height']}")
+            return encoded['data'], encoded['media_type']
                 
         except Exception as e:
-            logger.error(f"Failed to resize image: {e}")
-            return image_path
+            logger.error(f"Failed to prepare image for API: {e}")
+            return None
     
-    def validate_with_openai(self, image_path: Path, expected_content: str) -> Dict[str, Any]:
+    def validate_with_openai(self, image_path: Union[Path, np.ndarray], expected_content: str) -> Dict[str, Any]:
         """
         Validate screenshot content using OpenAI Vision API.
         
         Args:
-            image_path: Path to screenshot
+            image_path: Path to screenshot, or a BGR frame
             expected_content: Description of expected content
             
         Returns:
@@ -138,14 +132,12 @@ class ContentValidator:
             return result
         
         try:
-            # Resize image if needed
-            processed_image_path = self._resize_image_for_api(image_path)
-            
-            # Encode image
-            base64_image = self._encode_image_base64(processed_image_path)
-            if not base64_image:
+            # Resize and encode in memory
+            prepared = self._prepare_image_for_api(image_path)
+            if not prepared:
                 result['error'] = "Failed to encode image"
                 return result
+            base64_image, media_type = prepared
             
             # Create prompt
             prompt = f"""
@@ -177,7 +169,7 @@ class ContentValidator:
                             {
                                 "type": "image_url",
                                 "image_url": {
-                                    "url": f"data:image/png;base64,{base64_image}"
+                                    "url": f"data:{media_type};base64,{base64_image}"
                                 }
                             }
                         ]
@@ -201,10 +193,6 @@ class ContentValidator:
                 result['confidence'] = 0.7 if result['content_matches'] else 0.3
                 result['success'] = True
             
-            # Clean up resized image if created
-            if processed_image_path != image_path:
-                processed_image_path.unlink(missing_ok=True)
-            
             logger.info(f"OpenAI validation completed: {result['content_matches']} ({result['confidence']:.2f})")
             
         except Exception as e:
@@ -213,12 +201,12 @@ class ContentValidator:
         
         return result
     
-    def validate_with_claude(self, image_path: Path, expected_content: str) -> Dict[str, Any]:
+    def validate_with_claude(self, image_path: Union[Path, np.ndarray], expected_content: str) -> Dict[str, Any]:
         """
         Validate screenshot content using Anthropic Claude.
         
         Args:
-            image_path: Path to screenshot
+            image_path: Path to screenshot, or a BGR frame
             expected_content: Description of expected content
             
         Returns:
@@ -239,14 +227,12 @@ class ContentValidator:
             return result
         
         try:
-            # Resize image if needed
-            processed_image_path = self._resize_image_for_api(image_path)
-            
-            # Encode image
-            base64_image = self._encode_image_base64(processed_image_path)
-            if not base64_image:
+            # Resize and encode in memory
+            prepared = self._prepare_image_for_api(image_path)
+            if not prepared:
                 result['error'] = "Failed to encode image"
                 return result
+            base64_image, media_type = prepared
             
             # Create prompt
             prompt = f"""
@@ -275,7 +261,7 @@ class ContentValidator:
                                 "type": "image",
                                 "source": {
                                     "type": "base64",
-                                    "media_type": "image/png",
+                                    "media_type": media_type,
                                     "data": base64_image
                                 }
                             },
@@ -321,10 +307,6 @@ class ContentValidator:
             if 'issue' in response_lower or 'problem' in response_lower or 'recommend' in response_lower:
                 result['issues'] = [response_text]  # Full response as issue for now
             
-            # Clean up resized image if created
-            if processed_image_path != image_path:
-                processed_image_path.unlink(missing_ok=True)
-            
             logger.info(f"Claude validation completed: {result['content_matches']} ({result['confidence']:.2f})")
             
         except Exception as e:
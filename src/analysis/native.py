@@ -0,0 +1,1415 @@
+"""
+Python bindings for the native image kernels (native/ux_native.cpp).
+
+The kernels are a plain C library loaded through ctypes. ctypes releases the
+GIL for the duration of every call, so comparisons running on worker threads
+proceed in parallel. When the library has not been built
+(``./build_game.sh native``) the helpers return None and callers keep their
+OpenCV/numpy path.
+"""
+import base64
+import ctypes
+import hashlib
+import math
+import os
+import sys
+import threading
+import time
+from collections import OrderedDict
+from pathlib import Path
+from typing import Any, Dict, List, Optional, Tuple
+import logging
+
+import cv2
+import numpy as np
+
+logger = logging.getLogger(__name__)
+
+# Must match kNativeAbiVersion in native/ux_native.cpp
+ABI_VERSION = 13
+
+LIBRARY_ENV = "UX_NATIVE_LIB"
+# Threads (caller included) of the native pool, read when the pool starts; default all cores
+THREADS_ENV = "UX_NATIVE_THREADS"
+REPO_ROOT = Path(__file__).resolve().parents[2]
+
+SIMD_LEVELS = {'scalar': 0, 'sse2': 1, 'avx2': 2}
+
+
+class DiffStats(ctypes.Structure):
+    """Mirror of UxDiffStats."""
+    _fields_ = [
+        ('changed', ctypes.c_uint64),
+        ('sum_squared', ctypes.c_uint64),
+        ('pixels', ctypes.c_uint64),
+    ]
+
+
+class ImageStats(ctypes.Structure):
+    """Mirror of UxImageStats."""
+    _fields_ = [
+        ('pixels', ctypes.c_uint64),
+        ('luma_sum', ctypes.c_uint64),
+        ('luma_sum_squared', ctypes.c_uint64),
+        ('laplacian_sum', ctypes.c_int64),
+        ('laplacian_sum_squared', ctypes.c_uint64),
+        ('rg_sum', ctypes.c_int64),
+        ('yb2_sum', ctypes.c_int64),
+        ('rg_sum_squared', ctypes.c_uint64),
+        ('yb2_sum_squared', ctypes.c_uint64),
+        ('luma_histogram', ctypes.c_uint32 * 256),
+        ('colour_histogram', ctypes.c_uint32 * 512),
+    ]
+
+
+class Region(ctypes.Structure):
+    """Mirror of UxRegion."""
+    _fields_ = [
+        ('type', ctypes.c_int32),
+        ('x', ctypes.c_int32),
+        ('y', ctypes.c_int32),
+        ('width', ctypes.c_int32),
+        ('height', ctypes.c_int32),
+        ('area', ctypes.c_int32),
+        ('confidence', ctypes.c_float),
+        ('mean_colour', ctypes.c_float * 3),
+        ('luma_mean', ctypes.c_float),
+        ('luma_std', ctypes.c_float),
+    ]
+
+
+class ColourProfile(ctypes.Structure):
+    """Mirror of UxColourProfile."""
+    _fields_ = [
+        ('mean_colour', ctypes.c_float * 3),
+        ('luma_mean', ctypes.c_float),
+        ('luma_std', ctypes.c_float),
+        ('background', ctypes.c_float * 3),
+        ('background_luma', ctypes.c_float),
+        ('foreground', ctypes.c_float * 3),
+        ('foreground_luma', ctypes.c_float),
+        ('foreground_share', ctypes.c_float),
+    ]
+
+
+class TextLine(ctypes.Structure):
+    """Mirror of UxTextLine."""
+    _fields_ = [
+        ('x', ctypes.c_int32),
+        ('y', ctypes.c_int32),
+        ('width', ctypes.c_int32),
+        ('height', ctypes.c_int32),
+        ('glyphs', ctypes.c_int32),
+        ('polarity', ctypes.c_int32),
+        ('confidence', ctypes.c_float),
+    ]
+
+
+class OcrOptions(ctypes.Structure):
+    """Mirror of UxOcrOptions."""
+    _fields_ = [
+        ('target_height', ctypes.c_int32),
+        ('max_scale', ctypes.c_int32),
+        ('block_size', ctypes.c_int32),
+        ('offset', ctypes.c_int32),
+        ('border', ctypes.c_int32),
+        ('denoise', ctypes.c_int32),
+        ('max_skew', ctypes.c_float),
+    ]
+
+
+class OcrCrop(ctypes.Structure):
+    """Mirror of UxOcrCrop."""
+    _fields_ = [
+        ('offset', ctypes.c_int64),
+        ('width', ctypes.c_int32),
+        ('height', ctypes.c_int32),
+        ('scale', ctypes.c_int32),
+        ('inverted', ctypes.c_int32),
+        ('skew', ctypes.c_float),
+    ]
+
+
+_u8_p = ctypes.POINTER(ctypes.c_uint8)
+_u32_p = ctypes.POINTER(ctypes.c_uint32)
+_i32_p = ctypes.POINTER(ctypes.c_int32)
+
+# Row alignment of prepared frames (one AVX2 register / half a cache line)
+FRAME_ALIGNMENT = 32
+
+_lock = threading.Lock()
+_library: Optional[ctypes.CDLL] = None
+_load_attempted = False
+
+
+class EncodeOptions(ctypes.Structure):
+    """Mirror of UxEncodeOptions."""
+    _fields_ = [
+        ('max_size', ctypes.c_int32),
+        ('format', ctypes.c_int32),
+        ('quality', ctypes.c_int32),
+    ]
+
+
+class CatalogRecord(ctypes.Structure):
+    """Mirror of UxCatalogRecord."""
+    _fields_ = [
+        ('magic', ctypes.c_uint32),
+        ('flags', ctypes.c_uint32),
+        ('timestamp_ns', ctypes.c_int64),
+        ('width', ctypes.c_int32),
+        ('height', ctypes.c_int32),
+        ('channels', ctypes.c_int32),
+        ('name_length', ctypes.c_uint32),
+        ('name_offset', ctypes.c_uint64),
+        ('extra_offset', ctypes.c_uint64),
+        ('extra_length', ctypes.c_uint64),
+        ('file_bytes', ctypes.c_uint64),
+        ('content_hash', ctypes.c_uint64),
+        ('phash', ctypes.c_uint64),
+        ('dhash', ctypes.c_uint64),
+        ('label', ctypes.c_char * 32),
+        ('reserved', ctypes.c_uint8 * 8),
+    ]
+
+
+class ResultCacheStats(ctypes.Structure):
+    """Mirror of UxResultCacheStats."""
+    _fields_ = [
+        ('entries', ctypes.c_uint64),
+        ('live_bytes', ctypes.c_uint64),
+        ('log_bytes', ctypes.c_uint64),
+        ('hits', ctypes.c_uint64),
+        ('misses', ctypes.c_uint64),
+        ('evictions', ctypes.c_uint64),
+        ('compactions', ctypes.c_uint64),
+    ]
+
+
+IMAGE_FORMATS = {'png': 0, 'jpeg': 1}
+MEDIA_TYPES = {'png': 'image/png', 'jpeg': 'image/jpeg'}
+
+
+def library_name() -> str:
+    """File name of the library on this platform."""
+    if sys.platform == 'win32':
+        return 'ux_native.dll'
+    if sys.platform == 'darwin':
+        return 'libux_native.dylib'
+    return 'libux_native.so'
+
+
+def library_candidates() -> List[Path]:
+    """Paths searched for the library: $UX_NATIVE_LIB, then the repository root."""
+    candidates = []
+    if os.environ.get(LIBRARY_ENV):
+        candidates.append(Path(os.environ[LIBRARY_ENV]))
+    candidates.append(REPO_ROOT / library_name())
+    return candidates
+
+
+def _declare(lib: ctypes.CDLL) -> None:
+    lib.ux_native_abi_version.restype = ctypes.c_int32
+    lib.ux_native_abi_version.argtypes = []
+    lib.ux_native_simd_level.restype = ctypes.c_char_p
+    lib.ux_native_simd_level.argtypes = []
+    lib.ux_native_set_simd_level.restype = None
+    lib.ux_native_set_simd_level.argtypes = [ctypes.c_int32]
+    lib.ux_diff_luma.restype = ctypes.c_int32
+    lib.ux_diff_luma.argtypes = [
+        _u8_p, ctypes.c_int64, _u8_p, ctypes.c_int64,
+        ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32,
+        ctypes.c_int32, ctypes.c_int32, _u32_p, ctypes.POINTER(DiffStats),
+    ]
+    lib.ux_diff_colour.restype = ctypes.c_int32
+    lib.ux_diff_colour.argtypes = [
+        _u8_p, ctypes.c_int64, ctypes.c_int32, _u8_p, ctypes.c_int64, ctypes.c_int32,
+        ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32,
+        _u32_p, _i32_p, _u8_p, ctypes.c_int64, ctypes.POINTER(DiffStats),
+    ]
+    lib.ux_perceptual_hash.restype = ctypes.c_int32
+    lib.ux_perceptual_hash.argtypes = [
+        _u8_p, ctypes.c_int64, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32,
+        ctypes.POINTER(ctypes.c_uint64), ctypes.POINTER(ctypes.c_uint64),
+    ]
+    lib.ux_hash_index_create.restype = ctypes.c_void_p
+    lib.ux_hash_index_create.argtypes = []
+    lib.ux_hash_index_destroy.restype = None
+    lib.ux_hash_index_destroy.argtypes = [ctypes.c_void_p]
+    lib.ux_hash_index_size.restype = ctypes.c_int64
+    lib.ux_hash_index_size.argtypes = [ctypes.c_void_p]
+    lib.ux_hash_index_add.restype = ctypes.c_int32
+    lib.ux_hash_index_add.argtypes = [ctypes.c_void_p, ctypes.c_int64, ctypes.c_uint64]
+    lib.ux_hash_index_remove.restype = ctypes.c_int32
+    lib.ux_hash_index_remove.argtypes = [ctypes.c_void_p, ctypes.c_int64]
+    lib.ux_hash_index_query.restype = ctypes.c_int64
+    lib.ux_hash_index_query.argtypes = [
+        ctypes.c_void_p, ctypes.c_uint64, ctypes.c_int32,
+        ctypes.POINTER(ctypes.c_int64), _i32_p, ctypes.c_int64,
+    ]
+    lib.ux_image_stats.restype = ctypes.c_int32
+    lib.ux_image_stats.argtypes = [
+        _u8_p, ctypes.c_int64, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32,
+        ctypes.POINTER(ImageStats),
+    ]
+    lib.ux_detect_regions.restype = ctypes.c_int64
+    lib.ux_detect_regions.argtypes = [
+        _u8_p, ctypes.c_int64, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32,
+        ctypes.POINTER(Region), ctypes.c_int64,
+    ]
+    lib.ux_colour_profiles.restype = ctypes.c_int32
+    lib.ux_colour_profiles.argtypes = [
+        _u8_p, ctypes.c_int64, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, _i32_p, ctypes.c_int32,
+        ctypes.POINTER(ColourProfile),
+    ]
+    lib.ux_text_proposer_create.restype = ctypes.c_void_p
+    lib.ux_text_proposer_create.argtypes = []
+    lib.ux_text_proposer_destroy.restype = None
+    lib.ux_text_proposer_destroy.argtypes = [ctypes.c_void_p]
+    lib.ux_text_proposals.restype = ctypes.c_int64
+    lib.ux_text_proposals.argtypes = [
+        ctypes.c_void_p, _u8_p, ctypes.c_int64, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32,
+        ctypes.c_int32, ctypes.POINTER(TextLine), ctypes.c_int64, ctypes.POINTER(ctypes.c_int64),
+    ]
+    lib.ux_ocr_layout.restype = ctypes.c_int64
+    lib.ux_ocr_layout.argtypes = [
+        ctypes.c_int32, ctypes.c_int32, _i32_p, ctypes.c_int32, ctypes.POINTER(OcrOptions), ctypes.POINTER(OcrCrop),
+    ]
+    lib.ux_ocr_preprocess.restype = ctypes.c_int32
+    lib.ux_ocr_preprocess.argtypes = [
+        _u8_p, ctypes.c_int64, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, _i32_p, ctypes.c_int32,
+        ctypes.POINTER(OcrOptions), ctypes.POINTER(OcrCrop), _u8_p, ctypes.c_int64, ctypes.c_int32,
+    ]
+    lib.ux_encode_image_base64.restype = ctypes.c_int64
+    lib.ux_encode_image_base64.argtypes = [
+        _u8_p, ctypes.c_int64, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32, ctypes.c_int32,
+        ctypes.POINTER(EncodeOptions), _u8_p, ctypes.c_int64, ctypes.c_int32,
+    ]
+    lib.ux_content_hash.restype = ctypes.c_int32
+    lib.ux_content_hash.argtypes = [
+        ctypes.c_void_p, ctypes.c_int64, ctypes.c_int64, ctypes.c_int64, ctypes.c_uint64,
+        ctypes.POINTER(ctypes.c_uint64),
+    ]
+    lib.ux_result_cache_open.restype = ctypes.c_void_p
+    lib.ux_result_cache_open.argtypes = [ctypes.c_char_p, ctypes.c_uint64, ctypes.c_char_p, ctypes.c_int32]
+    lib.ux_result_cache_close.restype = None
+    lib.ux_result_cache_close.argtypes = [ctypes.c_void_p]
+    lib.ux_result_cache_get.restype = ctypes.c_int32
+    lib.ux_result_cache_get.argtypes = [
+        ctypes.c_void_p, ctypes.c_char_p, ctypes.c_int64, ctypes.c_void_p, ctypes.c_int64,
+        ctypes.POINTER(ctypes.c_int64),
+    ]
+    lib.ux_result_cache_put.restype = ctypes.c_int32
+    lib.ux_result_cache_put.argtypes = [
+        ctypes.c_void_p, ctypes.c_char_p, ctypes.c_int64, ctypes.c_void_p, ctypes.c_int64, ctypes.c_double,
+    ]
+    lib.ux_result_cache_remove.restype = ctypes.c_int32
+    lib.ux_result_cache_remove.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_int64]
+    lib.ux_result_cache_clear.restype = None
+    lib.ux_result_cache_clear.argtypes = [ctypes.c_void_p]
+    lib.ux_result_cache_stats.restype = ctypes.c_int32
+    lib.ux_result_cache_stats.argtypes = [ctypes.c_void_p, ctypes.POINTER(ResultCacheStats)]
+    lib.ux_catalog_open.restype = ctypes.c_void_p
+    lib.ux_catalog_open.argtypes = [ctypes.c_char_p, ctypes.c_char_p, ctypes.c_int32]
+    lib.ux_catalog_close.restype = None
+    lib.ux_catalog_close.argtypes = [ctypes.c_void_p]
+    lib.ux_catalog_append.restype = ctypes.c_int64
+    lib.ux_catalog_append.argtypes = [
+        ctypes.c_void_p, ctypes.POINTER(CatalogRecord), ctypes.c_char_p, ctypes.c_int32, ctypes.c_char_p,
+        ctypes.c_int64,
+    ]
+    lib.ux_catalog_find.restype = ctypes.c_int64
+    lib.ux_catalog_find.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_int32]
+    lib.ux_catalog_read.restype = ctypes.c_int32
+    lib.ux_catalog_read.argtypes = [
+        ctypes.c_void_p, ctypes.c_int64, ctypes.POINTER(CatalogRecord), ctypes.c_char_p, ctypes.c_int32,
+        ctypes.c_char_p, ctypes.c_int64,
+    ]
+    lib.ux_catalog_set_extra.restype = ctypes.c_int32
+    lib.ux_catalog_set_extra.argtypes = [ctypes.c_void_p, ctypes.c_int64, ctypes.c_char_p, ctypes.c_int64]
+    lib.ux_catalog_remove.restype = ctypes.c_int32
+    lib.ux_catalog_remove.argtypes = [ctypes.c_void_p, ctypes.c_int64]
+    lib.ux_catalog_latest.restype = ctypes.c_int64
+    lib.ux_catalog_latest.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_int64]
+    lib.ux_catalog_count.restype = ctypes.c_int64
+    lib.ux_catalog_count.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+    lib.ux_catalog_prune.restype = ctypes.c_int64
+    lib.ux_catalog_prune.argtypes = [ctypes.c_void_p, ctypes.c_int64, ctypes.POINTER(ctypes.c_int64), ctypes.c_int64]
+    lib.ux_catalog_list.restype = ctypes.c_int64
+    lib.ux_catalog_list.argtypes = [
+        ctypes.c_void_p, ctypes.c_char_p, ctypes.c_int32, ctypes.POINTER(ctypes.c_int64), ctypes.c_int64,
+    ]
+    lib.ux_nms.restype = ctypes.c_int32
+    lib.ux_nms.argtypes = [
+        ctypes.POINTER(ctypes.c_float), ctypes.POINTER(ctypes.c_double), ctypes.c_int32, ctypes.c_float, _i32_p,
+    ]
+
+
+def load_library(path: Optional[Path] = None) -> Optional[ctypes.CDLL]:
+    """
+    Load the native library (once) and return it, or None if it is unavailable.
+
+    Args:
+        path: Explicit library path; replaces any previously loaded library
+    """
+    global _library, _load_attempted
+    with _lock:
+        if path is None and _load_attempted:
+            return _library
+        _load_attempted = True
+        _library = None
+        for candidate in ([Path(path)] if path is not None else library_candidates()):
+            if not candidate.exists():
+                continue
+            try:
+                lib = ctypes.CDLL(str(candidate))
+                _declare(lib)
+            except (OSError, AttributeError) as e:
+                logger.warning(f"Could not load native kernels from {candidate}: {e}")
+                continue
+            if lib.ux_native_abi_version() != ABI_VERSION:
+                logger.warning(f"Ignoring {candidate}: ABI version {lib.ux_native_abi_version()}, "
+                               f"expected {ABI_VERSION} (rebuild with ./build_game.sh native)")
+                continue
+            _library = lib
+            logger.debug(f"Native kernels loaded from {candidate} ({simd_level()})")
+            break
+        return _library
+
+
+def available() -> bool:
+    """True if the native library is loaded (or loadable)."""
+    return load_library() is not None
+
+
+def simd_level() -> Optional[str]:
+    """SIMD path the kernels dispatch to ('scalar', 'sse2' or 'avx2')."""
+    lib = _library
+    return lib.ux_native_simd_level().decode() if lib is not None else None
+
+
+def set_simd_level(level: str) -> None:
+    """Force a lower SIMD path (benchmarks, equivalence checks)."""
+    lib = load_library()
+    if lib is not None:
+        lib.ux_native_set_simd_level(SIMD_LEVELS[level])
+
+
+def tile_shape(height: int, width: int, tile_size: int) -> Tuple[int, int]:
+    """Rows and columns of the change grid for a frame size."""
+    return -(-height // tile_size), -(-width // tile_size)
+
+
+def _pixels(img: np.ndarray) -> Optional[np.ndarray]:
+    """The image as uint8 HxWx3/4 with packed pixels (rows may be strided), or None."""
+    if not isinstance(img, np.ndarray) or img.dtype != np.uint8 or img.ndim != 3 or img.shape[2] not in (3, 4):
+        return None
+    if img.strides[2] != 1 or img.strides[1] != img.shape[2] or img.strides[0] <= 0:
+        img = np.ascontiguousarray(img)
+    return img
+
+
+def _ptr(img: np.ndarray):
+    return img.ctypes.data_as(_u8_p)
+
+
+def diff_frames(before: np.ndarray, after: np.ndarray, threshold: int = 0, tile_size: int = 64,
+                channel_order: str = 'bgr') -> Optional[Dict[str, Any]]:
+    """
+    Compare two frames in one pass over their pixels.
+
+    A pixel counts as changed when its luma (OpenCV BGR2GRAY weights) differs by
+    more than ``threshold``.
+
+    Args:
+        before: HxWx3 or HxWx4 uint8 frame
+        after: Frame with the same shape as ``before``
+        threshold: Luma difference a pixel must exceed to count as changed
+        tile_size: Edge length of the change grid tiles in pixels
+        channel_order: 'bgr' (OpenCV) or 'rgb' (PIL); a fourth channel is ignored
+
+    Returns:
+        Dict with change_ratio, changed_pixels, mse and tiles (per-tile changed
+        fraction, rows x cols), or None if the library or the input is unsupported
+    """
+    lib = load_library()
+    if lib is None:
+        return None
+    a, b = _pixels(before), _pixels(after)
+    if a is None or b is None or a.shape != b.shape:
+        return None
+
+    height, width, channels = a.shape
+    tile = max(1, int(tile_size))
+    rows, cols = tile_shape(height, width, tile)
+    tile_changed = np.zeros((rows, cols), dtype=np.uint32)
+    stats = DiffStats()
+    status = lib.ux_diff_luma(_ptr(a), a.strides[0], _ptr(b), b.strides[0], width, height, channels,
+                              1 if channel_order == 'bgr' else 0, int(threshold), tile, tile,
+                              tile_changed.ctypes.data_as(_u32_p), ctypes.byref(stats))
+    if status != 0:
+        return None
+
+    tile_h = np.minimum(tile, height - np.arange(rows) * tile)
+    tile_w = np.minimum(tile, width - np.arange(cols) * tile)
+    return {
+        'change_ratio': stats.changed / stats.pixels,
+        'changed_pixels': int(stats.changed),
+        'mse': stats.sum_squared / stats.pixels,
+        'tiles': tile_changed / np.outer(tile_h, tile_w),
+        'tile_size': tile,
+    }
+
+
+class PreparedFrame:
+    """
+    A frame copied once into the layout the kernels read fastest: 4 bytes per
+    pixel (fourth byte zero) with every row starting on a FRAME_ALIGNMENT
+    boundary. Used for baselines that are compared against many captures.
+    """
+
+    def __init__(self, img: np.ndarray):
+        height, width = img.shape[:2]
+        stride = -(-width * 4 // FRAME_ALIGNMENT) * FRAME_ALIGNMENT
+        raw = np.empty(height * stride + FRAME_ALIGNMENT, dtype=np.uint8)
+        offset = -raw.ctypes.data % FRAME_ALIGNMENT
+        rows = raw[offset:offset + height * stride].reshape(height, stride)
+        self.pixels = rows[:, :width * 4].reshape(height, width, 4)
+        self.pixels[:, :, :3] = img[:, :, :3]
+        self.pixels[:, :, 3] = 0
+        self.shape = img.shape
+
+    @property
+    def height(self) -> int:
+        return self.shape[0]
+
+    @property
+    def width(self) -> int:
+        return self.shape[1]
+
+
+def prepare_frame(img: np.ndarray) -> Optional[PreparedFrame]:
+    """PreparedFrame for a uint8 HxWx3/4 image, or None for other input."""
+    if not isinstance(img, np.ndarray) or img.dtype != np.uint8 or img.ndim != 3 or img.shape[2] not in (3, 4):
+        return None
+    return PreparedFrame(img)
+
+
+def merge_tile_boxes(tile_changed: np.ndarray, tile_bounds: np.ndarray) -> List[Tuple[int, int, int, int]]:
+    """
+    Merge changed tiles into bounding boxes.
+
+    Tiles with changes that touch (8-connected) form one region; its box is the
+    union of the changed-pixel extents of its tiles.
+
+    Args:
+        tile_changed: rows x cols changed counts
+        tile_bounds: rows x cols x 4 int32 (x0, y0, x1, y1) changed extents
+
+    Returns:
+        (x, y, width, height) boxes ordered top to bottom, left to right
+    """
+    count, labels = cv2.connectedComponents((tile_changed > 0).astype(np.uint8), connectivity=8)
+    boxes = []
+    for label in range(1, count):
+        bounds = tile_bounds[labels == label]
+        x0, y0 = bounds[:, 0].min(), bounds[:, 1].min()
+        x1, y1 = bounds[:, 2].max(), bounds[:, 3].max()
+        boxes.append((int(x0), int(y0), int(x1 - x0), int(y1 - y0)))
+    return sorted(boxes, key=lambda box: (box[1], box[0]))
+
+
+def mask_boxes(mask: np.ndarray, tile_size: int) -> List[Tuple[int, int, int, int]]:
+    """
+    merge_tile_boxes for a boolean change mask (the numpy counterpart of the
+    per-tile extents the kernels accumulate).
+    """
+    tile = max(1, int(tile_size))
+    rows, cols = tile_shape(*mask.shape[:2], tile)
+    ys, xs = np.nonzero(mask)
+    index = (ys // tile) * cols + xs // tile
+    tile_changed = np.bincount(index, minlength=rows * cols)
+    tile_bounds = np.zeros((rows * cols, 4), dtype=np.int64)
+    tile_bounds[:, :2] = np.iinfo(np.int64).max
+    np.minimum.at(tile_bounds[:, 0], index, xs)
+    np.minimum.at(tile_bounds[:, 1], index, ys)
+    np.maximum.at(tile_bounds[:, 2], index, xs + 1)
+    np.maximum.at(tile_bounds[:, 3], index, ys + 1)
+    return merge_tile_boxes(tile_changed.reshape(rows, cols), tile_bounds.reshape(rows, cols, 4))
+
+
+def diff_colour(baseline, frame: np.ndarray, threshold: int = 10, tile_size: int = 32,
+                channel_order: str = 'bgr', overlay: bool = False) -> Optional[Dict[str, Any]]:
+    """
+    Per-channel comparison in one pass: a pixel counts as changed when the luma
+    of its absolute channel differences exceeds ``threshold``
+    (``cvtColor(absdiff(baseline, frame)) > threshold``).
+
+    Args:
+        baseline: PreparedFrame or HxWx3/4 uint8 frame
+        frame: Frame with the same height and width (3 or 4 channels)
+        threshold: Luma of the difference a pixel must exceed to count as changed
+        tile_size: Tile edge length used to group changes into boxes
+        channel_order: 'bgr' (OpenCV) or 'rgb' (PIL)
+        overlay: Also render the diff overlay in the same pass
+
+    Returns:
+        Dict with change_ratio, changed_pixels, mse (over the colour channels),
+        tiles (per-tile changed fraction), boxes ((x, y, w, h) of changed
+        regions) and, if requested, overlay (HxWx3 uint8: ``frame`` at half
+        brightness with changed pixels tinted red), or None if the library or
+        the input is unsupported
+    """
+    lib = load_library()
+    if lib is None:
+        return None
+    a = baseline.pixels if isinstance(baseline, PreparedFrame) else _pixels(baseline)
+    b = _pixels(frame)
+    if a is None or b is None or a.shape[:2] != b.shape[:2]:
+        return None
+
+    height, width = a.shape[:2]
+    tile = max(1, int(tile_size))
+    rows, cols = tile_shape(height, width, tile)
+    tile_changed = np.zeros((rows, cols), dtype=np.uint32)
+    tile_bounds = np.zeros((rows, cols, 4), dtype=np.int32)
+    overlay_img = np.empty((height, width, 3), dtype=np.uint8) if overlay else None
+    stats = DiffStats()
+    status = lib.ux_diff_colour(_ptr(a), a.strides[0], a.shape[2], _ptr(b), b.strides[0], b.shape[2],
+                                width, height, 1 if channel_order == 'bgr' else 0, int(threshold), tile, tile,
+                                tile_changed.ctypes.data_as(_u32_p), tile_bounds.ctypes.data_as(_i32_p),
+                                _ptr(overlay_img) if overlay else None, width * 3 if overlay else 0,
+                                ctypes.byref(stats))
+    if status != 0:
+        return None
+
+    tile_h = np.minimum(tile, height - np.arange(rows) * tile)
+    tile_w = np.minimum(tile, width - np.arange(cols) * tile)
+    return {
+        'change_ratio': stats.changed / stats.pixels,
+        'changed_pixels': int(stats.changed),
+        'mse': stats.sum_squared / (stats.pixels * 3),
+        'tiles': tile_changed / np.outer(tile_h, tile_w),
+        'boxes': merge_tile_boxes(tile_changed, tile_bounds),
+        'tile_size': tile,
+        'overlay': overlay_img,
+    }
+
+
+def _variance(total: int, total_squared: int, count: int) -> float:
+    """Population variance from integer sums, exact until the final division."""
+    return (total_squared * count - total * total) / (count * count)
+
+
+def image_stats(img: np.ndarray, channel_order: str = 'bgr', threads: int = 0) -> Optional[Dict[str, Any]]:
+    """
+    Quality statistics of a frame in one banded, multithreaded pass.
+
+    The kernel accumulates integer sums only, so the values are identical
+    from run to run and for every thread count.
+
+    Args:
+        img: HxWx3 or HxWx4 uint8 frame
+        channel_order: 'bgr' (OpenCV) or 'rgb' (PIL)
+        threads: 1 runs on the calling thread; 0 uses the shared pool
+
+    Returns:
+        Dict with brightness (mean luma), contrast (luma standard deviation),
+        laplacian_var (cv2.Laplacian variance of luma), colorfulness
+        (Hasler-Suesstrunk), luma_histogram (256 counts) and color_histogram
+        (8x8x8 counts in byte order), or None if the library or the input is
+        unsupported
+    """
+    lib = load_library()
+    if lib is None:
+        return None
+    a = _pixels(img)
+    if a is None:
+        return None
+
+    height, width, channels = a.shape
+    stats = ImageStats()
+    status = lib.ux_image_stats(_ptr(a), a.strides[0], width, height, channels,
+                                1 if channel_order == 'bgr' else 0, int(threads), ctypes.byref(stats))
+    if status != 0:
+        return None
+
+    n = stats.pixels
+    luma_var = _variance(stats.luma_sum, stats.luma_sum_squared, n)
+    # yb2 is twice yb: its variance is four times and its mean twice the real one
+    rg_var = _variance(stats.rg_sum, stats.rg_sum_squared, n)
+    yb_var = _variance(stats.yb2_sum, stats.yb2_sum_squared, n) / 4
+    rg_mean, yb_mean = stats.rg_sum / n, stats.yb2_sum / (2 * n)
+    return {
+        'brightness': stats.luma_sum / n,
+        'contrast': float(np.sqrt(luma_var)),
+        'laplacian_var': _variance(stats.laplacian_sum, stats.laplacian_sum_squared, n),
+        'colorfulness': float(np.sqrt(rg_var + yb_var) + 0.3 * np.sqrt(rg_mean ** 2 + yb_mean ** 2)),
+        'luma_histogram': np.ctypeslib.as_array(stats.luma_histogram).copy(),
+        'color_histogram': np.ctypeslib.as_array(stats.colour_histogram).reshape(8, 8, 8).copy(),
+    }
+
+
+REGION_TYPES = {1: 'button', 2: 'input', 3: 'container'}
+
+
+def detect_regions(img: np.ndarray, tolerance: int = 8, channel_order: str = 'bgr') -> Optional[List[Dict[str, Any]]]:
+    """
+    Button, input field and container candidates of a flat-shaded frame.
+
+    One connected-components pass over regions of near-constant colour
+    (native/region_detector.h), classified with the size and aspect rules of
+    UIElementDetector. Replaces the Canny/findContours passes and the per-ROI
+    colour analysis of the OpenCV path.
+
+    Args:
+        img: HxWx3 or HxWx4 uint8 frame
+        tolerance: largest per-channel step between neighbouring pixels of one region
+        channel_order: 'bgr' (OpenCV) or 'rgb' (PIL)
+
+    Returns:
+        Dicts with type ('button', 'input' or 'container'), bbox (x, y, w, h),
+        area (pixels of the region), confidence, and mean_color (byte order),
+        brightness and contrast (luma mean and standard deviation) over the
+        bbox, top to bottom; None if the library or the input is unsupported
+    """
+    lib = load_library()
+    if lib is None:
+        return None
+    a = _pixels(img)
+    if a is None:
+        return None
+
+    height, width, channels = a.shape
+    capacity = 256
+    while True:
+        regions = (Region * capacity)()
+        count = lib.ux_detect_regions(_ptr(a), a.strides[0], width, height, channels,
+                                      1 if channel_order == 'bgr' else 0, int(tolerance), regions, capacity)
+        if count < 0:
+            return None
+        if count <= capacity:
+            break
+        capacity = count
+    return [{
+        'type': REGION_TYPES[r.type],
+        'bbox': (r.x, r.y, r.width, r.height),
+        'area': r.area,
+        'confidence': float(r.confidence),
+        'mean_color': tuple(float(c) for c in r.mean_colour),
+        'brightness': float(r.luma_mean),
+        'contrast': float(r.luma_std),
+    } for r in regions[:count]]
+
+
+def _clip_boxes(boxes: np.ndarray, width: int, height: int) -> np.ndarray:
+    """(x0, y0, x1, y1) of (x, y, w, h) boxes clipped to the frame, as ClipBox does."""
+    x0 = np.clip(boxes[:, 0], 0, width)
+    y0 = np.clip(boxes[:, 1], 0, height)
+    x1 = np.clip(boxes[:, 0] + np.maximum(boxes[:, 2], 0), x0, width)
+    y1 = np.clip(boxes[:, 1] + np.maximum(boxes[:, 3], 0), y0, height)
+    return np.stack([x0, y0, x1, y1], axis=1)
+
+
+def _profiles_from_moments(box: np.ndarray, ring: np.ndarray) -> Dict[str, np.ndarray]:
+    """Profiles from Nx6 moments (pixels, colour sums, luma sum, luma sum of squares)."""
+    n = np.maximum(box[:, 0], 1).astype(np.float64)
+    rn = np.maximum(ring[:, 0], 1).astype(np.float64)
+    mean = box[:, 4] / n
+    variance = np.maximum(box[:, 5] / n - mean * mean, 0.0)
+    colour = box[:, 1:4] / n[:, None]
+    background = ring[:, 1:4] / rn[:, None]
+    background_luma = ring[:, 4] / rn
+    d = mean - background_luma
+    spread = variance + d * d
+    share = np.divide(d * d, spread, out=np.zeros_like(d), where=spread > 0)
+    has_foreground = share >= 0.01
+    safe_share = np.where(has_foreground, share, 1.0)
+    foreground = np.where(has_foreground[:, None],
+                          np.clip(background + (colour - background) / safe_share[:, None], 0, 255), colour)
+    foreground_luma = np.where(has_foreground, np.clip(background_luma + d / safe_share, 0, 255), mean)
+    empty = box[:, 0] == 0
+    profiles = {
+        'mean_color': colour,
+        'brightness': mean,
+        'contrast': np.sqrt(variance),
+        'background_color': background,
+        'background_brightness': background_luma,
+        'foreground_color': foreground,
+        'foreground_brightness': foreground_luma,
+        'foreground_share': np.where(has_foreground, share, 0.0),
+    }
+    for values in profiles.values():
+        values[empty] = 0
+    return profiles
+
+
+def _colour_profiles_numpy(img: np.ndarray, boxes: np.ndarray, channel_order: str) -> Dict[str, np.ndarray]:
+    codes = {(3, 'bgr'): cv2.COLOR_BGR2GRAY, (4, 'bgr'): cv2.COLOR_BGRA2GRAY,
+             (3, 'rgb'): cv2.COLOR_RGB2GRAY, (4, 'rgb'): cv2.COLOR_RGBA2GRAY}
+    height, width = img.shape[:2]
+    luma = cv2.cvtColor(img, codes[(img.shape[2], channel_order)]).astype(np.int64)
+    planes = np.dstack([np.ones((height, width), np.int64), img[:, :, :3].astype(np.int64), luma, luma * luma])
+    integral = np.zeros((height + 1, width + 1, 6), np.int64)
+    integral[1:, 1:] = planes.cumsum(axis=0).cumsum(axis=1)
+
+    def moments(x0, y0, x1, y1):
+        return integral[y1, x1] - integral[y0, x1] - integral[y1, x0] + integral[y0, x0]
+
+    x0, y0, x1, y1 = _clip_boxes(boxes, width, height).T
+    box = moments(x0, y0, x1, y1)
+    # Border ring width max(1, min(w, h) // 8); boxes without an interior are all ring
+    r = np.maximum(1, np.minimum(x1 - x0, y1 - y0) // 8)
+    solid = (x1 - x0 <= 2 * r) | (y1 - y0 <= 2 * r)
+    inner = np.where(solid[:, None], 0, moments(x0 + r, y0 + r, np.maximum(x1 - r, x0 + r), np.maximum(y1 - r, y0 + r)))
+    return _profiles_from_moments(box, box - inner)
+
+
+def colour_profiles(img: np.ndarray, boxes, channel_order: str = 'bgr') -> Optional[Dict[str, np.ndarray]]:
+    """
+    Colour profiles of many boxes of one frame in a single call.
+
+    The native kernel walks each box once with SIMD, or builds integral images
+    once when the boxes overlap heavily; numpy integral images are used when
+    the library is not built. Boxes are clipped to the frame.
+
+    The border ring (max(1, min(w, h) // 8) pixels wide) is taken as the
+    background. The foreground colour and its share of the box follow from
+    the box and ring moments under a two-colour model. A share of 0 means no
+    distinct foreground; the foreground then equals the mean.
+
+    Args:
+        img: HxWx3 or HxWx4 uint8 frame
+        boxes: Nx4 (x, y, w, h)
+        channel_order: 'bgr' (OpenCV) or 'rgb' (PIL)
+
+    Returns:
+        Dict of arrays: mean_color, background_color, foreground_color (Nx3,
+        byte order); brightness and contrast (luma mean / standard deviation),
+        background_brightness, foreground_brightness, foreground_share (N);
+        None for unsupported input
+    """
+    a = _pixels(img)
+    if a is None:
+        return None
+    b = np.ascontiguousarray(boxes, dtype=np.int32).reshape(-1, 4)
+    lib = load_library()
+    if lib is None:
+        return _colour_profiles_numpy(a, b.astype(np.int64), channel_order)
+
+    height, width, channels = a.shape
+    out = (ColourProfile * max(len(b), 1))()
+    status = lib.ux_colour_profiles(_ptr(a), a.strides[0], width, height, channels,
+                                    1 if channel_order == 'bgr' else 0, b.ctypes.data_as(_i32_p), len(b), out)
+    if status != 0:
+        return None
+    raw = np.ctypeslib.as_array(out).view(np.float32).reshape(-1, 14)[:len(b)].astype(np.float64)
+    return {
+        'mean_color': raw[:, 0:3],
+        'brightness': raw[:, 3],
+        'contrast': raw[:, 4],
+        'background_color': raw[:, 5:8],
+        'background_brightness': raw[:, 8],
+        'foreground_color': raw[:, 9:12],
+        'foreground_brightness': raw[:, 12],
+        'foreground_share': raw[:, 13],
+    }
+
+
+def _ocr_scale(height: int, options: OcrOptions) -> int:
+    if height <= 0 or height >= options.target_height:
+        return 1
+    return min(max(-(-options.target_height // height), 1), options.max_scale)
+
+
+def _prepare_ocr_crops_opencv(a: np.ndarray, boxes: np.ndarray, options: OcrOptions,
+                              channel_order: str) -> List[Dict[str, Any]]:
+    """The native preprocessing with OpenCV, without deskewing."""
+    height, width, channels = a.shape
+    code = {('bgr', 3): cv2.COLOR_BGR2GRAY, ('bgr', 4): cv2.COLOR_BGRA2GRAY,
+            ('rgb', 3): cv2.COLOR_RGB2GRAY, ('rgb', 4): cv2.COLOR_RGBA2GRAY}[(channel_order, channels)]
+    crops = []
+    for x0, y0, x1, y1 in _clip_boxes(boxes.astype(np.int64), width, height):
+        if x1 <= x0 or y1 <= y0:
+            crops.append({'image': np.empty((0, 0), dtype=np.uint8), 'scale': 1, 'inverted': False, 'skew': 0.0})
+            continue
+        gray = cv2.cvtColor(np.ascontiguousarray(a[y0:y1, x0:x1]), code)
+        if options.denoise:
+            gray = cv2.medianBlur(gray, 3)
+        # Light text on a darker border is inverted
+        ring = np.ones(gray.shape, dtype=bool)
+        ring[1:-1, 1:-1] = False
+        edge = gray[ring]
+        inverted = int(gray.sum(dtype=np.int64)) * edge.size > int(edge.sum(dtype=np.int64)) * gray.size
+        if inverted:
+            gray = 255 - gray
+        scale = _ocr_scale(gray.shape[0], options)
+        scaled = np.repeat(np.repeat(gray, scale, axis=0), scale, axis=1)
+        binary = cv2.adaptiveThreshold(scaled, 255, cv2.ADAPTIVE_THRESH_MEAN_C, cv2.THRESH_BINARY,
+                                       options.block_size, options.offset)
+        uh, uw = binary.shape
+        pad = math.ceil(uw * 0.5 * math.tan(math.radians(options.max_skew))) if options.max_skew > 0 else 0
+        border = options.border
+        image = np.full((uh + 2 * (pad + border), uw + 2 * border), 255, dtype=np.uint8)
+        image[border + pad:border + pad + uh, border:border + uw] = binary
+        crops.append({'image': image, 'scale': scale, 'inverted': bool(inverted), 'skew': 0.0})
+    return crops
+
+
+def prepare_ocr_crops(img: np.ndarray, boxes, target_height: int = 32, max_scale: int = 4, block_size: int = 31,
+                      offset: int = 10, border: int = 8, denoise: bool = True, max_skew: float = 5.0,
+                      channel_order: str = 'bgr', threads: int = 0) -> Optional[List[Dict[str, Any]]]:
+    """
+    Binary, Tesseract-ready images of many text crops of one frame.
+
+    Each crop is converted to luma, median-filtered, inverted if its text is
+    lighter than its border, upscaled by an integer factor (nearest
+    neighbour) when shorter than ``target_height``, thresholded against the
+    mean of its block_size x block_size neighbourhood minus ``offset``
+    (cv2.ADAPTIVE_THRESH_MEAN_C), deskewed and padded with white. The native
+    kernel fills all crops into one buffer on the shared thread pool; OpenCV
+    does the same steps, except deskewing, when the library is not built.
+
+    Args:
+        img: HxWx3 or HxWx4 uint8 frame
+        boxes: Nx4 (x, y, w, h), clipped to the frame
+        target_height: Crops shorter than this are upscaled
+        max_scale: Largest upscaling factor
+        block_size: Odd adaptive-threshold window
+        offset: Constant subtracted from the window mean
+        border: White pixels around each result
+        denoise: Apply a 3x3 median first
+        max_skew: Largest skew in degrees to undo (0 disables deskewing)
+        channel_order: 'bgr' (OpenCV) or 'rgb' (PIL)
+        threads: 1 runs on the calling thread; 0 uses the shared pool
+
+    Returns:
+        Dicts with image (2-D uint8, 0 text on 255 paper; empty for empty
+        boxes), scale, inverted and skew (degrees undone); None for
+        unsupported input or options
+    """
+    a = _pixels(img)
+    if a is None or block_size < 3 or block_size % 2 == 0:
+        return None
+    b = np.ascontiguousarray(boxes, dtype=np.int32).reshape(-1, 4)
+    options = OcrOptions(int(target_height), int(max_scale), int(block_size), int(offset), int(border),
+                         1 if denoise else 0, float(max_skew))
+    lib = load_library()
+    if lib is None:
+        return _prepare_ocr_crops_opencv(a, b, options, channel_order)
+
+    height, width, channels = a.shape
+    crops = (OcrCrop * max(len(b), 1))()
+    size = lib.ux_ocr_layout(width, height, b.ctypes.data_as(_i32_p), len(b), ctypes.byref(options), crops)
+    if size < 0:
+        return None
+    buffer = np.empty(max(size, 1), dtype=np.uint8)
+    status = lib.ux_ocr_preprocess(_ptr(a), a.strides[0], width, height, channels,
+                                   1 if channel_order == 'bgr' else 0, b.ctypes.data_as(_i32_p), len(b),
+                                   ctypes.byref(options), crops, buffer.ctypes.data_as(_u8_p), size, int(threads))
+    if status != 0:
+        return None
+    return [{
+        'image': buffer[c.offset:c.offset + c.width * c.height].reshape(c.height, c.width),
+        'scale': c.scale,
+        'inverted': bool(c.inverted),
+        'skew': float(c.skew),
+    } for c in crops[:len(b)]]
+
+
+def fit_size(width: int, height: int, max_size: int) -> Tuple[int, int]:
+    """Size with the longest side at most max_size (aspect kept, never enlarged)."""
+    longest = max(width, height)
+    if max_size <= 0 or longest <= max_size:
+        return width, height
+    ratio = max_size / longest
+    return max(int(width * ratio), 1), max(int(height * ratio), 1)
+
+
+# Output buffer of encode_image_base64, kept per thread and grown as needed
+_encode_buffers = threading.local()
+
+
+def _encode_image_opencv(a: np.ndarray, size: Tuple[int, int], image_format: str, quality: int,
+                         channel_order: str) -> str:
+    """The native encoding with cv2.resize (INTER_AREA), cv2.imencode and base64."""
+    if a.shape[2] == 4:
+        a = a[:, :, :3]
+    if channel_order == 'rgb':
+        a = a[:, :, ::-1]
+    if size != (a.shape[1], a.shape[0]):
+        a = cv2.resize(np.ascontiguousarray(a), size, interpolation=cv2.INTER_AREA)
+    params = [cv2.IMWRITE_JPEG_QUALITY, int(quality)] if image_format == 'jpeg' else []
+    ok, encoded = cv2.imencode('.jpg' if image_format == 'jpeg' else '.png', np.ascontiguousarray(a), params)
+    if not ok:
+        raise ValueError(f"cv2.imencode failed for {image_format}")
+    return base64.b64encode(encoded.tobytes()).decode('ascii')
+
+
+def encode_image_base64(img: np.ndarray, max_size: int = 1024, image_format: str = 'png', quality: int = 85,
+                        channel_order: str = 'bgr', threads: int = 0) -> Optional[Dict[str, Any]]:
+    """
+    A frame as base64 PNG or JPEG data for a vision API request, in memory.
+
+    The frame is area-averaged (cv2.INTER_AREA) so its longest side is at
+    most ``max_size``, encoded and base64-encoded by one native call that
+    writes into a reused per-thread buffer: no temporary file, no re-read.
+    Without the library, cv2.resize, cv2.imencode and the base64 module do
+    the same.
+
+    Args:
+        img: HxWx3 or HxWx4 uint8 frame
+        max_size: Longest side of the result; 0 keeps the frame size
+        image_format: 'png' or 'jpeg'
+        quality: JPEG quality (1-100)
+        channel_order: 'bgr' (OpenCV) or 'rgb' (PIL)
+        threads: 1 runs on the calling thread; 0 uses the shared pool
+
+    Returns:
+        Dict with data (base64 str), media_type, width and height; None for
+        unsupported input or options
+    """
+    a = _pixels(img)
+    if a is None or image_format not in IMAGE_FORMATS or not 1 <= quality <= 100:
+        return None
+    height, width, channels = a.shape
+    size = fit_size(width, height, int(max_size))
+    result = {'media_type': MEDIA_TYPES[image_format], 'width': size[0], 'height': size[1]}
+    lib = load_library()
+    if lib is None:
+        result['data'] = _encode_image_opencv(a, size, image_format, quality, channel_order)
+        return result
+
+    options = EncodeOptions(int(max_size), IMAGE_FORMATS[image_format], int(quality))
+    # Fixed-Huffman deflate of filtered rows stays under 9/8 of their size
+    raw = size[1] * (size[0] * 3 + 1)
+    capacity = (raw + raw // 8 + 4096 + 2) // 3 * 4
+    for _ in range(2):
+        buffer = getattr(_encode_buffers, 'buffer', None)
+        if buffer is None or len(buffer) < capacity:
+            buffer = _encode_buffers.buffer = np.empty(capacity, dtype=np.uint8)
+        length = lib.ux_encode_image_base64(_ptr(a), a.strides[0], width, height, channels,
+                                            1 if channel_order == 'bgr' else 0, ctypes.byref(options),
+                                            buffer.ctypes.data_as(_u8_p), len(buffer), int(threads))
+        if length < 0:
+            return None
+        if length <= len(buffer):
+            result['data'] = buffer[:length].tobytes().decode('ascii')
+            return result
+        capacity = length
+    return None
+
+
+def nms(boxes, scores, iou_threshold: float = 0.5) -> Optional[np.ndarray]:
+    """
+    Greedy non-maximum suppression.
+
+    Boxes are visited by decreasing score (ties in input order); a box is kept
+    unless a kept box overlaps it with IoU above ``iou_threshold``. Candidates
+    are looked up in a packed R-tree, so 10^5 boxes take milliseconds.
+
+    Args:
+        boxes: Nx4 (x, y, w, h)
+        scores: N scores
+        iou_threshold: IoU above which the lower-scored box is dropped
+
+    Returns:
+        int32 indices of the kept boxes, highest score first, or None if the
+        library is not built
+    """
+    lib = load_library()
+    if lib is None:
+        return None
+    b = np.ascontiguousarray(boxes, dtype=np.float32).reshape(-1, 4)
+    s = np.ascontiguousarray(scores, dtype=np.float64).ravel()
+    if len(b) != len(s):
+        raise ValueError(f"{len(b)} boxes but {len(s)} scores")
+    keep = np.empty(len(b), np.int32)
+    count = lib.ux_nms(b.ctypes.data_as(ctypes.POINTER(ctypes.c_float)),
+                       s.ctypes.data_as(ctypes.POINTER(ctypes.c_double)), len(b), float(iou_threshold),
+                       keep.ctypes.data_as(_i32_p))
+    return keep[:count] if count >= 0 else None
+
+
+# Perceptual hashes (native/perceptual_hash.h). The numpy path below
+# reproduces the native bits exactly, so stored hashes stay comparable whether
+# or not the library is built.
+PHASH_GRID, PHASH_BLOCK = 32, 8
+DHASH_ROWS, DHASH_COLS = 8, 9
+
+
+def _round_half_away(value: float) -> int:
+    """std::lround"""
+    return int(math.copysign(math.floor(abs(value) + 0.5), value))
+
+
+_DCT_Q14 = np.array([[_round_half_away(math.cos((2 * x + 1) * u * math.pi / (2 * PHASH_GRID)) * (1 << 14))
+                      for x in range(PHASH_GRID)] for u in range(PHASH_BLOCK)], dtype=np.int64)
+
+
+def _cell_grid(luma: np.ndarray, rows: int, cols: int) -> Tuple[np.ndarray, np.ndarray]:
+    """Luma sums and pixel counts of a rows x cols grid (pixel x -> cell x * cols // width)."""
+    height, width = luma.shape
+    row = np.arange(height, dtype=np.int64) * rows // height
+    col = np.arange(width, dtype=np.int64) * cols // width
+    index = (row[:, None] * cols + col[None, :]).ravel()
+    sums = np.bincount(index, weights=luma.ravel(), minlength=rows * cols).astype(np.int64)
+    counts = np.bincount(index, minlength=rows * cols).astype(np.int64)
+    return sums.reshape(rows, cols), counts.reshape(rows, cols)
+
+
+def _bits_to_int(bits: np.ndarray) -> int:
+    return int.from_bytes(np.packbits(bits.astype(np.uint8).ravel()).tobytes(), 'big')
+
+
+def _perceptual_hash_numpy(img: np.ndarray, channel_order: str) -> Tuple[int, int]:
+    codes = {(3, 'bgr'): cv2.COLOR_BGR2GRAY, (4, 'bgr'): cv2.COLOR_BGRA2GRAY,
+             (3, 'rgb'): cv2.COLOR_RGB2GRAY, (4, 'rgb'): cv2.COLOR_RGBA2GRAY}
+    luma = cv2.cvtColor(img, codes[(img.shape[2], channel_order)])
+
+    sums, counts = _cell_grid(luma, PHASH_GRID, PHASH_GRID)
+    means = np.where(counts > 0, sums // np.maximum(counts, 1), 0)
+    coefficients = (_DCT_Q14 @ (means @ _DCT_Q14.T)).ravel()
+    ordered = np.sort(coefficients)
+    phash = _bits_to_int(2 * coefficients > ordered[31] + ordered[32])
+
+    sums, counts = _cell_grid(luma, DHASH_ROWS, DHASH_COLS)
+    dhash = _bits_to_int(sums[:, :-1] * counts[:, 1:] > sums[:, 1:] * counts[:, :-1])
+    return phash, dhash
+
+
+def perceptual_hash(img: np.ndarray, channel_order: str = 'bgr') -> Optional[Tuple[int, int]]:
+    """
+    64-bit pHash and dHash of a frame.
+
+    Uses the native kernel when it is built and numpy otherwise; both give the
+    same bits.
+
+    Args:
+        img: HxWx3 or HxWx4 uint8 frame
+        channel_order: 'bgr' (OpenCV) or 'rgb' (PIL)
+
+    Returns:
+        (phash, dhash), or None for unsupported input
+    """
+    a = _pixels(img)
+    if a is None:
+        return None
+    lib = load_library()
+    if lib is None:
+        return _perceptual_hash_numpy(a, channel_order)
+
+    height, width, channels = a.shape
+    phash, dhash = ctypes.c_uint64(), ctypes.c_uint64()
+    status = lib.ux_perceptual_hash(_ptr(a), a.strides[0], width, height, channels,
+                                    1 if channel_order == 'bgr' else 0, ctypes.byref(phash), ctypes.byref(dhash))
+    return (phash.value, dhash.value) if status == 0 else None
+
+
+def hamming(a: int, b: int) -> int:
+    """Number of differing bits of two hashes."""
+    return bin(a ^ b).count('1')
+
+
+class HashIndex:
+    """
+    Hamming-radius index of 64-bit hashes keyed by integer id.
+
+    Backed by the native multi-index-hashing table when the library is built
+    (microsecond queries at 10^6 entries); otherwise a linear scan over a dict.
+    """
+
+    def __init__(self):
+        self._lib = load_library()
+        self._handle = self._lib.ux_hash_index_create() if self._lib is not None else None
+        self._hashes: Dict[int, int] = {}
+
+    def __del__(self):
+        if getattr(self, '_handle', None):
+            self._lib.ux_hash_index_destroy(self._handle)
+            self._handle = None
+
+    def __len__(self) -> int:
+        if self._handle:
+            return self._lib.ux_hash_index_size(self._handle)
+        return len(self._hashes)
+
+    def add(self, id: int, hash_value: int) -> None:
+        """File ``id`` under ``hash_value`` (replacing its previous hash)."""
+        if self._handle:
+            self._lib.ux_hash_index_add(self._handle, id, hash_value)
+        else:
+            self._hashes[id] = hash_value
+
+    def remove(self, id: int) -> bool:
+        """Drop ``id``; False if it was not indexed."""
+        if self._handle:
+            return bool(self._lib.ux_hash_index_remove(self._handle, id))
+        return self._hashes.pop(id, None) is not None
+
+    def query(self, hash_value: int, radius: int) -> List[Tuple[int, int]]:
+        """(id, distance) of every entry within ``radius`` bits, nearest first."""
+        if not self._handle:
+            matches = [(id, hamming(h, hash_value)) for id, h in self._hashes.items()]
+            return sorted(((id, d) for id, d in matches if d <= radius), key=lambda m: (m[1], m[0]))
+
+        capacity = 64
+        while True:
+            ids = (ctypes.c_int64 * capacity)()
+            distances = (ctypes.c_int32 * capacity)()
+            count = self._lib.ux_hash_index_query(self._handle, hash_value, radius, ids, distances, capacity)
+            if count <= capacity:
+                break
+            capacity = count
+        return sorted(zip(ids[:count], distances[:count]), key=lambda m: (m[1], m[0]))
+
+
+TEXT_POLARITIES = {0: 'dark', 1: 'light'}
+
+
+class TextProposer:
+    """
+    Text-line proposals for a stream of frames (native/text_proposals.h).
+
+    Glyphs are MSER regions of luma and its inverse, filtered by shape and
+    chained into lines natively. The proposer keeps its buffers and the
+    previous frame's glyphs, so an incremental call searches only the 64x64
+    tiles that changed (plus a margin). Requires the native library.
+    """
+
+    def __init__(self):
+        self._lib = load_library()
+        self._handle = self._lib.ux_text_proposer_create() if self._lib is not None else None
+        self.searched_pixels = 0
+
+    def __del__(self):
+        if getattr(self, '_handle', None):
+            self._lib.ux_text_proposer_destroy(self._handle)
+            self._handle = None
+
+    @property
+    def available(self) -> bool:
+        return bool(self._handle)
+
+    def propose(self, img: np.ndarray, incremental: bool = True,
+                channel_order: str = 'bgr') -> Optional[List[Dict[str, Any]]]:
+        """
+        Text lines of a frame.
+
+        Args:
+            img: HxWx3 or HxWx4 uint8 frame
+            incremental: Search only what changed since the previous frame
+                (a frame of another size is always searched in full)
+            channel_order: 'bgr' (OpenCV) or 'rgb' (PIL)
+
+        Returns:
+            Dicts with bbox (x, y, w, h), glyphs (glyph count), polarity
+            ('dark' or 'light' text) and confidence, top to bottom; None if
+            the library or the input is unsupported
+        """
+        if not self._handle:
+            return None
+        a = _pixels(img)
+        if a is None:
+            return None
+
+        height, width, channels = a.shape
+        bgr = 1 if channel_order == 'bgr' else 0
+        searched = ctypes.c_int64(0)
+        capacity = 64
+        lines = (TextLine * capacity)()
+        count = self._lib.ux_text_proposals(self._handle, _ptr(a), a.strides[0], width, height, channels, bgr,
+                                            1 if incremental else 0, lines, capacity, ctypes.byref(searched))
+        if count > capacity:
+            # Same frame again: nothing changed, so the retry is only a copy
+            capacity = count
+            lines = (TextLine * capacity)()
+            count = self._lib.ux_text_proposals(self._handle, _ptr(a), a.strides[0], width, height, channels, bgr,
+                                                1, lines, capacity, None)
+        if count < 0:
+            return None
+        self.searched_pixels = searched.value
+        return [{
+            'bbox': (line.x, line.y, line.width, line.height),
+            'glyphs': line.glyphs,
+            'polarity': TEXT_POLARITIES[line.polarity],
+            'confidence': float(line.confidence),
+        } for line in lines[:count]]
+
+
+def content_hash(data, seed: int = 0) -> int:
+    """
+    64-bit hash of the bytes of an array or buffer (XXH64, native/content_hash.h).
+
+    Arrays are hashed by their elements in C order whatever their strides, so
+    a view and its copy hash alike; shape and dtype are not part of the hash.
+    Without the library the hash is a BLAKE2b digest, which differs from the
+    native value but is just as stable.
+
+    Raises:
+        TypeError: For arrays of Python objects
+    """
+    a = data if isinstance(data, np.ndarray) else np.frombuffer(data, np.uint8)
+    if a.dtype.hasobject:
+        raise TypeError("cannot hash an object array by content")
+    if a.ndim == 0 or a.flags.c_contiguous:
+        a = np.ascontiguousarray(a)
+        rows, row_bytes, stride = 1, a.nbytes, a.nbytes
+    elif a.strides[0] > 0 and a[0].flags.c_contiguous:
+        # Packed rows at a stride, e.g. a crop of a frame
+        rows, row_bytes, stride = a.shape[0], a[0].nbytes, a.strides[0]
+    else:
+        a = np.ascontiguousarray(a)
+        rows, row_bytes, stride = 1, a.nbytes, a.nbytes
+
+    lib = load_library()
+    if lib is None:
+        digest = hashlib.blake2b(digest_size=8, key=seed.to_bytes(8, 'little'))
+        for chunk in ([a] if rows == 1 else a):
+            digest.update(chunk.reshape(-1).view(np.uint8))
+        return int.from_bytes(digest.digest(), 'little')
+
+    out = ctypes.c_uint64(0)
+    status = lib.ux_content_hash(a.ctypes.data, stride, row_bytes, rows, seed, ctypes.byref(out))
+    if status != 0:
+        raise ValueError("invalid buffer")
+    return out.value
+
+
+class ResultCache:
+    """
+    Persistent bytes cache with a time-to-live per entry (native/result_cache.h).
+
+    Entries are kept in one memory-mapped, append-only log bounded to
+    ``max_bytes``; when it fills, expired and then least recently used entries
+    are evicted. Without the library, or when another process holds the log,
+    the cache is an in-memory LRU with the same bound that lasts as long as
+    the process.
+    """
+
+    def __init__(self, path, max_bytes: int = 256 << 20):
+        self.path = Path(path)
+        self.max_bytes = max_bytes
+        self._lib = load_library()
+        self._handle = None
+        self._memory: 'OrderedDict[bytes, Tuple[float, bytes]]' = OrderedDict()
+        self._memory_bytes = 0
+        self._memory_lock = threading.Lock()
+        self._counters = {'hits': 0, 'misses': 0, 'evictions': 0}
+        if self._lib is None:
+            return
+        try:
+            self.path.parent.mkdir(parents=True, exist_ok=True)
+        except OSError as e:
+            logger.warning(f"Result cache {self.path} unavailable ({e}); caching in memory")
+            return
+        error = ctypes.create_string_buffer(256)
+        self._handle = self._lib.ux_result_cache_open(str(self.path).encode(), max_bytes, error, len(error))
+        if not self._handle:
+            logger.warning(f"Result cache {self.path} unavailable ({error.value.decode()}); caching in memory")
+
+    def __del__(self):
+        self.close()
+
+    @property
+    def persistent(self) -> bool:
+        """True if entries are kept in the on-disk log."""
+        return bool(self._handle)
+
+    def close(self) -> None:
+        """Release the log (it stays on disk for the next run)."""
+        if getattr(self, '_handle', None):
+            self._lib.ux_result_cache_close(self._handle)
+            self._handle = None
+
+    def get(self, key) -> Optional[bytearray]:
+        """The value stored under ``key`` (str or bytes), or None if missing or expired."""
+        key = key.encode() if isinstance(key, str) else bytes(key)
+        if not self._handle:
+            return self._memory_get(key)
+
+        length = ctypes.c_int64(0)
+        value, buffer = bytearray(), None
+        while True:
+            found = self._lib.ux_result_cache_get(self._handle, key, len(key), buffer, len(value),
+                                                  ctypes.byref(length))
+            if found != 1:
+                return None
+            if length.value <= len(value):
+                return value
+            # Sized by the first call; only a concurrent put can make it loop again
+            value = bytearray(length.value)
+            buffer = ctypes.addressof((ctypes.c_char * len(value)).from_buffer(value))
+
+    def put(self, key, value, ttl: float) -> bool:
+        """
+        Store ``value`` (bytes-like) under ``key`` for ``ttl`` seconds.
+
+        Returns:
+            False if the value is too large for the cache's size bound
+        """
+        key = key.encode() if isinstance(key, str) else bytes(key)
+        if not self._handle:
+            return self._memory_put(key, bytes(value), ttl)
+        data = np.frombuffer(value, np.uint8)
+        return self._lib.ux_result_cache_put(self._handle, key, len(key), data.ctypes.data, data.size, ttl) == 1
+
+    def remove(self, key) -> bool:
+        """Drop ``key``; False if it was not cached."""
+        key = key.encode() if isinstance(key, str) else bytes(key)
+        if self._handle:
+            return self._lib.ux_result_cache_remove(self._handle, key, len(key)) == 1
+        with self._memory_lock:
+            entry = self._memory.pop(key, None)
+            if entry is not None:
+                self._memory_bytes -= len(key) + len(entry[1])
+            return entry is not None
+
+    def clear(self) -> None:
+        """Drop every entry."""
+        if self._handle:
+            self._lib.ux_result_cache_clear(self._handle)
+        with self._memory_lock:
+            self._memory.clear()
+            self._memory_bytes = 0
+
+    def stats(self) -> Dict[str, int]:
+        """Entry and byte counts plus hit, miss, eviction and compaction counters."""
+        if self._handle:
+            stats = ResultCacheStats()
+            self._lib.ux_result_cache_stats(self._handle, ctypes.byref(stats))
+            return {name: getattr(stats, name) for name, _ in ResultCacheStats._fields_}
+        with self._memory_lock:
+            return {'entries': len(self._memory), 'live_bytes': self._memory_bytes,
+                    'log_bytes': self._memory_bytes, 'compactions': 0, **self._counters}
+
+    def _memory_get(self, key: bytes) -> Optional[bytearray]:
+        with self._memory_lock:
+            entry = self._memory.get(key)
+            if entry is not None and entry[0] <= time.time():
+                del self._memory[key]
+                self._memory_bytes -= len(key) + len(entry[1])
+                self._counters['evictions'] += 1
+                entry = None
+            if entry is None:
+                self._counters['misses'] += 1
+                return None
+            self._memory.move_to_end(key)
+            self._counters['hits'] += 1
+            return bytearray(entry[1])
+
+    def _memory_put(self, key: bytes, value: bytes, ttl: float) -> bool:
+        size = len(key) + len(value)
+        if size > self.max_bytes // 2 or ttl <= 0:
+            return False
+        with self._memory_lock:
+            previous = self._memory.pop(key, None)
+            if previous is not None:
+                self._memory_bytes -= len(key) + len(previous[1])
+            while self._memory and self._memory_bytes + size > self.max_bytes:
+                old_key, (_, old_value) = self._memory.popitem(last=False)
+                self._memory_bytes -= len(old_key) + len(old_value)
+                self._counters['evictions'] += 1
+            self._memory[key] = (time.time() + ttl, value)
+            self._memory_bytes += size
+        return True
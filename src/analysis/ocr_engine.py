@@ -0,0 +1,243 @@
+"""
+OCR Engine for UX-MIRROR
+========================
+
+Extracts text from UI element crops with Tesseract.
+
+Crops are preprocessed in one batch by native.prepare_ocr_crops (grayscale,
+denoising, polarity, upscaling of small pixel-font text, adaptive
+binarisation and deskewing, on the native thread pool) and handed to
+Tesseract as raw buffers through its C API (libtesseract via ctypes), so no
+crop is encoded to or decoded from PNG. pytesseract, which round-trips every
+image through a temporary file, is the fallback when libtesseract cannot be
+loaded.
+"""
+
+import ctypes
+import ctypes.util
+import logging
+import threading
+from dataclasses import dataclass, field
+from typing import Any, Dict, List, Optional, Tuple
+
+import cv2
+import numpy as np
+
+from . import native
+
+logger = logging.getLogger(__name__)
+
+# Tesseract page segmentation mode 6: a single uniform block of text
+# (matches config/vision_config.json)
+DEFAULT_PSM = 6
+
+
+@dataclass
+class OCRResult:
+    """Text recognized in one region"""
+    text: str
+    confidence: float  # 0-1, Tesseract's mean word confidence
+    bbox: Optional[Tuple[int, int, int, int]] = None  # (x, y, width, height) in the frame
+    preprocessing: Dict[str, Any] = field(default_factory=dict)  # scale, inverted, skew
+
+
+class TesseractAPI:
+    """
+    Tesseract's C API through ctypes.
+
+    Images are passed as pointers to 8-bit single-channel buffers, with no
+    encoding. One TessBaseAPI instance is not reentrant, so calls are
+    serialized.
+    """
+
+    LIBRARY_NAMES = ('libtesseract.so.5', 'libtesseract.so.4', 'libtesseract.dylib', 'libtesseract-5.dll',
+                     'tesseract55.dll', 'tesseract54.dll', 'tesseract53.dll')
+
+    def __init__(self, language: str = "eng", psm: int = DEFAULT_PSM):
+        self._lib = self.load_library()
+        if self._lib is None:
+            raise RuntimeError("libtesseract not found")
+        self._handle = self._lib.TessBaseAPICreate()
+        if self._lib.TessBaseAPIInit3(self._handle, None, language.encode()) != 0:
+            self._lib.TessBaseAPIDelete(self._handle)
+            self._handle = None
+            raise RuntimeError(f"Tesseract could not load language data for '{language}'")
+        self._lib.TessBaseAPISetPageSegMode(self._handle, psm)
+        self._lock = threading.Lock()
+
+    def __del__(self):
+        if getattr(self, '_handle', None):
+            self._lib.TessBaseAPIEnd(self._handle)
+            self._lib.TessBaseAPIDelete(self._handle)
+            self._handle = None
+
+    @classmethod
+    def load_library(cls) -> Optional[ctypes.CDLL]:
+        """libtesseract with its C API declared, or None."""
+        names = [ctypes.util.find_library('tesseract')] + list(cls.LIBRARY_NAMES)
+        for name in names:
+            if not name:
+                continue
+            try:
+                lib = ctypes.CDLL(name)
+            except OSError:
+                continue
+            lib.TessBaseAPICreate.restype = ctypes.c_void_p
+            lib.TessBaseAPICreate.argtypes = []
+            lib.TessBaseAPIInit3.restype = ctypes.c_int
+            lib.TessBaseAPIInit3.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_char_p]
+            lib.TessBaseAPISetPageSegMode.restype = None
+            lib.TessBaseAPISetPageSegMode.argtypes = [ctypes.c_void_p, ctypes.c_int]
+            lib.TessBaseAPISetImage.restype = None
+            lib.TessBaseAPISetImage.argtypes = [
+                ctypes.c_void_p, ctypes.c_void_p, ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_int,
+            ]
+            lib.TessBaseAPISetSourceResolution.restype = None
+            lib.TessBaseAPISetSourceResolution.argtypes = [ctypes.c_void_p, ctypes.c_int]
+            lib.TessBaseAPIGetUTF8Text.restype = ctypes.c_void_p
+            lib.TessBaseAPIGetUTF8Text.argtypes = [ctypes.c_void_p]
+            lib.TessBaseAPIMeanTextConf.restype = ctypes.c_int
+            lib.TessBaseAPIMeanTextConf.argtypes = [ctypes.c_void_p]
+            lib.TessDeleteText.restype = None
+            lib.TessDeleteText.argtypes = [ctypes.c_void_p]
+            lib.TessBaseAPIEnd.restype = None
+            lib.TessBaseAPIEnd.argtypes = [ctypes.c_void_p]
+            lib.TessBaseAPIDelete.restype = None
+            lib.TessBaseAPIDelete.argtypes = [ctypes.c_void_p]
+            return lib
+        return None
+
+    def recognize(self, image: np.ndarray) -> Tuple[str, float]:
+        """Text and confidence (0-1) of a 2-D uint8 image."""
+        image = np.ascontiguousarray(image, dtype=np.uint8)
+        if image.size == 0:
+            return "", 0.0
+        height, width = image.shape
+        with self._lock:
+            self._lib.TessBaseAPISetImage(self._handle, image.ctypes.data, width, height, 1, image.strides[0])
+            self._lib.TessBaseAPISetSourceResolution(self._handle, 300)
+            text_ptr = self._lib.TessBaseAPIGetUTF8Text(self._handle)
+            confidence = self._lib.TessBaseAPIMeanTextConf(self._handle)
+        if not text_ptr:
+            return "", 0.0
+        try:
+            text = ctypes.string_at(text_ptr).decode('utf-8', errors='replace')
+        finally:
+            self._lib.TessDeleteText(text_ptr)
+        return text.strip(), max(confidence, 0) / 100.0
+
+
+class PytesseractBackend:
+    """Tesseract through pytesseract (writes each image to a temporary file)."""
+
+    def __init__(self, language: str = "eng", psm: int = DEFAULT_PSM):
+        import pytesseract
+        pytesseract.get_tesseract_version()  # raises TesseractNotFoundError
+        self._pytesseract = pytesseract
+        self._language = language
+        self._config = f"--oem 3 --psm {psm}"
+
+    def recognize(self, image: np.ndarray) -> Tuple[str, float]:
+        """Text and confidence (0-1) of a 2-D uint8 image."""
+        if image.size == 0:
+            return "", 0.0
+        data = self._pytesseract.image_to_data(image, lang=self._language, config=self._config,
+                                               output_type=self._pytesseract.Output.DICT)
+        words = [(word, float(conf)) for word, conf in zip(data['text'], data['conf'])
+                 if word.strip() and float(conf) >= 0]
+        if not words:
+            return "", 0.0
+        return " ".join(word for word, _ in words), sum(conf for _, conf in words) / len(words) / 100.0
+
+
+class OCREngine:
+    """
+    Batch OCR of regions of one frame.
+
+    Args:
+        language: Tesseract language code(s), e.g. 'eng' or 'eng+spa'
+        preprocessing: Binarize, upscale and deskew crops first (otherwise
+            Tesseract gets plain grayscale crops)
+        psm: Tesseract page segmentation mode
+        backend: Object with recognize(image) -> (text, confidence); by
+            default the Tesseract C API, else pytesseract
+    """
+
+    def __init__(self, language: str = "eng", preprocessing: bool = True, psm: int = DEFAULT_PSM, backend=None):
+        self.language = language
+        self.preprocessing = preprocessing
+        self.backend = backend if backend is not None else self._create_backend(language, psm)
+
+    @staticmethod
+    def _create_backend(language: str, psm: int):
+        try:
+            return TesseractAPI(language, psm)
+        except RuntimeError as e:
+            logger.debug(f"Tesseract C API unavailable ({e}); trying pytesseract")
+        try:
+            return PytesseractBackend(language, psm)
+        except Exception as e:
+            raise RuntimeError(f"Tesseract is not available: {e}") from e
+
+    def preprocess(self, image: np.ndarray, bboxes: List[Tuple[int, int, int, int]]) -> List[Dict[str, Any]]:
+        """
+        Tesseract-ready crops of many regions of one frame.
+
+        Returns:
+            Dicts with image (2-D uint8) and, when preprocessing, scale,
+            inverted and skew (see native.prepare_ocr_crops)
+        """
+        if image.ndim == 2:
+            image = cv2.cvtColor(image, cv2.COLOR_GRAY2BGR)
+        if self.preprocessing:
+            crops = native.prepare_ocr_crops(image, bboxes)
+            if crops is not None:
+                return crops
+        gray = cv2.cvtColor(image, cv2.COLOR_BGRA2GRAY if image.shape[2] == 4 else cv2.COLOR_BGR2GRAY)
+        height, width = gray.shape
+        crops = []
+        for x, y, w, h in bboxes:
+            x0, y0 = min(max(x, 0), width), min(max(y, 0), height)
+            crops.append({'image': gray[y0:min(y + h, height), x0:min(x + w, width)]})
+        return crops
+
+    def extract_text(self, image: np.ndarray,
+                     bbox: Optional[Tuple[int, int, int, int]] = None) -> OCRResult:
+        """Text of one region (the whole image if bbox is None)."""
+        if bbox is None:
+            bbox = (0, 0, image.shape[1], image.shape[0])
+        return self.extract_text_batch(image, [bbox])[0]
+
+    def extract_text_batch(self, image: np.ndarray,
+                           bboxes: List[Tuple[int, int, int, int]]) -> List[OCRResult]:
+        """
+        Text of many regions of one frame.
+
+        All crops are preprocessed in one call before any is recognized.
+        """
+        if not bboxes:
+            return []
+        results = []
+        for bbox, crop in zip(bboxes, self.preprocess(image, bboxes)):
+            text, confidence = self.backend.recognize(crop['image'])
+            details = {key: value for key, value in crop.items() if key != 'image'}
+            results.append(OCRResult(text=text, confidence=confidence, bbox=tuple(bbox), preprocessing=details))
+        return results
+
+
+_engines: Dict[Tuple[str, bool], OCREngine] = {}
+_engines_lock = threading.Lock()
+
+
+def get_ocr_engine(language: str = "eng", preprocessing: bool = True) -> OCREngine:
+    """
+    Shared OCR engine for a language (Tesseract loads its model once).
+
+    Raises:
+        RuntimeError: Tesseract is not installed
+    """
+    key = (language, preprocessing)
+    with _engines_lock:
+        if key not in _engines:
+            _engines[key] = OCREngine(language=language, preprocessing=preprocessing)
+        return _engines[key]
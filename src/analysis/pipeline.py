@@ -11,7 +11,6 @@ Version: 1.0.0
 """
 
 import asyncio
-import hashlib
 import json
 import logging
 import time
@@ -20,13 +19,14 @@ from typing import Any, Dict, List, Optional, Type, Union, Callable
 from dataclasses import dataclass, field
 from datetime import datetime, timedelta
 from pathlib import Path
-import pickle
 from concurrent.futures import ThreadPoolExecutor, ProcessPoolExecutor
 
 from core.exceptions import AnalysisError, ValidationError
 from core.error_handler import retry, RetryConfig, with_error_handling
 from core.configuration_manager import get_configuration_manager
 
+from . import result_cache
+
 logger = logging.getLogger(__name__)
 
 
@@ -81,6 +81,10 @@ class AnalysisStage(ABC):
     together to form complex analysis pipelines.
     """
     
+    # Part of the cache key: bump it when process() changes so that results
+    # cached by the previous code are not reused
+    version = 1
+    
     def __init__(self, name: str, cache_enabled: bool = True, cache_ttl: int = 3600):
         """
         Initialize analysis stage.
@@ -138,12 +142,10 @@ class AnalysisStage(ABC):
             context: Pipeline context
             
         Returns:
-            Cache key string
+            Cache key string: stage name, version and a hash of the input's
+            content (frames by their pixels)
         """
-        # Create a deterministic key from input data
-        data_str = json.dumps(context.input_data, sort_keys=True, default=str)
-        data_hash = hashlib.sha256(data_str.encode()).hexdigest()
-        return f"{self.name}:{data_hash}"
+        return f"{self.name}:v{self.version}:{result_cache.content_key(context.input_data)}"
     
     async def execute(self, context: PipelineContext) -> StageResult:
         """
@@ -201,35 +203,30 @@ class AnalysisStage(ABC):
                 execution_time=time.time() - start_time
             )
     
+    def _result_cache(self):
+        """The shared result cache (pipeline.cache.path / pipeline.cache.max_bytes)"""
+        return result_cache.get_result_cache(
+            self.config_manager.get("pipeline.cache.path", None),
+            self.config_manager.get("pipeline.cache.max_bytes", result_cache.DEFAULT_MAX_BYTES)
+        )
+    
     async def _get_cached_result(self, cache_key: str) -> Optional[Any]:
         """Get cached result if available and not expired"""
-        # TODO: Implement actual cache backend (Redis, disk, etc.)
-        # For now, using simple in-memory cache
-        cache_file = Path(f".cache/pipeline/{cache_key}.pkl")
-        
-        if cache_file.exists():
-            try:
-                # Check if cache is expired
-                cache_age = time.time() - cache_file.stat().st_mtime
-                if cache_age < self.cache_ttl:
-                    with open(cache_file, 'rb') as f:
-                        return pickle.load(f)
-            except Exception as e:
-                logger.warning(f"Failed to load cache for {cache_key}: {e}")
-        
-        return None
+        cache = self._result_cache()
+        data = cache.get(cache_key)
+        if data is None:
+            return None
+        try:
+            return result_cache.decode_result(data)
+        except Exception as e:
+            logger.warning(f"Failed to load cache for {cache_key}: {e}")
+            cache.remove(cache_key)
+            return None
     
     async def _cache_result(self, cache_key: str, data: Any):
-        """Cache the result"""
-        # TODO: Implement actual cache backend
-        cache_dir = Path(".cache/pipeline")
-        cache_dir.mkdir(parents=True, exist_ok=True)
-        
-        cache_file = cache_dir / f"{cache_key}.pkl"
-        
+        """Cache the result for cache_ttl seconds"""
         try:
-            with open(cache_file, 'wb') as f:
-                pickle.dump(data, f)
+            self._result_cache().put(cache_key, result_cache.encode_result(data), self.cache_ttl)
         except Exception as e:
             logger.warning(f"Failed to cache result for {cache_key}: {e}")
 
@@ -0,0 +1,99 @@
+"""
+Result cache shared by the analysis pipeline stages.
+
+Stage results are keyed by the content of their input - the bytes of every
+frame in it, hashed natively - together with the stage's name and version,
+and kept in the memory-mapped log of native.ResultCache. A lookup is one
+hash-table probe plus a copy out of the mapping: arrays come back as views of
+that copy, other results through pickle.
+"""
+import hashlib
+import json
+import pickle
+import threading
+from pathlib import Path
+from typing import Any, Dict, Optional
+
+import numpy as np
+
+from . import native
+
+CACHE_PATH = Path(".cache") / "pipeline" / "results.log"
+DEFAULT_MAX_BYTES = 256 << 20
+
+_ARRAY = b'A'
+_PICKLE = b'P'
+
+_caches: Dict[Path, native.ResultCache] = {}
+_caches_lock = threading.Lock()
+
+
+def get_result_cache(path: Optional[Path] = None, max_bytes: int = DEFAULT_MAX_BYTES) -> native.ResultCache:
+    """
+    The process-wide cache stored at ``path`` (default .cache/pipeline/results.log).
+
+    The log is opened once per process; ``max_bytes`` applies to that first
+    open.
+    """
+    key = Path(path or CACHE_PATH).resolve()
+    with _caches_lock:
+        cache = _caches.get(key)
+        if cache is None:
+            cache = _caches[key] = native.ResultCache(key, max_bytes)
+        return cache
+
+
+def _feed(digest, value: Any) -> None:
+    if hasattr(value, '__array_interface__') and not isinstance(value, np.ndarray):
+        value = np.asarray(value)  # PIL images
+    if isinstance(value, np.ndarray) and not value.dtype.hasobject:
+        digest.update(f"a{value.dtype.str}{value.shape}:{native.content_hash(value):016x};".encode())
+    elif isinstance(value, (bytes, bytearray, memoryview)):
+        digest.update(f"b:{native.content_hash(value):016x};".encode())
+    elif isinstance(value, dict):
+        digest.update(b"{")
+        for k, v in sorted(value.items(), key=lambda item: str(item[0])):
+            _feed(digest, k)
+            _feed(digest, v)
+        digest.update(b"}")
+    elif isinstance(value, (list, tuple)):
+        digest.update(b"[")
+        for item in value:
+            _feed(digest, item)
+        digest.update(b"]")
+    else:
+        digest.update(json.dumps(value, sort_keys=True, default=str).encode() + b";")
+
+
+def content_key(value: Any) -> str:
+    """
+    Hex digest identifying a stage input by content.
+
+    Arrays, images and byte buffers are identified by their bytes (plus dtype
+    and shape), containers by their items and anything else by its JSON form.
+    """
+    digest = hashlib.blake2b(digest_size=16)
+    _feed(digest, value)
+    return digest.hexdigest()
+
+
+def encode_result(value: Any) -> bytes:
+    """Serialize a stage result: arrays as raw bytes, anything else pickled."""
+    if isinstance(value, np.ndarray) and not value.dtype.hasobject:
+        header = json.dumps([value.dtype.str, value.shape]).encode()
+        # Pad so that the data starts 16-byte aligned
+        header += b' ' * (-(len(_ARRAY) + 4 + len(header)) % 16)
+        return b''.join((_ARRAY, len(header).to_bytes(4, 'little'), header, np.ascontiguousarray(value).data))
+    return _PICKLE + pickle.dumps(value, protocol=pickle.HIGHEST_PROTOCOL)
+
+
+def decode_result(data: bytearray) -> Any:
+    """Inverse of encode_result; arrays are writable views of ``data``."""
+    view = memoryview(data)
+    if view[:1] == _ARRAY:
+        length = int.from_bytes(view[1:5], 'little')
+        dtype, shape = json.loads(bytes(view[5:5 + length]))
+        return np.frombuffer(data, np.dtype(dtype), offset=5 + length).reshape(shape)
+    if view[:1] == _PICKLE:
+        return pickle.loads(view[1:])
+    raise ValueError("not an encoded stage result")
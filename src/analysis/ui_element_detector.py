@@ -15,6 +15,8 @@ from typing import List, Dict, Any, Tuple, Optional
 from dataclasses import dataclass
 from enum import Enum
 
+from . import native
+
 # Make PyTorch import optional for GPU acceleration
 try:
     import torch
@@ -65,7 +67,8 @@ class UIElementDetector:
                  use_gpu: bool = False,  # v0.1.0: GPU disabled by default 
                  confidence_threshold: float = 0.3,
                  enable_ocr: bool = True,
-                 ocr_language: str = "eng"):
+                 ocr_language: str = "eng",
+                 use_native: bool = True):
         """
         Initialize the UI Element Detector
         
@@ -74,8 +77,16 @@ class UIElementDetector:
             confidence_threshold: Minimum confidence score for detections
             enable_ocr: Enable OCR for text extraction from detected elements
             ocr_language: Language code for OCR (e.g., 'eng', 'eng+spa')
+            use_native: Find buttons, input fields and containers with the
+                native colour-region detector, and text lines with the native
+                text proposer, when the library is built
         """
         self.confidence_threshold = confidence_threshold
+        self.use_native = use_native
+        # Both keep state across frames: the proposer re-searches only
+        # changed tiles; the MSER object is the fallback's
+        self._text_proposer = native.TextProposer() if use_native else None
+        self._mser = None
         # v0.1.0: GPU disabled for MVP
         self.use_gpu = False  # Disable GPU for v0.1.0 MVP
         self.enable_ocr = enable_ocr
@@ -159,18 +170,19 @@ class UIElementDetector:
             # Convert to grayscale for processing
             gray = cv2.cvtColor(image, cv2.COLOR_BGR2GRAY)
             
-            # Detect button-like elements
-            elements.extend(self._detect_buttons(image, gray))
+            # Buttons, input fields and containers: one native labelling
+            # pass when available, otherwise edge/contour detection
+            regions = native.detect_regions(image) if self.use_native else None
+            if regions is not None:
+                elements.extend(self._elements_from_regions(regions))
+            else:
+                elements.extend(self._detect_buttons(image, gray))
+                elements.extend(self._detect_input_fields(image, gray))
+                elements.extend(self._detect_containers(image, gray))
             
             # Detect text regions
             elements.extend(self._detect_text_regions(image, gray))
             
-            # Detect input fields
-            elements.extend(self._detect_input_fields(image, gray))
-            
-            # Detect containers/panels
-            elements.extend(self._detect_containers(image, gray))
-            
             # Detect clickable elements
             elements.extend(self._detect_clickable_elements(image, gray))
             
@@ -192,6 +204,7 @@ class UIElementDetector:
         edges = cv2.Canny(gray, 50, 150)
         contours, _ = cv2.findContours(edges, cv2.RETR_EXTERNAL, cv2.CHAIN_APPROX_SIMPLE)
         
+        candidates = []
         for contour in contours:
             x, y, w, h = cv2.boundingRect(contour)
             area = cv2.contourArea(contour)
@@ -202,19 +215,53 @@ class UIElementDetector:
                 
                 # Buttons typically have specific aspect ratios
                 if 1.2 <= aspect_ratio <= 8.0:
-                    # Check if region has button-like characteristics
-                    roi = image[y:y+h, x:x+w]
-                    if self._is_button_like(roi):
-                        confidence = min(1.0, area / (w * h))
-                        
-                        elements.append(UIElement(
-                            element_type=UIElementType.BUTTON,
-                            bbox=(x, y, w, h),
-                            confidence=confidence,
-                            color_analysis=self._analyze_colors(roi),
-                            accessibility_score=self._assess_accessibility(roi),
-                            is_interactive=True
-                        ))
+                    candidates.append(((x, y, w, h), area))
+        
+        analyses = self._analyze_colors_batch(image, [bbox for bbox, _ in candidates])
+        for (bbox, area), color_analysis in zip(candidates, analyses):
+            # Buttons often have low color variation (see _is_button_like)
+            if color_analysis["contrast_ratio"] * 255.0 < 30:
+                x, y, w, h = bbox
+                elements.append(UIElement(
+                    element_type=UIElementType.BUTTON,
+                    bbox=bbox,
+                    confidence=min(1.0, area / (w * h)),
+                    color_analysis=color_analysis,
+                    accessibility_score=self._accessibility_score(color_analysis, w, h),
+                    is_interactive=True
+                ))
+        
+        return elements
+    
+    def _elements_from_regions(self, regions: List[Dict[str, Any]]) -> List[UIElement]:
+        """UI elements from native.detect_regions candidates"""
+        elements = []
+        
+        for region in regions:
+            x, y, w, h = region['bbox']
+            color_analysis = {
+                "dominant_color": [int(c) for c in region['mean_color']],
+                "contrast_ratio": region['contrast'] / 255.0,
+                "brightness": region['brightness'] / 255.0
+            }
+            if region['type'] == 'button':
+                element_type = UIElementType.BUTTON
+                accessibility = self._accessibility_score(color_analysis, w, h)
+            elif region['type'] == 'input':
+                element_type = UIElementType.INPUT
+                accessibility = self._input_accessibility_score(color_analysis, h)
+            else:
+                element_type = UIElementType.CONTAINER
+                accessibility = 0.5
+            
+            elements.append(UIElement(
+                element_type=element_type,
+                bbox=(x, y, w, h),
+                confidence=region['confidence'],
+                color_analysis=color_analysis,
+                accessibility_score=accessibility,
+                is_interactive=element_type != UIElementType.CONTAINER
+            ))
         
         return elements
     
@@ -222,10 +269,29 @@ class UIElementDetector:
         """Detect text regions using MSER and morphological operations"""
         elements = []
         
+        # Native text lines: MSER glyphs filtered and chained into lines,
+        # searching only the tiles that changed since the previous frame
+        lines = self._text_proposer.propose(image) if self._text_proposer is not None else None
+        if lines is not None:
+            bboxes = [line['bbox'] for line in lines]
+            for line, color_analysis in zip(lines, self._analyze_colors_batch(image, bboxes)):
+                x, y, w, h = line['bbox']
+                elements.append(UIElement(
+                    element_type=UIElementType.TEXT,
+                    bbox=line['bbox'],
+                    confidence=line['confidence'],
+                    color_analysis=color_analysis,
+                    accessibility_score=self._assess_text_accessibility(gray[y:y+h, x:x+w]),
+                    is_interactive=False
+                ))
+            return elements
+        
         # Use MSER for text detection
-        mser = cv2.MSER_create()
-        regions, _ = mser.detectRegions(gray)
+        if self._mser is None:
+            self._mser = cv2.MSER_create()
+        regions, _ = self._mser.detectRegions(gray)
         
+        candidates = []
         for region in regions:
             # Get bounding rectangle
             x, y, w, h = cv2.boundingRect(region)
@@ -235,16 +301,19 @@ class UIElementDetector:
                 # Check text-like characteristics
                 roi = gray[y:y+h, x:x+w]
                 if self._is_text_like(roi):
-                    confidence = 0.7  # Base confidence for text regions
-                    
-                    elements.append(UIElement(
-                        element_type=UIElementType.TEXT,
-                        bbox=(x, y, w, h),
-                        confidence=confidence,
-                        color_analysis=self._analyze_colors(image[y:y+h, x:x+w]),
-                        accessibility_score=self._assess_text_accessibility(roi),
-                        is_interactive=False
-                    ))
+                    candidates.append(((x, y, w, h), roi))
+        
+        # MSER regions overlap heavily; analyze them all in one call
+        analyses = self._analyze_colors_batch(image, [bbox for bbox, _ in candidates])
+        for (bbox, roi), color_analysis in zip(candidates, analyses):
+            elements.append(UIElement(
+                element_type=UIElementType.TEXT,
+                bbox=bbox,
+                confidence=0.7,  # Base confidence for text regions
+                color_analysis=color_analysis,
+                accessibility_score=self._assess_text_accessibility(roi),
+                is_interactive=False
+            ))
         
         return elements
     
@@ -256,25 +325,25 @@ class UIElementDetector:
         edges = cv2.Canny(gray, 30, 100)
         contours, _ = cv2.findContours(edges, cv2.RETR_EXTERNAL, cv2.CHAIN_APPROX_SIMPLE)
         
+        candidates = []
         for contour in contours:
             x, y, w, h = cv2.boundingRect(contour)
             
             # Input fields are typically wider than they are tall
             if w > 50 and h > 15 and w/h > 2.0 and w < 400 and h < 60:
-                roi = image[y:y+h, x:x+w]
-                
                 # Check if it looks like an input field
-                if self._is_input_field_like(roi):
-                    confidence = 0.6
-                    
-                    elements.append(UIElement(
-                        element_type=UIElementType.INPUT,
-                        bbox=(x, y, w, h),
-                        confidence=confidence,
-                        color_analysis=self._analyze_colors(roi),
-                        accessibility_score=self._assess_input_accessibility(roi),
-                        is_interactive=True
-                    ))
+                if self._is_input_field_like(image[y:y+h, x:x+w]):
+                    candidates.append((x, y, w, h))
+        
+        for bbox, color_analysis in zip(candidates, self._analyze_colors_batch(image, candidates)):
+            elements.append(UIElement(
+                element_type=UIElementType.INPUT,
+                bbox=bbox,
+                confidence=0.6,
+                color_analysis=color_analysis,
+                accessibility_score=self._input_accessibility_score(color_analysis, bbox[3]),
+                is_interactive=True
+            ))
         
         return elements
     
@@ -286,23 +355,25 @@ class UIElementDetector:
         edges = cv2.Canny(gray, 20, 60)
         contours, _ = cv2.findContours(edges, cv2.RETR_EXTERNAL, cv2.CHAIN_APPROX_SIMPLE)
         
+        candidates = []
         for contour in contours:
             x, y, w, h = cv2.boundingRect(contour)
             area = cv2.contourArea(contour)
             
             # Containers are typically large
             if w > 100 and h > 100 and area > 10000:
-                roi = image[y:y+h, x:x+w]
-                confidence = min(0.8, area / (image.shape[0] * image.shape[1]))
-                
-                elements.append(UIElement(
-                    element_type=UIElementType.CONTAINER,
-                    bbox=(x, y, w, h),
-                    confidence=confidence,
-                    color_analysis=self._analyze_colors(roi),
-                    accessibility_score=0.5,
-                    is_interactive=False
-                ))
+                candidates.append(((x, y, w, h), min(0.8, area / (image.shape[0] * image.shape[1]))))
+        
+        analyses = self._analyze_colors_batch(image, [bbox for bbox, _ in candidates])
+        for (bbox, confidence), color_analysis in zip(candidates, analyses):
+            elements.append(UIElement(
+                element_type=UIElementType.CONTAINER,
+                bbox=bbox,
+                confidence=confidence,
+                color_analysis=color_analysis,
+                accessibility_score=0.5,
+                is_interactive=False
+            ))
         
         return elements
     
@@ -385,6 +456,41 @@ class UIElementDetector:
         if roi.size == 0:
             return {"dominant_color": [0, 0, 0], "contrast_ratio": 0.0}
         
+        h, w = roi.shape[:2]
+        return self._analyze_colors_batch(roi, [(0, 0, w, h)])[0]
+    
+    def _analyze_colors_batch(self, image: np.ndarray, bboxes: List[Tuple[int, int, int, int]]) -> List[Dict[str, Any]]:
+        """
+        Analyze color properties of many regions of one image in a single call
+        
+        Besides the mean ("dominant") color, brightness and contrast, each
+        analysis estimates the background (the region's border) and foreground
+        colors and the share of the region the foreground covers.
+        """
+        if not bboxes:
+            return []
+        
+        profiles = native.colour_profiles(image, bboxes)
+        if profiles is None:
+            return [self._analyze_colors_roi(image[y:y+h, x:x+w]) for x, y, w, h in bboxes]
+        
+        mean_colors = profiles['mean_color'].astype(int).tolist()
+        foreground = profiles['foreground_color'].astype(int).tolist()
+        background = profiles['background_color'].astype(int).tolist()
+        return [{
+            "dominant_color": mean_colors[i],
+            "contrast_ratio": float(profiles['contrast'][i]) / 255.0,
+            "brightness": float(profiles['brightness'][i]) / 255.0,
+            "foreground_color": foreground[i],
+            "background_color": background[i],
+            "foreground_share": float(profiles['foreground_share'][i])
+        } for i in range(len(bboxes))]
+    
+    def _analyze_colors_roi(self, roi: np.ndarray) -> Dict[str, Any]:
+        """Mean color, contrast and brightness of one region (inputs colour_profiles rejects)"""
+        if roi.size == 0:
+            return {"dominant_color": [0, 0, 0], "contrast_ratio": 0.0}
+        
         # Calculate dominant color
         roi_reshaped = roi.reshape(-1, 3)
         dominant_color = np.mean(roi_reshaped, axis=0).astype(int).tolist()
@@ -404,11 +510,14 @@ class UIElementDetector:
         if roi.size == 0:
             return 0.0
         
-        color_analysis = self._analyze_colors(roi)
+        h, w = roi.shape[:2]
+        return self._accessibility_score(self._analyze_colors(roi), w, h)
+    
+    def _accessibility_score(self, color_analysis: Dict[str, Any], w: int, h: int) -> float:
+        """Accessibility score from a region's color analysis and size"""
         contrast = color_analysis["contrast_ratio"]
         
         # Base accessibility on contrast and size
-        h, w = roi.shape[:2]
         size_score = min(1.0, (w * h) / (44 * 44))  # 44px is minimum touch target
         contrast_score = min(1.0, contrast * 3.0)  # Scale contrast
         
@@ -430,11 +539,13 @@ class UIElementDetector:
         if roi.size == 0:
             return 0.0
         
+        return self._input_accessibility_score(self._analyze_colors(roi), roi.shape[0])
+    
+    def _input_accessibility_score(self, color_analysis: Dict[str, Any], h: int) -> float:
+        """Input field accessibility score from its color analysis and height"""
         # Input fields need good contrast and sufficient size
-        color_analysis = self._analyze_colors(roi)
         contrast = color_analysis["contrast_ratio"]
         
-        h, w = roi.shape[:2]
         size_score = min(1.0, h / 30.0)  # Minimum height for input fields
         contrast_score = min(1.0, contrast * 2.0)
         
@@ -446,6 +557,12 @@ class UIElementDetector:
         filtered = [elem for elem in elements if elem.confidence >= self.confidence_threshold]
         
         # Remove overlapping elements (keep higher confidence)
+        keep = None
+        if self.use_native and len(filtered) > 1:
+            keep = native.nms([elem.bbox for elem in filtered], [elem.confidence for elem in filtered], 0.5)
+        if keep is not None:
+            return [filtered[i] for i in keep]
+        
         deduplicated = []
         for elem in sorted(filtered, key=lambda x: x.confidence, reverse=True):
             is_duplicate = False
@@ -480,6 +597,12 @@ class UIElementDetector:
         """Enhance detected elements with additional analysis"""
         enhanced = []
         
+        # Analyze the elements that still lack color analysis in one call
+        # (clickable-corner candidates come in the hundreds)
+        pending = [elem for elem in elements if elem.color_analysis is None or elem.accessibility_score == 0.0]
+        analyses = self._analyze_colors_batch(image, [elem.bbox for elem in pending])
+        analysis_of = {id(elem): analysis for elem, analysis in zip(pending, analyses)}
+        
         for elem in elements:
             # Extract region of interest
             x, y, w, h = elem.bbox
@@ -487,11 +610,12 @@ class UIElementDetector:
             
             # Update color analysis if not present
             if elem.color_analysis is None:
-                elem.color_analysis = self._analyze_colors(roi)
+                elem.color_analysis = analysis_of[id(elem)]
             
             # Update accessibility score if not set
             if elem.accessibility_score == 0.0:
-                elem.accessibility_score = self._assess_accessibility(roi)
+                elem.accessibility_score = (self._accessibility_score(analysis_of[id(elem)], roi.shape[1], roi.shape[0])
+                                            if roi.size else 0.0)
             
             enhanced.append(elem)
         
@@ -511,31 +635,27 @@ class UIElementDetector:
         if not self.ocr_engine:
             return elements
         
-        enhanced = []
+        # Only extract text from elements that might contain text, and are
+        # large enough for OCR
+        candidates = [elem for elem in elements
+                      if elem.element_type in [UIElementType.TEXT, UIElementType.BUTTON,
+                                               UIElementType.INPUT, UIElementType.LINK]
+                      and elem.bbox[2] > 10 and elem.bbox[3] > 8]
         
-        for elem in elements:
-            # Only extract text from elements that might contain text
-            if elem.element_type in [UIElementType.TEXT, UIElementType.BUTTON, 
-                                     UIElementType.INPUT, UIElementType.LINK]:
-                try:
-                    # Extract region
-                    x, y, w, h = elem.bbox
-                    
-                    # Ensure region is valid
-                    if w > 10 and h > 8:  # Minimum size for OCR
-                        # Extract text using OCR
-                        ocr_result = self.ocr_engine.extract_text(image, elem.bbox)
-                        
-                        if ocr_result.text and ocr_result.confidence >= 0.5:
-                            elem.text_content = ocr_result.text
-                            elem.text_confidence = ocr_result.confidence
-                            logger.debug(f"Extracted text from {elem.element_type.value}: '{ocr_result.text[:50]}'")
-                except Exception as e:
-                    logger.warning(f"OCR failed for {elem.element_type.value} element: {e}")
-            
-            enhanced.append(elem)
+        # All crops are preprocessed in one batch, then recognized
+        try:
+            results = self.ocr_engine.extract_text_batch(image, [elem.bbox for elem in candidates])
+        except Exception as e:
+            logger.warning(f"OCR failed for {len(candidates)} elements: {e}")
+            return elements
         
-        return enhanced
+        for elem, ocr_result in zip(candidates, results):
+            if ocr_result.text and ocr_result.confidence >= 0.5:
+                elem.text_content = ocr_result.text
+                elem.text_confidence = ocr_result.confidence
+                logger.debug(f"Extracted text from {elem.element_type.value}: '{ocr_result.text[:50]}'")
+        
+        return elements
     
     def _init_detection_model(self):
         """Initialize the GPU detection model"""
@@ -579,7 +699,7 @@ class UIElementDetector:
         # Initialize any OpenCV-specific detectors here
         pass
     
-    def _process_gpu_predictions(self, predictions: torch.Tensor, image: np.ndarray) -> List[UIElement]:
+    def _process_gpu_predictions(self, predictions: "torch.Tensor", image: np.ndarray) -> List[UIElement]:
         """Process GPU model predictions into UI elements"""
         # This is a simplified version - in practice you'd have a proper object detection model
         # For now, we'll combine GPU classification with OpenCV detection
@@ -5,25 +5,59 @@ This module handles image comparison, change detection, and visual quality asses
 """
 import cv2
 import numpy as np
+from concurrent.futures import ThreadPoolExecutor
 from pathlib import Path
-from typing import Dict, Any, Tuple, Optional
+from typing import Dict, Any, Tuple, Optional, List, Sequence, Union
 from datetime import datetime
 import logging
 
+from . import native
+
 logger = logging.getLogger(__name__)
 
+# A frame given as an image, a file path, or an id in the analyzer's frame store
+FrameRef = Union[np.ndarray, Path, str]
+
 
 class VisualAnalyzer:
     """Handles visual analysis of screenshots."""
     
-    def __init__(self, ui_change_threshold: float = 0.05):
+    # Luma of the per-channel difference a pixel must exceed to show as changed
+    DIFF_PIXEL_THRESHOLD = 10
+    # Tile edge length used to group changed pixels into regions
+    DIFF_TILE_SIZE = 32
+    
+    def __init__(self, ui_change_threshold: float = 0.05, use_native: bool = True, frame_store=None):
         """
         Initialize visual analyzer.
         
         Args:
             ui_change_threshold: Threshold for detecting UI changes (0.0-1.0)
+            use_native: Use the native comparison kernels when they are built
+            frame_store: Store that resolves string frame ids through
+                load_screenshot(id), e.g. a ScreenshotHandler
         """
         self.ui_change_threshold = ui_change_threshold
+        self.use_native = use_native
+        self.frame_store = frame_store
+    
+    def change_statistics(self, before_img: np.ndarray, after_img: np.ndarray,
+                          pixel_threshold: int = 0, tile_size: int = 64) -> Optional[Dict[str, Any]]:
+        """
+        Changed-pixel ratio, luma MSE and per-tile change grid in one native pass.
+        
+        Args:
+            before_img: Before screenshot (BGR or BGRA)
+            after_img: After screenshot with the same shape
+            pixel_threshold: Luma difference a pixel must exceed to count as changed
+            tile_size: Edge length of the change grid tiles in pixels
+            
+        Returns:
+            Statistics from native.diff_frames, or None if the kernels are unavailable
+        """
+        if not self.use_native:
+            return None
+        return native.diff_frames(before_img, after_img, threshold=pixel_threshold, tile_size=tile_size)
     
     def detect_ui_changes(self, before_img: np.ndarray, after_img: np.ndarray) -> float:
         """
@@ -43,6 +77,12 @@ class VisualAnalyzer:
                 before_img = cv2.resize(before_img, (width, height))
                 after_img = cv2.resize(after_img, (width, height))
             
+            # One fused pass when the native kernels are built
+            stats = self.change_statistics(before_img, after_img)
+            if stats is not None:
+                logger.debug(f"UI change detection: {stats['change_ratio']:.3f} (native)")
+                return stats['change_ratio']
+            
             # Convert to grayscale for comparison
             before_gray = cv2.cvtColor(before_img, cv2.COLOR_BGR2GRAY)
             after_gray = cv2.cvtColor(after_img, cv2.COLOR_BGR2GRAY)
@@ -61,6 +101,26 @@ class VisualAnalyzer:
             logger.error(f"Error detecting UI changes: {e}")
             return 0.0
     
+    def detect_ui_changes_batch(self, pairs: Sequence[Tuple[np.ndarray, np.ndarray]],
+                                max_workers: Optional[int] = None) -> List[float]:
+        """
+        Change scores for many before/after pairs.
+        
+        The native kernels run without the GIL, so pairs are compared on a
+        thread pool in parallel.
+        
+        Args:
+            pairs: (before_img, after_img) tuples
+            max_workers: Thread count (default: ThreadPoolExecutor's)
+            
+        Returns:
+            One change score per pair, in order
+        """
+        if len(pairs) < 2 or not (self.use_native and native.available()):
+            return [self.detect_ui_changes(before, after) for before, after in pairs]
+        with ThreadPoolExecutor(max_workers=max_workers) as pool:
+            return list(pool.map(lambda pair: self.detect_ui_changes(*pair), pairs))
+    
     def calculate_response_time(self, before_path: Path, after_path: Path) -> float:
         """
         Calculate response time between before and after screenshots.
@@ -106,12 +166,27 @@ class VisualAnalyzer:
             'brightness': 0.0,
             'contrast': 0.0,
             'color_diversity': 0.0,
+            'colorfulness': 0.0,
             'is_blurry': False,
             'is_too_dark': False,
             'is_too_bright': False
         }
         
         try:
+            # One multithreaded pass over the frame when the native kernels are built
+            stats = native.image_stats(img) if self.use_native else None
+            if stats is not None:
+                quality_metrics['blur_score'] = stats['laplacian_var']
+                quality_metrics['is_blurry'] = stats['laplacian_var'] < 100.0
+                quality_metrics['brightness'] = stats['brightness']
+                quality_metrics['is_too_dark'] = stats['brightness'] < 50
+                quality_metrics['is_too_bright'] = stats['brightness'] > 200
+                quality_metrics['contrast'] = stats['contrast']
+                quality_metrics['color_diversity'] = float(np.count_nonzero(stats['color_histogram']) / 512)
+                quality_metrics['colorfulness'] = stats['colorfulness']
+                logger.debug(f"Visual quality metrics calculated: {quality_metrics} (native)")
+                return quality_metrics
+            
             # Convert to grayscale for analysis
             gray = cv2.cvtColor(img, cv2.COLOR_BGR2GRAY)
             
@@ -135,6 +210,12 @@ class VisualAnalyzer:
             color_diversity = np.count_nonzero(hist) / hist.size
             quality_metrics['color_diversity'] = float(color_diversity)
             
+            # 5. Colorfulness (Hasler-Suesstrunk opponent-channel statistics)
+            b, g, r = (img[:, :, c].astype(np.int32) for c in range(3))
+            rg, yb = r - g, (r + g) / 2 - b
+            quality_metrics['colorfulness'] = float(np.sqrt(rg.var() + yb.var()) +
+                                                    0.3 * np.sqrt(rg.mean() ** 2 + yb.mean() ** 2))
+            
             logger.debug(f"Visual quality metrics calculated: {quality_metrics}")
             
         except Exception as e:
@@ -295,49 +376,132 @@ class VisualAnalyzer:
         
         return analysis
     
-    def create_diff_image(self, before_path: Path, after_path: Path, output_path: Optional[Path] = None) -> Optional[Path]:
+    def _load_frame(self, frame: FrameRef) -> Optional[np.ndarray]:
+        """Image for an in-memory frame, a frame-store id or a file path."""
+        if isinstance(frame, np.ndarray):
+            return frame
+        if isinstance(frame, str) and self.frame_store is not None:
+            return self.frame_store.load_screenshot(frame)
+        return cv2.imread(str(frame))
+    
+    def diff_overlay(self, before: FrameRef, after: FrameRef) -> Optional[Dict[str, Any]]:
+        """
+        Colourised diff overlay and changed regions of two frames.
+        
+        The overlay is the after frame at half brightness with changed pixels
+        tinted red. With the native kernels, overlay, change count and regions
+        come out of one pass over the frames.
+        
+        Args:
+            before: Before frame (image, path, or frame-store id)
+            after: After frame (image, path, or frame-store id)
+            
+        Returns:
+            Dict with overlay (BGR image), regions ((x, y, w, h) boxes) and
+            change_ratio, or None if a frame could not be loaded
+        """
+        before_img = self._load_frame(before)
+        after_img = self._load_frame(after)
+        if before_img is None or after_img is None:
+            return None
+        
+        # Ensure same size
+        if before_img.shape[:2] != after_img.shape[:2]:
+            height, width = min(before_img.shape[0], after_img.shape[0]), min(before_img.shape[1], after_img.shape[1])
+            before_img = cv2.resize(before_img, (width, height))
+            after_img = cv2.resize(after_img, (width, height))
+        
+        if self.use_native:
+            stats = native.diff_colour(before_img, after_img, threshold=self.DIFF_PIXEL_THRESHOLD,
+                                       tile_size=self.DIFF_TILE_SIZE, overlay=True)
+            if stats is not None:
+                return {'overlay': stats['overlay'], 'regions': stats['boxes'],
+                        'change_ratio': stats['change_ratio']}
+        
+        # OpenCV path: same overlay and regions in several passes
+        after_bgr = after_img[:, :, :3]
+        diff = cv2.absdiff(before_img[:, :, :3], after_bgr)
+        changed = cv2.cvtColor(diff, cv2.COLOR_BGR2GRAY) > self.DIFF_PIXEL_THRESHOLD
+        overlay = after_bgr >> 1
+        overlay[changed, 2] += 128
+        return {'overlay': overlay, 'regions': native.mask_boxes(changed, self.DIFF_TILE_SIZE),
+                'change_ratio': np.count_nonzero(changed) / changed.size}
+    
+    def diff_overlay_batch(self, pairs: Sequence[Tuple[FrameRef, FrameRef]],
+                           max_workers: Optional[int] = None) -> List[Optional[Dict[str, Any]]]:
+        """
+        diff_overlay for many pairs, in parallel on a thread pool.
+        
+        Args:
+            pairs: (before, after) frame tuples
+            max_workers: Thread count (default: ThreadPoolExecutor's)
+            
+        Returns:
+            One diff_overlay result per pair, in order
+        """
+        if len(pairs) < 2:
+            return [self.diff_overlay(before, after) for before, after in pairs]
+        with ThreadPoolExecutor(max_workers=max_workers) as pool:
+            return list(pool.map(lambda pair: self.diff_overlay(*pair), pairs))
+    
+    def create_diff_image(self, before_path: FrameRef, after_path: FrameRef,
+                          output_path: Optional[Path] = None) -> Optional[Path]:
         """
         Create a difference image highlighting changes between screenshots.
         
         Args:
-            before_path: Path to before screenshot
-            after_path: Path to after screenshot
+            before_path: Before screenshot (path, image, or frame-store id)
+            after_path: After screenshot (path, image, or frame-store id)
             output_path: Optional output path for difference image
             
         Returns:
             Path to difference image or None if failed
         """
         try:
-            # Load images
-            before_img = cv2.imread(str(before_path))
-            after_img = cv2.imread(str(after_path))
-            
-            if before_img is None or after_img is None:
+            result = self.diff_overlay(before_path, after_path)
+            if result is None:
                 return None
             
-            # Ensure same size
-            if before_img.shape != after_img.shape:
-                height, width = min(before_img.shape[0], after_img.shape[0]), min(before_img.shape[1], after_img.shape[1])
-                before_img = cv2.resize(before_img, (width, height))
-                after_img = cv2.resize(after_img, (width, height))
-            
-            # Create difference image
-            diff = cv2.absdiff(before_img, after_img)
-            
-            # Enhance differences for visibility
-            diff_enhanced = cv2.convertScaleAbs(diff, alpha=3.0, beta=0)
-            
             # Set output path if not provided
             if output_path is None:
                 timestamp = datetime.now().strftime("%Y%m%d_%H%M%S")
-                output_path = before_path.parent / f"{timestamp}_diff.png"
+                output_path = self._diff_output_dir(before_path) / f"{timestamp}_diff.png"
             
             # Save difference image
-            cv2.imwrite(str(output_path), diff_enhanced)
+            cv2.imwrite(str(output_path), result['overlay'])
             
-            logger.info(f"Difference image created: {output_path}")
+            logger.info(f"Difference image created: {output_path} ({len(result['regions'])} changed regions)")
             return output_path
             
         except Exception as e:
             logger.error(f"Error creating difference image: {e}")
-            return None 
\ No newline at end of file
+            return None
+    
+    def create_diff_images(self, pairs: Sequence[Tuple[FrameRef, FrameRef]], output_dir: Optional[Path] = None,
+                           max_workers: Optional[int] = None) -> List[Optional[Path]]:
+        """
+        create_diff_image for many pairs, in parallel on a thread pool.
+        
+        Args:
+            pairs: (before, after) frame tuples
+            output_dir: Directory for the images (default: next to each before frame)
+            max_workers: Thread count (default: ThreadPoolExecutor's)
+            
+        Returns:
+            One image path (or None) per pair, in order
+        """
+        timestamp = datetime.now().strftime("%Y%m%d_%H%M%S")
+        
+        def create(index: int) -> Optional[Path]:
+            before, after = pairs[index]
+            directory = Path(output_dir) if output_dir is not None else self._diff_output_dir(before)
+            return self.create_diff_image(before, after, directory / f"{timestamp}_{index:03d}_diff.png")
+        
+        with ThreadPoolExecutor(max_workers=max_workers) as pool:
+            return list(pool.map(create, range(len(pairs))))
+    
+    def _diff_output_dir(self, before: FrameRef) -> Path:
+        """Directory for a diff image: next to the before file, else the frame store's."""
+        if isinstance(before, Path) or (isinstance(before, str) and self.frame_store is None):
+            return Path(before).parent
+        return Path(getattr(self.frame_store, 'storage_dir', '.'))
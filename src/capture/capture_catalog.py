@@ -0,0 +1,561 @@
+"""
+Catalog of the screenshots stored in a capture directory (native/capture_catalog.h).
+
+Each image gets one fixed-size record - timestamp, label, dimensions,
+content and perceptual hashes, file size and the offset of its name - in an
+append-only log next to the images (catalog.idx); names and optional JSON
+metadata go to a second log (catalog.dat). Records are appended in time
+order, so the latest capture with a label, the latest before/after pair and
+retention pruning are binary searches and forward walks over the index
+instead of directory listings and JSON parsing.
+
+With the native library the logs are memory-mapped; without it the same
+format is read and appended from Python.
+"""
+import bisect
+import ctypes
+import io
+import json
+import os
+import struct
+import threading
+import time
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Any, Dict, List, Optional, Tuple
+import logging
+
+import cv2
+
+from src.analysis import native
+
+logger = logging.getLogger(__name__)
+
+CATALOG_NAME = "catalog"
+# Longest gap, in seconds, between a 'before' capture and the 'after' it pairs with
+PAIR_WINDOW = 10.0
+
+REMOVED = 1
+PERCEPTUAL = 2
+LABEL_BYTES = 31
+
+_INDEX_MAGIC = 0x49435855   # "UXCI"
+_DATA_MAGIC = 0x44435855    # "UXCD"
+_RECORD_MAGIC = 0x52435855  # "UXCR"
+_VERSION = 1
+_HEADER_BYTES = 64
+_RECORD_BYTES = ctypes.sizeof(native.CatalogRecord)
+_INDEX_HEADER = struct.Struct('<IIQQQ32x')   # magic, version, count, data end, generation
+_DATA_HEADER = struct.Struct('<IIQ48x')      # magic, version, generation
+
+assert _RECORD_BYTES == 128
+
+
+@dataclass
+class Capture:
+    """One catalogued image."""
+    name: str
+    label: str
+    timestamp: float                # seconds since the epoch
+    width: int
+    height: int
+    channels: int = 3
+    file_bytes: int = 0
+    content_hash: int = 0
+    phash: Optional[int] = None
+    dhash: Optional[int] = None
+    extra: Dict[str, Any] = field(default_factory=dict)
+
+
+class _NativeLog:
+    """The catalog logs memory-mapped by the native library."""
+
+    def __init__(self, lib: ctypes.CDLL, handle: int):
+        self._lib = lib
+        self._handle = handle
+
+    def close(self) -> None:
+        if self._handle:
+            self._lib.ux_catalog_close(self._handle)
+            self._handle = None
+
+    def append(self, record: native.CatalogRecord, name: bytes, extra: bytes) -> int:
+        return self._lib.ux_catalog_append(self._handle, ctypes.byref(record), name, len(name), extra, len(extra))
+
+    def find(self, name: bytes) -> int:
+        return self._lib.ux_catalog_find(self._handle, name, len(name))
+
+    def read(self, i: int) -> Tuple[native.CatalogRecord, bytes, bytes]:
+        record = native.CatalogRecord()
+        name = ctypes.create_string_buffer(256)
+        extra = ctypes.create_string_buffer(1024)
+        self._lib.ux_catalog_read(self._handle, i, ctypes.byref(record), name, len(name), extra, len(extra))
+        if record.name_length > len(name) or record.extra_length > len(extra):
+            name = ctypes.create_string_buffer(max(record.name_length, 1))
+            extra = ctypes.create_string_buffer(max(record.extra_length, 1))
+            self._lib.ux_catalog_read(self._handle, i, ctypes.byref(record), name, len(name), extra, len(extra))
+        return record, name.raw[:record.name_length], extra.raw[:record.extra_length]
+
+    def set_extra(self, i: int, extra: bytes) -> bool:
+        return self._lib.ux_catalog_set_extra(self._handle, i, extra, len(extra)) == 0
+
+    def remove(self, i: int) -> bool:
+        return self._lib.ux_catalog_remove(self._handle, i) == 1
+
+    def latest(self, label: Optional[bytes], before_ns: int) -> int:
+        return self._lib.ux_catalog_latest(self._handle, label, before_ns)
+
+    def count(self, label: Optional[bytes]) -> int:
+        return self._lib.ux_catalog_count(self._handle, label)
+
+    def prune(self, keep: int) -> List[int]:
+        capacity = max(self.count(None) - keep, 0)
+        removed = (ctypes.c_int64 * max(capacity, 1))()
+        n = self._lib.ux_catalog_prune(self._handle, keep, removed, capacity)
+        return list(removed[:n])
+
+    def list(self, label: Optional[bytes], newest_first: bool) -> List[int]:
+        capacity = 256
+        while True:
+            out = (ctypes.c_int64 * capacity)()
+            n = self._lib.ux_catalog_list(self._handle, label, 1 if newest_first else 0, out, capacity)
+            if n <= capacity:
+                return list(out[:n])
+            capacity = n
+
+
+def _read_header(path: Path, header: struct.Struct) -> Optional[tuple]:
+    try:
+        with io.FileIO(path, 'r') as f:
+            raw = f.read(_HEADER_BYTES)
+    except OSError:
+        return None
+    return header.unpack(raw) if len(raw) == _HEADER_BYTES else None
+
+
+def _open_rw(path: Path) -> io.FileIO:
+    return io.FileIO(os.open(path, os.O_RDWR | os.O_CREAT | getattr(os, 'O_BINARY', 0), 0o644), 'r+')
+
+
+def _open_locked(path: Path) -> Optional[io.FileIO]:
+    """
+    Open a log holding the exclusive, non-blocking lock that MappedFile
+    takes; None if another process (or catalog) holds it.
+    """
+    try:
+        f = _open_rw(path)
+    except PermissionError:
+        return None  # held by the native library on Windows
+    try:
+        if os.name == 'nt':
+            import msvcrt
+            msvcrt.locking(f.fileno(), msvcrt.LK_NBLCK, 1)
+        else:
+            import fcntl
+            fcntl.flock(f.fileno(), fcntl.LOCK_EX | fcntl.LOCK_NB)
+    except OSError:
+        f.close()
+        return None
+    return f
+
+
+class _FileLog:
+    """
+    The catalog logs read and appended from Python, for when the native
+    library is not built. With persist=False, or when the logs are held by
+    another process, the catalog is loaded but changes stay in memory.
+    """
+
+    def __init__(self, base: Path, persist: bool = True):
+        self._index_path = Path(f"{base}.idx")
+        self._data_path = Path(f"{base}.dat")
+        self._index = self._data_file = None
+        if persist:
+            self._index = _open_locked(self._index_path)
+            if self._index is not None and self._recover():
+                # The lock was on the index that recovery replaced
+                self._index.close()
+                self._index = _open_locked(self._index_path)
+            if self._index is not None:
+                self._data_file = _open_rw(self._data_path)
+        self._records: List[native.CatalogRecord] = []
+        self._times: List[int] = []
+        self._by_name: Dict[bytes, int] = {}
+        self._by_label: Dict[bytes, List[int]] = {}
+        self._label_times: Dict[bytes, List[int]] = {}
+        self._live_by_label: Dict[bytes, int] = {}
+        self._live = 0
+        self._first_live = 0
+        self._load()
+
+    def _recover(self) -> bool:
+        """
+        Finish or roll back a native compaction interrupted between its
+        renames; True if the index was replaced.
+        """
+        index_tmp = Path(f"{self._index_path}.tmp")
+        data_tmp = Path(f"{self._data_path}.tmp")
+        if index_tmp.exists():
+            pending = _read_header(index_tmp, _INDEX_HEADER)
+            current = _read_header(self._data_path, _DATA_HEADER)
+            if (not data_tmp.exists() and pending and current and pending[0] == _INDEX_MAGIC
+                    and current[0] == _DATA_MAGIC and pending[4] == current[2]):
+                os.replace(index_tmp, self._index_path)
+                return True
+            index_tmp.unlink()
+        if data_tmp.exists():
+            data_tmp.unlink()
+        return False
+
+    def _load(self) -> None:
+        index = _read_file(self._index_path)
+        data = _read_file(self._data_path)
+        header = _INDEX_HEADER.unpack_from(index) if len(index) >= _HEADER_BYTES else None
+        data_header = _DATA_HEADER.unpack_from(data) if len(data) >= _HEADER_BYTES else None
+        if (header is None or data_header is None or header[:2] != (_INDEX_MAGIC, _VERSION)
+                or data_header[:2] != (_DATA_MAGIC, _VERSION) or header[4] != data_header[2]):
+            # New, foreign or mismatched logs: start an empty catalog
+            generation = header[4] + 1 if header is not None and header[0] == _INDEX_MAGIC else 1
+            self._count, self._data_end, self._generation = 0, _HEADER_BYTES, generation
+            self._data = bytearray(_DATA_HEADER.pack(_DATA_MAGIC, _VERSION, generation))
+            if self._index is not None:
+                self._index.truncate(0)
+                self._data_file.truncate(0)
+                _write_at(self._data_file, 0, self._data)
+                self._write_header()
+            return
+
+        _, _, committed, data_end, self._generation = header
+        data_end = max(min(data_end, len(data)), _HEADER_BYTES)
+        self._data = bytearray(data[:data_end])
+        self._data_end = data_end
+        committed = min(committed, (len(index) - _HEADER_BYTES) // _RECORD_BYTES)
+        last = 0
+        for i in range(committed):
+            record = native.CatalogRecord.from_buffer_copy(index, _HEADER_BYTES + i * _RECORD_BYTES)
+            if (record.magic != _RECORD_MAGIC or record.name_length == 0 or record.name_offset < _HEADER_BYTES
+                    or record.name_offset + record.name_length > data_end
+                    or record.extra_offset + record.extra_length > data_end or record.timestamp_ns < last):
+                break
+            last = record.timestamp_ns
+            self._track(record)
+        self._count = len(self._records)
+        if self._count != header[2] or data_end != header[3]:
+            self._write_header()
+
+    def _write_header(self) -> None:
+        if self._index is not None:
+            _write_at(self._index, 0, _INDEX_HEADER.pack(_INDEX_MAGIC, _VERSION, self._count, self._data_end,
+                                                         self._generation))
+
+    def _track(self, record: native.CatalogRecord) -> None:
+        i = len(self._records)
+        self._records.append(record)
+        self._times.append(record.timestamp_ns)
+        self._by_label.setdefault(record.label, []).append(i)
+        self._label_times.setdefault(record.label, []).append(record.timestamp_ns)
+        if record.flags & REMOVED:
+            if self._first_live == i:
+                self._first_live = i + 1
+            return
+        name = self._name(record)
+        if name in self._by_name:
+            self.remove(self._by_name[name])
+        self._by_name[name] = i
+        self._live_by_label[record.label] = self._live_by_label.get(record.label, 0) + 1
+        self._live += 1
+
+    def _name(self, record: native.CatalogRecord) -> bytes:
+        return bytes(self._data[record.name_offset:record.name_offset + record.name_length])
+
+    def _append_data(self, blob: bytes) -> int:
+        offset = self._data_end
+        self._data += blob
+        self._data_end += len(blob)
+        if self._data_file is not None:
+            _write_at(self._data_file, offset, blob)
+        return offset
+
+    def close(self) -> None:
+        for f in (self._index, self._data_file):
+            if f is not None:
+                f.close()
+        self._index = self._data_file = None
+
+    def append(self, record: native.CatalogRecord, name: bytes, extra: bytes) -> int:
+        existing = self.find(name)
+        if existing >= 0:
+            self.remove(existing)
+        record.magic = _RECORD_MAGIC
+        record.flags &= PERCEPTUAL
+        now = record.timestamp_ns if record.timestamp_ns > 0 else time.time_ns()
+        record.timestamp_ns = max(now, self._times[-1] if self._times else 0)
+        record.name_offset = self._append_data(name + extra)
+        record.name_length = len(name)
+        record.extra_offset = record.name_offset + len(name)
+        record.extra_length = len(extra)
+        i = self._count
+        if self._index is not None:
+            _write_at(self._index, _HEADER_BYTES + i * _RECORD_BYTES, bytes(record))
+        # Commit: the data first, then the record count
+        self._count += 1
+        self._write_header()
+        self._track(record)
+        return i
+
+    def find(self, name: bytes) -> int:
+        return self._by_name.get(name, -1)
+
+    def read(self, i: int) -> Tuple[native.CatalogRecord, bytes, bytes]:
+        record = self._records[i]
+        extra = self._data[record.extra_offset:record.extra_offset + record.extra_length]
+        return record, self._name(record), bytes(extra)
+
+    def set_extra(self, i: int, extra: bytes) -> bool:
+        record = self._records[i]
+        if record.flags & REMOVED:
+            return False
+        record.extra_offset = self._append_data(extra)
+        record.extra_length = len(extra)
+        self._write_header()
+        if self._index is not None:
+            _write_at(self._index, _HEADER_BYTES + i * _RECORD_BYTES, bytes(record))
+        return True
+
+    def remove(self, i: int) -> bool:
+        record = self._records[i]
+        if record.flags & REMOVED:
+            return False
+        record.flags |= REMOVED
+        # Every tracked record is committed, including one being loaded
+        if self._index is not None:
+            _write_at(self._index, _HEADER_BYTES + i * _RECORD_BYTES + 4, struct.pack('<I', record.flags))
+        name = self._name(record)
+        if self._by_name.get(name) == i:
+            del self._by_name[name]
+        self._live_by_label[record.label] -= 1
+        self._live -= 1
+        return True
+
+    def latest(self, label: Optional[bytes], before_ns: int) -> int:
+        if not label:
+            end = bisect.bisect_right(self._times, before_ns)
+            candidates = range(end - 1, self._first_live - 1, -1)
+        else:
+            records = self._by_label.get(label, [])
+            end = bisect.bisect_right(self._label_times.get(label, []), before_ns)
+            candidates = (records[k] for k in range(end - 1, -1, -1))
+        return next((i for i in candidates if not self._records[i].flags & REMOVED), -1)
+
+    def count(self, label: Optional[bytes]) -> int:
+        return self._live_by_label.get(label, 0) if label else self._live
+
+    def prune(self, keep: int) -> List[int]:
+        removed = []
+        while self._live > max(keep, 0):
+            while self._records[self._first_live].flags & REMOVED:
+                self._first_live += 1
+            self.remove(self._first_live)
+            removed.append(self._first_live)
+        return removed
+
+    def list(self, label: Optional[bytes], newest_first: bool) -> List[int]:
+        records = self._by_label.get(label, []) if label else range(self._first_live, len(self._records))
+        ordered = reversed(records) if newest_first else records
+        return [i for i in ordered if not self._records[i].flags & REMOVED]
+
+
+def _read_file(path: Path) -> bytes:
+    try:
+        with io.FileIO(path, 'r') as f:
+            return f.readall()
+    except OSError:
+        return b''
+
+
+def _write_at(f: io.FileIO, offset: int, data: bytes) -> None:
+    f.seek(offset)
+    f.write(data)
+
+
+def _label(label: Optional[str]) -> Optional[bytes]:
+    """A label as stored in a record (UTF-8, at most 31 bytes)."""
+    if not label:
+        return None
+    return label.encode('utf-8')[:LABEL_BYTES].decode('utf-8', 'ignore').encode('utf-8')
+
+
+class CaptureCatalog:
+    """
+    Catalog of the images in one capture directory.
+
+    The log is opened exclusively by one process; another process opening
+    it sees the captures catalogued so far and keeps its own changes in memory.
+    """
+
+    def __init__(self, path):
+        """
+        Args:
+            path: Log path without suffix (<directory>/catalog gives
+                catalog.idx and catalog.dat)
+        """
+        self.path = Path(path)
+        self._lock = threading.Lock()
+        self.path.parent.mkdir(parents=True, exist_ok=True)
+        lib = native.load_library()
+        if lib is None:
+            self._log = _FileLog(self.path)
+            if not self.persistent:
+                logger.warning(f"Capture catalog {self.path} unavailable (in use by another process); "
+                               f"changes are kept in memory")
+            return
+        error = ctypes.create_string_buffer(256)
+        handle = lib.ux_catalog_open(str(self.path).encode(), error, len(error))
+        if handle:
+            self._log = _NativeLog(lib, handle)
+        else:
+            logger.warning(f"Capture catalog {self.path} unavailable ({error.value.decode()}); "
+                           f"changes are kept in memory")
+            self._log = _FileLog(self.path, persist=False)
+
+    def __del__(self):
+        self.close()
+
+    def __len__(self) -> int:
+        return self.count()
+
+    @property
+    def persistent(self) -> bool:
+        """True if changes are written to the logs."""
+        return isinstance(self._log, _NativeLog) or self._log._index is not None
+
+    def close(self) -> None:
+        """Release the logs."""
+        log = getattr(self, '_log', None)
+        if log is not None:
+            log.close()
+
+    def add(self, name: str, label: str, width: int, height: int, channels: int = 3, file_bytes: int = 0,
+            content_hash: int = 0, phash: Optional[int] = None, dhash: Optional[int] = None,
+            extra: Optional[Dict[str, Any]] = None, timestamp: Optional[float] = None) -> Capture:
+        """
+        Catalog an image, replacing any earlier capture of the same name.
+
+        Args:
+            name: File name within the capture directory
+            label: Kind of capture ('before', 'after', ...), at most 31 bytes
+            timestamp: Capture time in seconds since the epoch (default now);
+                never earlier than the previous capture's
+            extra: JSON-serializable metadata kept with the record
+
+        Returns:
+            The catalogued capture
+        """
+        record = native.CatalogRecord()
+        record.timestamp_ns = int(timestamp * 1e9) if timestamp is not None else time.time_ns()
+        record.width, record.height, record.channels = width, height, channels
+        record.file_bytes = file_bytes
+        record.content_hash = content_hash
+        if phash is not None and dhash is not None:
+            record.flags = PERCEPTUAL
+            record.phash, record.dhash = phash, dhash
+        record.label = _label(label) or b''
+        extra_bytes = json.dumps(extra, default=str).encode() if extra else b''
+        with self._lock:
+            i = self._log.append(record, name.encode(), extra_bytes)
+            if i < 0:
+                raise OSError(f"cannot append to the capture catalog {self.path}")
+            return self._capture(i)
+
+    def get(self, name: str) -> Optional[Capture]:
+        """The live capture with this file name, or None."""
+        with self._lock:
+            i = self._log.find(name.encode())
+            return self._capture(i) if i >= 0 else None
+
+    def update_extra(self, name: str, extra: Dict[str, Any]) -> bool:
+        """Replace a capture's metadata; False if it is not catalogued."""
+        with self._lock:
+            i = self._log.find(name.encode())
+            return i >= 0 and self._log.set_extra(i, json.dumps(extra, default=str).encode())
+
+    def remove(self, name: str) -> bool:
+        """Drop a capture from the catalog (the file is left alone)."""
+        with self._lock:
+            i = self._log.find(name.encode())
+            return i >= 0 and self._log.remove(i)
+
+    def latest(self, label: Optional[str] = None, before: Optional[float] = None) -> Optional[Capture]:
+        """The newest capture with ``label`` (any when None) taken at or before ``before``."""
+        before_ns = int(before * 1e9) if before is not None else 2 ** 63 - 1
+        with self._lock:
+            i = self._log.latest(_label(label), before_ns)
+            return self._capture(i) if i >= 0 else None
+
+    def latest_pair(self, window: float = PAIR_WINDOW) -> Tuple[Optional[Capture], Optional[Capture]]:
+        """
+        The newest 'after' capture and the newest 'before' taken up to
+        ``window`` seconds ahead of it; failing that the newest of each, and
+        (None, None) while either label has no capture.
+        """
+        after = self.latest('after')
+        if after is not None:
+            before = self.latest('before', after.timestamp)
+            if before is not None and after.timestamp - before.timestamp <= window:
+                return before, after
+        before = self.latest('before')
+        if before is None or after is None:
+            return None, None
+        return before, after
+
+    def prune(self, keep: int) -> List[Capture]:
+        """Drop all but the newest ``keep`` captures and return the dropped ones, oldest first."""
+        with self._lock:
+            return [self._capture(i) for i in self._log.prune(keep)]
+
+    def count(self, label: Optional[str] = None) -> int:
+        """Number of captures with ``label`` (all when None)."""
+        with self._lock:
+            return self._log.count(_label(label))
+
+    def captures(self, label: Optional[str] = None, newest_first: bool = True) -> List[Capture]:
+        """Every capture with ``label`` (all when None), in time order."""
+        with self._lock:
+            return [self._capture(i) for i in self._log.list(_label(label), newest_first)]
+
+    def _capture(self, i: int) -> Capture:
+        record, name, extra = self._log.read(i)
+        perceptual = bool(record.flags & PERCEPTUAL)
+        return Capture(
+            name=name.decode(),
+            label=record.label.decode('utf-8', 'replace'),
+            timestamp=record.timestamp_ns / 1e9,
+            width=record.width,
+            height=record.height,
+            channels=record.channels,
+            file_bytes=record.file_bytes,
+            content_hash=record.content_hash,
+            phash=record.phash if perceptual else None,
+            dhash=record.dhash if perceptual else None,
+            extra=json.loads(extra) if extra else {},
+        )
+
+
+def image_hash(path) -> int:
+    """Content hash of an image file's BGR pixels, as catalogued at capture; 0 if it cannot be read."""
+    pixels = cv2.imread(str(path), cv2.IMREAD_COLOR)
+    return native.content_hash(pixels) if pixels is not None else 0
+
+
+_catalogs: Dict[Path, CaptureCatalog] = {}
+_catalogs_lock = threading.Lock()
+
+
+def get_catalog(directory) -> CaptureCatalog:
+    """The process-wide catalog of a capture directory."""
+    key = (Path(directory) / CATALOG_NAME).resolve()
+    with _catalogs_lock:
+        catalog = _catalogs.get(key)
+        if catalog is None:
+            catalog = _catalogs[key] = CaptureCatalog(key)
+        return catalog
@@ -0,0 +1,435 @@
+"""
+Zero-copy screen capture through X11 MIT-SHM (native/ux_capture.cpp).
+
+PIL's ImageGrab.grab() goes through XGetImage on Linux, which streams every
+frame over the X socket and converts it to a PIL image. The native capture
+asks the server to copy the screen, or one window such as the test game's,
+into shared segments that stay attached between frames. Frames are handed to
+Python as read-only numpy views of those segments, so nothing is copied
+between the server and the first consumer.
+
+A capture either grabs on demand (``grab()``) or runs a background thread,
+from which ``latest()`` picks up the newest frame. The thread captures at a
+fixed rate (``start(fps)``), or with ``start(fps, on_damage=True)`` only when
+the target is drawn to, as reported by the X DAMAGE extension. It captures at
+most fps times a second, so an idle game costs nothing and a transition is
+caught within one frame. With damage tracking, each frame's ``regions`` are the
+rectangles drawn since the previous frame. Each frame pins its slot until it
+is released; releasing early (or using ``with``) keeps the ring free for new
+frames.
+
+When the library has not been built (``./build_game.sh capture``), or there
+is no X display, ``NativeCapture`` raises RuntimeError and the module-level
+helpers return None, so callers keep their ImageGrab path.
+"""
+import ctypes
+import os
+import sys
+import threading
+from pathlib import Path
+from typing import Dict, Iterator, Optional, Tuple
+import logging
+
+import cv2
+import numpy as np
+
+logger = logging.getLogger(__name__)
+
+# Must match kCaptureAbiVersion in native/ux_capture.cpp
+ABI_VERSION = 2
+
+LIBRARY_ENV = "UX_CAPTURE_LIB"
+REPO_ROOT = Path(__file__).resolve().parents[2]
+
+# Must match kCaptureSlots / kMaxCaptureRegions in native/shm_capture.h
+CAPTURE_SLOTS = 4
+MAX_REGIONS = 32
+
+# Title substring of the C++ test game's window (sAppName in test_cpp_game.cpp)
+GAME_WINDOW_NAME = "UX Test Game"
+
+CAPTURE_OK = 0
+CAPTURE_EINVAL = -1
+CAPTURE_ETIMEDOUT = -2
+CAPTURE_EBUSY = -3
+CAPTURE_EXERROR = -4
+CAPTURE_ESTOPPED = -5
+
+
+class CaptureRect(ctypes.Structure):
+    """Mirror of UxCaptureRect."""
+    _fields_ = [
+        ('x', ctypes.c_int32),
+        ('y', ctypes.c_int32),
+        ('width', ctypes.c_int32),
+        ('height', ctypes.c_int32),
+    ]
+
+
+class CaptureFrameInfo(ctypes.Structure):
+    """Mirror of UxCaptureFrame."""
+    _fields_ = [
+        ('slot', ctypes.c_int32),
+        ('width', ctypes.c_int32),
+        ('height', ctypes.c_int32),
+        ('stride', ctypes.c_int32),
+        ('sequence', ctypes.c_uint64),
+        ('timestamp_ns', ctypes.c_uint64),
+        ('data', ctypes.c_void_p),
+        ('region_count', ctypes.c_int32),
+        ('regions', CaptureRect * MAX_REGIONS),
+    ]
+
+
+class CaptureStats(ctypes.Structure):
+    """Mirror of UxCaptureStats."""
+    _fields_ = [
+        ('frames', ctypes.c_uint64),
+        ('dropped', ctypes.c_uint64),
+        ('failed', ctypes.c_uint64),
+    ]
+
+
+_lock = threading.Lock()
+_library: Optional[ctypes.CDLL] = None
+_load_attempted = False
+
+
+def library_name() -> str:
+    """File name of the library on this platform."""
+    return 'libux_capture.so'
+
+
+def library_candidates():
+    """Paths searched for the library: $UX_CAPTURE_LIB, then the repository root."""
+    candidates = []
+    if os.environ.get(LIBRARY_ENV):
+        candidates.append(Path(os.environ[LIBRARY_ENV]))
+    candidates.append(REPO_ROOT / library_name())
+    return candidates
+
+
+def _declare(lib: ctypes.CDLL) -> None:
+    frame_p = ctypes.POINTER(CaptureFrameInfo)
+    lib.ux_capture_abi_version.restype = ctypes.c_int32
+    lib.ux_capture_abi_version.argtypes = []
+    lib.ux_capture_open.restype = ctypes.c_void_p
+    lib.ux_capture_open.argtypes = [ctypes.c_char_p, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_int32]
+    lib.ux_capture_close.restype = None
+    lib.ux_capture_close.argtypes = [ctypes.c_void_p]
+    lib.ux_capture_grab.restype = ctypes.c_int32
+    lib.ux_capture_grab.argtypes = [ctypes.c_void_p, frame_p]
+    lib.ux_capture_start.restype = ctypes.c_int32
+    lib.ux_capture_start.argtypes = [ctypes.c_void_p, ctypes.c_double, ctypes.c_int32]
+    lib.ux_capture_tracks_damage.restype = ctypes.c_int32
+    lib.ux_capture_tracks_damage.argtypes = [ctypes.c_void_p]
+    lib.ux_capture_stop.restype = None
+    lib.ux_capture_stop.argtypes = [ctypes.c_void_p]
+    lib.ux_capture_acquire.restype = ctypes.c_int32
+    lib.ux_capture_acquire.argtypes = [ctypes.c_void_p, ctypes.c_int64, ctypes.c_int32, frame_p]
+    lib.ux_capture_release.restype = None
+    lib.ux_capture_release.argtypes = [ctypes.c_void_p, ctypes.c_int32]
+    lib.ux_capture_stats.restype = ctypes.c_int32
+    lib.ux_capture_stats.argtypes = [ctypes.c_void_p, ctypes.POINTER(CaptureStats)]
+
+
+def load_library(path: Optional[Path] = None) -> Optional[ctypes.CDLL]:
+    """
+    Load the capture library (once) and return it, or None if it is unavailable.
+
+    Args:
+        path: Explicit library path; replaces any previously loaded library
+    """
+    global _library, _load_attempted
+    with _lock:
+        if path is None and _load_attempted:
+            return _library
+        _load_attempted = True
+        _library = None
+        if not sys.platform.startswith('linux'):
+            return None
+        for candidate in ([Path(path)] if path is not None else library_candidates()):
+            if not candidate.exists():
+                continue
+            try:
+                lib = ctypes.CDLL(str(candidate))
+                _declare(lib)
+            except (OSError, AttributeError) as e:
+                logger.warning(f"Could not load native capture from {candidate}: {e}")
+                continue
+            if lib.ux_capture_abi_version() != ABI_VERSION:
+                logger.warning(f"Ignoring {candidate}: ABI version {lib.ux_capture_abi_version()}, "
+                               f"expected {ABI_VERSION} (rebuild with ./build_game.sh capture)")
+                continue
+            _library = lib
+            logger.debug(f"Native capture loaded from {candidate}")
+            break
+        return _library
+
+
+class _Pin:
+    """Holds one slot of a capture; released explicitly or when the last view is collected."""
+
+    def __init__(self, capture: 'NativeCapture', slot: int):
+        self._capture = capture
+        self._slot = slot
+
+    def release(self):
+        capture, self._capture = self._capture, None
+        if capture is not None:
+            capture._release(self._slot)
+
+    def __del__(self):
+        self.release()
+
+
+class CaptureFrame:
+    """
+    One captured frame, pinned in its shared-memory slot.
+
+    Attributes:
+        pixels: HxWx4 uint8 read-only view (BGRX: OpenCV channel order, the
+            fourth byte is padding); valid until release()
+        sequence: Frame number of the capture (1 for the first)
+        timestamp_ns: time.monotonic_ns() at the end of the grab
+        regions: (x, y, width, height) rectangles drawn since the previous
+            frame, coalesced; the whole frame without damage tracking, empty
+            when nothing was drawn
+    """
+
+    def __init__(self, capture: 'NativeCapture', info: CaptureFrameInfo):
+        pin = _Pin(capture, info.slot)
+        buffer = (ctypes.c_uint8 * (info.stride * info.height)).from_address(info.data)
+        # Views keep the buffer, and through it the pin, alive
+        buffer._pin = pin
+        rows = np.frombuffer(buffer, dtype=np.uint8).reshape(info.height, info.stride)
+        self.pixels = rows[:, :info.width * 4].reshape(info.height, info.width, 4)
+        self.pixels.flags.writeable = False
+        self.sequence = int(info.sequence)
+        self.timestamp_ns = int(info.timestamp_ns)
+        self.regions = [(r.x, r.y, r.width, r.height) for r in info.regions[:info.region_count]]
+        self._pin = pin
+
+    @property
+    def width(self) -> int:
+        return self.pixels.shape[1]
+
+    @property
+    def height(self) -> int:
+        return self.pixels.shape[0]
+
+    def bgr(self, region: Optional[Tuple[int, int, int, int]] = None) -> np.ndarray:
+        """
+        A BGR copy of the frame (or of region (x, y, width, height)) that
+        outlives the slot.
+        """
+        pixels = self.pixels
+        if region is not None:
+            x, y, width, height = region
+            pixels = pixels[max(y, 0):max(y + height, 0), max(x, 0):max(x + width, 0)]
+        return cv2.cvtColor(pixels, cv2.COLOR_BGRA2BGR)
+
+    def release(self):
+        """Return the slot to the capture; pixels must not be used afterwards."""
+        self._pin.release()
+
+    def __enter__(self) -> 'CaptureFrame':
+        return self
+
+    def __exit__(self, *exc):
+        self.release()
+
+
+class NativeCapture:
+    """
+    MIT-SHM capture of the screen or of one window.
+
+    Args:
+        window_name: Substring of the title or class of the window to
+            capture (the topmost match); None captures the whole screen
+        display: X display name; None uses $DISPLAY
+
+    Raises:
+        RuntimeError: The library is not built or the display, extension or
+            window is unavailable
+    """
+
+    def __init__(self, window_name: Optional[str] = None, display: Optional[str] = None):
+        self._lib = load_library()
+        if self._lib is None:
+            raise RuntimeError("native capture library not built (./build_game.sh capture)")
+        error = ctypes.create_string_buffer(256)
+        self._handle = self._lib.ux_capture_open(display.encode() if display else None,
+                                                 window_name.encode() if window_name else None, error, len(error))
+        if not self._handle:
+            raise RuntimeError(f"native capture unavailable: {error.value.decode(errors='replace')}")
+        self.window_name = window_name
+        # Frames carry the regions reported by X DAMAGE (else the whole target)
+        self.tracks_damage = bool(self._lib.ux_capture_tracks_damage(self._handle))
+        self._pins = 0
+        self._closing = False
+        # Re-entrant: a pin may be collected (and released) while the lock is held
+        self._state_lock = threading.RLock()
+
+    def grab(self) -> Optional[CaptureFrame]:
+        """Capture a frame now (None if the grab failed, e.g. the window is unmapped)."""
+        return self._frame(lambda info: self._lib.ux_capture_grab(self._handle, ctypes.byref(info)))
+
+    def start(self, fps: float = 60.0, on_damage: bool = False) -> bool:
+        """
+        Capture on a background thread.
+
+        Args:
+            fps: Frames per second, or the most per second with on_damage
+            on_damage: Capture only when the target is drawn to (needs
+                tracks_damage; the first frame is taken at once)
+
+        Returns:
+            False if the capture is already running or on_damage is unsupported
+        """
+        return self._lib.ux_capture_start(self._handle, float(fps), int(on_damage)) == CAPTURE_OK
+
+    def stop(self):
+        """Stop the background capture."""
+        self._lib.ux_capture_stop(self._handle)
+
+    def latest(self, after: int = -1, timeout: float = 1.0) -> Optional[CaptureFrame]:
+        """
+        The newest frame of the background capture.
+
+        Args:
+            after: Only return a frame with a greater sequence number, waiting
+                for one (pass the previous frame's sequence to get each new
+                frame once)
+            timeout: Seconds to wait
+
+        Returns:
+            The frame, or None on timeout or when no capture is running
+        """
+        millis = max(int(timeout * 1000), 0)
+        return self._frame(lambda info: self._lib.ux_capture_acquire(self._handle, int(after), millis,
+                                                                     ctypes.byref(info)))
+
+    def frames(self, timeout: Optional[float] = None) -> Iterator[CaptureFrame]:
+        """
+        Each new frame of the background capture, in order, skipping frames
+        that were replaced before they were read. Stops after timeout seconds
+        without a new frame (None waits indefinitely) or when the capture stops.
+        """
+        last = -1
+        millis = max(int(timeout * 1000), 0) if timeout is not None else 1000
+        while True:
+            frame, status = self._frame_status(
+                lambda info: self._lib.ux_capture_acquire(self._handle, last, millis, ctypes.byref(info)))
+            if frame is not None:
+                last = frame.sequence
+                yield frame
+            elif status != CAPTURE_ETIMEDOUT or timeout is not None:
+                return
+
+    def stats(self) -> Dict[str, int]:
+        """Frames captured, dropped (every slot pinned) and failed so far."""
+        stats = CaptureStats()
+        self._lib.ux_capture_stats(self._handle, ctypes.byref(stats))
+        return {'frames': stats.frames, 'dropped': stats.dropped, 'failed': stats.failed}
+
+    def close(self):
+        """Stop capturing; the segments are freed once every frame is released."""
+        with self._state_lock:
+            if self._handle is None or self._closing:
+                return
+            self._closing = True
+            self._lib.ux_capture_stop(self._handle)
+            if self._pins == 0:
+                self._destroy()
+
+    def __enter__(self) -> 'NativeCapture':
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        if getattr(self, '_handle', None):
+            self.close()
+
+    def _frame(self, call) -> Optional[CaptureFrame]:
+        return self._frame_status(call)[0]
+
+    def _frame_status(self, call) -> Tuple[Optional[CaptureFrame], int]:
+        with self._state_lock:
+            if self._handle is None or self._closing:
+                return None, CAPTURE_ESTOPPED
+            self._pins += 1
+        info = CaptureFrameInfo()
+        status = call(info)
+        if status != CAPTURE_OK:
+            self._release(None)
+            if status not in (CAPTURE_ETIMEDOUT, CAPTURE_ESTOPPED):
+                logger.debug(f"Native capture failed with status {status}")
+            return None, status
+        return CaptureFrame(self, info), status
+
+    def _release(self, slot: Optional[int]):
+        with self._state_lock:
+            if slot is not None:
+                self._lib.ux_capture_release(self._handle, slot)
+            self._pins -= 1
+            if self._closing and self._pins == 0:
+                self._destroy()
+
+    def _destroy(self):
+        self._lib.ux_capture_close(self._handle)
+        self._handle = None
+
+
+_captures: Dict[Tuple[Optional[str], Optional[str]], Optional[NativeCapture]] = {}
+_captures_lock = threading.Lock()
+
+
+def get_capture(window_name: Optional[str] = None, display: Optional[str] = None) -> Optional[NativeCapture]:
+    """
+    Shared capture of a window (or the screen), or None when native capture
+    is unavailable. Failures are remembered, except a missing window, which
+    may not have been mapped yet.
+    """
+    key = (window_name, display or os.environ.get('DISPLAY'))
+    if not key[1]:
+        return None
+    with _captures_lock:
+        if key not in _captures:
+            try:
+                _captures[key] = NativeCapture(window_name, display)
+            except RuntimeError as e:
+                logger.debug(str(e))
+                if window_name is not None and load_library() is not None:
+                    return None
+                _captures[key] = None
+        return _captures[key]
+
+
+def _forget_capture(capture: NativeCapture):
+    with _captures_lock:
+        for key, value in list(_captures.items()):
+            if value is capture:
+                del _captures[key]
+    capture.close()
+
+
+def grab_bgr(window_name: Optional[str] = None,
+             region: Optional[Tuple[int, int, int, int]] = None) -> Optional[np.ndarray]:
+    """
+    A BGR copy of the screen (or a window), optionally cropped to region
+    (x, y, width, height), or None when native capture is unavailable.
+    """
+    capture = get_capture(window_name)
+    if capture is None:
+        return None
+    frame = capture.grab()
+    if frame is None:
+        # The window may have been closed or re-created; look it up again next time
+        if window_name is not None:
+            _forget_capture(capture)
+        return None
+    with frame:
+        return frame.bgr(region)
@@ -2,33 +2,104 @@
 Screenshot capture functionality for UX testing.
 
 This module handles all screenshot capture operations with metadata tracking.
+Frames come from the MIT-SHM capture (native_capture) when it is built and an
+X display is available, otherwise from PIL's ImageGrab. Metadata is kept in
+the capture catalog of the output directory (capture_catalog) rather than in
+a JSON file per image.
 """
 import json
 from datetime import datetime
 from pathlib import Path
 from typing import Dict, Any, Tuple, Optional
 
+import cv2
+import numpy as np
 from PIL import Image, ImageGrab
 import logging
 
+from src.analysis import native
+from . import native_capture
+from .capture_catalog import Capture, CaptureCatalog, PAIR_WINDOW, get_catalog, image_hash
+
 logger = logging.getLogger(__name__)
 
 
 class ScreenshotCapture:
     """Handles screenshot capture with metadata tracking."""
     
-    def __init__(self, output_dir: str = "ux_captures", quality: int = 85):
+    def __init__(self, output_dir: str = "ux_captures", quality: int = 85, window_name: Optional[str] = None):
         """
         Initialize screenshot capture.
         
         Args:
             output_dir: Directory to save screenshots
             quality: JPEG quality (1-100)
+            window_name: Capture only the window whose title contains this
+                (e.g. native_capture.GAME_WINDOW_NAME); needs the native
+                capture, ImageGrab always grabs the whole screen
         """
         self.output_dir = Path(output_dir)
         self.output_dir.mkdir(exist_ok=True)
         self.quality = quality
+        self.window_name = window_name
+        self._catalog: Optional[CaptureCatalog] = None
+
+    @property
+    def catalog(self) -> CaptureCatalog:
+        """The catalog of output_dir, opened on first use."""
+        if self._catalog is None:
+            catalog = get_catalog(self.output_dir)
+            self._import_sidecars(catalog)
+            self._catalog = catalog
+        return self._catalog
+
+    def _import_sidecars(self, catalog: CaptureCatalog) -> None:
+        """
+        Catalog the screenshots of a directory written with JSON sidecars.
         
+        The sidecars are deleted only once every image is in a persistent
+        catalog; until then the import resumes on the next open, skipping
+        the images already catalogued.
+        """
+        if len(catalog) == 0:
+            images = self.output_dir.glob("*.png")
+        else:
+            images = (f.with_suffix('.png') for f in self.output_dir.glob("*.json") if f.with_suffix('.png').exists())
+        sidecars = []
+        for filepath in sorted(images):
+            sidecar = filepath.with_suffix('.json')
+            metadata = {}
+            if sidecar.exists():
+                sidecars.append(sidecar)
+                try:
+                    with open(sidecar, 'r') as f:
+                        metadata = json.load(f)
+                except Exception as e:
+                    logger.warning(f"Could not load metadata for {filepath.name}: {e}")
+            if catalog.get(filepath.name) is not None:
+                continue
+            width, height = metadata.get('size') or (0, 0)
+            stat = filepath.stat()
+            extra = {k: v for k, v in metadata.items() if k in ('timestamp', 'quality', 'expected_content')}
+            catalog.add(filepath.name, metadata.get('label') or filepath.stem.rsplit('_', 1)[-1],
+                        width, height, file_bytes=stat.st_size, content_hash=image_hash(filepath),
+                        extra=extra, timestamp=stat.st_mtime)
+        if catalog.persistent:
+            for sidecar in sidecars:
+                sidecar.unlink(missing_ok=True)
+
+    def _metadata(self, capture: Capture) -> Dict[str, Any]:
+        """The metadata dictionary capture_screenshot returned for a capture."""
+        metadata = {
+            'filename': capture.name,
+            'timestamp': capture.extra.get('timestamp'),
+            'label': capture.label,
+            'size': (capture.width, capture.height),
+            'capture_time': datetime.fromtimestamp(capture.timestamp).isoformat(),
+        }
+        metadata.update(capture.extra)
+        return metadata
+
     def capture_screenshot(self, label: str = "screenshot") -> Tuple[Path, Dict[str, Any]]:
         """
         Capture a screenshot with timestamp and metadata.
@@ -47,23 +118,39 @@ class ScreenshotCapture:
         
         try:
             # Capture screenshot
-            screenshot = ImageGrab.grab()
-            screenshot.save(filepath, quality=self.quality)
+            frame = native_capture.grab_bgr(self.window_name)
+            if frame is not None:
+                cv2.imwrite(str(filepath), frame)
+                size = (frame.shape[1], frame.shape[0])
+                pixels = frame
+            else:
+                screenshot = ImageGrab.grab()
+                screenshot.save(filepath, quality=self.quality)
+                size = screenshot.size
+                # Hashed as BGR, like frames from the native capture and imported files
+                pixels = np.asarray(screenshot)
+                if pixels.ndim == 3:
+                    pixels = pixels[:, :, 2::-1]
             
             # Create metadata
             metadata = {
                 'filename': filename,
                 'timestamp': timestamp,
                 'label': label,
-                'size': screenshot.size,
+                'size': size,
                 'capture_time': datetime.now().isoformat(),
                 'quality': self.quality
             }
             
-            # Save metadata
-            metadata_file = filepath.with_suffix('.json')
-            with open(metadata_file, 'w') as f:
-                json.dump(metadata, f, indent=2)
+            # Catalog the capture
+            try:
+                content_hash = native.content_hash(pixels)
+            except (TypeError, ValueError):
+                content_hash = 0
+            self.catalog.add(filename, label, size[0], size[1],
+                             file_bytes=filepath.stat().st_size if filepath.exists() else 0,
+                             content_hash=content_hash,
+                             extra={'timestamp': timestamp, 'quality': self.quality})
             
             logger.info(f"Screenshot saved: {filepath}")
             return filepath, metadata
@@ -86,9 +173,8 @@ class ScreenshotCapture:
         
         if expected_content:
             metadata['expected_content'] = expected_content
-            metadata_file = filepath.with_suffix('.json')
-            with open(metadata_file, 'w') as f:
-                json.dump(metadata, f, indent=2)
+            self.catalog.update_extra(filepath.name, {'timestamp': metadata['timestamp'], 'quality': self.quality,
+                                                      'expected_content': expected_content})
         
         return filepath, metadata
     
@@ -106,9 +192,8 @@ class ScreenshotCapture:
         
         if expected_content:
             metadata['expected_content'] = expected_content
-            metadata_file = filepath.with_suffix('.json')
-            with open(metadata_file, 'w') as f:
-                json.dump(metadata, f, indent=2)
+            self.catalog.update_extra(filepath.name, {'timestamp': metadata['timestamp'], 'quality': self.quality,
+                                                      'expected_content': expected_content})
         
         return filepath, metadata
     
@@ -116,32 +201,16 @@ class ScreenshotCapture:
         """
         Find the most recent Before/after screenshot pair.
         
+        The newest 'after' capture is paired with the newest 'before' taken
+        up to 10 seconds ahead of it; failing that the newest of each is used.
+        
         Returns:
             Tuple of (before_path, after_path) or (None, None) if not found
         """
-        before_files = list(self.output_dir.glob("*_before.png"))
-        after_files = list(self.output_dir.glob("*_after.png"))
-        
-        if not before_files or not after_files:
+        before, after = self.catalog.latest_pair(PAIR_WINDOW)
+        if before is None or after is None:
             return None, None
-            
-        # Sort by timestamp (filename starts with timestamp)
-        before_files.sort(reverse=True)
-        after_files.sort(reverse=True)
-        
-        # Find matching pair (same timestamp prefix)
-        for before_file in before_files:
-            before_timestamp = before_file.stem.split('_')[0]
-            
-            for after_file in after_files:
-                after_timestamp = after_file.stem.split('_')[0]
-                
-                # Look for after screenshot within reasonable time window
-                if abs(int(after_timestamp) - int(before_timestamp)) < 100000:  # 10 seconds
-                    return before_file, after_file
-        
-        # If no perfect match, use most recent of each
-        return before_files[0], after_files[0]
+        return self.output_dir / before.name, self.output_dir / after.name
     
     def list_captures(self) -> Dict[str, Any]:
         """
@@ -150,51 +219,28 @@ class ScreenshotCapture:
         Returns:
             Dictionary with capture information
         """
+        catalog = self.catalog
         captures = {
-            'total_screenshots': 0,
-            'before_screenshots': 0,
-            'after_screenshots': 0,
+            'total_screenshots': catalog.count(),
+            'before_screenshots': catalog.count('before'),
+            'after_screenshots': catalog.count('after'),
             'other_screenshots': 0,
             'latest_capture': None,
             'files': []
         }
+        captures['other_screenshots'] = (captures['total_screenshots'] - captures['before_screenshots']
+                                         - captures['after_screenshots'])
         
-        # Find all screenshot files
-        screenshot_files = list(self.output_dir.glob("*.png"))
-        captures['total_screenshots'] = len(screenshot_files)
-        
-        if not screenshot_files:
-            return captures
-        
-        # Sort by timestamp
-        screenshot_files.sort(reverse=True)
-        captures['latest_capture'] = screenshot_files[0].name
-        
-        # Categorize and collect metadata
-        for filepath in screenshot_files:
-            if '_before.png' in filepath.name:
-                captures['before_screenshots'] += 1
-            elif '_after.png' in filepath.name:
-                captures['after_screenshots'] += 1
-            else:
-                captures['other_screenshots'] += 1
-            
-            # Load metadata if available
-            metadata_file = filepath.with_suffix('.json')
-            metadata = {}
-            if metadata_file.exists():
-                try:
-                    with open(metadata_file, 'r') as f:
-                        metadata = json.load(f)
-                except Exception as e:
-                    logger.warning(f"Could not load metadata for {filepath.name}: {e}")
-            
+        for capture in catalog.captures():
             captures['files'].append({
-                'filename': filepath.name,
-                'size_mb': round(filepath.stat().st_size / (1024 * 1024), 2),
-                'metadata': metadata
+                'filename': capture.name,
+                'size_mb': round(capture.file_bytes / (1024 * 1024), 2),
+                'metadata': self._metadata(capture)
             })
         
+        if captures['files']:
+            captures['latest_capture'] = captures['files'][0]['filename']
+        
         return captures
     
     def clean_old_captures(self, keep_count: int = 20) -> int:
@@ -207,27 +253,14 @@ class ScreenshotCapture:
         Returns:
             Number of files deleted
         """
-        screenshot_files = list(self.output_dir.glob("*.png"))
-        metadata_files = list(self.output_dir.glob("*.json"))
-        
-        all_files = screenshot_files + metadata_files
-        
-        if len(all_files) <= keep_count * 2:  # Keep pairs (screenshot + metadata)
-            return 0
-        
-        # Sort by modification time
-        all_files.sort(key=lambda f: f.stat().st_mtime, reverse=True)
-        
-        # Keep the most recent files
-        files_to_keep = all_files[:keep_count * 2]
-        files_to_delete = all_files[keep_count * 2:]
-        
         deleted_count = 0
-        for file_path in files_to_delete:
+        for capture in self.catalog.prune(keep_count):
+            file_path = self.output_dir / capture.name
             try:
-                file_path.unlink()
-                deleted_count += 1
-                logger.info(f"Deleted old capture: {file_path.name}")
+                if file_path.exists():
+                    file_path.unlink()
+                    deleted_count += 1
+                    logger.info(f"Deleted old capture: {file_path.name}")
             except Exception as e:
                 logger.warning(f"Could not delete {file_path.name}: {e}")
         
@@ -243,14 +276,5 @@ class ScreenshotCapture:
         Returns:
             Metadata dictionary
         """
-        metadata_file = image_path.with_suffix('.json')
-        
-        if not metadata_file.exists():
-            return {}
-        
-        try:
-            with open(metadata_file, 'r') as f:
-                return json.load(f)
-        except Exception as e:
-            logger.warning(f"Could not load metadata for {image_path.name}: {e}")
-            return {} 
\ No newline at end of file
+        capture = self.catalog.get(Path(image_path).name)
+        return self._metadata(capture) if capture is not None else {}
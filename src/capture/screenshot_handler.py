@@ -16,9 +16,12 @@ from PIL import Image, ImageGrab
 from typing import Optional, List, Dict, Any, Tuple
 from datetime import datetime
 from pathlib import Path
-import hashlib
 import json
 
+from src.analysis import native
+from src.capture import native_capture
+from src.capture.capture_catalog import Capture, get_catalog, image_hash
+
 logger = logging.getLogger(__name__)
 
 class ScreenshotHandler:
@@ -27,24 +30,48 @@ class ScreenshotHandler:
     Provides a clean interface for screenshot-related functionality.
     """
     
-    def __init__(self, storage_dir: str = "screenshots", max_stored: int = 100):
+    # Luma of the per-channel difference a pixel must exceed to count as changed
+    CHANGE_THRESHOLD = 10
+    # Tile edge length used to group changed pixels into regions
+    CHANGE_TILE_SIZE = 32
+    
+    def __init__(self, storage_dir: str = "screenshots", max_stored: int = 100, use_native: bool = True,
+                 near_duplicate_radius: int = 4, window_name: Optional[str] = None):
         """
         Initialize the ScreenshotHandler
         
         Args:
             storage_dir: Directory to store screenshots
             max_stored: Maximum number of screenshots to keep in storage
+            use_native: Compare against the baseline with the native kernels when built
+            near_duplicate_radius: pHash bits two screenshots may differ in and
+                still count as near-duplicates
+            window_name: Capture only the window whose title contains this
+                (regions are then relative to the window); needs the native
+                MIT-SHM capture, ImageGrab always grabs the screen
         """
         self.storage_dir = Path(storage_dir)
         self.max_stored = max_stored
+        self.use_native = use_native
+        self.near_duplicate_radius = near_duplicate_radius
+        self.window_name = window_name
         self.current_screenshot: Optional[np.ndarray] = None
         self.previous_screenshot: Optional[np.ndarray] = None
         self.baseline_screenshot: Optional[np.ndarray] = None
+        # Baseline copied into the kernels' aligned layout, rebuilt when the baseline changes
+        self._prepared_baseline: Optional[native.PreparedFrame] = None
+        self._prepared_source: Optional[np.ndarray] = None
+        # pHash index over stored screenshots, built from metadata on first use
+        self._hash_index: Optional[native.HashIndex] = None
+        self._index_ids: Dict[str, int] = {}
+        self._index_names: Dict[int, str] = {}
+        self._next_index_id = 0
         
         # Create storage directory if it doesn't exist
         self.storage_dir.mkdir(parents=True, exist_ok=True)
         
-        # Load metadata if exists
+        # Metadata lives in the capture catalog; metadata.json is only read to migrate it
+        self.catalog = get_catalog(self.storage_dir)
         self.metadata_file = self.storage_dir / "metadata.json"
         self.screenshots_metadata = self._load_metadata()
         
@@ -61,21 +88,24 @@ class ScreenshotHandler:
             Screenshot as numpy array in BGR format, or None if capture fails
         """
         try:
-            if region:
-                # Capture specific region
-                x, y, width, height = region
-                screenshot = ImageGrab.grab(bbox=(x, y, x + width, y + height))
-            else:
-                # Capture full screen
-                screenshot = ImageGrab.grab()
-            
-            if screenshot is None:
-                logger.error("Failed to capture screenshot")
-                return None
-            
-            # Convert to numpy array and BGR format for OpenCV compatibility
-            screenshot_array = np.array(screenshot)
-            screenshot_bgr = cv2.cvtColor(screenshot_array, cv2.COLOR_RGB2BGR)
+            # Shared-memory grab when built, without PIL's conversions
+            screenshot_bgr = native_capture.grab_bgr(self.window_name, region)
+            if screenshot_bgr is None:
+                if region:
+                    # Capture specific region
+                    x, y, width, height = region
+                    screenshot = ImageGrab.grab(bbox=(x, y, x + width, y + height))
+                else:
+                    # Capture full screen
+                    screenshot = ImageGrab.grab()
+                
+                if screenshot is None:
+                    logger.error("Failed to capture screenshot")
+                    return None
+                
+                # Convert to numpy array and BGR format for OpenCV compatibility
+                screenshot_array = np.array(screenshot)
+                screenshot_bgr = cv2.cvtColor(screenshot_array, cv2.COLOR_RGB2BGR)
             
             # Update current and previous
             self.previous_screenshot = self.current_screenshot
@@ -113,20 +143,19 @@ class ScreenshotHandler:
             image = Image.fromarray(screenshot_rgb)
             image.save(filepath)
             
-            # Calculate hash for deduplication
-            screenshot_hash = self._calculate_hash(screenshot)
+            # Calculate hashes for exact and near-duplicate detection
+            perceptual = native.perceptual_hash(screenshot)
+            phash, dhash = perceptual if perceptual is not None else (None, None)
             
             # Store metadata
-            screenshot_metadata = {
-                "filename": filename,
-                "timestamp": datetime.now().isoformat(),
-                "size": screenshot.shape,
-                "hash": screenshot_hash,
-                "metadata": metadata or {}
-            }
-            
-            self.screenshots_metadata[filename] = screenshot_metadata
-            self._save_metadata()
+            height, width = screenshot.shape[:2]
+            capture = self.catalog.add(filename, (metadata or {}).get("type", "screenshot"), width, height,
+                                       channels=screenshot.shape[2] if screenshot.ndim == 3 else 1,
+                                       file_bytes=filepath.stat().st_size,
+                                       content_hash=native.content_hash(screenshot),
+                                       phash=phash, dhash=dhash, extra=metadata)
+            self.screenshots_metadata[filename] = self._capture_metadata(capture)
+            self._index_screenshot(filename)
             
             # Cleanup old screenshots if needed
             self._cleanup_old_screenshots()
@@ -243,17 +272,17 @@ class ScreenshotHandler:
                 h, w = self.baseline_screenshot.shape[:2]
                 screenshot = cv2.resize(screenshot, (w, h))
             
-            # Calculate difference
-            diff = cv2.absdiff(self.baseline_screenshot, screenshot)
-            diff_gray = cv2.cvtColor(diff, cv2.COLOR_BGR2GRAY)
+            stats = None
+            if self.use_native and native.available():
+                stats = native.diff_colour(self._get_prepared_baseline(), screenshot,
+                                           threshold=self.CHANGE_THRESHOLD, tile_size=self.CHANGE_TILE_SIZE)
+            if stats is None:
+                stats = self._compare_opencv(self.baseline_screenshot, screenshot)
             
-            # Calculate change metrics
-            total_pixels = diff_gray.size
-            changed_pixels = np.count_nonzero(diff_gray > 10)  # Threshold for meaningful change
+            total_pixels = screenshot.shape[0] * screenshot.shape[1]
+            changed_pixels = stats["changed_pixels"]
             change_percentage = (changed_pixels / total_pixels) * 100
-            
-            # Calculate mean squared error
-            mse = np.mean((self.baseline_screenshot.astype("float") - screenshot.astype("float")) ** 2)
+            mse = stats["mse"]
             
             comparison_result = {
                 "timestamp": datetime.now().isoformat(),
@@ -261,6 +290,7 @@ class ScreenshotHandler:
                 "changed_pixels": changed_pixels,
                 "total_pixels": total_pixels,
                 "mse": mse,
+                "changed_regions": stats["boxes"],
                 "has_significant_change": change_percentage > 5.0  # 5% threshold
             }
             
@@ -271,6 +301,26 @@ class ScreenshotHandler:
             logger.error(f"Error comparing with baseline: {e}")
             return None
     
+    def _get_prepared_baseline(self):
+        """The baseline in the native kernels' layout (prepared once per baseline)."""
+        if self._prepared_source is not self.baseline_screenshot:
+            self._prepared_baseline = native.prepare_frame(self.baseline_screenshot)
+            self._prepared_source = self.baseline_screenshot
+        return self._prepared_baseline if self._prepared_baseline is not None else self.baseline_screenshot
+    
+    def _compare_opencv(self, baseline: np.ndarray, screenshot: np.ndarray) -> Dict[str, Any]:
+        """OpenCV path of compare_with_baseline, used when the native kernels are unavailable."""
+        diff = cv2.absdiff(baseline, screenshot)
+        diff_gray = cv2.cvtColor(diff, cv2.COLOR_BGR2GRAY)
+        changed = diff_gray > self.CHANGE_THRESHOLD
+        
+        return {
+            "changed_pixels": int(np.count_nonzero(changed)),
+            # Squared L2 norm accumulates in integers; no float copies of the frames
+            "mse": cv2.norm(baseline, screenshot, cv2.NORM_L2SQR) / baseline.size,
+            "boxes": native.mask_boxes(changed, self.CHANGE_TILE_SIZE),
+        }
+    
     def find_duplicates(self) -> List[List[str]]:
         """
         Find duplicate screenshots based on hash comparison
@@ -300,38 +350,98 @@ class ScreenshotHandler:
             logger.error(f"Error finding duplicates: {e}")
             return []
     
+    def find_near_duplicates(self, radius: Optional[int] = None) -> List[List[str]]:
+        """
+        Group screenshots that are identical or perceptually near-identical
+        (e.g. differing only in a HUD timer digit)
+        
+        Screenshots are visited newest first; each one not yet grouped keeps
+        every other ungrouped screenshot within ``radius`` pHash bits (or with
+        the same exact hash), so every member is close to its group's first entry.
+        
+        Args:
+            radius: pHash Hamming radius (default: near_duplicate_radius)
+            
+        Returns:
+            List of groups, each newest first, with more than one filename
+        """
+        try:
+            radius = self.near_duplicate_radius if radius is None else radius
+            index = self._near_index()
+            exact_groups: Dict[str, List[str]] = {}
+            for filename, metadata in self.screenshots_metadata.items():
+                if metadata.get("hash"):
+                    exact_groups.setdefault(metadata["hash"], []).append(filename)
+            
+            grouped = set()
+            groups = []
+            for filename in sorted(self.screenshots_metadata,
+                                   key=lambda f: self.screenshots_metadata[f]["timestamp"], reverse=True):
+                if filename in grouped:
+                    continue
+                metadata = self.screenshots_metadata[filename]
+                members = [filename]
+                grouped.add(filename)
+                candidates = list(exact_groups.get(metadata.get("hash"), []))
+                if metadata.get("phash"):
+                    candidates += [self._index_names[id] for id, _ in index.query(int(metadata["phash"], 16), radius)]
+                for other in candidates:
+                    if other not in grouped:
+                        members.append(other)
+                        grouped.add(other)
+                if len(members) > 1:
+                    groups.append(members)
+            
+            if groups:
+                logger.info(f"Found {len(groups)} groups of near-duplicate screenshots")
+            
+            return groups
+            
+        except Exception as e:
+            logger.error(f"Error finding near-duplicates: {e}")
+            return []
+    
+    def find_similar(self, screenshot: np.ndarray, radius: Optional[int] = None) -> List[Tuple[str, int]]:
+        """
+        Stored screenshots perceptually close to a frame
+        
+        Args:
+            screenshot: Frame to look up (BGR)
+            radius: pHash Hamming radius (default: near_duplicate_radius)
+            
+        Returns:
+            (filename, distance) pairs, nearest first
+        """
+        perceptual = native.perceptual_hash(screenshot)
+        if perceptual is None:
+            return []
+        radius = self.near_duplicate_radius if radius is None else radius
+        return [(self._index_names[id], distance)
+                for id, distance in self._near_index().query(perceptual[0], radius)]
+    
     def cleanup_duplicates(self) -> int:
         """
-        Remove duplicate screenshots, keeping the newest one
+        Remove duplicate and near-duplicate screenshots, keeping the newest one
         
         Returns:
             Number of files removed
         """
         try:
-            duplicates = self.find_duplicates()
+            duplicates = self.find_near_duplicates()
             removed_count = 0
             
             for duplicate_group in duplicates:
-                # Sort by timestamp, keep the newest
-                sorted_group = sorted(
-                    duplicate_group,
-                    key=lambda f: self.screenshots_metadata[f]["timestamp"],
-                    reverse=True
-                )
-                
-                # Remove all but the first (newest)
-                for filename in sorted_group[1:]:
+                # Groups are newest first; remove all but the first
+                for filename in duplicate_group[1:]:
                     filepath = self.storage_dir / filename
                     if filepath.exists():
                         filepath.unlink()
                         removed_count += 1
                     
                     # Remove from metadata
-                    if filename in self.screenshots_metadata:
-                        del self.screenshots_metadata[filename]
+                    self._forget_screenshot(filename)
             
             if removed_count > 0:
-                self._save_metadata()
                 logger.info(f"Removed {removed_count} duplicate screenshots")
             
             return removed_count
@@ -357,6 +467,7 @@ class ScreenshotHandler:
                     total_size += filepath.stat().st_size
             
             duplicates = len(self.find_duplicates())
+            near_duplicates = len(self.find_near_duplicates())
             
             return {
                 "total_screenshots": total_files,
@@ -364,6 +475,7 @@ class ScreenshotHandler:
                 "total_size_mb": total_size / (1024 * 1024),
                 "storage_directory": str(self.storage_dir),
                 "duplicate_groups": duplicates,
+                "near_duplicate_groups": near_duplicates,
                 "has_baseline": self.baseline_screenshot is not None
             }
             
@@ -371,55 +483,111 @@ class ScreenshotHandler:
             logger.error(f"Error getting storage stats: {e}")
             return {}
     
-    def _calculate_hash(self, screenshot: np.ndarray) -> str:
-        """Calculate hash of screenshot for deduplication"""
-        return hashlib.md5(screenshot.tobytes()).hexdigest()
+    def _near_index(self) -> native.HashIndex:
+        """pHash index of the stored screenshots (built from metadata once)."""
+        if self._hash_index is None:
+            self._hash_index = native.HashIndex()
+            for filename in self.screenshots_metadata:
+                self._index_screenshot(filename)
+        return self._hash_index
+    
+    def _index_screenshot(self, filename: str):
+        """File a screenshot's pHash in the index (if the index is built)."""
+        phash = self.screenshots_metadata[filename].get("phash")
+        if self._hash_index is None or not phash:
+            return
+        id = self._index_ids.get(filename)
+        if id is None:
+            id = self._index_ids[filename] = self._next_index_id
+            self._next_index_id += 1
+        self._index_names[id] = filename
+        self._hash_index.add(id, int(phash, 16))
+    
+    def _forget_screenshot(self, filename: str):
+        """Drop a screenshot from the catalog, the metadata and the pHash index."""
+        self.catalog.remove(filename)
+        self.screenshots_metadata.pop(filename, None)
+        id = self._index_ids.pop(filename, None)
+        if id is not None:
+            self._index_names.pop(id, None)
+            if self._hash_index is not None:
+                self._hash_index.remove(id)
+    
+    @staticmethod
+    def _capture_metadata(capture: Capture) -> Dict[str, Any]:
+        """The metadata entry of a catalogued screenshot."""
+        entry = {
+            "filename": capture.name,
+            "timestamp": datetime.fromtimestamp(capture.timestamp).isoformat(),
+            "size": (capture.height, capture.width, capture.channels) if capture.channels > 1
+                    else (capture.height, capture.width),
+            "metadata": capture.extra
+        }
+        # 0 means the pixels were never hashed; such captures are not exact duplicates
+        if capture.content_hash:
+            entry["hash"] = f"{capture.content_hash:016x}"
+        if capture.phash is not None:
+            entry["phash"] = f"{capture.phash:016x}"
+            entry["dhash"] = f"{capture.dhash:016x}"
+        return entry
     
     def _load_metadata(self) -> Dict[str, Any]:
-        """Load screenshots metadata from file"""
+        """Load screenshots metadata from the catalog"""
+        if self.metadata_file.exists():
+            try:
+                self._import_metadata_file()
+            except Exception as e:
+                logger.error(f"Error importing {self.metadata_file}: {e}")
         try:
-            if self.metadata_file.exists():
-                with open(self.metadata_file, 'r') as f:
-                    return json.load(f)
-            return {}
+            return {capture.name: self._capture_metadata(capture)
+                    for capture in self.catalog.captures(newest_first=False)}
         except Exception as e:
             logger.error(f"Error loading metadata: {e}")
             return {}
     
-    def _save_metadata(self):
-        """Save screenshots metadata to file"""
-        try:
-            with open(self.metadata_file, 'w') as f:
-                json.dump(self.screenshots_metadata, f, indent=2)
-        except Exception as e:
-            logger.error(f"Error saving metadata: {e}")
+    def _import_metadata_file(self):
+        """
+        Catalog the screenshots listed in a metadata.json of an older storage
+        directory. The file is deleted once every entry is in a persistent
+        catalog; until then the import resumes on the next open.
+        """
+        with open(self.metadata_file, 'r') as f:
+            entries = json.load(f)
+        for filename, entry in sorted(entries.items(), key=lambda item: item[1]["timestamp"]):
+            filepath = self.storage_dir / filename
+            if not filepath.exists() or self.catalog.get(filename) is not None:
+                continue
+            shape = entry.get("size") or (0, 0)
+            extra = entry.get("metadata") or {}
+            self.catalog.add(filename, extra.get("type", "screenshot"), shape[1], shape[0],
+                             channels=shape[2] if len(shape) > 2 else 1,
+                             file_bytes=filepath.stat().st_size,
+                             content_hash=image_hash(filepath),
+                             phash=int(entry["phash"], 16) if entry.get("phash") else None,
+                             dhash=int(entry["dhash"], 16) if entry.get("dhash") else None,
+                             extra=extra,
+                             timestamp=datetime.fromisoformat(entry["timestamp"]).timestamp())
+        if self.catalog.persistent:
+            self.metadata_file.unlink()
     
     def _cleanup_old_screenshots(self):
         """Remove old screenshots if storage limit exceeded"""
         try:
-            if len(self.screenshots_metadata) <= self.max_stored:
+            if self.catalog.count() <= self.max_stored:
                 return
             
-            # Sort by timestamp, oldest first
-            sorted_files = sorted(
-                self.screenshots_metadata.items(),
-                key=lambda x: x[1]["timestamp"]
-            )
-            
-            # Remove oldest files
-            files_to_remove = len(sorted_files) - self.max_stored
-            for i in range(files_to_remove):
-                filename = sorted_files[i][0]
-                filepath = self.storage_dir / filename
+            # The catalog drops the oldest captures first
+            removed = self.catalog.prune(self.max_stored)
+            for capture in removed:
+                filepath = self.storage_dir / capture.name
                 
                 if filepath.exists():
                     filepath.unlink()
                 
-                del self.screenshots_metadata[filename]
+                self._forget_screenshot(capture.name)
             
-            if files_to_remove > 0:
-                self._save_metadata()
-                logger.info(f"Cleaned up {files_to_remove} old screenshots")
+            if removed:
+                logger.info(f"Cleaned up {len(removed)} old screenshots")
                 
         except Exception as e:
             logger.error(f"Error during cleanup: {e}")
@@ -13,6 +13,7 @@ from ..capture.screenshot import ScreenshotCapture
 from ..analysis.visual_analysis import VisualAnalyzer
 from ..analysis.content_validation import ContentValidator
 from .utils import load_config, validate_config, setup_logging, ensure_directory
+from .trace import get_tracer
 
 import logging
 
@@ -78,7 +79,8 @@ class UXTester:
         Returns:
             Tuple of (filepath, metadata)
         """
-        return self.screenshot_capture.capture_screenshot(label)
+        with get_tracer().span("capture_screenshot", "capture", label=label):
+            return self.screenshot_capture.capture_screenshot(label)
     
     def capture_before(self, expected_content: Optional[str] = None) -> Tuple[Path, Dict[str, Any]]:
         """
@@ -90,7 +92,8 @@ class UXTester:
         Returns:
             Tuple of (filepath, metadata)
         """
-        return self.screenshot_capture.capture_before(expected_content)
+        with get_tracer().span("capture_before", "capture"):
+            return self.screenshot_capture.capture_before(expected_content)
     
     def capture_after(self, expected_content: Optional[str] = None) -> Tuple[Path, Dict[str, Any]]:
         """
@@ -102,7 +105,8 @@ class UXTester:
         Returns:
             Tuple of (filepath, metadata)
         """
-        return self.screenshot_capture.capture_after(expected_content)
+        with get_tracer().span("capture_after", "capture"):
+            return self.screenshot_capture.capture_after(expected_content)
     
     def analyze_screenshots(self, before_path: Optional[Path] = None, after_path: Optional[Path] = None) -> Dict[str, Any]:
         """
@@ -134,7 +138,8 @@ class UXTester:
         logger.info(f"Analyzing: {before_path.name} -> {after_path.name}")
         
         # Perform visual analysis
-        analysis = self.visual_analyzer.analyze_screenshots(before_path, after_path)
+        with get_tracer().span("visual_analysis", "analysis"):
+            analysis = self.visual_analyzer.analyze_screenshots(before_path, after_path)
         
         # Add content validation if enabled and expected content is available
         if self.content_validator:
@@ -146,7 +151,8 @@ class UXTester:
             
             if expected_content:
                 logger.info("Performing AI content validation")
-                content_validation = self.content_validator.validate_content(after_path, expected_content)
+                with get_tracer().span("content_validation", "encode"):
+                    content_validation = self.content_validator.validate_content(after_path, expected_content)
                 analysis['results']['content_validation'] = content_validation
             else:
                 logger.debug("No expected content specified, skipping AI validation")
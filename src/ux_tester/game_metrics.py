@@ -0,0 +1,366 @@
+"""
+Reader for the per-frame metrics stream published by the C++ test game.
+
+The game (see ux_game/metrics_shm.h) writes one 64-byte slot per frame into a
+shared-memory ring guarded by per-slot sequence counters (seqlock). This module
+maps the same segment read-only and copies completed slots out, so frame-level
+metrics reach the harness without any syscalls per sample.
+"""
+import json
+import mmap
+import os
+import statistics
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+from typing import Dict, Any, List, Optional, Sequence
+import logging
+
+logger = logging.getLogger(__name__)
+
+DEFAULT_SEGMENT_NAME = "ux_game_metrics"
+
+METRICS_MAGIC = 0x534D5855  # "UXMS"
+METRICS_VERSION = 1
+
+# Must match MetricsHeader / MetricsSlot in ux_game/metrics_shm.h
+HEADER_STRUCT = struct.Struct("<IIIIQQI28x")
+SLOT_STRUCT = struct.Struct("<IIQQfffIIIiiIf")
+SLOT_SEQ_STRUCT = struct.Struct("<I")
+HEAD_OFFSET = 16
+
+STATE_NAMES = {0: 'menu', 1: 'playing', 2: 'settings', 3: 'game_over'}
+
+# How often a slot that is being rewritten is retried before giving up on it
+MAX_READ_RETRIES = 8
+
+
+class GameMetricsReader:
+    """
+    Attaches to the game's shared-memory metrics ring and reads new frames.
+
+    The reader never blocks the game: slots that are overwritten before they
+    are read are counted in ``dropped_samples`` instead of stalling the writer.
+    """
+
+    def __init__(self, name: str = DEFAULT_SEGMENT_NAME, path: Optional[Path] = None):
+        """
+        Initialize the reader.
+
+        Args:
+            name: Shared-memory segment name (UX_GAME_METRICS_SHM in the game)
+            path: Explicit file backing the segment (defaults to /dev/shm/<name>)
+        """
+        self.name = name.lstrip('/')
+        self.path = Path(path) if path else None
+        self.slot_count = 0
+        self.start_time_ns = 0
+        self.writer_pid = 0
+        self.next_frame = 0
+        self.dropped_samples = 0
+        self._map: Optional[mmap.mmap] = None
+
+    @property
+    def attached(self) -> bool:
+        """Whether the reader is currently mapped to a segment."""
+        return self._map is not None
+
+    def attach(self) -> bool:
+        """
+        Map the metrics segment.
+
+        Returns:
+            True if a valid segment was found and mapped
+        """
+        if self._map is not None:
+            return True
+
+        try:
+            if self.path is None and sys.platform == 'win32':
+                shm = mmap.mmap(-1, HEADER_STRUCT.size, tagname=self.name, access=mmap.ACCESS_READ)
+                slot_count = HEADER_STRUCT.unpack_from(shm, 0)[2]
+                shm.close()
+                size = HEADER_STRUCT.size + slot_count * SLOT_STRUCT.size
+                shm = mmap.mmap(-1, size, tagname=self.name, access=mmap.ACCESS_READ)
+            else:
+                path = self.path or Path('/dev/shm') / self.name
+                fd = os.open(path, os.O_RDONLY)
+                try:
+                    shm = mmap.mmap(fd, 0, access=mmap.ACCESS_READ)
+                finally:
+                    os.close(fd)
+        except (OSError, ValueError) as e:
+            logger.debug(f"Game metrics segment '{self.name}' not available: {e}")
+            return False
+
+        magic, version, slot_count, slot_size, head, start_ns, pid = HEADER_STRUCT.unpack_from(shm, 0)
+        if magic != METRICS_MAGIC or version != METRICS_VERSION or slot_size != SLOT_STRUCT.size:
+            logger.warning(f"Ignoring game metrics segment '{self.name}': unexpected layout "
+                           f"(magic={magic:#x}, version={version}, slot_size={slot_size})")
+            shm.close()
+            return False
+        if len(shm) < HEADER_STRUCT.size + slot_count * SLOT_STRUCT.size:
+            logger.warning(f"Ignoring game metrics segment '{self.name}': truncated")
+            shm.close()
+            return False
+
+        self._map = shm
+        self.slot_count = slot_count
+        self.start_time_ns = start_ns
+        self.writer_pid = pid
+        # Start with the frames still in the ring, then follow new ones as they are published
+        self.next_frame = max(0, head - slot_count)
+        self.dropped_samples = 0
+
+        logger.info(f"Attached to game metrics '{self.name}' ({slot_count} slots, writer pid {pid})")
+        return True
+
+    def close(self) -> None:
+        """Unmap the segment."""
+        if self._map is not None:
+            self._map.close()
+            self._map = None
+
+    def head(self) -> int:
+        """Number of frames the game has published so far."""
+        if self._map is None:
+            return 0
+        return struct.unpack_from("<Q", self._map, HEAD_OFFSET)[0]
+
+    def read_new(self, max_frames: Optional[int] = None) -> List[Dict[str, Any]]:
+        """
+        Read all frames published since the previous call.
+
+        Args:
+            max_frames: Optional cap on the number of frames returned
+
+        Returns:
+            List of frame dictionaries in publication order
+        """
+        if self._map is None:
+            return []
+
+        head = self.head()
+        oldest = max(0, head - self.slot_count)
+        if self.next_frame < oldest:
+            self.dropped_samples += oldest - self.next_frame
+            self.next_frame = oldest
+
+        end = head if max_frames is None else min(head, self.next_frame + max_frames)
+        frames = []
+        for index in range(self.next_frame, end):
+            frame = self._read_slot(index)
+            if frame is None:
+                self.dropped_samples += 1
+            else:
+                frames.append(frame)
+        self.next_frame = end
+        return frames
+
+    def latest(self) -> Optional[Dict[str, Any]]:
+        """
+        Read the most recently published frame without advancing the cursor.
+
+        Returns:
+            Frame dictionary, or None if nothing has been published
+        """
+        head = self.head()
+        if head == 0:
+            return None
+        return self._read_slot(head - 1)
+
+    def _read_slot(self, index: int) -> Optional[Dict[str, Any]]:
+        """Copy one slot out under the seqlock; None if it was overwritten."""
+        offset = HEADER_STRUCT.size + (index % self.slot_count) * SLOT_STRUCT.size
+        for _ in range(MAX_READ_RETRIES):
+            seq_before = SLOT_SEQ_STRUCT.unpack_from(self._map, offset)[0]
+            if seq_before & 1:
+                continue
+            values = SLOT_STRUCT.unpack_from(self._map, offset)
+            if values[0] != seq_before or SLOT_SEQ_STRUCT.unpack_from(self._map, offset)[0] != seq_before:
+                continue
+            if values[2] != index:
+                # Slot already holds a newer (or not yet written) frame
+                return None
+            return self._to_dict(values)
+        return None
+
+    def _to_dict(self, values: tuple) -> Dict[str, Any]:
+        (_, state, frame_index, timestamp_ns, frame_ms, update_ms, render_ms,
+         entity_count, allocations, allocation_bytes, score, lives,
+         audit_violations, min_contrast) = values
+        return {
+            'frame_index': frame_index,
+            'timestamp_s': timestamp_ns / 1e9,
+            'state': STATE_NAMES.get(state, str(state)),
+            'frame_ms': frame_ms,
+            'update_ms': update_ms,
+            'render_ms': render_ms,
+            'entity_count': entity_count,
+            'allocations': allocations,
+            'allocation_bytes': allocation_bytes,
+            'score': score,
+            'lives': lives,
+            'audit_violations': audit_violations,
+            'min_contrast': min_contrast
+        }
+
+    def __enter__(self) -> 'GameMetricsReader':
+        self.attach()
+        return self
+
+    def __exit__(self, exc_type, exc, tb) -> None:
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+
+def summarize_frames(frames: List[Dict[str, Any]]) -> Dict[str, Any]:
+    """
+    Summarize a list of game frames.
+
+    Args:
+        frames: Frames as returned by GameMetricsReader.read_new
+
+    Returns:
+        Frame time percentiles, FPS and allocation totals
+    """
+    if not frames:
+        return {'message': 'No game frames recorded'}
+
+    frame_times = sorted(f['frame_ms'] for f in frames)
+
+    def percentile(p: float) -> float:
+        return frame_times[min(len(frame_times) - 1, int(p / 100.0 * len(frame_times)))]
+
+    avg_ms = sum(frame_times) / len(frame_times)
+    contrasts = [f['min_contrast'] for f in frames if f.get('min_contrast')]
+    summary = {
+        'frames': len(frames),
+        'avg_fps': 1000.0 / avg_ms if avg_ms > 0 else 0.0,
+        'frame_ms': {
+            'min': frame_times[0],
+            'p50': percentile(50),
+            'p95': percentile(95),
+            'p99': percentile(99),
+            'max': frame_times[-1],
+            'avg': avg_ms
+        },
+        'avg_update_ms': sum(f['update_ms'] for f in frames) / len(frames),
+        'avg_render_ms': sum(f['render_ms'] for f in frames) / len(frames),
+        'max_entities': max(f['entity_count'] for f in frames),
+        'total_allocations': sum(f['allocations'] for f in frames),
+        'frames_with_allocations': sum(1 for f in frames if f['allocations'])
+    }
+    if contrasts:
+        summary['audit'] = {
+            'frames_with_violations': sum(1 for f in frames if f.get('audit_violations')),
+            'max_violations': max(f.get('audit_violations', 0) for f in frames),
+            'min_contrast': min(contrasts)
+        }
+    return summary
+
+
+def load_audit_log(path: Path) -> List[Dict[str, Any]]:
+    """
+    Load the in-engine accessibility audit written by the game (UX_GAME_AUDIT).
+
+    The game appends one JSON object each time the audited frame changes: text
+    runs with their WCAG contrast ratio against the pixels under them, and click
+    targets with their size in screen pixels.
+
+    Args:
+        path: JSONL file written by the game
+
+    Returns:
+        Audit records in frame order; failing checks have "pass": false
+    """
+    records = []
+    try:
+        with open(path, 'r', encoding='utf-8') as f:
+            for line in f:
+                line = line.strip()
+                if line:
+                    records.append(json.loads(line))
+    except (OSError, ValueError) as e:
+        logger.error(f"Failed to read audit log {path}: {e}")
+    return records
+
+
+def audit_failures(records: List[Dict[str, Any]]) -> List[Dict[str, Any]]:
+    """
+    Distinct failing widgets across an audit log.
+
+    Args:
+        records: Records from load_audit_log
+
+    Returns:
+        One entry per (state, kind, text) that failed, with its lowest value
+    """
+    failures: Dict[tuple, Dict[str, Any]] = {}
+    for record in records:
+        for kind, key in (('text', 'contrast'), ('targets', 'min_side_px')):
+            for item in record.get(kind, []):
+                if item.get('pass', True):
+                    continue
+                ident = (record.get('state'), kind, item.get('text'))
+                entry = failures.setdefault(ident, {
+                    'state': record.get('state'), 'kind': 'contrast' if kind == 'text' else 'target_size',
+                    'text': item.get('text'), 'bounds': item.get('bounds'), 'value': item[key],
+                    'first_frame': record.get('frame')
+                })
+                entry['value'] = min(entry['value'], item[key])
+    return list(failures.values())
+
+
+def measure_startup(command: Sequence[str], runs: int = 5, timeout: float = 30.0) -> Dict[str, Any]:
+    """
+    Measure game startup by relaunching it with --startup-trace.
+
+    The game is started with --exit-after-first-frame so each run ends as soon
+    as the first frame is out. Add --headless to the command to measure the
+    path that skips window and GL setup.
+
+    Args:
+        command: Game command line, e.g. ["./ux_test_game", "--headless"]
+        runs: Number of launches
+        timeout: Per-launch timeout in seconds
+
+    Returns:
+        Median wall-clock launch time, time-to-first-frame and per-step deltas
+    """
+    wall_ms: List[float] = []
+    ttff_ms: List[float] = []
+    step_deltas: Dict[str, List[float]] = {}
+
+    with tempfile.TemporaryDirectory() as tmp:
+        trace_path = Path(tmp) / "startup.json"
+        for _ in range(runs):
+            start = time.perf_counter()
+            try:
+                subprocess.run(list(command) + [f"--startup-trace={trace_path}", "--exit-after-first-frame"],
+                               timeout=timeout, check=True, capture_output=True)
+                elapsed = (time.perf_counter() - start) * 1000
+                report = json.loads(trace_path.read_text())
+            except (OSError, subprocess.SubprocessError, ValueError) as e:
+                logger.error(f"Startup measurement failed: {e}")
+                continue
+
+            wall_ms.append(elapsed)
+            ttff_ms.append(report['time_to_first_frame_ms'])
+            for step in report['steps']:
+                step_deltas.setdefault(step['step'], []).append(step['delta_ms'])
+
+    if not wall_ms:
+        return {'runs': 0, 'error': 'No successful launches'}
+
+    return {
+        'runs': len(wall_ms),
+        'launch_to_exit_ms': statistics.median(wall_ms),
+        'time_to_first_frame_ms': statistics.median(ttff_ms),
+        'steps_ms': {name: statistics.median(values) for name, values in step_deltas.items()}
+    }
@@ -12,6 +12,8 @@ from pathlib import Path
 import json
 import logging
 
+from .game_metrics import GameMetricsReader, summarize_frames
+
 logger = logging.getLogger(__name__)
 
 
@@ -35,6 +37,10 @@ class PerformanceMetrics:
         self.current_operation: Optional[Dict[str, Any]] = None
         self.system_monitoring = False
         self.system_stats: List[Dict[str, Any]] = []
+        self.game_reader: Optional[GameMetricsReader] = None
+        self.game_frames: List[Dict[str, Any]] = []
+        # Guards game_reader/game_frames, which the monitoring thread also uses
+        self._game_lock = threading.RLock()
         
     def start_operation(self, operation_name: str, metadata: Optional[Dict[str, Any]] = None) -> str:
         """
@@ -157,6 +163,7 @@ class PerformanceMetrics:
             while self.system_monitoring:
                 stats = self._get_system_stats()
                 self.system_stats.append(stats)
+                self.collect_game_frames()
                 time.sleep(interval)
         
         self.monitor_thread = threading.Thread(target=monitor, daemon=True)
@@ -182,6 +189,67 @@ class PerformanceMetrics:
         logger.info(f"Stopped system monitoring ({len(self.system_stats)} measurements)")
         return self.system_stats.copy()
     
+    def attach_game_metrics(self, name: str = "ux_game_metrics", path: Optional[Path] = None) -> bool:
+        """
+        Attach to the game's shared-memory frame metrics stream.
+        
+        Args:
+            name: Segment name the game was started with (UX_GAME_METRICS_SHM)
+            path: Optional explicit file backing the segment
+            
+        Returns:
+            True if the stream was found
+        """
+        reader = GameMetricsReader(name, path)
+        if not reader.attach():
+            logger.warning(f"Game metrics stream '{name}' not found")
+            return False
+        
+        with self._game_lock:
+            self.detach_game_metrics()
+            self.game_reader = reader
+            self.game_frames = []
+        return True
+    
+    def detach_game_metrics(self) -> None:
+        """Drain and close the game metrics stream, if attached."""
+        with self._game_lock:
+            if self.game_reader:
+                self.collect_game_frames()
+                self.game_reader.close()
+                self.game_reader = None
+    
+    def collect_game_frames(self) -> List[Dict[str, Any]]:
+        """
+        Pull frames published by the game since the last call.
+        
+        Called from the system monitoring thread; can also be called directly
+        around operations for tighter correlation.
+        
+        Returns:
+            Newly collected frames
+        """
+        with self._game_lock:
+            if not self.game_reader:
+                return []
+            
+            frames = self.game_reader.read_new()
+            self.game_frames.extend(frames)
+            return frames
+    
+    def get_game_frame_summary(self) -> Dict[str, Any]:
+        """
+        Summarize game frame metrics collected so far.
+        
+        Returns:
+            Frame time percentiles, FPS, allocation counts and dropped samples
+        """
+        with self._game_lock:
+            summary = summarize_frames(self.game_frames)
+            if self.game_reader:
+                summary['dropped_samples'] = self.game_reader.dropped_samples
+            return summary
+    
     def get_summary(self) -> Dict[str, Any]:
         """
         Get summary of all performance measurements.
@@ -190,10 +258,13 @@ class PerformanceMetrics:
             Performance summary statistics
         """
         if not self.measurements:
-            return {
+            summary = {
                 'total_operations': 0,
                 'message': 'No performance measurements recorded'
             }
+            if self.game_frames:
+                summary['game_frames'] = self.get_game_frame_summary()
+            return summary
         
         durations = [m['duration_ms'] for m in self.measurements]
         
@@ -210,6 +281,9 @@ class PerformanceMetrics:
             'measurements': self.measurements
         }
         
+        if self.game_frames:
+            summary['game_frames'] = self.get_game_frame_summary()
+        
         return summary
     
     def export_metrics(self, output_path: Path) -> None:
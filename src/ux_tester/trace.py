@@ -0,0 +1,163 @@
+"""
+Timeline tracing for UX test sessions.
+
+Records begin/end spans, instant events and counters from the harness into
+per-thread buffers and exports them as a Chrome JSON trace that opens in
+chrome://tracing or ui.perfetto.dev. Traces written by the C++ game
+(UX_GAME_TRACE, see ux_game/trace.h) use the same monotonic clock and can be
+merged into the export, so game frames and harness jobs share one timeline.
+"""
+import json
+import os
+import threading
+import time
+from contextlib import contextmanager
+from pathlib import Path
+from typing import Dict, Any, Iterator, List, Optional, Union
+import logging
+
+logger = logging.getLogger(__name__)
+
+
+class TraceRecorder:
+    """
+    Collects trace events from any number of threads.
+
+    Each thread appends to its own list, so recording never contends on a
+    lock; the registry lock is only taken when a thread records its first
+    event and when the trace is exported. Recording is a no-op while disabled.
+    """
+
+    def __init__(self, enabled: bool = False):
+        """
+        Initialize the recorder.
+
+        Args:
+            enabled: Whether events are recorded from the start
+        """
+        self.enabled = enabled
+        self._local = threading.local()
+        self._lock = threading.Lock()
+        self._buffers: List[Dict[str, Any]] = []
+
+    def enable(self, enabled: bool = True) -> None:
+        """Turn recording on or off."""
+        self.enabled = enabled
+
+    def clear(self) -> None:
+        """Drop all recorded events."""
+        with self._lock:
+            for buffer in self._buffers:
+                buffer['events'].clear()
+
+    def _buffer(self) -> List[tuple]:
+        buffer = getattr(self._local, 'buffer', None)
+        if buffer is None:
+            thread = threading.current_thread()
+            buffer = {'tid': threading.get_native_id(), 'name': thread.name, 'events': []}
+            with self._lock:
+                self._buffers.append(buffer)
+            self._local.buffer = buffer
+        return buffer['events']
+
+    def _record(self, phase: str, name: str, category: str, args: Optional[Dict[str, Any]]) -> None:
+        if self.enabled:
+            self._buffer().append((phase, name, category, time.monotonic_ns(), args))
+
+    def begin(self, name: str, category: str = "harness", **args) -> None:
+        """Open a span on the calling thread."""
+        self._record('B', name, category, args or None)
+
+    def end(self, name: str, category: str = "harness", **args) -> None:
+        """Close the most recent span on the calling thread."""
+        self._record('E', name, category, args or None)
+
+    def instant(self, name: str, category: str = "harness", **args) -> None:
+        """Record a point-in-time event, e.g. a state transition."""
+        self._record('i', name, category, args or None)
+
+    def counter(self, name: str, value: float, category: str = "harness") -> None:
+        """Record a counter sample."""
+        self._record('C', name, category, {'value': value})
+
+    @contextmanager
+    def span(self, name: str, category: str = "harness", **args) -> Iterator[None]:
+        """
+        Record a begin/end pair around a block.
+
+        Args:
+            name: Span name
+            category: Event category (capture, encode, analysis, ...)
+            **args: Extra arguments shown in the viewer
+        """
+        self.begin(name, category, **args)
+        try:
+            yield
+        finally:
+            self.end(name, category)
+
+    def events(self) -> List[Dict[str, Any]]:
+        """
+        Get all recorded events in Chrome trace format.
+
+        Returns:
+            List of trace event dictionaries
+        """
+        pid = os.getpid()
+        trace_events = []
+        with self._lock:
+            buffers = [(b['tid'], b['name'], list(b['events'])) for b in self._buffers]
+
+        for tid, thread_name, events in buffers:
+            trace_events.append({'ph': 'M', 'name': 'thread_name', 'pid': pid, 'tid': tid,
+                                 'args': {'name': thread_name}})
+            for phase, name, category, ts_ns, args in events:
+                event = {'ph': phase, 'name': name, 'cat': category,
+                         'ts': ts_ns / 1000.0, 'pid': pid, 'tid': tid}
+                if phase == 'i':
+                    event['s'] = 't'
+                if args:
+                    event['args'] = args
+                trace_events.append(event)
+        return trace_events
+
+    def export_chrome_json(self, output_path: Union[str, Path],
+                           merge_traces: Optional[List[Union[str, Path]]] = None) -> bool:
+        """
+        Write recorded events as a Chrome JSON trace.
+
+        Args:
+            output_path: Path of the trace file to write
+            merge_traces: Other Chrome JSON traces (e.g. the game's) to include
+
+        Returns:
+            True if the trace was written
+        """
+        trace_events = self.events()
+        trace_events.append({'ph': 'M', 'name': 'process_name', 'pid': os.getpid(),
+                             'args': {'name': 'ux-mirror harness'}})
+
+        for path in merge_traces or []:
+            try:
+                with open(path, 'r') as f:
+                    data = json.load(f)
+                trace_events.extend(data['traceEvents'] if isinstance(data, dict) else data)
+            except (OSError, ValueError, KeyError) as e:
+                logger.warning(f"Could not merge trace {path}: {e}")
+
+        try:
+            with open(output_path, 'w') as f:
+                json.dump({'displayTimeUnit': 'ms', 'traceEvents': trace_events}, f)
+            logger.info(f"Trace exported to: {output_path} ({len(trace_events)} events)")
+            return True
+        except Exception as e:
+            logger.error(f"Failed to export trace: {e}")
+            return False
+
+
+_tracer = TraceRecorder(enabled=bool(os.environ.get('UX_TRACE')))
+
+
+def get_tracer() -> TraceRecorder:
+    """Get the process-wide trace recorder (enabled by the UX_TRACE env var)."""
+    return _tracer
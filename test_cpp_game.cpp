@@ -1,371 +1,459 @@
 #define OLC_PGE_APPLICATION
 #include "pixel_game_engine/olcPixelGameEngine.h"
 
-#include <vector>
-#include <string>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
 #include <random>
+#include <string>
+#include <vector>
+
+#define UX_ALLOC_COUNTER_IMPLEMENTATION
+#include "ux_game/alloc_counter.h"
+#include "ux_game/cvd.h"
+#include "ux_game/game.h"
+#include "ux_game/image_io.h"
+#include "ux_game/input.h"
+#include "ux_game/metrics_shm.h"
+#include "ux_game/raster.h"
+#include "ux_game/resolution.h"
+#include "ux_game/startup.h"
+#include "ux_game/trace.h"
+#include "ux_game/ui_audit.h"
+
+// Startup timeline origin is taken here, during static initialization
+static ux::StartupTrace& startupTrace = ux::StartupTrace::Get();
+
+struct LaunchOptions {
+    int32_t width = 640;            // framebuffer size; the UI scales with it
+    int32_t height = 480;
+    int32_t pixelScale = 2;         // window pixels per framebuffer pixel
+    bool headless = false;          // skip window and GL setup entirely
+    int frames = 600;               // headless frames to run when no replay is given
+    std::string replayPath;         // headless input source
+    std::string dumpFramePath;      // headless: write the last frame as BMP
+    bool exitAfterFirstFrame = false;
+    std::vector<ux::Cvd> cvd;       // colour-vision-deficiency variants (window: one)
+    std::vector<ux::TargetSpec> targets; // headless: extra resolutions rendered from the same frame
+};
+
+// Per-frame instrumentation shared by the windowed and headless front ends
+class FrameHooks {
+public:
+    void Init(int32_t width, int32_t height, uint32_t seed, int32_t pixelScale)
+    {
+        if (const char* name = std::getenv("UX_GAME_METRICS_SHM")) {
+            metrics.Open(*name ? name : ux::kDefaultMetricsName);
+        }
+        if (const char* path = std::getenv("UX_GAME_TRACE")) {
+            tracePath = *path ? path : "ux_game_trace.json";
+            ux::trace::Enable();
+            ux::trace::SetThreadName("game");
+        }
+        if (const char* path = std::getenv("UX_GAME_RECORD")) {
+            recorder.Open(*path ? path : "ux_game_recording.uxr", width, height, seed);
+        }
+        if (const char* path = std::getenv("UX_GAME_AUDIT")) {
+            const char* configPath = std::getenv("UX_GAME_AUDIT_CONFIG");
+            ux::LoadAuditConfig(configPath ? configPath : "game_ux_config.json", auditConfig);
+            auditConfig.pixelScale = pixelScale;
+            auditLog = std::fopen(*path ? path : "ux_game_audit.jsonl", "w");
+        }
+    }
+
+    // Every frame is also drawn into these, in parallel with the main canvas
+    void SetRenderTargets(std::vector<ux::Game::RenderTarget>* targets)
+    {
+        renderTargets = targets;
+        if (targets && !targets->empty() && !pool) pool = std::make_unique<ux::WorkerPool>();
+    }
+
+    void RunFrame(ux::Game& game, const ux::InputFrame& input, const ux::Canvas& canvas)
+    {
+        using Clock = std::chrono::steady_clock;
+        const uint64_t allocsBefore = ux::AllocationCount();
+        const uint64_t bytesBefore = ux::AllocationBytes();
+        const auto t0 = Clock::now();
+        const ux::Game::State previousState = game.GetState();
+        ux::trace::Begin("frame");
+        ux::trace::Begin("update");
+
+        recorder.Write(input);
+        game.Update(input);
+
+        const auto t1 = Clock::now();
+        ux::trace::End("update");
+        if (game.GetState() != previousState) {
+            ux::trace::Instant(ux::Game::kStateNames[game.GetState()], "state", previousState);
+        }
+
+        ux::trace::Begin("render");
+        game.SetUiRecorder(auditLog ? &uiRecord : nullptr);
+        if (renderTargets && !renderTargets->empty()) game.Render(canvas, renderCache, *renderTargets, *pool);
+        else game.Render(canvas, renderCache);
+        const auto t2 = Clock::now();
+        ux::trace::End("render");
+
+        // The audit only reruns when the frame was actually redrawn
+        if (auditLog && uiRecord.generation != auditReport.generation) {
+            UX_TRACE_SCOPE("audit");
+            ux::AuditFrame(canvas, uiRecord, auditConfig, auditReport);
+            ux::WriteAuditJsonLine(auditLog, frameIndex, ux::Game::kStateNames[game.GetState()],
+                                   auditReport, auditConfig);
+        }
+        frameIndex++;
+
+        if (metrics.IsOpen()) {
+            using Ms = std::chrono::duration<float, std::milli>;
+            ux::FrameSample sample;
+            sample.state = uint32_t(game.GetState());
+            sample.frameMs = input.dt * 1000.0f;
+            sample.updateMs = Ms(t1 - t0).count();
+            sample.renderMs = Ms(t2 - t1).count();
+            sample.entityCount = uint32_t(game.EntityCount());
+            sample.allocations = uint32_t(ux::AllocationCount() - allocsBefore);
+            sample.allocationBytes = uint32_t(ux::AllocationBytes() - bytesBefore);
+            sample.score = game.Score();
+            sample.lives = game.Lives();
+            sample.auditViolations = auditReport.violations;
+            sample.minContrast = auditReport.minContrast;
+            metrics.Publish(sample);
+        }
+
+        ux::trace::Counter("frame_us", int64_t(input.dt * 1e6f));
+        ux::trace::Counter("entities", int64_t(game.EntityCount()));
+        if (auditLog) ux::trace::Counter("audit_violations", int64_t(auditReport.violations));
+        ux::trace::End("frame");
+    }
+
+    void Shutdown()
+    {
+        recorder.Close();
+        if (auditLog) {
+            std::fclose(auditLog);
+            auditLog = nullptr;
+        }
+        if (!tracePath.empty()) {
+            ux::trace::WriteChromeJson(tracePath);
+        }
+    }
+
+private:
+    // Both front ends keep their framebuffer between frames
+    ux::Game::RenderCache renderCache;
+
+    // Multi-resolution rendering of each frame (headless --targets)
+    std::vector<ux::Game::RenderTarget>* renderTargets = nullptr;
+    std::unique_ptr<ux::WorkerPool> pool;
+
+    // Per-frame metrics for the test harness (enabled by UX_GAME_METRICS_SHM)
+    ux::MetricsPublisher metrics;
+
+    // Chrome JSON timeline written on exit (enabled by UX_GAME_TRACE=<path>)
+    std::string tracePath;
+
+    // Input recording for headless replays (enabled by UX_GAME_RECORD=<path>)
+    ux::ReplayWriter recorder;
 
-// Simple C++ Game for UX Testing
-// Features: Menu system, HUD, buttons, score display, settings
+    // WCAG contrast / target size audit, one JSON line per redrawn frame
+    // (enabled by UX_GAME_AUDIT=<path>, thresholds from game_ux_config.json)
+    FILE* auditLog = nullptr;
+    ux::AuditConfig auditConfig;
+    ux::UiRecord uiRecord;
+    ux::AuditReport auditReport;
+    uint64_t frameIndex = 0;
+};
+
+// Windowed front end for the UX test game: olc::PixelGameEngine supplies input
+// and the draw target, the game itself lives in ux_game/game.cpp.
 class UXTestGame : public olc::PixelGameEngine
 {
 public:
-    UXTestGame()
+    explicit UXTestGame(const LaunchOptions& options) : options(options)
     {
         sAppName = "UX Test Game - C++ Edition";
     }
 
 private:
-    enum GameState {
-        MENU,
-        PLAYING,
-        SETTINGS,
-        GAME_OVER
-    };
-
-    GameState currentState = MENU;
-    
-    // Game variables
-    float playerX = 50.0f, playerY = 50.0f;
-    float playerSpeed = 100.0f;
-    int score = 0;
-    int lives = 3;
-    float gameTime = 0.0f;
-    
-    // Menu variables
-    int selectedMenuItem = 0;
-    std::vector<std::string> menuItems = {"Start Game", "Settings", "Exit"};
-    
-    // Settings variables
-    int volume = 50;
-    bool fullscreen = false;
-    int difficulty = 1; // 0=Easy, 1=Medium, 2=Hard
-    
-    // Enemies
-    struct Enemy {
-        float x, y;
-        float dx, dy;
-        int health;
-        olc::Pixel color;
-    };
-    std::vector<Enemy> enemies;
-    
-    // UI Button structure
-    struct Button {
-        float x, y, w, h;
-        std::string text;
-        olc::Pixel color;
-        bool enabled;
-        
-        bool IsClicked(float mouseX, float mouseY) {
-            return mouseX >= x && mouseX <= x + w && 
-                   mouseY >= y && mouseY <= y + h && enabled;
-        }
-    };
-    
-    std::vector<Button> menuButtons;
-    std::vector<Button> settingsButtons;
-    
-    // Random engine
-    std::random_device rd;
-    std::mt19937 gen{rd()};
+    const LaunchOptions& options;
+    std::unique_ptr<ux::Game> game;
+    FrameHooks hooks;
+    std::vector<uint32_t> offscreen;  // game frame before the CVD pass
+    uint64_t frameCount = 0;
 
 public:
     bool OnUserCreate() override
     {
-        // Initialize menu buttons
-        menuButtons.clear();
-        menuButtons.push_back({50, 100, 150, 40, "Start Game", olc::GREEN, true});
-        menuButtons.push_back({50, 160, 150, 40, "Settings", olc::BLUE, true});
-        menuButtons.push_back({50, 220, 150, 40, "Exit", olc::RED, true});
-        
-        // Initialize settings buttons
-        settingsButtons.clear();
-        settingsButtons.push_back({50, 100, 100, 30, "Volume -", olc::YELLOW, true});
-        settingsButtons.push_back({160, 100, 100, 30, "Volume +", olc::YELLOW, true});
-        settingsButtons.push_back({50, 150, 200, 30, "Toggle Fullscreen", olc::CYAN, true});
-        settingsButtons.push_back({50, 200, 100, 30, "Easy", olc::GREEN, true});
-        settingsButtons.push_back({160, 200, 100, 30, "Medium", olc::YELLOW, true});
-        settingsButtons.push_back({270, 200, 100, 30, "Hard", olc::RED, true});
-        settingsButtons.push_back({50, 280, 100, 30, "Back", olc::WHITE, true});
-        
+        // Start() has created the window and GL context by the time this runs
+        startupTrace.Mark("window_gl_ready");
+
+        const uint32_t seed = std::random_device{}();
+        game = std::make_unique<ux::Game>(ScreenWidth(), ScreenHeight(), seed);
+        hooks.Init(ScreenWidth(), ScreenHeight(), seed, options.pixelScale);
+        if (!options.cvd.empty()) offscreen.resize(size_t(ScreenWidth()) * ScreenHeight());
+
+        startupTrace.Mark("user_create");
         return true;
     }
 
     bool OnUserUpdate(float fElapsedTime) override
     {
-        gameTime += fElapsedTime;
-        
-        switch (currentState) {
-            case MENU:
-                UpdateMenu(fElapsedTime);
-                break;
-            case PLAYING:
-                UpdateGame(fElapsedTime);
-                break;
-            case SETTINGS:
-                UpdateSettings(fElapsedTime);
-                break;
-            case GAME_OVER:
-                UpdateGameOver(fElapsedTime);
-                break;
+        // The previous frame was presented between the two updates
+        if (frameCount == 1) {
+            startupTrace.FirstFrame("first_frame_presented");
+            if (options.exitAfterFirstFrame) return false;
+        }
+
+        const ux::Canvas target{reinterpret_cast<uint32_t*>(GetDrawTarget()->GetData()),
+                                GetDrawTargetWidth(), GetDrawTargetHeight()};
+        if (options.cvd.empty()) {
+            hooks.RunFrame(*game, PollInput(fElapsedTime), target);
+        } else {
+            // The game draws into its own buffer (the incremental redraw relies on
+            // it), the simulated frame goes to the window as a final pass
+            const ux::Canvas frame{offscreen.data(), target.width, target.height};
+            hooks.RunFrame(*game, PollInput(fElapsedTime), frame);
+            UX_TRACE_SCOPE("cvd");
+            ux::SimulateCvd(frame, target, options.cvd.front());
         }
-        
+
+        if (frameCount == 0) startupTrace.Mark("first_frame_rendered");
+        frameCount++;
         return true;
     }
-    
+
+    bool OnUserDestroy() override
+    {
+        hooks.Shutdown();
+        return true;
+    }
+
 private:
-    void UpdateMenu(float fElapsedTime) {
-        Clear(olc::BLACK);
-        
-        // Draw title
-        DrawString(50, 30, "UX TEST GAME", olc::WHITE, 2);
-        DrawString(50, 50, "C++ Edition with UI Elements", olc::GREY, 1);
-        
-        // Handle input
-        if (GetKey(olc::Key::UP).bPressed && selectedMenuItem > 0) selectedMenuItem--;
-        if (GetKey(olc::Key::DOWN).bPressed && selectedMenuItem < menuItems.size() - 1) selectedMenuItem++;
-        if (GetKey(olc::Key::ENTER).bPressed) {
-            switch (selectedMenuItem) {
-                case 0: // Start Game
-                    currentState = PLAYING;
-                    InitializeGame();
-                    break;
-                case 1: // Settings
-                    currentState = SETTINGS;
-                    break;
-                case 2: // Exit
-                    return;
-            }
-        }
-        
-        // Draw menu buttons with visual feedback
-        for (int i = 0; i < menuButtons.size(); i++) {
-            auto& btn = menuButtons[i];
-            olc::Pixel buttonColor = btn.color;
-            if (i == selectedMenuItem) {
-                buttonColor = olc::WHITE;
-                // Draw selection highlight
-                FillRect(btn.x - 5, btn.y - 5, btn.w + 10, btn.h + 10, olc::DARK_YELLOW);
-            }
-            
-            FillRect(btn.x, btn.y, btn.w, btn.h, buttonColor);
-            DrawRect(btn.x, btn.y, btn.w, btn.h, olc::WHITE);
-            DrawString(btn.x + 10, btn.y + 15, btn.text, olc::BLACK);
+    ux::InputFrame PollInput(float fElapsedTime)
+    {
+        static constexpr struct { olc::Key key; ux::Key bit; } kKeyMap[] = {
+            {olc::Key::UP, ux::KEY_UP}, {olc::Key::DOWN, ux::KEY_DOWN},
+            {olc::Key::LEFT, ux::KEY_LEFT}, {olc::Key::RIGHT, ux::KEY_RIGHT},
+            {olc::Key::W, ux::KEY_W}, {olc::Key::A, ux::KEY_A},
+            {olc::Key::S, ux::KEY_S}, {olc::Key::D, ux::KEY_D},
+            {olc::Key::ENTER, ux::KEY_ENTER}, {olc::Key::SPACE, ux::KEY_SPACE},
+            {olc::Key::ESCAPE, ux::KEY_ESCAPE},
+        };
+
+        ux::InputFrame input;
+        input.dt = fElapsedTime;
+        for (const auto& k : kKeyMap) {
+            olc::HWButton state = GetKey(k.key);
+            if (state.bHeld) input.held |= k.bit;
+            if (state.bPressed) input.pressed |= k.bit;
         }
-        
-        // Mouse interaction
         olc::vi2d mousePos = GetMousePos();
-        if (GetMouse(0).bPressed) {
-            for (int i = 0; i < menuButtons.size(); i++) {
-                if (menuButtons[i].IsClicked(mousePos.x, mousePos.y)) {
-                    selectedMenuItem = i;
-                    // Trigger same action as ENTER key
-                    switch (i) {
-                        case 0: currentState = PLAYING; InitializeGame(); break;
-                        case 1: currentState = SETTINGS; break;
-                        case 2: return;
-                    }
-                }
-            }
-        }
-        
-        // Instructions
-        DrawString(300, 100, "Controls:", olc::GREEN);
-        DrawString(300, 120, "Arrow Keys: Navigate", olc::WHITE);
-        DrawString(300, 140, "Enter: Select", olc::WHITE);
-        DrawString(300, 160, "Mouse: Click buttons", olc::WHITE);
-        DrawString(300, 200, "Game Features:", olc::GREEN);
-        DrawString(300, 220, "- Menu system", olc::WHITE);
-        DrawString(300, 240, "- Settings panel", olc::WHITE);
-        DrawString(300, 260, "- HUD elements", olc::WHITE);
-        DrawString(300, 280, "- Button interactions", olc::WHITE);
+        input.mouseX = mousePos.x;
+        input.mouseY = mousePos.y;
+        input.mousePressed = GetMouse(0).bPressed;
+        return input;
     }
-    
-    void UpdateGame(float fElapsedTime) {
-        Clear(olc::DARK_BLUE);
-        
-        // Player movement
-        if (GetKey(olc::Key::A).bHeld || GetKey(olc::Key::LEFT).bHeld) playerX -= playerSpeed * fElapsedTime;
-        if (GetKey(olc::Key::D).bHeld || GetKey(olc::Key::RIGHT).bHeld) playerX += playerSpeed * fElapsedTime;
-        if (GetKey(olc::Key::W).bHeld || GetKey(olc::Key::UP).bHeld) playerY -= playerSpeed * fElapsedTime;
-        if (GetKey(olc::Key::S).bHeld || GetKey(olc::Key::DOWN).bHeld) playerY += playerSpeed * fElapsedTime;
-        
-        // Keep player in bounds
-        playerX = std::max(10.0f, std::min(playerX, float(ScreenWidth() - 20)));
-        playerY = std::max(50.0f, std::min(playerY, float(ScreenHeight() - 20)));
-        
-        // Spawn enemies
-        if (fmod(gameTime, 2.0f) < fElapsedTime) {
-            std::uniform_real_distribution<float> dis(50, ScreenWidth() - 50);
-            enemies.push_back({dis(gen), 10, 0, 50 + difficulty * 30, 3, olc::RED});
-        }
-        
-        // Update enemies
-        for (auto& enemy : enemies) {
-            enemy.y += enemy.dy * fElapsedTime;
-        }
-        
-        // Remove off-screen enemies and update score
-        enemies.erase(std::remove_if(enemies.begin(), enemies.end(), 
-            [this](const Enemy& e) { 
-                if (e.y > ScreenHeight()) {
-                    score += 10;
-                    return true;
-                }
-                return false;
-            }), enemies.end());
-        
-        // Check collisions
-        for (auto it = enemies.begin(); it != enemies.end();) {
-            float dx = it->x - playerX;
-            float dy = it->y - playerY;
-            if (sqrt(dx*dx + dy*dy) < 20) {
-                lives--;
-                it = enemies.erase(it);
-                if (lives <= 0) {
-                    currentState = GAME_OVER;
-                    return;
-                }
-            } else {
-                ++it;
-            }
-        }
-        
-        // Draw player
-        FillCircle(playerX, playerY, 8, olc::GREEN);
-        DrawCircle(playerX, playerY, 8, olc::WHITE);
-        
-        // Draw enemies
-        for (const auto& enemy : enemies) {
-            FillCircle(enemy.x, enemy.y, 6, enemy.color);
-            DrawCircle(enemy.x, enemy.y, 6, olc::WHITE);
+};
+
+// Path without its extension, for the extra files written next to --dump-frame
+std::string PathStem(const std::string& path)
+{
+    const size_t dot = path.rfind('.');
+    return dot == std::string::npos ? path : path.substr(0, dot);
+}
+
+// Writes the frame, plus one "<stem>_<variant>.bmp" per requested CVD simulation.
+// All three variants come from a single pass over the frame.
+bool DumpFrame(const std::string& path, const ux::Canvas& canvas, const std::vector<ux::Cvd>& cvd)
+{
+    bool ok = ux::WriteBmp(path, canvas);
+    if (!ok) std::fprintf(stderr, "Failed to write frame: %s\n", path.c_str());
+    if (cvd.empty()) return ok;
+
+    const size_t pixels = size_t(canvas.width) * canvas.height;
+    std::vector<uint32_t> buffers(pixels * ux::kCvdCount);
+    ux::Canvas variants[ux::kCvdCount];
+    for (int i = 0; i < ux::kCvdCount; i++) variants[i] = {buffers.data() + pixels * i, canvas.width, canvas.height};
+    if (cvd.size() == 1) {
+        ux::SimulateCvd(canvas, variants[int(cvd.front())], cvd.front());
+    } else {
+        ux::SimulateCvdAll(canvas, variants);
+    }
+
+    const std::string stem = PathStem(path);
+    for (ux::Cvd type : cvd) {
+        const std::string variantPath = stem + "_" + ux::CvdName(type) + ".bmp";
+        if (!ux::WriteBmp(variantPath, variants[int(type)])) {
+            std::fprintf(stderr, "Failed to write frame: %s\n", variantPath.c_str());
+            ok = false;
         }
-        
-        // Draw HUD (this is what we want to analyze and improve)
-        DrawHUD();
-        
-        // Pause/Menu
-        if (GetKey(olc::Key::ESCAPE).bPressed) {
-            currentState = MENU;
+    }
+    return ok;
+}
+
+// Headless front end: no window, no GL context. Runs a replay (or idle frames)
+// into a memory framebuffer, optionally dumping the last frame for analysis.
+int RunHeadless(const LaunchOptions& options)
+{
+    ux::Replay replay;
+    if (!options.replayPath.empty()) {
+        if (!ux::LoadReplay(options.replayPath, replay)) {
+            std::fprintf(stderr, "Failed to load replay: %s\n", options.replayPath.c_str());
+            return 1;
         }
+        startupTrace.Mark("replay_loaded");
+    } else {
+        replay.width = options.width;
+        replay.height = options.height;
+        replay.seed = std::random_device{}();
+        ux::InputFrame idle;
+        idle.dt = 1.0f / 60.0f;
+        replay.frames.assign(size_t(std::max(options.frames, 1)), idle);
+    }
+
+    std::vector<uint32_t> pixels(size_t(replay.width) * replay.height);
+    const ux::Canvas canvas{pixels.data(), replay.width, replay.height};
+    ux::Game game(replay.width, replay.height, replay.seed);
+    FrameHooks hooks;
+    hooks.Init(replay.width, replay.height, replay.seed, options.pixelScale);
+
+    // Extra framebuffers showing the same simulation frame at other resolutions
+    std::vector<std::vector<uint32_t>> targetPixels;
+    std::vector<ux::Game::RenderTarget> targets(options.targets.size());
+    for (size_t i = 0; i < targets.size(); i++) {
+        const ux::TargetSpec& spec = options.targets[i];
+        targetPixels.emplace_back(size_t(spec.width) * spec.height);
+        targets[i].canvas = {targetPixels.back().data(), spec.width, spec.height};
+        targets[i].ui = spec.ui;
     }
-    
-    void UpdateSettings(float fElapsedTime) {
-        Clear(olc::DARK_GREY);
-        
-        // Title
-        DrawString(50, 30, "SETTINGS", olc::WHITE, 2);
-        
-        // Volume setting
-        DrawString(50, 80, "Volume: " + std::to_string(volume) + "%", olc::WHITE);
-        
-        // Fullscreen setting
-        DrawString(50, 130, "Fullscreen: " + std::string(fullscreen ? "ON" : "OFF"), olc::WHITE);
-        
-        // Difficulty setting
-        DrawString(50, 180, "Difficulty:", olc::WHITE);
-        
-        // Draw settings buttons
-        for (int i = 0; i < settingsButtons.size(); i++) {
-            auto& btn = settingsButtons[i];
-            olc::Pixel color = btn.color;
-            
-            // Highlight active difficulty
-            if (i >= 3 && i <= 5 && (i - 3) == difficulty) {
-                color = olc::WHITE;
+    hooks.SetRenderTargets(&targets);
+    startupTrace.Mark("user_create");
+
+    for (const ux::InputFrame& input : replay.frames) {
+        hooks.RunFrame(game, input, canvas);
+        startupTrace.FirstFrame("first_frame_rendered");
+        if (options.exitAfterFirstFrame) break;
+    }
+
+    hooks.Shutdown();
+    if (options.dumpFramePath.empty()) return 0;
+
+    bool ok = DumpFrame(options.dumpFramePath, canvas, options.cvd);
+    const std::string stem = PathStem(options.dumpFramePath);
+    for (size_t i = 0; i < targets.size(); i++) {
+        ok &= DumpFrame(stem + "_" + ux::TargetName(options.targets[i]) + ".bmp", targets[i].canvas, options.cvd);
+    }
+    return ok ? 0 : 1;
+}
+
+void PrintUsage()
+{
+    std::fprintf(stderr,
+        "Usage: ux_test_game [options]\n"
+        "  --resolution WxH           framebuffer size, or 720p/1080p/1440p/4k (default 640x480)\n"
+        "  --scale N                  window pixels per framebuffer pixel (default 2)\n"
+        "  --headless                 run without a window or GL context\n"
+        "  --replay PATH              headless: play a recorded replay (.uxr, uses its resolution)\n"
+        "  --frames N                 headless: idle frames to run without a replay (default 600)\n"
+        "  --dump-frame PATH          headless: write the last frame as a BMP\n"
+        "  --startup-trace[=PATH]     report init step timings and time-to-first-frame as JSON\n"
+        "                             (default: stderr; also UX_GAME_STARTUP_TRACE)\n"
+        "  --exit-after-first-frame   quit once the first frame is out (startup measurement)\n"
+        "  --cvd TYPE[,TYPE...]|all   colour-vision-deficiency simulation: protanopia, deuteranopia,\n"
+        "                             tritanopia. Window: shows one; headless: --dump-frame also\n"
+        "                             writes <stem>_<type>.bmp per variant\n"
+        "  --targets RES[@UI][,...]   headless: also render every frame at these resolutions (optional\n"
+        "                             UI scale), in parallel; --dump-frame writes <stem>_<WxH>.bmp each\n");
+}
+
+bool ParseArgs(int argc, char** argv, LaunchOptions& opts)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : nullptr; };
+        const char* value = nullptr;
+
+        if (arg == "--help" || arg == "-h") {
+            PrintUsage();
+            std::exit(0);
+        } else if ((arg == "--resolution") && (value = next())) {
+            if (!ux::ParseResolution(value, opts.width, opts.height)) {
+                std::fprintf(stderr, "Invalid resolution: %s\n", value);
+                return false;
             }
-            
-            FillRect(btn.x, btn.y, btn.w, btn.h, color);
-            DrawRect(btn.x, btn.y, btn.w, btn.h, olc::BLACK);
-            DrawString(btn.x + 5, btn.y + 10, btn.text, olc::BLACK);
-        }
-        
-        // Mouse interaction
-        olc::vi2d mousePos = GetMousePos();
-        if (GetMouse(0).bPressed) {
-            for (int i = 0; i < settingsButtons.size(); i++) {
-                if (settingsButtons[i].IsClicked(mousePos.x, mousePos.y)) {
-                    switch (i) {
-                        case 0: volume = std::max(0, volume - 10); break;
-                        case 1: volume = std::min(100, volume + 10); break;
-                        case 2: fullscreen = !fullscreen; break;
-                        case 3: difficulty = 0; break;
-                        case 4: difficulty = 1; break;
-                        case 5: difficulty = 2; break;
-                        case 6: currentState = MENU; break;
-                    }
+        } else if ((arg == "--scale") && (value = next())) {
+            opts.pixelScale = std::max(1, std::atoi(value));
+        } else if (arg == "--headless") {
+            opts.headless = true;
+        } else if ((arg == "--replay") && (value = next())) {
+            opts.replayPath = value;
+        } else if ((arg == "--frames") && (value = next())) {
+            opts.frames = std::atoi(value);
+        } else if ((arg == "--dump-frame") && (value = next())) {
+            opts.dumpFramePath = value;
+        } else if (arg == "--startup-trace") {
+            startupTrace.Enable("-");
+        } else if (arg.rfind("--startup-trace=", 0) == 0) {
+            startupTrace.Enable(arg.substr(std::strlen("--startup-trace=")));
+        } else if ((arg == "--cvd") && (value = next())) {
+            opts.cvd.clear();
+            std::string list = value;
+            if (list == "all") list = "protanopia,deuteranopia,tritanopia";
+            for (size_t start = 0; start <= list.size();) {
+                size_t end = std::min(list.find(',', start), list.size());
+                ux::Cvd type;
+                if (!ux::ParseCvd(std::string_view(list).substr(start, end - start), type)) {
+                    std::fprintf(stderr, "Unknown CVD type in: %s\n", value);
+                    return false;
                 }
+                if (std::find(opts.cvd.begin(), opts.cvd.end(), type) == opts.cvd.end()) opts.cvd.push_back(type);
+                start = end + 1;
             }
-        }
-        
-        if (GetKey(olc::Key::ESCAPE).bPressed) {
-            currentState = MENU;
+        } else if ((arg == "--targets") && (value = next())) {
+            if (!ux::ParseTargetSpecs(value, opts.targets)) {
+                std::fprintf(stderr, "Invalid render targets: %s\n", value);
+                return false;
+            }
+        } else if (arg == "--exit-after-first-frame") {
+            opts.exitAfterFirstFrame = true;
+        } else {
+            std::fprintf(stderr, "Unknown or incomplete option: %s\n", arg.c_str());
+            PrintUsage();
+            return false;
         }
     }
-    
-    void UpdateGameOver(float fElapsedTime) {
-        Clear(olc::DARK_RED);
-        
-        DrawString(100, 100, "GAME OVER", olc::WHITE, 3);
-        DrawString(100, 150, "Final Score: " + std::to_string(score), olc::YELLOW, 2);
-        DrawString(100, 200, "Press ENTER to return to menu", olc::WHITE);
-        DrawString(100, 220, "Press SPACE to play again", olc::WHITE);
-        
-        if (GetKey(olc::Key::ENTER).bPressed) {
-            currentState = MENU;
-        }
-        if (GetKey(olc::Key::SPACE).bPressed) {
-            currentState = PLAYING;
-            InitializeGame();
-        }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (const char* path = std::getenv("UX_GAME_STARTUP_TRACE")) {
+        startupTrace.Enable(*path ? path : "-");
     }
-    
-    void DrawHUD() {
-        // HUD Background
-        FillRect(0, 0, ScreenWidth(), 40, olc::DARK_GREY);
-        DrawLine(0, 40, ScreenWidth(), 40, olc::WHITE);
-        
-        // Score
-        DrawString(10, 10, "Score: " + std::to_string(score), olc::YELLOW);
-        
-        // Lives with visual representation
-        DrawString(150, 10, "Lives: ", olc::WHITE);
-        for (int i = 0; i < lives; i++) {
-            FillCircle(200 + i * 20, 20, 5, olc::GREEN);
-        }
-        
-        // Time
-        DrawString(300, 10, "Time: " + std::to_string(int(gameTime)), olc::CYAN);
-        
-        // Mini-map area (example UI element)
-        DrawRect(ScreenWidth() - 120, 10, 100, 80, olc::WHITE);
-        DrawString(ScreenWidth() - 115, 15, "Mini-Map", olc::WHITE);
-        FillCircle(ScreenWidth() - 70, 50, 2, olc::GREEN); // Player dot
-        
-        // Health bar example
-        DrawString(10, ScreenHeight() - 30, "Health:", olc::WHITE);
-        DrawRect(60, ScreenHeight() - 25, 100, 10, olc::WHITE);
-        FillRect(61, ScreenHeight() - 24, lives * 33, 8, olc::GREEN);
-        
-        // Action buttons overlay
-        DrawString(ScreenWidth() - 200, ScreenHeight() - 30, "ESC: Menu", olc::GREY);
+    LaunchOptions options;
+    if (!ParseArgs(argc, argv, options)) return 1;
+    startupTrace.Mark("main");
+
+    if (options.headless) {
+        return RunHeadless(options);
     }
-    
-    void InitializeGame() {
-        playerX = 50.0f;
-        playerY = 100.0f;
-        score = 0;
-        lives = 3;
-        gameTime = 0.0f;
-        enemies.clear();
+
+    if (!options.targets.empty()) {
+        std::fprintf(stderr, "--targets needs --headless\n");
+        return 1;
+    }
+    if (options.cvd.size() > 1) {
+        std::fprintf(stderr, "The window shows one CVD simulation; use --headless --dump-frame for several\n");
+        return 1;
     }
-};
 
-int main()
-{
-    UXTestGame game;
-    if (game.Construct(640, 480, 2, 2))
+    UXTestGame game(options);
+    if (game.Construct(options.width, options.height, options.pixelScale, options.pixelScale)) {
+        startupTrace.Mark("construct");
         game.Start();
+    }
     return 0;
-} 
\ No newline at end of file
+}
@@ -169,7 +169,7 @@ def simulate_cpp_game_analysis():
     print("   2. Modify the DrawHUD() function for HUD improvements")
     print("   3. Update UpdateSettings() for better volume controls")
     print("   4. Adjust button spacing in UpdateMenu()")
-    print("   5. Recompile with: g++ test_cpp_game.cpp -o ux_test_game")
+    print("   5. Recompile with: ./build_game.sh")
     print("   6. Re-run UX-MIRROR analysis to validate improvements")
     
     # 8. Port cleanup
@@ -4,7 +4,10 @@ Unit tests for AI-powered content validation functionality.
 import json
 import base64
 from pathlib import Path
-from unittest.mock import Mock, patch, mock_open
+from unittest.mock import Mock, patch
+
+import cv2
+import numpy as np
 import pytest
 
 from src.analysis.content_validation import ContentValidator
@@ -62,59 +65,45 @@ class TestContentValidator:
         
         assert validator.openai_client is None
     
-    def test_encode_image_base64_success(self):
-        """Test successful image encoding to base64."""
-        test_image_data = b"fake_image_data"
-        expected_base64 = base64.b64encode(test_image_data).decode('utf-8')
-        
-        with patch('builtins.open', mock_open(read_data=test_image_data)):
-            result = self.validator._encode_image_base64(Path("test.png"))
-            assert result == expected_base64
-    
-    def test_encode_image_base64_error(self):
-        """Test image encoding error handling."""
-        with patch('builtins.open', side_effect=FileNotFoundError()):
-            result = self.validator._encode_image_base64(Path("nonexistent.png"))
-            assert result is None
-    
-    @patch('src.analysis.content_validation.Image')
-    def test_resize_image_for_api_no_resize_needed(self, mock_image):
-        """Test image resize when no resize is needed."""
-        mock_img = Mock()
-        mock_img.size = (800, 600)
-        mock_image.open.return_value.__enter__.return_value = mock_img
+    def test_prepare_image_passes_fitting_file_through(self, tmp_path):
+        """Test that a PNG that already fits is sent as its own bytes."""
+        path = tmp_path / "small.png"
+        cv2.imwrite(str(path), np.full((60, 80, 3), 128, dtype=np.uint8))
         
-        result = self.validator._resize_image_for_api(Path("test.png"), max_size=1024)
+        data, media_type = self.validator._prepare_image_for_api(path, max_size=1024)
         
-        assert result == Path("test.png")
-        mock_img.resize.assert_not_called()
+        assert media_type == "image/png"
+        assert base64.b64decode(data) == path.read_bytes()
     
-    @patch('src.analysis.content_validation.Image')
-    def test_resize_image_for_api_resize_needed(self, mock_image):
-        """Test image resize when resize is needed."""
-        mock_img = Mock()
-        mock_img.size = (2048, 1536)
-        mock_resized_img = Mock()
-        mock_img.resize.return_value = mock_resized_img
-        
-        mock_image.open.return_value.__enter__.return_value = mock_img
-        mock_image.Resampling.LANCZOS = "LANCZOS"
-        
-        result = self.validator._resize_image_for_api(Path("test.png"), max_size=1024)
-        
-        # Should resize to maintain aspect ratio
-        mock_img.resize.assert_called_once()
-        mock_resized_img.save.assert_called_once()
-        assert "resized_" in str(result)
+    def test_prepare_image_resizes_in_memory(self, tmp_path):
+        """Test that large screenshots are shrunk without writing files."""
+        path = tmp_path / "large.png"
+        image = np.random.default_rng(0).integers(0, 256, (1536, 2048, 3), dtype=np.uint8)
+        cv2.imwrite(str(path), image)
+        
+        data, media_type = self.validator._prepare_image_for_api(path, max_size=1024)
+        
+        decoded = cv2.imdecode(np.frombuffer(base64.b64decode(data), np.uint8), cv2.IMREAD_COLOR)
+        assert media_type == "image/png"
+        assert decoded.shape == (768, 1024, 3)
+        assert list(tmp_path.iterdir()) == [path]
     
-    @patch('src.analysis.content_validation.Image')
-    def test_resize_image_for_api_error(self, mock_image):
-        """Test image resize error handling."""
-        mock_image.open.side_effect = Exception("Image error")
+    def test_prepare_image_from_frame(self):
+        """Test encoding a BGR frame straight from memory."""
+        frame = np.zeros((600, 800, 3), dtype=np.uint8)
+        frame[:, :, 2] = 255  # red in BGR
         
-        result = self.validator._resize_image_for_api(Path("test.png"))
+        data, media_type = self.validator._prepare_image_for_api(frame, max_size=400)
         
-        assert result == Path("test.png")
+        decoded = cv2.imdecode(np.frombuffer(base64.b64decode(data), np.uint8), cv2.IMREAD_COLOR)
+        assert media_type == "image/png"
+        assert decoded.shape == (300, 400, 3)
+        np.testing.assert_array_equal(decoded[0, 0], [0, 0, 255])
+    
+    def test_prepare_image_error(self):
+        """Test image preparation error handling."""
+        result = self.validator._prepare_image_for_api(Path("nonexistent.png"))
+        assert result is None
     
     def test_validate_with_openai_no_client(self):
         """Test OpenAI validation without client."""
@@ -126,12 +115,10 @@ class TestContentValidator:
         assert result['success'] is False
         assert result['error'] == "OpenAI client not available"
     
-    @patch.object(ContentValidator, '_resize_image_for_api')
-    @patch.object(ContentValidator, '_encode_image_base64')
-    def test_validate_with_openai_encoding_failure(self, mock_encode, mock_resize):
+    @patch.object(ContentValidator, '_prepare_image_for_api')
+    def test_validate_with_openai_encoding_failure(self, mock_prepare):
         """Test OpenAI validation with encoding failure."""
-        mock_resize.return_value = Path("test.png")
-        mock_encode.return_value = None
+        mock_prepare.return_value = None
         
         # Mock client
         self.validator.openai_client = Mock()
@@ -141,12 +128,10 @@ class TestContentValidator:
         assert result['success'] is False
         assert result['error'] == "Failed to encode image"
     
-    @patch.object(ContentValidator, '_resize_image_for_api')
-    @patch.object(ContentValidator, '_encode_image_base64')
-    def test_validate_with_openai_success_json_response(self, mock_encode, mock_resize):
+    @patch.object(ContentValidator, '_prepare_image_for_api')
+    def test_validate_with_openai_success_json_response(self, mock_prepare):
         """Test successful OpenAI validation with JSON response."""
-        mock_resize.return_value = Path("test.png")
-        mock_encode.return_value = "encoded_image_data"
+        mock_prepare.return_value = ("encoded_image_data", "image/png")
         
         # Mock OpenAI client
         mock_client = Mock()
@@ -170,12 +155,10 @@ class TestContentValidator:
         assert result['description'] == 'Test description'
         assert result['issues'] == ['Test issue']
     
-    @patch.object(ContentValidator, '_resize_image_for_api')
-    @patch.object(ContentValidator, '_encode_image_base64')
-    def test_validate_with_openai_success_text_response(self, mock_encode, mock_resize):
+    @patch.object(ContentValidator, '_prepare_image_for_api')
+    def test_validate_with_openai_success_text_response(self, mock_prepare):
         """Test successful OpenAI validation with text response."""
-        mock_resize.return_value = Path("test.png")
-        mock_encode.return_value = "encoded_image_data"
+        mock_prepare.return_value = ("encoded_image_data", "image/png")
         
         # Mock OpenAI client
         mock_client = Mock()
@@ -193,12 +176,10 @@ class TestContentValidator:
         assert result['confidence'] == 0.7
         assert "expected content" in result['description']
     
-    @patch.object(ContentValidator, '_resize_image_for_api')
-    @patch.object(ContentValidator, '_encode_image_base64')
-    def test_validate_with_openai_api_error(self, mock_encode, mock_resize):
+    @patch.object(ContentValidator, '_prepare_image_for_api')
+    def test_validate_with_openai_api_error(self, mock_prepare):
         """Test OpenAI validation API error."""
-        mock_resize.return_value = Path("test.png")
-        mock_encode.return_value = "encoded_image_data"
+        mock_prepare.return_value = ("encoded_image_data", "image/png")
         
         # Mock OpenAI client with error
         mock_client = Mock()
@@ -220,12 +201,10 @@ class TestContentValidator:
         assert result['success'] is False
         assert result['error'] == "Anthropic client not available"
     
-    @patch.object(ContentValidator, '_resize_image_for_api')
-    @patch.object(ContentValidator, '_encode_image_base64')
-    def test_validate_with_claude_success_positive(self, mock_encode, mock_resize):
+    @patch.object(ContentValidator, '_prepare_image_for_api')
+    def test_validate_with_claude_success_positive(self, mock_prepare):
         """Test successful Claude validation with positive response."""
-        mock_resize.return_value = Path("test.png")
-        mock_encode.return_value = "encoded_image_data"
+        mock_prepare.return_value = ("encoded_image_data", "image/png")
         
         # Mock Anthropic client
         mock_client = Mock()
@@ -242,12 +221,10 @@ class TestContentValidator:
         assert result['confidence'] == 0.9  # Extracted from "90% confidence"
         assert "expected content" in result['description']
     
-    @patch.object(ContentValidator, '_resize_image_for_api')
-    @patch.object(ContentValidator, '_encode_image_base64')
-    def test_validate_with_claude_success_negative(self, mock_encode, mock_resize):
+    @patch.object(ContentValidator, '_prepare_image_for_api')
+    def test_validate_with_claude_success_negative(self, mock_prepare):
         """Test successful Claude validation with negative response."""
-        mock_resize.return_value = Path("test.png")
-        mock_encode.return_value = "encoded_image_data"
+        mock_prepare.return_value = ("encoded_image_data", "image/png")
         
         # Mock Anthropic client
         mock_client = Mock()
@@ -263,12 +240,10 @@ class TestContentValidator:
         assert result['content_matches'] is False
         assert len(result['issues']) > 0  # Should extract issues
     
-    @patch.object(ContentValidator, '_resize_image_for_api')
-    @patch.object(ContentValidator, '_encode_image_base64')
-    def test_validate_with_claude_api_error(self, mock_encode, mock_resize):
+    @patch.object(ContentValidator, '_prepare_image_for_api')
+    def test_validate_with_claude_api_error(self, mock_prepare):
         """Test Claude validation API error."""
-        mock_resize.return_value = Path("test.png")
-        mock_encode.return_value = "encoded_image_data"
+        mock_prepare.return_value = ("encoded_image_data", "image/png")
         
         # Mock Anthropic client with error
         mock_client = Mock()
@@ -0,0 +1,273 @@
+"""
+Unit tests for the game shared-memory metrics reader.
+"""
+import struct
+import sys
+from pathlib import Path
+
+import pytest
+
+from src.ux_tester.game_metrics import (
+    GameMetricsReader, summarize_frames, measure_startup, load_audit_log, audit_failures,
+    HEADER_STRUCT, SLOT_STRUCT,
+    METRICS_MAGIC, METRICS_VERSION
+)
+from src.ux_tester.metrics import PerformanceMetrics
+
+
+class FakeSegment:
+    """Writes a metrics segment file the same way the game does."""
+
+    def __init__(self, path: Path, slot_count: int = 8):
+        self.path = path
+        self.slot_count = slot_count
+        self.head = 0
+        self.seqs = [0] * slot_count
+        self.data = bytearray(HEADER_STRUCT.size + slot_count * SLOT_STRUCT.size)
+        self._write_header()
+
+    def _write_header(self, magic: int = METRICS_MAGIC):
+        HEADER_STRUCT.pack_into(self.data, 0, magic, METRICS_VERSION, self.slot_count,
+                                SLOT_STRUCT.size, self.head, 123, 4242)
+        self.path.write_bytes(self.data)
+
+    def publish(self, frame_ms: float = 16.0, allocations: int = 0, state: int = 1,
+                audit_violations: int = 0, min_contrast: float = 0.0):
+        slot = self.head % self.slot_count
+        self.seqs[slot] += 2
+        SLOT_STRUCT.pack_into(self.data, HEADER_STRUCT.size + slot * SLOT_STRUCT.size,
+                              self.seqs[slot], state, self.head, self.head * 16_000_000,
+                              frame_ms, 1.0, 2.0, 5, allocations, allocations * 32, 10, 3,
+                              audit_violations, min_contrast)
+        self.head += 1
+        self._write_header()
+
+    def tear_slot(self, slot: int):
+        """Leave a slot in the middle of a write (odd sequence)."""
+        offset = HEADER_STRUCT.size + slot * SLOT_STRUCT.size
+        struct.pack_into("<I", self.data, offset, self.seqs[slot] + 1)
+        self.path.write_bytes(self.data)
+
+
+class TestGameMetricsReader:
+    """Test cases for GameMetricsReader."""
+
+    def setup_method(self):
+        """Set up test fixtures."""
+        self.reader = None
+
+    def teardown_method(self):
+        """Release the mapping."""
+        if self.reader:
+            self.reader.close()
+
+    def test_attach_missing_segment(self, tmp_path):
+        """Test attaching to a segment that does not exist."""
+        self.reader = GameMetricsReader(path=tmp_path / "missing")
+        assert self.reader.attach() is False
+        assert self.reader.read_new() == []
+
+    def test_attach_rejects_bad_magic(self, tmp_path):
+        """Test that a segment with the wrong magic is ignored."""
+        segment = FakeSegment(tmp_path / "seg")
+        segment._write_header(magic=0)
+        self.reader = GameMetricsReader(path=segment.path)
+        assert self.reader.attach() is False
+
+    def test_read_new_frames(self, tmp_path):
+        """Test reading frames published before and after attaching."""
+        segment = FakeSegment(tmp_path / "seg")
+        segment.publish(frame_ms=16.0)
+
+        self.reader = GameMetricsReader(path=segment.path)
+        assert self.reader.attach() is True
+        assert self.reader.slot_count == 8
+        assert self.reader.writer_pid == 4242
+
+        frames = self.reader.read_new()
+        assert len(frames) == 1
+        assert frames[0]['frame_index'] == 0
+        assert frames[0]['state'] == 'playing'
+        assert frames[0]['frame_ms'] == pytest.approx(16.0)
+        assert frames[0]['entity_count'] == 5
+
+        # The file mapping is shared, so later writes are visible
+        segment.publish(frame_ms=33.0, allocations=2)
+        frames = self.reader.read_new()
+        assert [f['frame_index'] for f in frames] == [1]
+        assert frames[0]['allocations'] == 2
+        assert self.reader.read_new() == []
+
+    def test_overrun_counts_dropped_samples(self, tmp_path):
+        """Test that frames overwritten before being read are counted as dropped."""
+        segment = FakeSegment(tmp_path / "seg", slot_count=4)
+        self.reader = GameMetricsReader(path=segment.path)
+        assert self.reader.attach() is True
+
+        for _ in range(10):
+            segment.publish()
+
+        frames = self.reader.read_new()
+        assert [f['frame_index'] for f in frames] == [6, 7, 8, 9]
+        assert self.reader.dropped_samples == 6
+
+    def test_torn_slot_is_skipped(self, tmp_path):
+        """Test that a slot being written is not returned."""
+        segment = FakeSegment(tmp_path / "seg")
+        self.reader = GameMetricsReader(path=segment.path)
+        assert self.reader.attach() is True
+
+        segment.publish()
+        segment.publish()
+        segment.tear_slot(1)
+
+        frames = self.reader.read_new()
+        assert [f['frame_index'] for f in frames] == [0]
+        assert self.reader.dropped_samples == 1
+
+    def test_latest(self, tmp_path):
+        """Test reading the latest frame without consuming it."""
+        segment = FakeSegment(tmp_path / "seg")
+        self.reader = GameMetricsReader(path=segment.path)
+        assert self.reader.attach() is True
+        assert self.reader.latest() is None
+
+        segment.publish(frame_ms=20.0)
+        assert self.reader.latest()['frame_ms'] == pytest.approx(20.0)
+        assert len(self.reader.read_new()) == 1
+
+
+class TestGameFrameSummary:
+    """Test cases for game frame summaries."""
+
+    def test_summarize_empty(self):
+        """Test summarizing no frames."""
+        assert 'message' in summarize_frames([])
+
+    def test_summarize_frames(self):
+        """Test frame time percentiles and allocation totals."""
+        frames = [{'frame_ms': float(ms), 'update_ms': 1.0, 'render_ms': 2.0,
+                   'entity_count': i, 'allocations': i % 2}
+                  for i, ms in enumerate(range(1, 101))]
+        summary = summarize_frames(frames)
+
+        assert summary['frames'] == 100
+        assert summary['frame_ms']['min'] == 1.0
+        assert summary['frame_ms']['max'] == 100.0
+        assert summary['frame_ms']['p50'] == 51.0
+        assert summary['frame_ms']['p99'] == 100.0
+        assert summary['max_entities'] == 99
+        assert summary['total_allocations'] == 50
+        assert summary['frames_with_allocations'] == 50
+        assert 'audit' not in summary
+
+    def test_summarize_audit(self, tmp_path):
+        """Test that in-engine audit results are read and summarized."""
+        segment = FakeSegment(tmp_path / "seg")
+        reader = GameMetricsReader(path=segment.path)
+        assert reader.attach() is True
+        segment.publish(audit_violations=1, min_contrast=2.44)
+        segment.publish(audit_violations=0, min_contrast=5.25)
+
+        frames = reader.read_new()
+        reader.close()
+        assert frames[0]['audit_violations'] == 1
+        assert frames[0]['min_contrast'] == pytest.approx(2.44)
+
+        audit = summarize_frames(frames)['audit']
+        assert audit['frames_with_violations'] == 1
+        assert audit['max_violations'] == 1
+        assert audit['min_contrast'] == pytest.approx(2.44)
+
+    def test_performance_metrics_integration(self, tmp_path):
+        """Test collecting game frames through PerformanceMetrics."""
+        segment = FakeSegment(tmp_path / "seg")
+        metrics = PerformanceMetrics()
+
+        assert metrics.attach_game_metrics(path=segment.path) is True
+        segment.publish(frame_ms=10.0)
+        segment.publish(frame_ms=30.0)
+
+        assert len(metrics.collect_game_frames()) == 2
+        summary = metrics.get_summary()
+        assert summary['game_frames']['frames'] == 2
+        assert summary['game_frames']['dropped_samples'] == 0
+
+        metrics.detach_game_metrics()
+        assert metrics.game_reader is None
+
+    def test_reattach_while_monitoring(self, tmp_path):
+        """Test swapping the stream while the monitoring thread is collecting."""
+        segment = FakeSegment(tmp_path / "seg")
+        for _ in range(8):
+            segment.publish()
+        metrics = PerformanceMetrics()
+        metrics.start_system_monitoring(interval=0)
+        try:
+            for _ in range(200):
+                assert metrics.attach_game_metrics(path=segment.path) is True
+                metrics.detach_game_metrics()
+            assert metrics.monitor_thread.is_alive()
+        finally:
+            metrics.stop_system_monitoring()
+        assert metrics.game_reader is None
+
+
+class TestMeasureStartup:
+    """Test cases for startup measurement."""
+
+    def test_measure_startup(self, tmp_path):
+        """Test collecting startup reports from repeated launches."""
+        fake_game = tmp_path / "fake_game.py"
+        fake_game.write_text(
+            "import json, sys\n"
+            "path = [a for a in sys.argv if a.startswith('--startup-trace=')][0].split('=', 1)[1]\n"
+            "assert '--exit-after-first-frame' in sys.argv\n"
+            "json.dump({'steps': [{'step': 'main', 'ms': 1.0, 'delta_ms': 1.0},\n"
+            "                     {'step': 'first_frame_rendered', 'ms': 3.0, 'delta_ms': 2.0}],\n"
+            "           'time_to_first_frame_ms': 3.0}, open(path, 'w'))\n"
+        )
+
+        result = measure_startup([sys.executable, str(fake_game), "--headless"], runs=3)
+
+        assert result['runs'] == 3
+        assert result['time_to_first_frame_ms'] == 3.0
+        assert result['steps_ms'] == {'main': 1.0, 'first_frame_rendered': 2.0}
+        assert result['launch_to_exit_ms'] > 0
+
+    def test_measure_startup_failure(self, tmp_path):
+        """Test that failing launches are reported rather than raised."""
+        result = measure_startup([str(tmp_path / "missing_game")], runs=2)
+        assert result['runs'] == 0
+
+
+class TestAuditLog:
+    """Test cases for the in-engine accessibility audit log."""
+
+    def test_load_and_collect_failures(self, tmp_path):
+        """Test loading audit records and collapsing repeated failures."""
+        log = tmp_path / "audit.jsonl"
+        log.write_text(
+            '{"frame": 0, "state": "menu", "violations": 1, "text": ['
+            '{"text": "Settings", "bounds": [60, 175, 64, 8], "contrast": 2.44, "pass": false},'
+            '{"text": "Exit", "bounds": [60, 235, 32, 8], "contrast": 5.25, "pass": true}], "targets": []}\n'
+            '{"frame": 40, "state": "settings", "violations": 2, "text": ['
+            '{"text": "Back", "bounds": [55, 290, 32, 8], "contrast": 3.1, "pass": false}], "targets": ['
+            '{"text": "Back", "bounds": [50, 280, 100, 30], "min_side_px": 30, "pass": false}]}\n'
+            '{"frame": 90, "state": "menu", "violations": 1, "text": ['
+            '{"text": "Settings", "bounds": [60, 175, 64, 8], "contrast": 2.1, "pass": false}], "targets": []}\n'
+        )
+
+        records = load_audit_log(log)
+        assert [r['frame'] for r in records] == [0, 40, 90]
+
+        failures = {(f['state'], f['kind'], f['text']): f for f in audit_failures(records)}
+        assert len(failures) == 3
+        settings = failures[('menu', 'contrast', 'Settings')]
+        assert settings['value'] == 2.1
+        assert settings['first_frame'] == 0
+        assert failures[('settings', 'target_size', 'Back')]['value'] == 30
+
+    def test_load_missing_log(self, tmp_path):
+        """Test that a missing log yields no records."""
+        assert load_audit_log(tmp_path / "missing.jsonl") == []
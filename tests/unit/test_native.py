@@ -0,0 +1,1110 @@
+"""
+Unit tests for the native image kernels and their Python bindings.
+"""
+import base64
+import json
+import os
+import shutil
+import subprocess
+import sys
+import time
+from pathlib import Path
+from unittest.mock import patch
+
+import cv2
+import numpy as np
+import pytest
+
+from src.analysis import native
+from src.analysis.ui_element_detector import UIElement, UIElementDetector, UIElementType
+from src.analysis.visual_analysis import VisualAnalyzer
+from src.capture.capture_catalog import CaptureCatalog
+from src.capture.screenshot_handler import ScreenshotHandler
+
+REPO_ROOT = Path(__file__).resolve().parents[2]
+
+
+@pytest.fixture(scope="module")
+def native_lib(tmp_path_factory):
+    """Build the native library into a temp dir (skipped without g++)."""
+    if shutil.which("g++") is None:
+        pytest.skip("g++ not available")
+    out = tmp_path_factory.mktemp("native") / native.library_name()
+    result = subprocess.run(
+        ["g++", "-std=c++17", "-O2", "-pthread", "-shared", "-fPIC", "-fvisibility=hidden", f"-I{REPO_ROOT}",
+         str(REPO_ROOT / "native" / "ux_native.cpp"), "-o", str(out)],
+        capture_output=True, text=True
+    )
+    if result.returncode != 0:
+        pytest.skip(f"native build failed: {result.stderr[:500]}")
+    return out
+
+
+@pytest.fixture
+def loaded(native_lib):
+    """Load the freshly built library and restore the default lookup afterwards."""
+    lib = native.load_library(native_lib)
+    assert lib is not None
+    yield lib
+    native.set_simd_level('avx2')
+    native._library = None
+    native._load_attempted = False
+
+
+def ui_frame(seed=0, height=240, width=320):
+    """A synthetic UI screen: gradient background, panels and a HUD counter."""
+    rng = np.random.default_rng(seed)
+    frame = np.zeros((height, width, 3), np.uint8)
+    frame[:] = np.linspace(20, 120, width, dtype=np.uint8)[None, :, None]
+    for _ in range(6):
+        y, x = rng.integers(0, height - 40), rng.integers(0, width - 60)
+        frame[y:y + 40, x:x + 60] = rng.integers(0, 256, 3)
+    cv2.putText(frame, "00:00", (8, 20), cv2.FONT_HERSHEY_SIMPLEX, 0.5, (255, 255, 255), 1)
+    return frame
+
+
+def flat_ui_frame(height=480, width=640):
+    """A flat-shaded game menu: panel, two labelled buttons and a bordered text field."""
+    frame = np.full((height, width, 3), 30, np.uint8)
+    frame[40:440, 60:580] = (90, 70, 60)
+    for x in (100, 340):
+        frame[320:370, x:x + 160] = (40, 140, 220)
+        cv2.putText(frame, "PLAY", (x + 40, 355), cv2.FONT_HERSHEY_SIMPLEX, 0.8, (255, 255, 255), 2)
+    frame[150:186, 150:450] = (80, 80, 80)
+    frame[152:184, 152:448] = (245, 245, 245)
+    return frame
+
+
+def reference_diff(before, after, threshold=0):
+    """The OpenCV path the kernels replace."""
+    code = cv2.COLOR_BGRA2GRAY if before.shape[2] == 4 else cv2.COLOR_BGR2GRAY
+    diff = cv2.absdiff(cv2.cvtColor(before, code), cv2.cvtColor(after, code)).astype(np.int64)
+    return np.count_nonzero(diff > threshold), float((diff ** 2).mean()), diff > threshold
+
+
+def random_pair(shape, seed=0):
+    rng = np.random.default_rng(seed)
+    before = rng.integers(0, 256, shape, dtype=np.uint8)
+    after = before.copy()
+    # A changed block plus sparse noise
+    h, w = shape[0] // 3, shape[1] // 3
+    after[h:2 * h, w:2 * w] = rng.integers(0, 256, (h, w, shape[2]), dtype=np.uint8)
+    noise = rng.random(shape[:2]) < 0.02
+    after[noise] = after[noise] // 2
+    return before, after
+
+
+class TestNativeLibrary:
+    """Test cases for loading the library."""
+
+    def test_missing_library(self, tmp_path):
+        """Test that a missing library leaves the helpers unavailable."""
+        assert native.load_library(tmp_path / "missing.so") is None
+        assert native.diff_frames(np.zeros((4, 4, 3), np.uint8), np.zeros((4, 4, 3), np.uint8)) is None
+        native._load_attempted = False
+
+    def test_load(self, loaded):
+        """Test loading the built library."""
+        assert native.available()
+        assert native.simd_level() in native.SIMD_LEVELS
+
+
+class TestDiffFrames:
+    """Test cases for the fused change-detection pass."""
+
+    @pytest.mark.parametrize("level", ["scalar", "avx2"])
+    @pytest.mark.parametrize("channels", [3, 4])
+    def test_matches_opencv(self, loaded, level, channels):
+        """Test changed count and MSE against cvtColor/absdiff."""
+        native.set_simd_level(level)
+        before, after = random_pair((97, 131, channels))
+
+        for threshold in (0, 25):
+            stats = native.diff_frames(before, after, threshold=threshold, tile_size=32)
+            changed, mse, _ = reference_diff(before, after, threshold)
+            assert stats['changed_pixels'] == changed
+            assert stats['change_ratio'] == pytest.approx(changed / (97 * 131))
+            assert stats['mse'] == pytest.approx(mse)
+
+    def test_tiles(self, loaded):
+        """Test the per-tile change grid, including partial edge tiles."""
+        before, after = random_pair((97, 131, 3), seed=1)
+        stats = native.diff_frames(before, after, tile_size=32)
+        _, _, mask = reference_diff(before, after)
+
+        assert stats['tiles'].shape == (4, 5)
+        for r in range(4):
+            for c in range(5):
+                tile = mask[r * 32:(r + 1) * 32, c * 32:(c + 1) * 32]
+                assert stats['tiles'][r, c] == pytest.approx(tile.mean())
+
+    def test_strided_and_rgb_input(self, loaded):
+        """Test row-strided views and RGB channel order."""
+        before, after = random_pair((60, 80, 3), seed=2)
+        wide_b = np.zeros((60, 100, 3), np.uint8)
+        wide_a = np.zeros((60, 100, 3), np.uint8)
+        wide_b[:, :80], wide_a[:, :80] = before, after
+
+        stats = native.diff_frames(wide_b[:, :80], wide_a[:, :80])
+        assert stats['changed_pixels'] == reference_diff(before, after)[0]
+
+        rgb = native.diff_frames(before[:, :, ::-1], after[:, :, ::-1], channel_order='rgb')
+        assert rgb['changed_pixels'] == stats['changed_pixels']
+
+    def test_unsupported_input(self, loaded):
+        """Test that grayscale or mismatched frames are declined."""
+        assert native.diff_frames(np.zeros((4, 4), np.uint8), np.zeros((4, 4), np.uint8)) is None
+        assert native.diff_frames(np.zeros((4, 4, 3), np.uint8), np.zeros((4, 5, 3), np.uint8)) is None
+
+
+class TestDiffColour:
+    """Test cases for the per-channel baseline comparison."""
+
+    @pytest.mark.parametrize("level", ["scalar", "avx2"])
+    @pytest.mark.parametrize("prepared", [False, True])
+    def test_matches_opencv(self, loaded, level, prepared, tmp_path):
+        """Test changed count, MSE and regions against the OpenCV path."""
+        native.set_simd_level(level)
+        before, after = random_pair((97, 131, 3), seed=4)
+        baseline = native.prepare_frame(before) if prepared else before
+
+        stats = native.diff_colour(baseline, after, threshold=10, tile_size=32)
+        reference = ScreenshotHandler(storage_dir=str(tmp_path))._compare_opencv(before, after)
+        assert stats['changed_pixels'] == reference['changed_pixels']
+        assert stats['mse'] == pytest.approx(reference['mse'])
+        assert stats['boxes'] == reference['boxes']
+
+    def test_prepared_layout(self, loaded):
+        """Test that prepared frames have aligned rows and a zero fourth byte."""
+        frame = native.prepare_frame(np.full((5, 13, 4), 200, np.uint8))
+        assert frame.pixels.ctypes.data % native.FRAME_ALIGNMENT == 0
+        assert frame.pixels.strides[0] % native.FRAME_ALIGNMENT == 0
+        assert (frame.pixels[:, :, 3] == 0).all()
+        assert native.prepare_frame(np.zeros((5, 13), np.uint8)) is None
+
+    def test_boxes(self, loaded):
+        """Test that separate changes give separate tight boxes."""
+        before = np.zeros((100, 200, 3), np.uint8)
+        after = before.copy()
+        after[10:20, 30:70] = 255    # spans two tiles
+        after[80:90, 150:155] = 255
+        stats = native.diff_colour(before, after, tile_size=32)
+        assert stats['boxes'] == [(30, 10, 40, 10), (150, 80, 5, 10)]
+
+
+    @pytest.mark.parametrize("level", ["scalar", "avx2"])
+    @pytest.mark.parametrize("channels", [3, 4])
+    @pytest.mark.parametrize("tile_size", [13, 32])
+    def test_overlay(self, loaded, level, channels, tile_size):
+        """Test the overlay rendered in the same pass against numpy."""
+        native.set_simd_level(level)
+        before, after = random_pair((61, 97, channels), seed=7)
+        stats = native.diff_colour(before, after, threshold=10, tile_size=tile_size, overlay=True)
+
+        diff = cv2.absdiff(before[:, :, :3], after[:, :, :3])
+        changed = cv2.cvtColor(diff, cv2.COLOR_BGR2GRAY) > 10
+        expected = after[:, :, :3] >> 1
+        expected[changed, 2] += 128
+        np.testing.assert_array_equal(stats['overlay'], expected)
+        assert stats['boxes'] == native.mask_boxes(changed, tile_size)
+        assert native.diff_colour(before, after)['overlay'] is None
+
+
+class TestImageStats:
+    """Test cases for the single-pass quality statistics."""
+
+    @pytest.mark.parametrize("shape", [(97, 131, 3), (70, 45, 4), (1, 40, 3), (40, 1, 3), (2, 2, 3)])
+    def test_matches_opencv(self, loaded, shape):
+        """Test every statistic against the OpenCV/numpy computation."""
+        img = random_pair(shape, seed=9)[1]
+        gray = cv2.cvtColor(img, cv2.COLOR_BGRA2GRAY if shape[2] == 4 else cv2.COLOR_BGR2GRAY)
+        stats = native.image_stats(img)
+
+        assert stats['brightness'] == pytest.approx(gray.mean())
+        assert stats['contrast'] == pytest.approx(gray.std())
+        assert stats['laplacian_var'] == pytest.approx(cv2.Laplacian(gray, cv2.CV_64F).var())
+        np.testing.assert_array_equal(stats['luma_histogram'], np.bincount(gray.ravel(), minlength=256))
+        hist = cv2.calcHist([img[:, :, :3].copy()], [0, 1, 2], None, [8, 8, 8], [0, 256, 0, 256, 0, 256])
+        np.testing.assert_array_equal(stats['color_histogram'], hist)
+
+        b, g, r = (img[:, :, c].astype(np.int32) for c in range(3))
+        rg, yb = r - g, (r + g) / 2 - b
+        colorfulness = np.sqrt(rg.var() + yb.var()) + 0.3 * np.sqrt(rg.mean() ** 2 + yb.mean() ** 2)
+        assert stats['colorfulness'] == pytest.approx(colorfulness)
+
+    def test_bit_stable(self, loaded):
+        """Test identical results across SIMD paths and thread counts."""
+        img = random_pair((301, 203, 3), seed=10)[0]
+        results = []
+        for level in ("scalar", "avx2"):
+            native.set_simd_level(level)
+            for threads in (1, 0):
+                results.append(native.image_stats(img, threads=threads))
+        for other in results[1:]:
+            for key in ('brightness', 'contrast', 'laplacian_var', 'colorfulness'):
+                assert other[key] == results[0][key]
+            np.testing.assert_array_equal(other['luma_histogram'], results[0]['luma_histogram'])
+
+
+class TestPerceptualHash:
+    """Test cases for pHash/dHash."""
+
+    @pytest.mark.parametrize("shape", [(240, 320, 3), (37, 53, 4), (5, 7, 3), (1, 64, 3)])
+    @pytest.mark.parametrize("channel_order", ["bgr", "rgb"])
+    def test_native_matches_numpy(self, loaded, shape, channel_order):
+        """Test that stored hashes do not depend on whether the library is built."""
+        img = random_pair(shape, seed=12)[0]
+        img[:shape[0] // 2] //= 3
+        assert native.perceptual_hash(img, channel_order) == native._perceptual_hash_numpy(img, channel_order)
+
+    def test_near_duplicates_are_close(self, loaded):
+        """Test that a HUD digit change moves the hash by a few bits at most."""
+        frame = ui_frame()
+        ticked = frame.copy()
+        ticked[5:25, 5:60] = frame[5:25, 5:60, :] // 2
+        cv2.putText(ticked, "00:07", (8, 20), cv2.FONT_HERSHEY_SIMPLEX, 0.5, (255, 255, 255), 1)
+        other = ui_frame(seed=1)
+
+        phash, dhash = native.perceptual_hash(frame)
+        assert native.hamming(phash, native.perceptual_hash(ticked)[0]) <= 4
+        assert native.hamming(dhash, native.perceptual_hash(ticked)[1]) <= 4
+        assert native.hamming(phash, native.perceptual_hash(other)[0]) > 10
+
+
+class TestHashIndex:
+    """Test cases for the Hamming-radius index."""
+
+    def build(self, hashes):
+        index = native.HashIndex()
+        for id, h in enumerate(hashes):
+            index.add(id, h)
+        return index
+
+    def test_matches_linear_scan(self, loaded):
+        """Test every radius against a brute-force scan."""
+        rng = np.random.default_rng(13)
+        base = [int(h) for h in rng.integers(0, 2 ** 63, 200, dtype=np.int64)]
+        # Clusters of near hashes around a few centres
+        hashes = base + [base[i % 5] ^ (1 << int(b)) ^ (1 << int(c))
+                         for i, (b, c) in enumerate(rng.integers(0, 64, (300, 2)))]
+        index = self.build(hashes)
+        assert len(index) == len(hashes)
+
+        for radius in (0, 2, 3, 7, 12):
+            for query in base[:5] + [base[0] ^ 0xFF]:
+                expected = sorted(((id, native.hamming(h, query)) for id, h in enumerate(hashes)
+                                   if native.hamming(h, query) <= radius), key=lambda m: (m[1], m[0]))
+                assert index.query(query, radius) == expected
+
+    def test_remove_and_replace(self, loaded):
+        """Test removal (including compaction) and re-filing an id."""
+        index = self.build(range(3000))
+        for id in range(0, 2900):
+            assert index.remove(id)
+        assert not index.remove(5)
+        assert len(index) == 100
+        assert index.query(2950, 0) == [(2950, 0)]
+        assert index.query(5, 0) == []
+
+        index.add(2950, 7)
+        assert index.query(2950, 0) == []
+        assert index.query(7, 0) == [(2950, 0)]
+
+    def test_invalid_arguments(self, loaded):
+        """Test that a null index or result buffer is rejected."""
+        lib = loaded
+        assert lib.ux_hash_index_size(None) == -1
+        assert lib.ux_hash_index_add(None, 1, 7) == -1
+        assert lib.ux_hash_index_remove(None, 1) == -1
+        assert lib.ux_hash_index_query(None, 7, 0, None, None, 0) == -1
+
+        index = self.build([7])
+        assert lib.ux_hash_index_query(index._handle, 7, 0, None, None, 4) == -1
+        assert lib.ux_hash_index_query(index._handle, 7, 0, None, None, -1) == -1
+        assert lib.ux_hash_index_query(index._handle, 7, 0, None, None, 0) == 1
+
+    def test_fallback_matches_native(self, loaded):
+        """Test that the linear-scan fallback answers the same queries."""
+        hashes = [int(h) for h in np.random.default_rng(14).integers(0, 2 ** 40, 300, dtype=np.int64)]
+        expected = [self.build(hashes).query(h, 20) for h in hashes[:10]]
+        native._library, native._load_attempted = None, True
+        fallback = self.build(hashes)
+        assert fallback._handle is None
+        assert [fallback.query(h, 20) for h in hashes[:10]] == expected
+
+
+class TestContentHash:
+    """Test cases for the XXH64 content hash."""
+
+    def test_reference_values(self, loaded):
+        """Test against published XXH64 values."""
+        assert native.content_hash(b"") == 0xEF46DB3751D8E999
+        assert native.content_hash(b"abc") == 0x44BC2CF5AD770999
+
+    def test_strided_views_hash_like_copies(self, loaded):
+        """Test that a crop hashes row by row like its packed copy, and seeds differ."""
+        frame = ui_frame()
+        crop = frame[10:90, 20:140]
+        assert not crop.flags.c_contiguous
+        assert native.content_hash(crop) == native.content_hash(np.ascontiguousarray(crop))
+        assert native.content_hash(frame[:, ::2]) == native.content_hash(frame[:, ::2].copy())
+        assert native.content_hash(frame) == native.content_hash(frame.tobytes())
+        assert native.content_hash(frame, seed=1) != native.content_hash(frame)
+        changed = frame.copy()
+        changed[239, 319, 2] ^= 1
+        assert native.content_hash(changed) != native.content_hash(frame)
+
+    def test_fallback(self, loaded):
+        """Test that the BLAKE2b fallback is also independent of strides."""
+        native._library, native._load_attempted = None, True
+        crop = ui_frame()[10:90, 20:140]
+        assert native.content_hash(crop) == native.content_hash(crop.copy())
+        with pytest.raises(TypeError):
+            native.content_hash(np.array([object()]))
+
+
+class TestResultCache:
+    """Test cases for the memory-mapped result cache."""
+
+    def test_put_get_and_reopen(self, loaded, tmp_path):
+        """Test that entries survive closing and reopening the log."""
+        path = tmp_path / "results.log"
+        cache = native.ResultCache(path, max_bytes=1 << 20)
+        assert cache.persistent
+        assert cache.get("missing") is None
+        assert cache.put("a", b"first", ttl=60)
+        assert cache.put("b", b"", ttl=60)
+        assert cache.put("a", b"second", ttl=60)
+        assert cache.get("a") == b"second" and cache.get(b"b") == b""
+        cache.close()
+
+        reopened = native.ResultCache(path, max_bytes=1 << 20)
+        assert reopened.get("a") == b"second"
+        assert reopened.remove("b") and not reopened.remove("b")
+        reopened.close()
+        assert native.ResultCache(path).get("b") is None
+
+    def test_ttl(self, loaded, tmp_path):
+        """Test that expired entries are misses."""
+        cache = native.ResultCache(tmp_path / "results.log")
+        cache.put("short", b"x", ttl=0.05)
+        cache.put("long", b"y", ttl=60)
+        assert cache.get("short") == b"x"
+        time.sleep(0.1)
+        assert cache.get("short") is None and cache.get("long") == b"y"
+        stats = cache.stats()
+        assert stats['entries'] == 1 and stats['evictions'] == 1 and stats['hits'] == 2
+
+    def test_size_bound_evicts_least_recently_used(self, loaded, tmp_path):
+        """Test that compaction keeps the log under its bound and keeps recently used entries."""
+        cache = native.ResultCache(tmp_path / "results.log", max_bytes=256 << 10)
+        value = bytes(range(256)) * 16
+        for i in range(200):
+            assert cache.put(f"entry{i}", value, ttl=60)
+            assert cache.get("entry0") == value  # keep it in use
+        stats = cache.stats()
+        assert stats['compactions'] > 0 and stats['evictions'] > 0
+        assert stats['log_bytes'] <= 256 << 10
+        assert (tmp_path / "results.log").stat().st_size <= 256 << 10
+        assert cache.get("entry199") == value and cache.get("entry0") == value
+        assert cache.get("entry1") is None
+        assert not cache.put("huge", bytes(200 << 10), ttl=60)
+
+    def test_torn_tail_is_dropped(self, loaded, tmp_path):
+        """Test that a damaged last record is cut off on open."""
+        path = tmp_path / "results.log"
+        cache = native.ResultCache(path)
+        cache.put("kept", b"1" * 100, ttl=60)
+        cache.put("torn", b"2" * 100, ttl=60)
+        size = cache.stats()['log_bytes']
+        cache.close()
+        with open(path, "r+b") as f:
+            f.seek(size - 8)
+            f.write(b"garbage!")
+        reopened = native.ResultCache(path)
+        assert reopened.get("kept") == b"1" * 100 and reopened.get("torn") is None
+        assert reopened.put("after", b"3", ttl=60) and reopened.get("after") == b"3"
+
+    def test_log_is_exclusive(self, loaded, tmp_path):
+        """Test that a second open of the same log falls back to memory."""
+        path = tmp_path / "results.log"
+        first = native.ResultCache(path)
+        second = native.ResultCache(path)
+        assert first.persistent and not second.persistent
+        assert second.put("k", b"v", ttl=60) and second.get("k") == b"v"
+        assert first.get("k") is None
+
+    def test_memory_fallback(self, loaded, tmp_path):
+        """Test the in-memory LRU used without the library."""
+        native._library, native._load_attempted = None, True
+        cache = native.ResultCache(tmp_path / "results.log", max_bytes=1000)
+        assert not cache.persistent
+        for i in range(5):
+            assert cache.put(f"k{i}", bytes(300), ttl=60)
+            cache.get("k0")
+        assert cache.get("k0") is not None and cache.get("k1") is None
+        assert not cache.put("big", bytes(600), ttl=60)
+        assert cache.stats()['live_bytes'] <= 1000
+
+
+class TestCaptureCatalog:
+    """Test cases for the capture catalog on the native logs and the Python reader."""
+
+    @pytest.fixture(params=["native", "python"])
+    def backend(self, request, loaded):
+        """Run a test against the library and against the fallback."""
+        if request.param == "python":
+            native._library, native._load_attempted = None, True
+        return request.param
+
+    def test_add_find_and_reopen(self, backend, tmp_path):
+        """Test that captures, metadata and removals survive reopening."""
+        catalog = CaptureCatalog(tmp_path / "catalog")
+        assert catalog.persistent
+        catalog.add("a.png", "before", 640, 480, file_bytes=10, content_hash=7, phash=1, dhash=2,
+                    extra={"expected_content": "menu"}, timestamp=1000.0)
+        catalog.add("b.png", "after", 640, 480, timestamp=1001.0)
+        catalog.add("c.png", "after", 640, 480, timestamp=1002.0)
+        assert catalog.update_extra("b.png", {"note": "x"}) and not catalog.update_extra("z.png", {})
+        assert catalog.remove("c.png") and not catalog.remove("c.png")
+        catalog.add("a.png", "before", 320, 240, timestamp=1003.0)  # replaces the first a.png
+        catalog.close()
+
+        reopened = CaptureCatalog(tmp_path / "catalog")
+        assert [c.name for c in reopened.captures(newest_first=False)] == ["b.png", "a.png"]
+        a = reopened.get("a.png")
+        assert (a.width, a.height, a.timestamp, a.phash, a.extra) == (320, 240, 1003.0, None, {})
+        assert reopened.get("b.png").extra == {"note": "x"} and reopened.get("c.png") is None
+        assert reopened.count() == 2 and reopened.count("after") == 1
+        reopened.close()
+
+    def test_latest_and_prune(self, backend, tmp_path):
+        """Test time lookups per label and pruning of the oldest captures."""
+        catalog = CaptureCatalog(tmp_path / "catalog")
+        for i in range(10):
+            catalog.add(f"{i}.png", "before" if i % 2 == 0 else "after", 8, 8, timestamp=1000.0 + i)
+        assert catalog.latest().name == "9.png"
+        assert catalog.latest("before").name == "8.png"
+        assert catalog.latest("after", before=1004.5).name == "3.png"
+        assert catalog.latest("before", before=999.0) is None and catalog.latest("missing") is None
+        before, after = catalog.latest_pair()
+        assert (before.name, after.name) == ("8.png", "9.png")
+
+        assert [c.name for c in catalog.prune(7)] == ["0.png", "1.png", "2.png"]
+        assert catalog.count() == 7 and catalog.count("before") == 3
+        assert catalog.prune(7) == []
+        catalog.remove("4.png")
+        assert catalog.latest("before", before=1005.0) is None
+        # Timestamps never run backwards in the log
+        assert catalog.add("late.png", "after", 8, 8, timestamp=1.0).timestamp == 1009.0
+        catalog.close()
+
+    def test_damaged_record_is_dropped(self, backend, tmp_path):
+        """Test that a record damaged by a crash is cut off on open."""
+        catalog = CaptureCatalog(tmp_path / "catalog")
+        catalog.add("kept.png", "before", 8, 8, timestamp=1000.0)
+        catalog.add("kept.png", "before", 16, 16, timestamp=1000.5)  # replaces record 0
+        catalog.add("torn.png", "after", 8, 8, timestamp=1001.0)
+        catalog.close()
+        with open(tmp_path / "catalog.idx", "r+b") as f:
+            # The replaced record's removal flag never reached the disk
+            f.seek(64 + 4)
+            f.write(b"\0" * 4)
+            f.seek(64 + 2 * 128)
+            f.write(b"\0" * 4)
+        reopened = CaptureCatalog(tmp_path / "catalog")
+        assert [c.name for c in reopened.captures()] == ["kept.png"]
+        assert reopened.get("kept.png").width == 16
+        assert reopened.add("after.png", "after", 8, 8).name == "after.png"
+        assert reopened.count() == 2
+        reopened.close()
+
+    def test_formats_interoperate(self, loaded, native_lib, tmp_path):
+        """Test that the native and Python backends read each other's logs, compacted or not."""
+        catalog = CaptureCatalog(tmp_path / "catalog")
+        for i in range(600):
+            catalog.add(f"{i}.png", "before", 8, 8, extra={"i": i}, timestamp=1000.0 + i)
+        catalog.prune(20)
+        catalog.close()
+        size = (tmp_path / "catalog.idx").stat().st_size
+
+        compacted = CaptureCatalog(tmp_path / "catalog")
+        assert (tmp_path / "catalog.idx").stat().st_size < size
+        assert compacted.get("599.png").extra == {"i": 599} and compacted.count() == 20
+        compacted.close()
+
+        native._library, native._load_attempted = None, True
+        fallback = CaptureCatalog(tmp_path / "catalog")
+        assert [c.name for c in fallback.captures()][:2] == ["599.png", "598.png"]
+        fallback.add("python.png", "after", 8, 8, phash=5, dhash=6, extra={"by": "python"})
+        fallback.remove("580.png")
+        fallback.close()
+
+        native.load_library(native_lib)
+        reopened = CaptureCatalog(tmp_path / "catalog")
+        assert reopened.latest("after").phash == 5 and reopened.get("python.png").extra == {"by": "python"}
+        assert reopened.get("580.png") is None and reopened.count() == 20
+        reopened.close()
+
+    def test_log_is_exclusive(self, backend, tmp_path):
+        """Test that a second open of the same catalog keeps its changes in memory."""
+        first = CaptureCatalog(tmp_path / "catalog")
+        first.add("a.png", "before", 8, 8)
+        second = CaptureCatalog(tmp_path / "catalog")
+        assert first.persistent and not second.persistent
+        assert second.get("a.png") is not None
+        second.add("b.png", "after", 8, 8)
+        assert first.get("b.png") is None
+        first.close()
+        second.close()
+
+        reopened = CaptureCatalog(tmp_path / "catalog")
+        assert [c.name for c in reopened.captures()] == ["a.png"]
+        reopened.close()
+
+    def test_lock_is_shared_with_the_native_log(self, loaded, native_lib, tmp_path):
+        """Test that the Python reader and the native log exclude each other."""
+        held = CaptureCatalog(tmp_path / "catalog")
+        native._library, native._load_attempted = None, True
+        assert not CaptureCatalog(tmp_path / "catalog").persistent
+        held.close()
+
+        held = CaptureCatalog(tmp_path / "catalog")
+        native.load_library(native_lib)
+        assert held.persistent and not CaptureCatalog(tmp_path / "catalog").persistent
+        held.close()
+
+
+class TestDetectRegions:
+    """Test cases for the colour-region UI element detector."""
+
+    def test_flat_ui(self, loaded):
+        """Test that the panel, buttons and text field are found and classified."""
+        frame = flat_ui_frame()
+        regions = native.detect_regions(frame)
+        found = {(r['type'], r['bbox']) for r in regions}
+
+        assert ('container', (60, 40, 520, 400)) in found
+        assert ('button', (100, 320, 160, 50)) in found
+        assert ('button', (340, 320, 160, 50)) in found
+        assert ('input', (152, 152, 296, 32)) in found
+
+    @pytest.mark.parametrize("level", ["scalar", "avx2"])
+    @pytest.mark.parametrize("channels", [3, 4])
+    def test_box_statistics_match_opencv(self, loaded, level, channels):
+        """Test that colour and luma statistics cover the whole bbox like _analyze_colors."""
+        native.set_simd_level(level)
+        frame = flat_ui_frame()
+        if channels == 4:
+            frame = cv2.cvtColor(frame, cv2.COLOR_BGR2BGRA)
+        button = next(r for r in native.detect_regions(frame) if r['type'] == 'button')
+        x, y, w, h = button['bbox']
+        roi = np.ascontiguousarray(frame[y:y + h, x:x + w, :3])
+        gray = cv2.cvtColor(roi, cv2.COLOR_BGR2GRAY)
+
+        assert button['bbox'] == (100, 320, 160, 50)
+        assert button['area'] < w * h  # the label leaves holes in the region
+        assert button['mean_color'] == pytest.approx(roi.reshape(-1, 3).mean(axis=0), abs=1e-3)
+        assert button['brightness'] == pytest.approx(gray.mean(), abs=1e-3)
+        assert button['contrast'] == pytest.approx(gray.std(), abs=1e-2)
+
+    def test_tolerance_and_channel_order(self, loaded):
+        """Test that noise within the tolerance keeps regions whole and RGB input is accepted."""
+        frame = flat_ui_frame().astype(np.int16)
+        rng = np.random.default_rng(0)
+        noisy = np.clip(frame + rng.integers(-1, 2, frame.shape), 0, 255).astype(np.uint8)
+
+        boxes = {r['bbox'] for r in native.detect_regions(noisy, tolerance=4)}
+        assert (60, 40, 520, 400) in boxes
+        rgb = {(r['type'], r['bbox']) for r in native.detect_regions(np.ascontiguousarray(noisy[:, :, ::-1]),
+                                                                     tolerance=4, channel_order='rgb')}
+        assert rgb == {(r['type'], r['bbox']) for r in native.detect_regions(noisy, tolerance=4)}
+
+    def test_unsupported_input(self, loaded):
+        """Test that unsupported input returns None."""
+        assert native.detect_regions(np.zeros((8, 8), np.uint8)) is None
+        assert native.detect_regions(np.zeros((8, 8, 3), np.uint8), tolerance=-1) is None
+
+
+def random_boxes(count, spread=250, seed=0):
+    """Overlapping (x, y, w, h) boxes with coarse scores, so ties occur."""
+    rng = np.random.default_rng(seed)
+    boxes = np.hstack([rng.integers(0, spread, (count, 2)), rng.integers(5, 80, (count, 2))])
+    return boxes, rng.random(count).round(1)
+
+
+def reference_nms(boxes, scores, threshold):
+    """The quadratic loop _filter_and_deduplicate uses without the library."""
+    detector = UIElementDetector(enable_ocr=False, use_native=False, confidence_threshold=0.0)
+    elements = [UIElement(UIElementType.TEXT, tuple(int(v) for v in box), float(score), text_content=str(i))
+                for i, (box, score) in enumerate(zip(boxes, scores))]
+    kept = []
+    for elem in sorted(elements, key=lambda e: e.confidence, reverse=True):
+        if not any(detector._elements_overlap(elem, other, threshold) for other in kept):
+            kept.append(elem)
+    return [int(e.text_content) for e in kept]
+
+
+class TestNms:
+    """Test cases for the R-tree non-maximum suppression."""
+
+    @pytest.mark.parametrize("level", ["scalar", "avx2"])
+    @pytest.mark.parametrize("count,threshold", [(1, 0.5), (40, 0.5), (1000, 0.5), (1000, 0.2), (1000, 0.8)])
+    def test_matches_greedy_loop(self, loaded, level, count, threshold):
+        """Test kept indices and their order against the pairwise loop, ties included."""
+        native.set_simd_level(level)
+        boxes, scores = random_boxes(count)
+        assert native.nms(boxes, scores, threshold).tolist() == reference_nms(boxes, scores, threshold)
+
+    def test_large_input(self, loaded):
+        """Test that 10^5 boxes give the same result on both SIMD levels."""
+        boxes, scores = random_boxes(100000, spread=1900)
+        kept = native.nms(boxes, scores)
+        native.set_simd_level('scalar')
+        assert np.array_equal(native.nms(boxes, scores), kept)
+        assert 0 < len(kept) < len(boxes)
+        assert np.all(np.diff(scores[kept]) <= 0)
+
+    def test_edge_cases(self, loaded):
+        """Test empty input, identical boxes and mismatched lengths."""
+        assert len(native.nms(np.zeros((0, 4)), [])) == 0
+        assert native.nms([[0, 0, 10, 10]] * 3, [0.1, 0.9, 0.9]).tolist() == [1]
+        assert native.nms([[0, 0, 10, 10], [20, 20, 5, 5]], [0.5, 0.6]).tolist() == [1, 0]
+        with pytest.raises(ValueError):
+            native.nms([[0, 0, 10, 10]], [0.5, 0.6])
+
+    def test_filter_and_deduplicate(self, loaded):
+        """Test the detector keeps the same elements with and without the library."""
+        boxes, scores = random_boxes(500)
+        elements = [UIElement(UIElementType.TEXT, tuple(int(v) for v in box), float(score))
+                    for box, score in zip(boxes, scores)]
+        native_kept = UIElementDetector(enable_ocr=False)._filter_and_deduplicate(elements)
+        python_kept = UIElementDetector(enable_ocr=False, use_native=False)._filter_and_deduplicate(elements)
+        assert [id(e) for e in native_kept] == [id(e) for e in python_kept]
+
+
+def profile_boxes(count, seed=0, height=480, width=640):
+    """Random (x, y, w, h) boxes, some of them clipped or empty."""
+    rng = np.random.default_rng(seed)
+    boxes = np.stack([rng.integers(-20, width, count), rng.integers(-20, height, count),
+                      rng.integers(0, 200, count), rng.integers(0, 120, count)], axis=1)
+    boxes[0] = (0, 0, 0, 5)
+    return boxes
+
+
+class TestColourProfiles:
+    """Test cases for the batched colour profiles of many boxes."""
+
+    @pytest.mark.parametrize("level", ["scalar", "avx2"])
+    @pytest.mark.parametrize("count", [8, 150])
+    def test_matches_numpy(self, loaded, level, count):
+        """Test the SIMD scans and the integral-image path against numpy."""
+        native.set_simd_level(level)
+        frame = flat_ui_frame()
+        frame[::7, ::5] = 255
+        boxes = profile_boxes(count, seed=count)
+        fast = native.colour_profiles(frame, boxes)
+        reference = native._colour_profiles_numpy(frame, boxes.astype(np.int64), 'bgr')
+        assert fast.keys() == reference.keys()
+        for key, value in reference.items():
+            np.testing.assert_allclose(fast[key], value, atol=1e-3)
+        assert np.all(fast['foreground_share'][0] == 0) and np.all(fast['mean_color'][0] == 0)
+
+    def test_matches_opencv_statistics(self, loaded):
+        """Test mean colour and luma statistics against OpenCV on the button."""
+        frame = flat_ui_frame()
+        roi = frame[320:370, 100:260]
+        gray = cv2.cvtColor(roi, cv2.COLOR_BGR2GRAY)
+        profile = native.colour_profiles(frame, [(100, 320, 160, 50)])
+        np.testing.assert_allclose(profile['mean_color'][0], roi.reshape(-1, 3).mean(axis=0), atol=1e-3)
+        assert profile['brightness'][0] == pytest.approx(gray.mean(), abs=1e-3)
+        assert profile['contrast'][0] == pytest.approx(gray.std(), abs=1e-3)
+        # Blue fill with white "PLAY" on it
+        np.testing.assert_allclose(profile['background_color'][0], (40, 140, 220), atol=1)
+        assert profile['foreground_brightness'][0] > 200
+        assert 0 < profile['foreground_share'][0] < 0.2
+
+    def test_analyze_colors_batch(self, loaded):
+        """Test that the detector's batch analysis matches per-ROI analysis."""
+        frame = flat_ui_frame()
+        detector = UIElementDetector(enable_ocr=False)
+        boxes = [(100, 320, 160, 50), (150, 150, 300, 36), (60, 40, 520, 400)]
+        for (x, y, w, h), analysis in zip(boxes, detector._analyze_colors_batch(frame, boxes)):
+            roi = frame[y:y + h, x:x + w]
+            reference = detector._analyze_colors_roi(roi)
+            assert analysis['dominant_color'] == reference['dominant_color']
+            assert analysis['contrast_ratio'] == pytest.approx(reference['contrast_ratio'], abs=1e-5)
+            assert analysis['brightness'] == pytest.approx(reference['brightness'], abs=1e-5)
+            assert detector._analyze_colors(roi) == analysis
+        assert detector._analyze_colors_batch(frame, []) == []
+
+
+def text_frame(height=480, width=640):
+    """Light frame with dark text lines and a dark button with light text."""
+    frame = np.full((height, width, 3), 235, dtype=np.uint8)
+    cv2.putText(frame, "Hello World settings", (20, 60), cv2.FONT_HERSHEY_SIMPLEX, 0.8, (20, 20, 20), 2)
+    cv2.rectangle(frame, (20, 200), (300, 260), (60, 40, 30), -1)
+    cv2.putText(frame, "Start Game", (40, 240), cv2.FONT_HERSHEY_SIMPLEX, 0.7, (250, 250, 250), 2)
+    cv2.putText(frame, "Score: 12345", (400, 400), cv2.FONT_HERSHEY_PLAIN, 1.2, (0, 0, 200), 1)
+    return frame
+
+
+def inside(inner, outer, slack=2):
+    """Whether bbox inner lies within bbox outer give or take slack pixels."""
+    return (inner[0] >= outer[0] - slack and inner[1] >= outer[1] - slack and
+            inner[0] + inner[2] <= outer[0] + outer[2] + slack and inner[1] + inner[3] <= outer[1] + outer[3] + slack)
+
+
+class TestTextProposer:
+    """Test cases for the native text-line proposals."""
+
+    def test_finds_text_lines(self, loaded):
+        """Test that each line of text is one proposal of the right polarity."""
+        lines = native.TextProposer().propose(text_frame())
+        assert [line['polarity'] for line in lines] == ['dark', 'light', 'dark']
+        expected = [(18, 40, 228, 30), (38, 222, 115, 22), (398, 384, 118, 20)]
+        for line, box in zip(lines, expected):
+            assert inside(line['bbox'], box)
+            assert line['bbox'][2] > 0.8 * box[2]
+            assert line['glyphs'] >= 2 and 0.5 <= line['confidence'] <= 0.9
+
+    def test_no_text(self, loaded):
+        """Test that flat frames and noise give (almost) nothing."""
+        assert native.TextProposer().propose(np.full((120, 160, 3), 90, dtype=np.uint8)) == []
+        noise = np.random.default_rng(0).integers(0, 256, (240, 320, 3), dtype=np.uint8)
+        assert len(native.TextProposer().propose(noise)) <= 2
+        assert native.TextProposer().propose(np.zeros((10, 10), dtype=np.uint8)) is None
+
+    def test_incremental_matches_full_search(self, loaded):
+        """Test that re-searching changed tiles gives the full search's lines."""
+        proposer = native.TextProposer()
+        frame = text_frame()
+        first = proposer.propose(frame)
+        assert proposer.searched_pixels == frame.shape[0] * frame.shape[1]
+
+        assert proposer.propose(frame) == first
+        assert proposer.searched_pixels == 0
+
+        changed = frame.copy()
+        cv2.putText(changed, "New label", (400, 120), cv2.FONT_HERSHEY_SIMPLEX, 0.6, (10, 10, 10), 1)
+        incremental = proposer.propose(changed)
+        assert 0 < proposer.searched_pixels < frame.shape[0] * frame.shape[1] // 2
+        assert incremental == native.TextProposer().propose(changed)
+        assert len(incremental) == len(first) + 1
+
+        # Erasing the label again
+        assert proposer.propose(frame) == first
+        assert proposer.propose(frame[:, :320], incremental=True) == native.TextProposer().propose(frame[:, :320])
+        assert proposer.searched_pixels == frame.shape[0] * 320
+
+    def test_detector_text_regions(self, loaded):
+        """Test that the detector reports the native lines as text elements."""
+        frame = text_frame()
+        detector = UIElementDetector(enable_ocr=False)
+        gray = cv2.cvtColor(frame, cv2.COLOR_BGR2GRAY)
+        elements = detector._detect_text_regions(frame, gray)
+        assert [e.bbox for e in elements] == [line['bbox'] for line in native.TextProposer().propose(frame)]
+        assert all(e.element_type == UIElementType.TEXT and e.color_analysis for e in elements)
+        assert UIElementDetector(enable_ocr=False, use_native=False)._text_proposer is None
+
+
+class TestOcrPreprocess:
+    """Test cases for the batched OCR crop preprocessing."""
+
+    BOXES = [(18, 40, 228, 30), (38, 222, 115, 22), (398, 384, 118, 20), (100, 300, 200, 40), (-5, -5, 3, 3),
+             (630, 470, 20, 20)]
+
+    def noisy_text_frame(self):
+        frame = text_frame()
+        frame[300:340, 100:300] = np.random.default_rng(1).integers(0, 256, (40, 200, 3), dtype=np.uint8)
+        return frame
+
+    @pytest.mark.parametrize("max_skew", [0.0, 5.0])
+    def test_matches_opencv(self, loaded, max_skew):
+        """Test the native crops against the OpenCV steps on level text."""
+        frame = self.noisy_text_frame()
+        fast = native.prepare_ocr_crops(frame, self.BOXES, max_skew=max_skew)
+        options = native.OcrOptions(32, 4, 31, 10, 8, 1, max_skew)
+        reference = native._prepare_ocr_crops_opencv(frame, np.array(self.BOXES, dtype=np.int32), options, 'bgr')
+        assert [c['inverted'] for c in fast] == [False, True, False, True, False, False]
+        assert [c['scale'] for c in fast] == [2, 2, 2, 1, 1, 4]
+        for crop, expected in zip(fast, reference):
+            assert crop['skew'] == 0.0
+            assert crop['scale'] == expected['scale'] and crop['inverted'] == expected['inverted']
+            np.testing.assert_array_equal(crop['image'], expected['image'])
+        assert fast[4]['image'].shape == (0, 0)
+
+    def test_deskews(self, loaded):
+        """Test that rotated text is found skewed and sheared level."""
+        line = np.full((60, 300, 3), 240, dtype=np.uint8)
+        cv2.putText(line, "Skewed line of text", (10, 40), cv2.FONT_HERSHEY_SIMPLEX, 0.8, (10, 10, 10), 2)
+        rotated = cv2.warpAffine(line, cv2.getRotationMatrix2D((150, 30), -4, 1.0), (300, 60),
+                                 borderValue=(240, 240, 240))
+        crop = native.prepare_ocr_crops(rotated, [(0, 0, 300, 60)])[0]
+        assert crop['skew'] == pytest.approx(4.0, abs=1.0)
+
+        # Text rows of the deskewed crop span about the height of the level line
+        text_rows = np.flatnonzero((crop['image'] == 0).any(axis=1))
+        level = native.prepare_ocr_crops(line, [(0, 0, 300, 60)])[0]['image']
+        level_rows = np.flatnonzero((level == 0).any(axis=1))
+        assert len(text_rows) <= len(level_rows) + 6
+
+    def test_threads_and_options(self, loaded):
+        """Test that the pool gives the calling thread's result and options are checked."""
+        frame = self.noisy_text_frame()
+        pooled = native.prepare_ocr_crops(frame, self.BOXES * 4)
+        single = native.prepare_ocr_crops(frame, self.BOXES * 4, threads=1)
+        for a, b in zip(pooled, single):
+            np.testing.assert_array_equal(a['image'], b['image'])
+        assert native.prepare_ocr_crops(frame, self.BOXES, block_size=4) is None
+        assert native.prepare_ocr_crops(frame, self.BOXES, max_skew=45) is None
+        assert native.prepare_ocr_crops(frame, []) == []
+
+
+def decode_base64_image(result):
+    """The BGR pixels of an encode_image_base64 result."""
+    data = np.frombuffer(base64.b64decode(result['data']), np.uint8)
+    return cv2.imdecode(data, cv2.IMREAD_COLOR)
+
+
+class TestEncodeImage:
+    """Test cases for the in-memory resample, encode and base64 pass."""
+
+    def test_png_matches_opencv_resize(self, loaded):
+        """Test that the PNG decodes to cv2's INTER_AREA downscale."""
+        frame = ui_frame(seed=2, height=600, width=1000)
+        result = native.encode_image_base64(frame, max_size=256)
+        assert result['media_type'] == 'image/png'
+        assert (result['width'], result['height']) == (256, 153)
+        expected = cv2.resize(frame, (256, 153), interpolation=cv2.INTER_AREA)
+        decoded = decode_base64_image(result)
+        assert np.abs(decoded.astype(int) - expected).max() <= 1
+
+    def test_frame_that_fits_is_lossless(self, loaded):
+        """Test that a frame within max_size round-trips exactly, in either channel order."""
+        frame = random_pair((75, 101, 3), seed=4)[0]
+        decoded = decode_base64_image(native.encode_image_base64(frame, max_size=128))
+        np.testing.assert_array_equal(decoded, frame)
+
+        rgba = np.dstack([frame[:, :, ::-1], np.full(frame.shape[:2], 255, np.uint8)])
+        decoded = decode_base64_image(native.encode_image_base64(rgba, max_size=0, channel_order='rgb'))
+        np.testing.assert_array_equal(decoded, frame)
+
+    def test_jpeg_close_to_opencv(self, loaded):
+        """Test that the JPEG decodes about as close to the frame as cv2's."""
+        frame = ui_frame(seed=5, height=480, width=640)
+        result = native.encode_image_base64(frame, max_size=0, image_format='jpeg', quality=85)
+        assert result['media_type'] == 'image/jpeg'
+        error = np.abs(decode_base64_image(result).astype(int) - frame).mean()
+        _, reference = cv2.imencode('.jpg', frame, [cv2.IMWRITE_JPEG_QUALITY, 85])
+        reference_error = np.abs(cv2.imdecode(reference, cv2.IMREAD_COLOR).astype(int) - frame).mean()
+        assert error <= reference_error * 1.5 + 0.5
+
+    def test_multi_worker_pool(self, native_lib):
+        """Test that a pool with several workers encodes frames of many bands like one thread."""
+        script = (
+            "import sys\n"
+            "from src.analysis import native\n"
+            "from tests.unit.test_native import decode_base64_image, ui_frame\n"
+            "assert native.load_library(sys.argv[1]) is not None\n"
+            "frame = ui_frame(seed=7, height=600, width=800)\n"
+            "for image_format in ('png', 'jpeg'):\n"
+            "    pooled = native.encode_image_base64(frame, max_size=400, image_format=image_format)\n"
+            "    single = native.encode_image_base64(frame, max_size=400, image_format=image_format, threads=1)\n"
+            "    assert pooled == single, image_format\n"
+            "    assert decode_base64_image(pooled).shape == (300, 400, 3)\n"
+        )
+        env = dict(os.environ, **{native.THREADS_ENV: "4"})
+        result = subprocess.run([sys.executable, "-c", script, str(native_lib)], cwd=REPO_ROOT, env=env,
+                                capture_output=True, text=True)
+        assert result.returncode == 0, result.stderr[-2000:]
+
+    @pytest.mark.parametrize("image_format", ["png", "jpeg"])
+    def test_simd_levels_and_threads_agree(self, loaded, image_format):
+        """Test identical output across SIMD paths and thread counts."""
+        frame = random_pair((333, 517, 3), seed=6)[0]
+        outputs = []
+        for level in native.SIMD_LEVELS:
+            native.set_simd_level(level)
+            for threads in (0, 1):
+                outputs.append(native.encode_image_base64(frame, max_size=200, image_format=image_format,
+                                                          threads=threads)['data'])
+        assert len(set(outputs)) == 1
+
+    def test_fallback_decodes_alike(self, loaded):
+        """Test that the OpenCV fallback gives the same pixels."""
+        frame = ui_frame(seed=7, height=300, width=500)
+        result = native.encode_image_base64(frame, max_size=240)
+        size = (result['width'], result['height'])
+        fallback = native._encode_image_opencv(frame, size, 'png', 85, 'bgr')
+        reference = decode_base64_image({'data': fallback})
+        assert np.abs(decode_base64_image(result).astype(int) - reference).max() <= 1
+
+    def test_invalid_options(self, loaded):
+        """Test that unsupported formats and qualities are rejected."""
+        frame = ui_frame()
+        assert native.encode_image_base64(frame, image_format='gif') is None
+        assert native.encode_image_base64(frame, image_format='jpeg', quality=0) is None
+        assert native.encode_image_base64(frame, max_size=-1) is None
+
+
+class TestUIElementDetectorNative:
+    """Test cases for the native path of UIElementDetector."""
+
+    def test_native_regions_become_elements(self, loaded):
+        """Test that buttons and inputs carry the color analysis of the OpenCV path."""
+        frame = flat_ui_frame()
+        detector = UIElementDetector(enable_ocr=False)
+        elements = detector._elements_from_regions(native.detect_regions(frame))
+        buttons = [e for e in elements if e.element_type == UIElementType.BUTTON]
+        inputs = [e for e in elements if e.element_type == UIElementType.INPUT]
+
+        assert len(buttons) == 2 and len(inputs) == 1
+        for element in buttons + inputs:
+            x, y, w, h = element.bbox
+            roi = frame[y:y + h, x:x + w]
+            expected = detector._analyze_colors(roi)
+            assert element.is_interactive
+            assert element.color_analysis['dominant_color'] == expected['dominant_color']
+            assert element.color_analysis['contrast_ratio'] == pytest.approx(expected['contrast_ratio'], abs=1e-4)
+            assert element.color_analysis['brightness'] == pytest.approx(expected['brightness'], abs=1e-4)
+        assert buttons[0].accessibility_score == pytest.approx(
+            detector._assess_accessibility(frame[320:370, 100:260]), abs=1e-4)
+
+    def test_detect_elements_uses_native_path(self, loaded):
+        """Test that detection finds the buttons with and without the library."""
+        frame = flat_ui_frame()
+        for use_native in (True, False):
+            detector = UIElementDetector(enable_ocr=False, use_native=use_native)
+            elements = detector.detect_elements(frame)
+            assert any(e.element_type == UIElementType.CONTAINER for e in elements)
+        native_buttons = [e.bbox for e in UIElementDetector(enable_ocr=False).detect_elements(frame)
+                          if e.element_type == UIElementType.BUTTON]
+        assert (100, 320, 160, 50) in native_buttons
+
+
+class TestScreenshotHandlerNative:
+    """Test cases for ScreenshotHandler.compare_with_baseline on both paths."""
+
+    def test_native_matches_opencv(self, loaded, tmp_path):
+        """Test that both paths report the same comparison."""
+        before, after = random_pair((90, 120, 3), seed=5)
+        results = []
+        for use_native in (True, False):
+            handler = ScreenshotHandler(storage_dir=str(tmp_path / str(use_native)), use_native=use_native)
+            assert handler.set_baseline(before)
+            results.append(handler.compare_with_baseline(after))
+
+        fast, reference = results
+        for key in ('changed_pixels', 'total_pixels', 'change_percentage', 'changed_regions'):
+            assert fast[key] == reference[key]
+        assert fast['mse'] == pytest.approx(reference['mse'])
+
+    @pytest.mark.parametrize("use_library", [True, False])
+    def test_cleanup_near_duplicates(self, native_lib, tmp_path, use_library):
+        """Test that near-identical frames are merged, keeping the newest."""
+        if use_library:
+            native.load_library(native_lib)
+        else:
+            native._library, native._load_attempted = None, True
+        try:
+            handler = ScreenshotHandler(storage_dir=str(tmp_path))
+            frame, other = ui_frame(), ui_frame(seed=1)
+            names = []
+            for second in range(5):
+                ticked = frame.copy()
+                cv2.putText(ticked, f"00:0{second}", (8, 20), cv2.FONT_HERSHEY_SIMPLEX, 0.5, (255, 255, 255), 1)
+                names.append(handler.save_screenshot(ticked, f"tick_{second}.png"))
+            names.append(handler.save_screenshot(other, "other.png"))
+
+            assert [name for name, _ in handler.find_similar(frame)][0] in names[:5]
+            groups = handler.find_near_duplicates()
+            assert len(groups) == 1 and sorted(groups[0]) == sorted(names[:5])
+
+            assert handler.cleanup_duplicates() == 4
+            assert set(handler.screenshots_metadata) == {groups[0][0], "other.png"}
+            assert handler.find_similar(frame, radius=64)[0][0] == groups[0][0]
+            assert ScreenshotHandler(storage_dir=str(tmp_path)).find_near_duplicates() == []
+        finally:
+            native._library, native._load_attempted = None, False
+
+    def test_metadata_file_import_resumes(self, tmp_path):
+        """Test that metadata.json is kept until every entry is in a persistent catalog."""
+        entries = {}
+        for i, name in enumerate(("a.png", "b.png")):
+            cv2.imwrite(str(tmp_path / name), ui_frame(seed=i))
+            entries[name] = {"filename": name, "timestamp": f"2024-01-01T10:00:0{i}", "size": [240, 320, 3],
+                             "metadata": {}}
+        (tmp_path / "metadata.json").write_text(json.dumps(entries))
+
+        with patch("src.capture.screenshot_handler.image_hash", side_effect=[1, OSError("disk full")]):
+            assert set(ScreenshotHandler(storage_dir=str(tmp_path)).screenshots_metadata) == {"a.png"}
+        assert (tmp_path / "metadata.json").exists()
+
+        holder = CaptureCatalog(tmp_path / "other" / "catalog")
+        (tmp_path / "other" / "metadata.json").write_text(json.dumps({}))
+        ScreenshotHandler(storage_dir=str(tmp_path / "other"))
+        assert (tmp_path / "other" / "metadata.json").exists()
+        holder.close()
+
+        assert set(ScreenshotHandler(storage_dir=str(tmp_path)).screenshots_metadata) == {"a.png", "b.png"}
+        assert not (tmp_path / "metadata.json").exists()
+
+    def test_baseline_prepared_once(self, loaded, tmp_path):
+        """Test that the prepared baseline is reused until the baseline changes."""
+        handler = ScreenshotHandler(storage_dir=str(tmp_path))
+        before, after = random_pair((40, 40, 3), seed=6)
+        handler.set_baseline(before)
+        handler.compare_with_baseline(after)
+        prepared = handler._prepared_baseline
+        handler.compare_with_baseline(after)
+        assert handler._prepared_baseline is prepared
+
+        handler.set_baseline(after)
+        assert handler.compare_with_baseline(after)['changed_pixels'] == 0
+        assert handler._prepared_baseline is not prepared
+
+
+class TestVisualAnalyzerNative:
+    """Test cases for VisualAnalyzer on the native path."""
+
+    def test_detect_ui_changes_matches_opencv(self, loaded):
+        """Test that the native and OpenCV paths give the same score."""
+        before, after = random_pair((120, 160, 3), seed=3)
+        native_score = VisualAnalyzer().detect_ui_changes(before, after)
+        opencv_score = VisualAnalyzer(use_native=False).detect_ui_changes(before, after)
+        assert native_score == pytest.approx(opencv_score)
+
+    def test_check_visual_quality_matches_opencv(self, loaded):
+        """Test that both paths report the same quality metrics."""
+        img = random_pair((120, 160, 3), seed=11)[0]
+        fast = VisualAnalyzer().check_visual_quality(img)
+        reference = VisualAnalyzer(use_native=False).check_visual_quality(img)
+        assert fast.keys() == reference.keys()
+        for key, value in reference.items():
+            assert fast[key] == pytest.approx(value)
+
+    def test_diff_overlay_matches_opencv(self, loaded):
+        """Test that both paths give the same overlay and regions."""
+        before, after = random_pair((120, 160, 3), seed=8)
+        fast = VisualAnalyzer().diff_overlay(before, after)
+        reference = VisualAnalyzer(use_native=False).diff_overlay(before, after)
+        np.testing.assert_array_equal(fast['overlay'], reference['overlay'])
+        assert fast['regions'] == reference['regions']
+        assert fast['change_ratio'] == pytest.approx(reference['change_ratio'])
+
+    def test_create_diff_images(self, loaded, tmp_path):
+        """Test writing diff images for many in-memory pairs in parallel."""
+        pairs = [random_pair((48, 64, 3), seed=s) for s in range(5)]
+        paths = VisualAnalyzer().create_diff_images(pairs, output_dir=tmp_path, max_workers=3)
+        assert len(set(paths)) == 5
+        for (before, after), path in zip(pairs, paths):
+            expected = VisualAnalyzer(use_native=False).diff_overlay(before, after)['overlay']
+            np.testing.assert_array_equal(cv2.imread(str(path)), expected)
+
+    def test_detect_ui_changes_batch(self, loaded):
+        """Test batch scoring on the thread pool."""
+        analyzer = VisualAnalyzer()
+        pairs = [random_pair((64, 64, 3), seed=s) for s in range(6)]
+        scores = analyzer.detect_ui_changes_batch(pairs, max_workers=3)
+        assert scores == [analyzer.detect_ui_changes(b, a) for b, a in pairs]
@@ -0,0 +1,196 @@
+"""
+Unit tests for the MIT-SHM screen capture and its Python binding.
+
+The capture tests run against a private Xvfb server and are skipped when g++,
+the X11 headers or Xvfb are missing.
+"""
+import os
+import shutil
+import subprocess
+import time
+from pathlib import Path
+from unittest.mock import patch
+
+import numpy as np
+import pytest
+
+from src.capture import native_capture
+from src.capture.native_capture import NativeCapture
+from src.capture.screenshot_handler import ScreenshotHandler
+
+REPO_ROOT = Path(__file__).resolve().parents[2]
+XVFB_DISPLAY = ":97"
+
+
+@pytest.fixture(scope="module")
+def capture_lib(tmp_path_factory):
+    """Build the capture library into a temp dir (skipped without g++ or X11)."""
+    if shutil.which("g++") is None:
+        pytest.skip("g++ not available")
+    out = tmp_path_factory.mktemp("capture") / native_capture.library_name()
+    command = ["g++", "-std=c++17", "-O2", "-pthread", "-shared", "-fPIC", "-fvisibility=hidden", f"-I{REPO_ROOT}",
+               str(REPO_ROOT / "native" / "ux_capture.cpp"), "-o", str(out), "-lX11", "-lXext"]
+    # With damage tracking when libXdamage is installed
+    result = subprocess.run(command + ["-DUX_CAPTURE_DAMAGE=1", "-lXdamage", "-lXfixes"],
+                            capture_output=True, text=True)
+    if result.returncode != 0:
+        result = subprocess.run(command, capture_output=True, text=True)
+    if result.returncode != 0:
+        pytest.skip(f"capture build failed: {result.stderr[:500]}")
+    return out
+
+
+@pytest.fixture(scope="module")
+def xvfb():
+    """A private 320x240 Xvfb display."""
+    if shutil.which("Xvfb") is None:
+        pytest.skip("Xvfb not available")
+    server = subprocess.Popen(["Xvfb", XVFB_DISPLAY, "-screen", "0", "320x240x24", "-nolisten", "tcp"],
+                              stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    socket = Path(f"/tmp/.X11-unix/X{XVFB_DISPLAY[1:]}")
+    for _ in range(100):
+        if socket.exists():
+            break
+        time.sleep(0.05)
+    else:
+        server.kill()
+        pytest.skip("Xvfb did not start")
+    yield XVFB_DISPLAY
+    server.terminate()
+    server.wait()
+
+
+@pytest.fixture
+def loaded(capture_lib, xvfb):
+    """Load the freshly built library against Xvfb and restore the default lookup afterwards."""
+    assert native_capture.load_library(capture_lib) is not None
+    with patch.dict(os.environ, {'DISPLAY': xvfb}):
+        yield xvfb
+    native_capture._library = None
+    native_capture._load_attempted = False
+    native_capture._captures.clear()
+
+
+@pytest.fixture
+def probe_window(loaded):
+    """A red Tk window titled like the test game, mapped on Xvfb."""
+    tkinter = pytest.importorskip("tkinter")
+    root = tkinter.Tk(screenName=loaded)
+    root.title("UX Test Game probe")
+    root.geometry("64x48+10+20")
+    tkinter.Frame(root, width=64, height=48, background="#ff0000").pack()
+    for _ in range(20):
+        root.update()
+        time.sleep(0.01)
+    yield root
+    root.destroy()
+
+
+class TestNativeCapture:
+    """Test cases for NativeCapture on Xvfb."""
+
+    def test_grab_screen(self, loaded):
+        """Test that a grab is a zero-copy BGRX view of the whole screen."""
+        with NativeCapture(display=loaded) as capture:
+            frame = capture.grab()
+            assert frame.pixels.shape == (240, 320, 4)
+            assert not frame.pixels.flags.writeable and not frame.pixels.flags.owndata
+            assert frame.sequence == 1 and frame.timestamp_ns <= time.monotonic_ns()
+            assert frame.bgr((10, 20, 30, 40)).shape == (40, 30, 3)
+            frame.release()
+            assert capture.stats()['frames'] == 1
+
+    def test_grab_window(self, probe_window, loaded):
+        """Test capturing one window found by title."""
+        with NativeCapture(native_capture.GAME_WINDOW_NAME, display=loaded) as capture:
+            with capture.grab() as frame:
+                assert frame.pixels.shape == (48, 64, 4)
+                np.testing.assert_array_equal(frame.bgr()[24, 32], [0, 0, 255])
+
+    def test_missing_window(self, loaded):
+        """Test that an unknown window name is reported."""
+        with pytest.raises(RuntimeError, match="no window"):
+            NativeCapture("no such window", display=loaded)
+
+    def test_background_capture(self, loaded):
+        """Test that the background thread delivers new frames at the requested rate."""
+        with NativeCapture(display=loaded) as capture:
+            assert capture.start(fps=120)
+            sequences = []
+            deadline = time.monotonic() + 0.5
+            last = -1
+            while time.monotonic() < deadline:
+                with capture.latest(after=last, timeout=0.5) as frame:
+                    sequences.append(frame.sequence)
+                    last = frame.sequence
+            capture.stop()
+            assert sequences == sorted(set(sequences))
+            assert capture.stats()['frames'] >= 30
+
+    def test_pinned_frames_are_not_overwritten(self, loaded):
+        """Test that pinned slots are never reused and a full ring drops captures."""
+        with NativeCapture(display=loaded) as capture:
+            frames = []
+            while len(frames) <= native_capture.CAPTURE_SLOTS:
+                frame = capture.grab()
+                if frame is None:
+                    break
+                frames.append(frame)
+            assert len(frames) == native_capture.CAPTURE_SLOTS
+            assert len({frame.pixels.ctypes.data for frame in frames}) == len(frames)
+            assert capture.stats()['dropped'] == 1
+            for frame in frames:
+                frame.release()
+            assert capture.grab() is not None
+
+    def test_damage_triggered_capture(self, probe_window, loaded):
+        """Test that only drawing triggers captures, each carrying the drawn area."""
+        with NativeCapture(native_capture.GAME_WINDOW_NAME, display=loaded) as capture:
+            if not capture.tracks_damage:
+                pytest.skip("built without libXdamage")
+            assert capture.start(fps=60, on_damage=True)
+            with capture.latest(timeout=1.0) as first:
+                assert first.regions == [(0, 0, 64, 48)]
+                sequence = first.sequence
+            # Idle: no frames at all
+            assert capture.latest(after=sequence, timeout=0.3) is None
+
+            tkinter = pytest.importorskip("tkinter")
+            tkinter.Frame(probe_window, width=8, height=6, background="#00ff00").place(x=20, y=10)
+            probe_window.update()
+            with capture.latest(after=sequence, timeout=1.0) as frame:
+                x, y, width, height = frame.regions[0]
+                assert len(frame.regions) == 1
+                assert x <= 20 and y <= 10 and x + width >= 28 and y + height >= 16
+                assert width * height < 64 * 48
+                np.testing.assert_array_equal(frame.bgr()[12, 22], [0, 255, 0])
+            capture.stop()
+            assert capture.stats()['frames'] <= 4
+
+    def test_frames_without_damage_cover_target(self, loaded):
+        """Test that grabs report the whole target without damage tracking or on the first frame."""
+        with NativeCapture(display=loaded) as capture:
+            with capture.grab() as frame:
+                assert frame.regions == [(0, 0, 320, 240)]
+            if capture.tracks_damage:
+                # Nothing was drawn since
+                with capture.grab() as frame:
+                    assert frame.regions == []
+
+    def test_handler_uses_native_capture(self, loaded, tmp_path):
+        """Test that ScreenshotHandler grabs through shared memory when available."""
+        with patch('src.capture.screenshot_handler.ImageGrab.grab') as grab:
+            handler = ScreenshotHandler(storage_dir=str(tmp_path))
+            screenshot = handler.capture_screenshot(region=(0, 0, 100, 50))
+        grab.assert_not_called()
+        assert screenshot.shape == (50, 100, 3)
+
+
+class TestFallback:
+    """Test cases for running without the native capture."""
+
+    def test_no_display(self):
+        """Test that the helpers give None without an X display."""
+        with patch.dict(os.environ, {'DISPLAY': ''}):
+            assert native_capture.get_capture() is None
+            assert native_capture.grab_bgr() is None
@@ -0,0 +1,100 @@
+"""
+Unit tests for the OCR engine.
+"""
+import cv2
+import numpy as np
+import pytest
+
+from src.analysis import native
+from src.analysis.ocr_engine import OCREngine, OCRResult, TesseractAPI
+from src.analysis.ui_element_detector import UIElement, UIElementDetector, UIElementType
+
+
+class RecordingBackend:
+    """Backend that records the images it is handed."""
+
+    def __init__(self):
+        self.images = []
+
+    def recognize(self, image):
+        self.images.append(image)
+        return f"crop {len(self.images)}", 0.9
+
+
+def text_image():
+    """Dark label and light-on-dark label side by side."""
+    image = np.full((80, 320, 3), 230, dtype=np.uint8)
+    cv2.putText(image, "Options", (10, 30), cv2.FONT_HERSHEY_SIMPLEX, 0.5, (20, 20, 20), 1)
+    cv2.rectangle(image, (160, 10), (310, 70), (50, 40, 30), -1)
+    cv2.putText(image, "Quit", (190, 50), cv2.FONT_HERSHEY_SIMPLEX, 0.6, (250, 250, 250), 1)
+    return image
+
+
+class TestOCREngine:
+    """Test cases for OCREngine with a stand-in recognizer."""
+
+    def setup_method(self):
+        """Set up test fixtures."""
+        self.backend = RecordingBackend()
+        self.engine = OCREngine(backend=self.backend)
+
+    def test_batch_hands_binary_buffers(self):
+        """Test that every crop reaches the backend as a dark-on-white 2-D array."""
+        bboxes = [(5, 12, 80, 24), (160, 10, 150, 60)]
+        results = self.engine.extract_text_batch(text_image(), bboxes)
+
+        assert [r.text for r in results] == ["crop 1", "crop 2"]
+        assert [r.bbox for r in results] == bboxes
+        assert results[0].preprocessing['scale'] == 2 and not results[0].preprocessing['inverted']
+        assert results[1].preprocessing['inverted']
+        for image in self.backend.images:
+            assert image.ndim == 2 and image.dtype == np.uint8
+            assert set(np.unique(image)) == {0, 255}
+            # White paper around the text
+            assert image[0].min() == 255 and image[:, 0].min() == 255
+
+    def test_extract_text(self):
+        """Test single regions, the whole image and empty batches."""
+        image = text_image()
+        result = self.engine.extract_text(image, (5, 12, 80, 24))
+        assert isinstance(result, OCRResult) and result.confidence == 0.9
+        assert self.engine.extract_text(image).bbox == (0, 0, 320, 80)
+        assert self.engine.extract_text_batch(image, []) == []
+
+    def test_without_preprocessing(self):
+        """Test that plain grayscale crops are passed when preprocessing is off."""
+        engine = OCREngine(preprocessing=False, backend=self.backend)
+        engine.extract_text(text_image(), (5, 12, 80, 24))
+        expected = cv2.cvtColor(text_image(), cv2.COLOR_BGR2GRAY)[12:36, 5:85]
+        np.testing.assert_array_equal(self.backend.images[-1], expected)
+
+    def test_detector_batches_ocr(self):
+        """Test that the detector recognizes all text-bearing elements in one batch."""
+        detector = UIElementDetector(enable_ocr=False)
+        detector.ocr_engine = OCREngine(backend=self.backend)
+        elements = [
+            UIElement(UIElementType.TEXT, (5, 12, 80, 24), 0.7),
+            UIElement(UIElementType.BUTTON, (160, 10, 150, 60), 0.8),
+            UIElement(UIElementType.CONTAINER, (0, 0, 320, 80), 0.5),
+            UIElement(UIElementType.TEXT, (0, 0, 8, 8), 0.7),
+        ]
+        calls = []
+        batch = detector.ocr_engine.extract_text_batch
+        detector.ocr_engine.extract_text_batch = lambda image, bboxes: calls.append(bboxes) or batch(image, bboxes)
+
+        result = detector._extract_text_from_elements(elements, text_image())
+        assert calls == [[(5, 12, 80, 24), (160, 10, 150, 60)]]
+        assert [e.text_content for e in result] == ["crop 1", "crop 2", None, None]
+
+
+@pytest.mark.skipif(TesseractAPI.load_library() is None, reason="libtesseract not installed")
+class TestTesseractAPI:
+    """Test cases for the Tesseract C API binding."""
+
+    def test_recognizes_preprocessed_crop(self):
+        """Test recognition straight from the preprocessed buffer."""
+        image = np.full((40, 200, 3), 255, dtype=np.uint8)
+        cv2.putText(image, "HELLO", (10, 30), cv2.FONT_HERSHEY_SIMPLEX, 0.9, (0, 0, 0), 2)
+        crop = native.prepare_ocr_crops(image, [(0, 0, 200, 40)])[0]['image']
+        text, confidence = TesseractAPI().recognize(crop)
+        assert "HELLO" in text.upper() and confidence > 0.5
@@ -0,0 +1,66 @@
+"""
+Unit tests for the pipeline result cache helpers.
+"""
+import numpy as np
+import pytest
+
+from src.analysis import native, result_cache
+from src.analysis.result_cache import content_key, decode_result, encode_result
+
+
+class TestContentKey:
+    """Test cases for content-addressed stage keys."""
+
+    def test_frames_are_keyed_by_pixels(self):
+        """Test that frames with the same repr but different pixels get different keys."""
+        a = np.zeros((480, 640, 3), np.uint8)
+        b = a.copy()
+        b[240, 320] = 1
+        assert repr(a) == repr(b)
+        assert content_key(a) != content_key(b)
+        assert content_key(a) == content_key(a.copy())
+
+    def test_shape_dtype_and_structure(self):
+        """Test that dtype, shape, nesting and dict order are handled."""
+        a = np.zeros(12, np.uint8)
+        assert content_key(a) != content_key(a.reshape(3, 4))
+        assert content_key(a) != content_key(a.view(np.int8))
+        assert content_key({'x': 1, 'frame': a}) == content_key({'frame': a.copy(), 'x': 1})
+        assert content_key([1, 2]) != content_key([[1, 2]])
+        assert content_key({'path': 'a.png'}) != content_key({'path': 'b.png'})
+
+
+class TestEncoding:
+    """Test cases for result serialization."""
+
+    def test_array_roundtrip(self):
+        """Test that arrays come back as aligned, writable views of the buffer."""
+        img = np.arange(2 * 3 * 4, dtype=np.float32).reshape(2, 3, 4)[:, ::2]
+        data = bytearray(encode_result(img))
+        decoded = decode_result(data)
+        np.testing.assert_array_equal(decoded, img)
+        assert decoded.dtype == img.dtype and decoded.flags.writeable and decoded.flags.aligned
+        assert np.shares_memory(decoded, np.frombuffer(data, np.uint8))
+
+    def test_empty_array_and_objects(self):
+        """Test an empty array and pickled results."""
+        assert decode_result(bytearray(encode_result(np.zeros((0, 3), np.uint8)))).shape == (0, 3)
+        result = {'elements': [{'type': 'button', 'bbox': (1, 2, 3, 4)}], 'score': 0.5}
+        assert decode_result(bytearray(encode_result(result))) == result
+        with pytest.raises(ValueError):
+            decode_result(bytearray(b'?'))
+
+
+class TestGetResultCache:
+    """Test cases for the process-wide cache."""
+
+    def test_shared_per_path(self, tmp_path):
+        """Test that one cache is opened per path and stores encoded results."""
+        path = tmp_path / "results.log"
+        cache = result_cache.get_result_cache(path, max_bytes=1 << 20)
+        try:
+            assert result_cache.get_result_cache(path) is cache
+            assert cache.put("stage:v1:key", encode_result(np.ones(4)), ttl=60)
+            np.testing.assert_array_equal(decode_result(cache.get("stage:v1:key")), np.ones(4))
+        finally:
+            result_cache._caches.pop(path.resolve()).close()
@@ -5,11 +5,15 @@ import json
 import tempfile
 from pathlib import Path
 from unittest.mock import Mock, patch, mock_open, MagicMock
+import cv2
+import numpy as np
 import pytest
 import unittest
 from datetime import datetime
 
+from src.capture.capture_catalog import CaptureCatalog
 from src.capture.screenshot import ScreenshotCapture
+from src.capture.screenshot_handler import ScreenshotHandler
 
 
 class TestScreenshotCapture(unittest.TestCase):
@@ -42,9 +46,7 @@ class TestScreenshotCapture(unittest.TestCase):
         mock_screenshot.size = (1920, 1080)
         mock_grab.return_value = mock_screenshot
         
-        # Mock file operations
-        with patch('builtins.open', mock_open()) as mock_file:
-            filepath, metadata = self.capture.capture_screenshot("test")
+        filepath, metadata = self.capture.capture_screenshot("test")
         
         # Verify results - timestamp should be truncated to milliseconds
         expected_timestamp = "20240101_120000_123"  # [:-3] truncation
@@ -57,8 +59,12 @@ class TestScreenshotCapture(unittest.TestCase):
         # Verify screenshot was saved
         mock_screenshot.save.assert_called_once()
         
-        # Verify metadata was saved
-        mock_file.assert_called()
+        # Verify metadata was catalogued instead of written next to the image
+        assert not filepath.with_suffix('.json').exists()
+        record = self.capture.catalog.get(filepath.name)
+        assert record.label == "test"
+        assert (record.width, record.height) == (1920, 1080)
+        assert self.capture.load_metadata(filepath)['timestamp'] == expected_timestamp
     
     @patch('src.capture.screenshot.ImageGrab.grab')
     def test_capture_screenshot_failure(self, mock_grab):
@@ -99,11 +105,11 @@ class TestScreenshotCapture(unittest.TestCase):
         mock_screenshot.size = (1920, 1080)
         mock_grab.return_value = mock_screenshot
 
-        with patch('builtins.open', mock_open()):
-            filepath, metadata = self.capture.capture_before("test content")
+        filepath, metadata = self.capture.capture_before("test content")
 
         assert "_before.png" in filepath.name
         assert metadata['expected_content'] == "test content"
+        assert self.capture.load_metadata(filepath)['expected_content'] == "test content"
     
     @patch('src.capture.screenshot.ImageGrab.grab')
     @patch('src.capture.screenshot.datetime')
@@ -124,133 +130,155 @@ class TestScreenshotCapture(unittest.TestCase):
         assert "_after.png" in filepath.name
         assert metadata['expected_content'] == "test content"
     
-    @patch.object(Path, 'glob')
-    def test_find_latest_pair_no_files(self, mock_glob):
+    def add_capture(self, name, label, timestamp, file_bytes=0):
+        """Catalog a capture and write its (empty) image file."""
+        catalog = self.capture.catalog
+        (Path(self.temp_dir) / name).write_bytes(b'')
+        return catalog.add(name, label, 1920, 1080, file_bytes=file_bytes, timestamp=timestamp)
+    
+    def test_find_latest_pair_no_files(self):
         """Test find_latest_pair with no files."""
-        mock_glob.return_value = []
+        self.add_capture("20240101_120000_123_before.png", "before", 1000.0)
         
         before_file, after_file = self.capture.find_latest_pair()
         
         assert before_file is None
         assert after_file is None
     
-    @patch.object(Path, 'glob')
-    def test_find_latest_pair_with_files(self, mock_glob):
+    def test_find_latest_pair_with_files(self):
         """Test find_latest_pair with files."""
-        # Mock files
-        before_file = Mock()
-        before_file.name = "20240101_120000_123_before.png"
-        before_file.stem = "20240101_120000_123_before"
-        after_file = Mock()
-        after_file.name = "20240101_120000_123_after.png"
-        after_file.stem = "20240101_120000_123_after"
+        self.add_capture("a_before.png", "before", 1000.0)
+        self.add_capture("a_after.png", "after", 1004.0)
+        self.add_capture("b_before.png", "before", 1030.0)
+        
+        result_before, result_after = self.capture.find_latest_pair()
         
-        mock_glob.side_effect = [[before_file], [after_file]]
+        # The later 'before' has no 'after' yet; the pair stays together
+        assert result_before == Path(self.temp_dir) / "a_before.png"
+        assert result_after == Path(self.temp_dir) / "a_after.png"
+    
+    def test_find_latest_pair_outside_window(self):
+        """Test that find_latest_pair falls back to the newest of each label."""
+        self.add_capture("a_before.png", "before", 1000.0)
+        self.add_capture("a_after.png", "after", 1020.0)
+        self.add_capture("b_before.png", "before", 1030.0)
         
         result_before, result_after = self.capture.find_latest_pair()
         
-        assert result_before == before_file
-        assert result_after == after_file
+        assert result_before.name == "b_before.png"
+        assert result_after.name == "a_after.png"
     
-    @patch.object(Path, 'glob')
-    def test_list_captures_empty(self, mock_glob):
+    def test_list_captures_empty(self):
         """Test list_captures with no files."""
-        mock_glob.return_value = []
-        
         captures = self.capture.list_captures()
         
         assert captures['total_screenshots'] == 0
         assert captures['files'] == []
     
-    @patch.object(Path, 'glob')
-    def test_list_captures_with_files(self, mock_glob):
+    def test_list_captures_with_files(self):
         """Test list_captures with files."""
-        # Mock file with proper stat method
-        mock_file = Mock()
-        mock_file.name = "20240101_120000_123_before.png"
-        mock_file.with_suffix.return_value.exists.return_value = False
-        
-        # Mock the stat method to return a proper stat result
-        mock_stat_result = Mock()
-        mock_stat_result.st_size = 1024 * 1024  # 1MB
-        mock_file.stat.return_value = mock_stat_result
-
-        mock_glob.return_value = [mock_file]
+        self.add_capture("20240101_120000_123_before.png", "before", 1000.0, file_bytes=1024 * 1024)
+        self.add_capture("20240101_120001_000_test.png", "test", 1001.0)
 
         captures = self.capture.list_captures()
 
-        assert captures['total_screenshots'] == 1
+        assert captures['total_screenshots'] == 2
         assert captures['before_screenshots'] == 1
-        assert captures['latest_capture'] == "20240101_120000_123_before.png"
-        assert len(captures['files']) == 1
-        assert captures['files'][0]['filename'] == "20240101_120000_123_before.png"
-        assert captures['files'][0]['size_mb'] == 1.0
+        assert captures['other_screenshots'] == 1
+        assert captures['latest_capture'] == "20240101_120001_000_test.png"
+        assert len(captures['files']) == 2
+        assert captures['files'][1]['filename'] == "20240101_120000_123_before.png"
+        assert captures['files'][1]['size_mb'] == 1.0
+        assert captures['files'][1]['metadata']['label'] == "before"
     
-    @patch.object(Path, 'glob')
-    def test_clean_old_captures(self, mock_glob):
+    def test_clean_old_captures(self):
         """Test cleaning old captures."""
-        # Create 10 mock files (5 PNG + 5 JSON) with different modification times
-        all_files = []
-        
-        # Create PNG files
         for i in range(5):
-            mock_file = Mock()
-            mock_file.name = f"file_{i}.png"
-            mock_stat_result = Mock()
-            mock_stat_result.st_mtime = i  # Different timestamps
-            mock_file.stat.return_value = mock_stat_result
-            mock_file.unlink = Mock()
-            all_files.append(mock_file)
-        
-        # Create JSON files
-        for i in range(5):
-            mock_file = Mock()
-            mock_file.name = f"file_{i}.json"
-            mock_stat_result = Mock()
-            mock_stat_result.st_mtime = i + 5  # Different timestamps
-            mock_file.stat.return_value = mock_stat_result
-            mock_file.unlink = Mock()
-            all_files.append(mock_file)
-
-        # Mock glob to return PNG files first, then JSON files
-        mock_glob.side_effect = [all_files[:5], all_files[5:]]
+            self.add_capture(f"file_{i}.png", "test", 1000.0 + i)
 
         deleted_count = self.capture.clean_old_captures(keep_count=2)
 
-        # With 10 files total, keep_count=2 means keep 4 files (2*2)
-        # So should delete 6 files
-        assert deleted_count == 6
+        # The three oldest images go, from the directory and the catalog
+        assert deleted_count == 3
+        assert sorted(f.name for f in Path(self.temp_dir).glob("*.png")) == ["file_3.png", "file_4.png"]
+        assert [c.name for c in self.capture.catalog.captures()] == ["file_4.png", "file_3.png"]
+        assert self.capture.clean_old_captures(keep_count=2) == 0
+    
+    def test_imports_json_sidecars(self):
+        """Test that a directory of images with JSON sidecars is catalogued once."""
+        legacy = Path(tempfile.mkdtemp())
+        for name, label in (("20240101_120000_000_before.png", "before"), ("20240101_120005_000_after.png", "after")):
+            (legacy / name).write_bytes(b'png')
+            metadata = {'filename': name, 'label': label, 'size': [800, 600], 'expected_content': label}
+            (legacy / name).with_suffix('.json').write_text(json.dumps(metadata))
+        
+        capture = ScreenshotCapture(output_dir=str(legacy))
+        before_file, after_file = capture.find_latest_pair()
         
-        # The implementation sorts all files by mtime and keeps the newest 4
-        # Files with mtime 9,8,7,6 should be kept (newest 4)
-        # Files with mtime 5,4,3,2,1,0 should be deleted (oldest 6)
+        assert after_file.name == "20240101_120005_000_after.png"
+        assert capture.load_metadata(before_file)['expected_content'] == "before"
+        assert capture.list_captures()['files'][0]['metadata']['size'] == (800, 600)
+        assert list(legacy.glob("*.json")) == []
+    
+    def legacy_directory(self, count=2):
+        """A directory of images with JSON sidecars, as older versions wrote them."""
+        legacy = Path(tempfile.mkdtemp())
+        for i in range(count):
+            name = f"20240101_12000{i}_000_before.png"
+            (legacy / name).write_bytes(b'png')
+            (legacy / name).with_suffix('.json').write_text(json.dumps({'filename': name, 'label': 'before'}))
+        return legacy
+    
+    def test_sidecar_import_resumes_after_failure(self):
+        """Test that sidecars are kept until every image is catalogued."""
+        legacy = self.legacy_directory()
+        with patch('src.capture.screenshot.image_hash', side_effect=[0, OSError("disk full")]):
+            with pytest.raises(OSError):
+                ScreenshotCapture(output_dir=str(legacy)).catalog
+        assert len(list(legacy.glob("*.json"))) == 2
         
-        # Count how many unlink calls were made
-        total_unlink_calls = sum(1 for f in all_files if f.unlink.called)
-        assert total_unlink_calls == 6
+        capture = ScreenshotCapture(output_dir=str(legacy))
+        assert capture.catalog.count() == 2
+        assert list(legacy.glob("*.json")) == []
+    
+    def test_sidecars_kept_without_persistent_catalog(self):
+        """Test that sidecars imported into an in-memory catalog stay on disk."""
+        legacy = self.legacy_directory(count=1)
+        holder = CaptureCatalog(legacy / "catalog")
+        capture = ScreenshotCapture(output_dir=str(legacy))
+        assert not capture.catalog.persistent and capture.catalog.count() == 1
+        assert len(list(legacy.glob("*.json"))) == 1
+        holder.close()
+    
+    def test_imported_captures_are_not_duplicates(self):
+        """Test that imported images get real content hashes, so distinct ones are kept."""
+        legacy = Path(tempfile.mkdtemp())
+        for i, name in enumerate(("20240101_120000_000_before.png", "20240101_120005_000_after.png")):
+            cv2.imwrite(str(legacy / name), np.random.default_rng(i).integers(0, 256, (60, 80, 3), np.uint8))
+            (legacy / name).with_suffix('.json').write_text(json.dumps({'filename': name, 'size': [80, 60]}))
+        
+        capture = ScreenshotCapture(output_dir=str(legacy))
+        hashes = {c.content_hash for c in capture.catalog.captures()}
+        assert len(hashes) == 2 and 0 not in hashes
+        
+        handler = ScreenshotHandler(storage_dir=str(legacy))
+        assert handler.cleanup_duplicates() == 0
+        assert len(list(legacy.glob("*.png"))) == 2
     
     def test_load_metadata_file_not_exists(self):
-        """Test load_metadata when file doesn't exist."""
-        with patch.object(Path, 'exists', return_value=False):
-            metadata = self.capture.load_metadata(Path("nonexistent.json"))
-            assert metadata == {}
+        """Test load_metadata for an image that is not catalogued."""
+        metadata = self.capture.load_metadata(Path("nonexistent.png"))
+        assert metadata == {}
     
     def test_load_metadata_success(self):
         """Test successful metadata loading."""
-        test_metadata = {"test": "data"}
+        self.capture.catalog.add("test.png", "before", 640, 480, extra={"test": "data"}, timestamp=1000.0)
         
-        with patch.object(Path, 'exists', return_value=True):
-            with patch('builtins.open', mock_open(read_data=json.dumps(test_metadata))):
-                metadata = self.capture.load_metadata(Path("test.json"))
-                assert metadata == test_metadata
-    
-    def test_load_metadata_json_error(self):
-        """Test metadata loading with JSON error."""
-        with patch.object(Path, 'exists', return_value=True):
-            with patch('builtins.open', mock_open(read_data="invalid json")):
-                metadata = self.capture.load_metadata(Path("test.json"))
-                assert metadata == {}
-
+        metadata = self.capture.load_metadata(Path(self.temp_dir) / "test.png")
+        
+        assert metadata['test'] == "data"
+        assert metadata['label'] == "before"
+        assert metadata['size'] == (640, 480)
 
 if __name__ == '__main__':
     unittest.main() 
\ No newline at end of file
@@ -0,0 +1,89 @@
+"""
+Unit tests for harness timeline tracing.
+"""
+import json
+import threading
+
+from src.ux_tester.trace import TraceRecorder
+
+
+class TestTraceRecorder:
+    """Test cases for TraceRecorder class."""
+
+    def setup_method(self):
+        """Set up test fixtures."""
+        self.tracer = TraceRecorder(enabled=True)
+
+    def test_disabled_records_nothing(self):
+        """Test that a disabled recorder is a no-op."""
+        tracer = TraceRecorder()
+        with tracer.span("capture"):
+            tracer.instant("state")
+        assert tracer.events() == []
+
+    def test_span_records_begin_and_end(self):
+        """Test that spans emit a matching begin/end pair."""
+        with self.tracer.span("capture_screenshot", "capture", label="before"):
+            pass
+
+        events = [e for e in self.tracer.events() if e['ph'] != 'M']
+        assert [e['ph'] for e in events] == ['B', 'E']
+        assert events[0]['name'] == events[1]['name'] == "capture_screenshot"
+        assert events[0]['cat'] == "capture"
+        assert events[0]['args'] == {'label': 'before'}
+        assert events[0]['ts'] <= events[1]['ts']
+
+    def test_span_closes_on_exception(self):
+        """Test that the end event is recorded when the block raises."""
+        try:
+            with self.tracer.span("encode"):
+                raise RuntimeError("boom")
+        except RuntimeError:
+            pass
+
+        phases = [e['ph'] for e in self.tracer.events() if e['ph'] != 'M']
+        assert phases == ['B', 'E']
+
+    def test_threads_get_separate_tracks(self):
+        """Test that each thread records into its own buffer."""
+        def worker():
+            for _ in range(100):
+                self.tracer.instant("task")
+
+        threads = [threading.Thread(target=worker, name=f"worker-{i}") for i in range(4)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+
+        events = self.tracer.events()
+        names = {e['args']['name'] for e in events if e['ph'] == 'M'}
+        assert names == {f"worker-{i}" for i in range(4)}
+        assert sum(1 for e in events if e['name'] == "task") == 400
+
+    def test_counter_and_clear(self):
+        """Test counter events and clearing the buffers."""
+        self.tracer.counter("queue_depth", 3)
+        counters = [e for e in self.tracer.events() if e['ph'] == 'C']
+        assert counters[0]['args'] == {'value': 3}
+
+        self.tracer.clear()
+        assert [e for e in self.tracer.events() if e['ph'] != 'M'] == []
+
+    def test_export_merges_game_trace(self, tmp_path):
+        """Test exporting a Chrome JSON trace merged with the game's trace."""
+        game_trace = tmp_path / "game.json"
+        game_trace.write_text(json.dumps({'traceEvents': [
+            {'ph': 'B', 'name': 'frame', 'cat': 'game', 'ts': 1.0, 'pid': 99, 'tid': 1},
+            {'ph': 'E', 'name': 'frame', 'cat': 'game', 'ts': 2.0, 'pid': 99, 'tid': 1}
+        ]}))
+        with self.tracer.span("capture_screenshot", "capture"):
+            pass
+
+        output = tmp_path / "merged.json"
+        assert self.tracer.export_chrome_json(output, [game_trace, tmp_path / "missing.json"])
+
+        data = json.loads(output.read_text())
+        names = [e['name'] for e in data['traceEvents']]
+        assert names.count("frame") == 2
+        assert names.count("capture_screenshot") == 2
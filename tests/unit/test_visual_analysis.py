@@ -1,6 +1,7 @@
 """
 Unit tests for visual analysis functionality.
 """
+import cv2
 import numpy as np
 from pathlib import Path
 from unittest.mock import Mock, patch
@@ -14,7 +15,7 @@ class TestVisualAnalyzer:
     
     def setup_method(self):
         """Set up test fixtures."""
-        self.analyzer = VisualAnalyzer(ui_change_threshold=0.05)
+        self.analyzer = VisualAnalyzer(ui_change_threshold=0.05, use_native=False)
     
     def test_init(self):
         """Test analyzer initialization."""
@@ -224,29 +225,26 @@ class TestVisualAnalyzer:
         
         assert 'error' in analysis['results']
     
-    @patch('src.analysis.visual_analysis.cv2')
     @patch('src.analysis.visual_analysis.datetime')
-    def test_create_diff_image_success(self, mock_datetime, mock_cv2):
+    def test_create_diff_image_success(self, mock_datetime, tmp_path):
         """Test successful difference image creation."""
-        before_path = Mock()
-        after_path = Mock()
-        
-        # Mock images
-        mock_img = np.zeros((100, 100, 3), dtype=np.uint8)
-        mock_cv2.imread.return_value = mock_img
-        mock_cv2.absdiff.return_value = mock_img
-        mock_cv2.convertScaleAbs.return_value = mock_img
+        before_img = np.zeros((100, 100, 3), dtype=np.uint8)
+        after_img = before_img.copy()
+        after_img[10:20, 30:50] = 200
+        before_path, after_path = tmp_path / "before.png", tmp_path / "after.png"
+        cv2.imwrite(str(before_path), before_img)
+        cv2.imwrite(str(after_path), after_img)
         
         # Mock datetime
         mock_datetime.now.return_value.strftime.return_value = "20240101_120000"
         
-        # Mock parent directory
-        before_path.parent = Path("/test")
-        
         output_path = self.analyzer.create_diff_image(before_path, after_path)
         
-        assert output_path is not None
-        mock_cv2.imwrite.assert_called_once()
+        assert output_path == tmp_path / "20240101_120000_diff.png"
+        overlay = cv2.imread(str(output_path))
+        # Changed pixels tinted red over the dimmed after frame
+        assert tuple(overlay[15, 40]) == (100, 100, 228)
+        assert tuple(overlay[50, 50]) == (0, 0, 0)
     
     @patch('src.analysis.visual_analysis.cv2')
     def test_create_diff_image_load_error(self, mock_cv2):
@@ -274,13 +272,26 @@ class TestVisualAnalyzer:
         mock_cv2.imread.side_effect = [before_img, after_img]
         mock_cv2.resize.return_value = before_img
         mock_cv2.absdiff.return_value = before_img
-        mock_cv2.convertScaleAbs.return_value = before_img
+        mock_cv2.cvtColor.return_value = before_img[:, :, 0]
         
-        # Mock parent directory
-        before_path.parent = Path("/test")
-        
-        output_path = self.analyzer.create_diff_image(before_path, after_path)
+        output_path = self.analyzer.create_diff_image(before_path, after_path, Path("/test/diff.png"))
         
         # Should call resize
         mock_cv2.resize.assert_called()
-        assert output_path is not None 
\ No newline at end of file
+        assert output_path == Path("/test/diff.png")
+        mock_cv2.imwrite.assert_called_once()
+    
+    def test_diff_overlay_from_frame_store(self):
+        """Test that string ids are resolved through the frame store."""
+        store = Mock()
+        before_img = np.zeros((64, 64, 3), dtype=np.uint8)
+        after_img = before_img.copy()
+        after_img[5:10, 40:60] = 255
+        store.load_screenshot.side_effect = lambda frame_id: {'a': before_img, 'b': after_img}[frame_id]
+        analyzer = VisualAnalyzer(use_native=False, frame_store=store)
+        
+        results = analyzer.diff_overlay_batch([('a', 'b'), ('b', 'b')], max_workers=2)
+        
+        assert results[0]['regions'] == [(40, 5, 20, 5)]
+        assert results[0]['change_ratio'] == pytest.approx(100 / 4096)
+        assert results[1]['regions'] == []
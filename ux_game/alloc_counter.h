@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Process-wide heap allocation counter.
+//
+// Define UX_ALLOC_COUNTER_IMPLEMENTATION in exactly one translation unit before
+// including this header to replace the global operator new/delete with counting
+// versions (same pattern as OLC_PGE_APPLICATION).
+namespace ux {
+
+inline std::atomic<uint64_t> g_allocCount{0};
+inline std::atomic<uint64_t> g_allocBytes{0};
+
+inline uint64_t AllocationCount() { return g_allocCount.load(std::memory_order_relaxed); }
+inline uint64_t AllocationBytes() { return g_allocBytes.load(std::memory_order_relaxed); }
+
+} // namespace ux
+
+#ifdef UX_ALLOC_COUNTER_IMPLEMENTATION
+#undef UX_ALLOC_COUNTER_IMPLEMENTATION
+#include <cstdlib>
+#include <new>
+
+// Kept out of line so GCC does not pair the inlined malloc/free with new/delete
+// expressions at call sites (-Wmismatched-new-delete false positives)
+#if defined(__GNUC__)
+#define UX_ALLOC_NOINLINE __attribute__((noinline))
+#else
+#define UX_ALLOC_NOINLINE
+#endif
+
+UX_ALLOC_NOINLINE void* operator new(std::size_t size)
+{
+    ux::g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    ux::g_allocBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+UX_ALLOC_NOINLINE void operator delete(void* p) noexcept { std::free(p); }
+UX_ALLOC_NOINLINE void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#endif // UX_ALLOC_COUNTER_IMPLEMENTATION
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string_view>
+
+#include "ux_game/raster.h"
+#include "ux_game/simd_fill.h"
+
+// Colour-vision-deficiency simulation as a final pass over a finished frame.
+//
+// Each pixel is decoded to linear light (sRGB LUT), multiplied by the 3x3
+// dichromacy matrix (Machado, Oliveira & Fernandes 2009, severity 1.0) and
+// re-encoded through a 4096-entry linear->sRGB table. SimulateCvdAll decodes
+// each pixel once and writes all three variants, so an accessibility capture of
+// one simulated frame costs one pass rather than three separate runs.
+namespace ux {
+
+enum class Cvd { Protanopia, Deuteranopia, Tritanopia };
+
+constexpr int kCvdCount = 3;
+
+inline const char* CvdName(Cvd type)
+{
+    switch (type) {
+        case Cvd::Protanopia: return "protanopia";
+        case Cvd::Deuteranopia: return "deuteranopia";
+        case Cvd::Tritanopia: break;
+    }
+    return "tritanopia";
+}
+
+// Accepts the full name or its prefix ("protan", "deutan", "tritan")
+inline bool ParseCvd(std::string_view text, Cvd& type)
+{
+    for (int i = 0; i < kCvdCount; i++) {
+        std::string_view name = CvdName(Cvd(i));
+        if (text.size() >= 6 && name.compare(0, text.size(), text) == 0) {
+            type = Cvd(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+namespace detail {
+
+// Row-major, applied to linear RGB
+constexpr float kCvdMatrices[kCvdCount][9] = {
+    { 0.152286f,  1.052583f, -0.204868f,
+      0.114503f,  0.786281f,  0.099216f,
+     -0.003882f, -0.048116f,  1.051998f},
+    { 0.367322f,  0.860646f, -0.227968f,
+      0.280085f,  0.672501f,  0.047413f,
+     -0.011820f,  0.042940f,  0.968881f},
+    { 1.255528f, -0.076749f, -0.178779f,
+     -0.078411f,  0.930809f,  0.147602f,
+      0.004733f,  0.691367f,  0.303900f},
+};
+
+constexpr int kSrgbEncodeSize = 4096;
+
+struct CvdTables {
+    float toLinear[256];
+    int32_t toSrgb[kSrgbEncodeSize]; // int32 so the AVX2 path can gather from it
+
+    CvdTables()
+    {
+        for (int i = 0; i < 256; i++) {
+            float c = float(i) / 255.0f;
+            toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        for (int i = 0; i < kSrgbEncodeSize; i++) {
+            float l = float(i) / float(kSrgbEncodeSize - 1);
+            float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+            toSrgb[i] = int32_t(std::lround(std::min(std::max(c, 0.0f), 1.0f) * 255.0f));
+        }
+    }
+};
+
+inline const CvdTables& Tables()
+{
+    static const CvdTables tables;
+    return tables;
+}
+
+inline int32_t EncodeIndex(float v)
+{
+    v = std::min(std::max(v, 0.0f), 1.0f);
+    return int32_t(v * float(kSrgbEncodeSize - 1) + 0.5f);
+}
+
+inline void CvdSpanScalar(const uint32_t* src, uint32_t* const* dst, const int* types, int count, int32_t n)
+{
+    const CvdTables& t = Tables();
+    for (int32_t i = 0; i < n; i++) {
+        const uint32_t p = src[i];
+        const float r = t.toLinear[p & 0xFF], g = t.toLinear[(p >> 8) & 0xFF], b = t.toLinear[(p >> 16) & 0xFF];
+        for (int k = 0; k < count; k++) {
+            const float* m = kCvdMatrices[types[k]];
+            const int32_t ro = t.toSrgb[EncodeIndex(m[0] * r + m[1] * g + m[2] * b)];
+            const int32_t go = t.toSrgb[EncodeIndex(m[3] * r + m[4] * g + m[5] * b)];
+            const int32_t bo = t.toSrgb[EncodeIndex(m[6] * r + m[7] * g + m[8] * b)];
+            dst[k][i] = (p & 0xFF000000u) | uint32_t(ro) | uint32_t(go) << 8 | uint32_t(bo) << 16;
+        }
+    }
+}
+
+#if UX_SIMD_X86
+UX_TARGET_AVX2 inline __m256 CvdRowAVX2(const float* m, __m256 r, __m256 g, __m256 b)
+{
+    return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(m[0]), r),
+                                       _mm256_mul_ps(_mm256_set1_ps(m[1]), g)),
+                         _mm256_mul_ps(_mm256_set1_ps(m[2]), b));
+}
+
+UX_TARGET_AVX2 inline __m256i CvdEncodeAVX2(const CvdTables& t, __m256 v)
+{
+    v = _mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+    const __m256 scaled = _mm256_mul_ps(v, _mm256_set1_ps(float(kSrgbEncodeSize - 1)));
+    const __m256i idx = _mm256_cvttps_epi32(_mm256_add_ps(scaled, _mm256_set1_ps(0.5f)));
+    return _mm256_i32gather_epi32(t.toSrgb, idx, 4);
+}
+
+// Eight pixels per step; same operation order as the scalar path, so both
+// produce identical output.
+UX_TARGET_AVX2 inline void CvdSpanAVX2(const uint32_t* src, uint32_t* const* dst, const int* types, int count,
+                                       int32_t n)
+{
+    const CvdTables& t = Tables();
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    const __m256i alphaMask = _mm256_set1_epi32(int(0xFF000000u));
+
+    int32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        const __m256 r = _mm256_i32gather_ps(t.toLinear, _mm256_and_si256(p, byteMask), 4);
+        const __m256 g = _mm256_i32gather_ps(t.toLinear, _mm256_and_si256(_mm256_srli_epi32(p, 8), byteMask), 4);
+        const __m256 b = _mm256_i32gather_ps(t.toLinear, _mm256_and_si256(_mm256_srli_epi32(p, 16), byteMask), 4);
+        const __m256i alpha = _mm256_and_si256(p, alphaMask);
+        for (int k = 0; k < count; k++) {
+            const float* m = kCvdMatrices[types[k]];
+            const __m256i ro = CvdEncodeAVX2(t, CvdRowAVX2(m, r, g, b));
+            const __m256i go = CvdEncodeAVX2(t, CvdRowAVX2(m + 3, r, g, b));
+            const __m256i bo = CvdEncodeAVX2(t, CvdRowAVX2(m + 6, r, g, b));
+            const __m256i out = _mm256_or_si256(_mm256_or_si256(alpha, ro),
+                                                _mm256_or_si256(_mm256_slli_epi32(go, 8), _mm256_slli_epi32(bo, 16)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst[k] + i), out);
+        }
+    }
+
+    uint32_t* tails[kCvdCount];
+    for (int k = 0; k < count; k++) tails[k] = dst[k] + i;
+    CvdSpanScalar(src + i, tails, types, count, n - i);
+}
+#endif
+
+inline void CvdSpan(const uint32_t* src, uint32_t* const* dst, const int* types, int count, int32_t n)
+{
+#if UX_SIMD_X86
+    if (simd::ActiveLevel() == simd::Level::AVX2) {
+        CvdSpanAVX2(src, dst, types, count, n);
+        return;
+    }
+#endif
+    CvdSpanScalar(src, dst, types, count, n);
+}
+
+} // namespace detail
+
+// Writes the simulated frame to dst (same size as src; may be src itself)
+inline void SimulateCvd(const Canvas& src, const Canvas& dst, Cvd type)
+{
+    const int types[1] = {int(type)};
+    const int32_t w = std::min(src.width, dst.width), h = std::min(src.height, dst.height);
+    for (int32_t y = 0; y < h; y++) {
+        uint32_t* out[1] = {dst.Row(y)};
+        detail::CvdSpan(src.Row(y), out, types, 1, w);
+    }
+}
+
+// Writes all three variants (indexed by Cvd) from a single pass over src
+inline void SimulateCvdAll(const Canvas& src, const Canvas (&dst)[kCvdCount])
+{
+    const int types[kCvdCount] = {0, 1, 2};
+    int32_t w = src.width, h = src.height;
+    for (const Canvas& c : dst) {
+        w = std::min(w, c.width);
+        h = std::min(h, c.height);
+    }
+    for (int32_t y = 0; y < h; y++) {
+        uint32_t* out[kCvdCount] = {dst[0].Row(y), dst[1].Row(y), dst[2].Row(y)};
+        detail::CvdSpan(src.Row(y), out, types, kCvdCount, w);
+    }
+}
+
+} // namespace ux
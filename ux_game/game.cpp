@@ -0,0 +1,397 @@
+#include "ux_game/game.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "ux_game/hud.h"
+
+namespace ux {
+
+Game::Game(int32_t width, int32_t height, uint32_t seed)
+    : width(width), height(height), ui(UiScale(width, height)), gen(seed)
+{
+    auto button = [this](int32_t x, int32_t y, int32_t w, int32_t h, const char* text, uint32_t color) {
+        return Button{float(Px(x)), float(Px(y)), float(Px(w)), float(Px(h)), text, color, true};
+    };
+
+    // Initialize menu buttons
+    menuButtons.push_back(button(50, 100, 150, 40, "Start Game", GREEN));
+    menuButtons.push_back(button(50, 160, 150, 40, "Settings", BLUE));
+    menuButtons.push_back(button(50, 220, 150, 40, "Exit", RED));
+
+    // Initialize settings buttons
+    settingsButtons.push_back(button(50, 100, 100, 30, "Volume -", YELLOW));
+    settingsButtons.push_back(button(160, 100, 100, 30, "Volume +", YELLOW));
+    settingsButtons.push_back(button(50, 150, 200, 30, "Toggle Fullscreen", CYAN));
+    settingsButtons.push_back(button(50, 200, 100, 30, "Easy", GREEN));
+    settingsButtons.push_back(button(160, 200, 100, 30, "Medium", YELLOW));
+    settingsButtons.push_back(button(270, 200, 100, 30, "Hard", RED));
+    settingsButtons.push_back(button(50, 280, 100, 30, "Back", WHITE));
+
+    playerSpeed *= float(ui);
+}
+
+void Game::Update(const InputFrame& input)
+{
+    gameTime += input.dt;
+
+    switch (currentState) {
+        case MENU:
+            UpdateMenu(input);
+            break;
+        case PLAYING:
+            UpdateGame(input);
+            break;
+        case SETTINGS:
+            UpdateSettings(input);
+            break;
+        case GAME_OVER:
+            UpdateGameOver(input);
+            break;
+    }
+}
+
+void Game::Render(const Canvas& canvas) const
+{
+    RenderView(MakeView(canvas, ui, recorder));
+}
+
+void Game::Render(const Canvas& canvas, RenderCache& cache) const
+{
+    RenderView(MakeView(canvas, ui, recorder), cache);
+}
+
+void Game::Render(RenderTarget& target) const
+{
+    const int32_t viewUi = target.ui > 0 ? target.ui : UiScale(target.canvas.width, target.canvas.height);
+    RenderView(MakeView(target.canvas, viewUi, target.record), target.cache);
+}
+
+void Game::Render(const Canvas& canvas, RenderCache& cache, std::vector<RenderTarget>& targets,
+                  WorkerPool& pool) const
+{
+    pool.Run(targets.size() + 1, [&](size_t i) {
+        if (i == 0) Render(canvas, cache);
+        else Render(targets[i - 1]);
+    });
+}
+
+Game::View Game::MakeView(const Canvas& canvas, int32_t viewUi, UiRecord* record) const
+{
+    return {canvas, canvas.width, canvas.height, viewUi, ui,
+            float(canvas.width) / float(width), float(canvas.height) / float(height), record};
+}
+
+void Game::RenderView(const View& v) const
+{
+    if (v.recorder) v.recorder->Begin();
+    switch (currentState) {
+        case MENU: RenderMenu(v); break;
+        case PLAYING: RenderGame(v); break;
+        case SETTINGS: RenderSettings(v); break;
+        case GAME_OVER: RenderGameOver(v); break;
+    }
+}
+
+void Game::RenderView(const View& v, RenderCache& cache) const
+{
+    const Canvas& canvas = v.canvas;
+    const bool reuse = cache.data == canvas.data && cache.state == currentState;
+    if (currentState != PLAYING) {
+        const uint64_t key = ScreenKey();
+        if (!reuse || cache.screenKey != key) RenderView(v);
+        cache.screenKey = key;
+    } else {
+        // Only sprites and the HUD change between gameplay frames
+        if (reuse) {
+            for (const Rect& r : cache.sprites) FillRect(canvas, r.x, r.y, r.w, r.h, DARK_BLUE);
+        } else {
+            Clear(canvas, DARK_BLUE);
+        }
+        cache.sprites.clear();
+        DrawSprites(v, &cache.sprites);
+        if (v.recorder) v.recorder->Begin();
+        DrawHUD(v);
+    }
+    cache.data = canvas.data;
+    cache.state = currentState;
+}
+
+uint64_t Game::ScreenKey() const
+{
+    switch (currentState) {
+        case MENU: return uint64_t(selectedMenuItem);
+        case SETTINGS: return uint64_t(volume) | uint64_t(fullscreen) << 8 | uint64_t(difficulty) << 9;
+        case GAME_OVER: return uint64_t(uint32_t(score));
+        case PLAYING: break;
+    }
+    return 0;
+}
+
+void Game::UpdateMenu(const InputFrame& input) {
+    // Handle input
+    if (input.Pressed(KEY_UP) && selectedMenuItem > 0) selectedMenuItem--;
+    if (input.Pressed(KEY_DOWN) && selectedMenuItem < int(menuItems.size()) - 1) selectedMenuItem++;
+    if (input.Pressed(KEY_ENTER)) {
+        switch (selectedMenuItem) {
+            case 0: // Start Game
+                currentState = PLAYING;
+                InitializeGame();
+                break;
+            case 1: // Settings
+                currentState = SETTINGS;
+                break;
+            case 2: // Exit
+                return;
+        }
+    }
+
+    // Mouse interaction
+    if (input.mousePressed) {
+        int i = HitTest(menuButtons, input.mouseX, input.mouseY);
+        if (i >= 0) {
+            selectedMenuItem = i;
+            // Trigger same action as ENTER key
+            switch (i) {
+                case 0: currentState = PLAYING; InitializeGame(); break;
+                case 1: currentState = SETTINGS; break;
+                case 2: return;
+            }
+        }
+    }
+}
+
+void Game::RenderMenu(const View& v) const {
+    const Canvas& canvas = v.canvas;
+    Clear(canvas, BLACK);
+
+    // Draw title
+    Label(v, v.Px(50), v.Px(30), "UX TEST GAME", WHITE, v.Px(2));
+    Label(v, v.Px(50), v.Px(50), "C++ Edition with UI Elements", GREY, v.Px(1));
+
+    // Draw menu buttons with visual feedback
+    for (int i = 0; i < int(menuButtons.size()); i++) {
+        auto& btn = menuButtons[i];
+        uint32_t buttonColor = btn.color;
+        if (i == selectedMenuItem) {
+            buttonColor = WHITE;
+            // Draw selection highlight
+            const Rect r = v.Layout(btn);
+            FillRect(canvas, r.x - v.Px(5), r.y - v.Px(5), r.w + v.Px(10), r.h + v.Px(10), DARK_YELLOW);
+        }
+
+        DrawButton(v, btn, buttonColor, WHITE, v.Px(10), v.Px(15));
+    }
+
+    // Instructions
+    Label(v, v.Px(300), v.Px(100), "Controls:", GREEN, v.ui);
+    Label(v, v.Px(300), v.Px(120), "Arrow Keys: Navigate", WHITE, v.ui);
+    Label(v, v.Px(300), v.Px(140), "Enter: Select", WHITE, v.ui);
+    Label(v, v.Px(300), v.Px(160), "Mouse: Click buttons", WHITE, v.ui);
+    Label(v, v.Px(300), v.Px(200), "Game Features:", GREEN, v.ui);
+    Label(v, v.Px(300), v.Px(220), "- Menu system", WHITE, v.ui);
+    Label(v, v.Px(300), v.Px(240), "- Settings panel", WHITE, v.ui);
+    Label(v, v.Px(300), v.Px(260), "- HUD elements", WHITE, v.ui);
+    Label(v, v.Px(300), v.Px(280), "- Button interactions", WHITE, v.ui);
+}
+
+void Game::UpdateGame(const InputFrame& input) {
+    const float fElapsedTime = input.dt;
+
+    // Player movement
+    if (input.Held(KEY_A) || input.Held(KEY_LEFT)) playerX -= playerSpeed * fElapsedTime;
+    if (input.Held(KEY_D) || input.Held(KEY_RIGHT)) playerX += playerSpeed * fElapsedTime;
+    if (input.Held(KEY_W) || input.Held(KEY_UP)) playerY -= playerSpeed * fElapsedTime;
+    if (input.Held(KEY_S) || input.Held(KEY_DOWN)) playerY += playerSpeed * fElapsedTime;
+
+    // Keep player in bounds
+    playerX = std::max(float(Px(10)), std::min(playerX, float(width - Px(20))));
+    playerY = std::max(float(Px(50)), std::min(playerY, float(height - Px(20))));
+
+    // Spawn enemies
+    if (std::fmod(gameTime, 2.0f) < fElapsedTime) {
+        // Keep the range valid on windows narrower than the scaled margins
+        const float spawnMin = float(std::min(Px(50), width / 2));
+        const float spawnMax = std::max(spawnMin, float(width - Px(50)));
+        std::uniform_real_distribution<float> dis(spawnMin, spawnMax);
+        enemies.push_back({dis(gen), float(Px(10)), 0, float(Px(50 + difficulty * 30)), 3, RED});
+    }
+
+    // Update enemies
+    IntegrateEnemies(enemies, fElapsedTime);
+
+    // Remove off-screen enemies and update score
+    score += 10 * CullEnemies(enemies, float(height));
+
+    // Check collisions
+    lives -= CollideWithPlayer(enemies, playerX, playerY, float(Px(20)), lives);
+    if (lives <= 0) {
+        currentState = GAME_OVER;
+        return;
+    }
+
+    // Pause/Menu
+    if (input.Pressed(KEY_ESCAPE)) {
+        currentState = MENU;
+    }
+}
+
+void Game::RenderGame(const View& v) const {
+    const Canvas& canvas = v.canvas;
+    Clear(canvas, DARK_BLUE);
+
+    DrawSprites(v, nullptr);
+
+    // Draw HUD (this is what we want to analyze and improve)
+    DrawHUD(v);
+}
+
+// Draws the player and enemies, optionally recording the area each one covers
+void Game::DrawSprites(const View& v, std::vector<Rect>* drawn) const {
+    const Canvas& canvas = v.canvas;
+    auto sprite = [&](int32_t x, int32_t y, int32_t radius, uint32_t color) {
+        FillCircle(canvas, x, y, radius, color);
+        DrawCircle(canvas, x, y, radius, WHITE);
+        if (drawn) drawn->push_back({x - radius, y - radius, 2 * radius + 1, 2 * radius + 1});
+    };
+
+    // Draw player
+    sprite(v.X(playerX), v.Y(playerY), v.Px(8), GREEN);
+
+    // Draw enemies
+    for (const auto& enemy : enemies) {
+        sprite(v.X(enemy.x), v.Y(enemy.y), v.Px(6), enemy.color);
+    }
+}
+
+void Game::UpdateSettings(const InputFrame& input) {
+    // Mouse interaction
+    if (input.mousePressed) {
+        switch (HitTest(settingsButtons, input.mouseX, input.mouseY)) {
+            case 0: volume = std::max(0, volume - 10); break;
+            case 1: volume = std::min(100, volume + 10); break;
+            case 2: fullscreen = !fullscreen; break;
+            case 3: difficulty = 0; break;
+            case 4: difficulty = 1; break;
+            case 5: difficulty = 2; break;
+            case 6: currentState = MENU; break;
+        }
+    }
+
+    if (input.Pressed(KEY_ESCAPE)) {
+        currentState = MENU;
+    }
+}
+
+void Game::RenderSettings(const View& v) const {
+    const Canvas& canvas = v.canvas;
+    char textBuf[64];
+    Clear(canvas, DARK_GREY);
+
+    // Title
+    Label(v, v.Px(50), v.Px(30), "SETTINGS", WHITE, v.Px(2));
+
+    // Volume setting
+    Label(v, v.Px(50), v.Px(80), FormatLabel(textBuf, "Volume: ", volume, "%"), WHITE, v.ui);
+
+    // Fullscreen setting
+    Label(v, v.Px(50), v.Px(130), fullscreen ? "Fullscreen: ON" : "Fullscreen: OFF", WHITE, v.ui);
+
+    // Difficulty setting
+    Label(v, v.Px(50), v.Px(180), "Difficulty:", WHITE, v.ui);
+
+    // Draw settings buttons
+    for (int i = 0; i < int(settingsButtons.size()); i++) {
+        auto& btn = settingsButtons[i];
+        uint32_t color = btn.color;
+
+        // Highlight active difficulty
+        if (i >= 3 && i <= 5 && (i - 3) == difficulty) {
+            color = WHITE;
+        }
+
+        DrawButton(v, btn, color, BLACK, v.Px(5), v.Px(10));
+    }
+}
+
+void Game::UpdateGameOver(const InputFrame& input) {
+    if (input.Pressed(KEY_ENTER)) {
+        currentState = MENU;
+    }
+    if (input.Pressed(KEY_SPACE)) {
+        currentState = PLAYING;
+        InitializeGame();
+    }
+}
+
+void Game::RenderGameOver(const View& v) const {
+    const Canvas& canvas = v.canvas;
+    char textBuf[64];
+    Clear(canvas, DARK_RED);
+
+    Label(v, v.Px(100), v.Px(100), "GAME OVER", WHITE, v.Px(3));
+    Label(v, v.Px(100), v.Px(150), FormatLabel(textBuf, "Final Score: ", score), YELLOW, v.Px(2));
+    Label(v, v.Px(100), v.Px(200), "Press ENTER to return to menu", WHITE, v.ui);
+    Label(v, v.Px(100), v.Px(220), "Press SPACE to play again", WHITE, v.ui);
+}
+
+void Game::DrawHUD(const View& v) const {
+    const Canvas& canvas = v.canvas;
+    char textBuf[64];
+
+    // HUD Background
+    FillRect(canvas, 0, 0, v.width, v.Px(40), DARK_GREY);
+    FillRect(canvas, 0, v.Px(40), v.width + 1, v.ui, WHITE);
+
+    // Score
+    Label(v, v.Px(10), v.Px(10), FormatLabel(textBuf, "Score: ", score), YELLOW, v.ui);
+
+    // Lives with visual representation
+    Label(v, v.Px(150), v.Px(10), "Lives: ", WHITE, v.ui);
+    for (int i = 0; i < lives; i++) {
+        FillCircle(canvas, v.Px(200 + i * 20), v.Px(20), v.Px(5), GREEN);
+    }
+
+    // Time
+    Label(v, v.Px(300), v.Px(10), FormatLabel(textBuf, "Time: ", int(gameTime)), CYAN, v.ui);
+
+    // Mini-map area (example UI element)
+    DrawRect(canvas, v.width - v.Px(120), v.Px(10), v.Px(100), v.Px(80), WHITE, v.ui);
+    Label(v, v.width - v.Px(115), v.Px(15), "Mini-Map", WHITE, v.ui);
+    FillCircle(canvas, v.width - v.Px(70), v.Px(50), v.Px(2), GREEN); // Player dot
+
+    // Health bar example
+    Label(v, v.Px(10), v.height - v.Px(30), "Health:", WHITE, v.ui);
+    FillRect(canvas, v.Px(61), v.height - v.Px(24), v.Px(99), v.Px(8), DARK_BLUE); // lost lives
+    FillRect(canvas, v.Px(61), v.height - v.Px(24), v.Px(lives * 33), v.Px(8), GREEN);
+    DrawRect(canvas, v.Px(60), v.height - v.Px(25), v.Px(100), v.Px(10), WHITE, v.ui);
+
+    // Action buttons overlay
+    Label(v, v.width - v.Px(200), v.height - v.Px(30), "ESC: Menu", GREY, v.ui);
+}
+
+void Game::Label(const View& v, int32_t x, int32_t y, std::string_view text, uint32_t color,
+                 int32_t scale) const {
+    DrawString(v.canvas, x, y, text, color, uint32_t(scale));
+    if (v.recorder) v.recorder->AddText(TextBounds(x, y, text, uint32_t(scale)), color, text);
+}
+
+void Game::DrawButton(const View& v, const Button& btn, uint32_t fill, uint32_t outline,
+                      int32_t textX, int32_t textY) const {
+    const Rect r = v.Layout(btn);
+    FillRect(v.canvas, r.x, r.y, r.w, r.h, fill);
+    DrawRect(v.canvas, r.x, r.y, r.w, r.h, outline, v.ui);
+    Label(v, r.x + textX, r.y + textY, btn.text, BLACK, v.ui);
+    if (v.recorder) v.recorder->AddTarget(r, btn.text);
+}
+
+void Game::InitializeGame() {
+    playerX = float(Px(50));
+    playerY = float(Px(100));
+    score = 0;
+    lives = 3;
+    gameTime = 0.0f;
+    enemies.clear();
+}
+
+} // namespace ux
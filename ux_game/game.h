@@ -0,0 +1,190 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ux_game/input.h"
+#include "ux_game/raster.h"
+#include "ux_game/sim.h"
+#include "ux_game/widgets.h"
+#include "ux_game/worker_pool.h"
+
+// Simple C++ Game for UX Testing
+// Features: Menu system, HUD, buttons, score display, settings
+//
+// Game logic and drawing, independent of the window: the windowed build
+// (test_cpp_game.cpp) feeds it input from olc::PixelGameEngine and hands it the
+// draw target, the headless replay runner (replay_cpp_game.cpp) feeds it
+// recorded input and renders into a memory buffer.
+namespace ux {
+
+class Game {
+public:
+    enum State : uint32_t {
+        MENU,
+        PLAYING,
+        SETTINGS,
+        GAME_OVER
+    };
+
+    static constexpr const char* kStateNames[] = {"menu", "playing", "settings", "game_over"};
+
+    // The layout is authored for 640x480; larger framebuffers scale it by an
+    // integer factor so text stays crisp (1080p -> 2, 1440p -> 3, 4K -> 4).
+    static constexpr int32_t kDesignWidth = 640;
+    static constexpr int32_t kDesignHeight = 480;
+
+    static int32_t UiScale(int32_t width, int32_t height)
+    {
+        return std::max(1, std::min(width / kDesignWidth, height / kDesignHeight));
+    }
+
+    Game(int32_t width, int32_t height, uint32_t seed);
+
+    // Advances the simulation by one frame of input
+    void Update(const InputFrame& input);
+
+    // What the previous frame left in a persistent framebuffer. Static screens
+    // are only redrawn when what they show changes, and gameplay erases just the
+    // sprites it drew last frame instead of clearing the whole target, which is
+    // what keeps 4K frames off the memory-bandwidth floor of a full clear.
+    struct RenderCache {
+        const uint32_t* data = nullptr;
+        State state = MENU;
+        uint64_t screenKey = 0;
+        std::vector<Rect> sprites;
+
+        void Invalidate() { data = nullptr; }
+    };
+
+    // Draws the current state; canvas is expected to be Width() x Height()
+    void Render(const Canvas& canvas) const;
+
+    // Same pixels as Render(canvas), reusing what the canvas still holds from
+    // the previous call with this cache
+    void Render(const Canvas& canvas, RenderCache& cache) const;
+
+    // Another framebuffer for the same simulation frame, at any size. The layout
+    // is rebuilt at the target's own UI scale and world positions are mapped
+    // proportionally, so every target shows identical state (resolution
+    // comparisons without rerunning the session per resolution).
+    struct RenderTarget {
+        Canvas canvas;
+        int32_t ui = 0;            // UI scale; 0 picks UiScale(canvas size)
+        RenderCache cache;
+        UiRecord* record = nullptr;
+    };
+
+    // Render only reads the game, so different targets may be drawn concurrently
+    void Render(RenderTarget& target) const;
+
+    // Draws the frame into canvas (as Render(canvas, cache)) and into every
+    // target, one task per framebuffer spread over the pool
+    void Render(const Canvas& canvas, RenderCache& cache, std::vector<RenderTarget>& targets,
+                WorkerPool& pool) const;
+
+    State GetState() const { return currentState; }
+    int Score() const { return score; }
+    int Lives() const { return lives; }
+    float GameTime() const { return gameTime; }
+    size_t EntityCount() const { return enemies.size(); }
+    int32_t Width() const { return width; }
+    int32_t Height() const { return height; }
+    int32_t Ui() const { return ui; }
+
+    // Records the text runs and click targets of every redrawn frame (for the
+    // accessibility audit); nullptr to stop
+    void SetUiRecorder(UiRecord* record) { recorder = record; }
+
+private:
+    // Where one Render call draws: framebuffer, its layout scale and the mapping
+    // from simulation pixels (Width() x Height()) to its pixels
+    struct View {
+        Canvas canvas;
+        int32_t width, height;
+        int32_t ui;
+        int32_t simUi;
+        float sx, sy;
+        UiRecord* recorder;
+
+        // Design-space (640x480) length to framebuffer pixels
+        int32_t Px(int32_t v) const { return v * ui; }
+        // Simulation-space position to framebuffer pixels
+        int32_t X(float x) const { return int32_t(x * sx); }
+        int32_t Y(float y) const { return int32_t(y * sy); }
+        // Button laid out at the simulation's UI scale, relaid at this one
+        Rect Layout(const Button& btn) const
+        {
+            return {Relayout(btn.x), Relayout(btn.y), Relayout(btn.w), Relayout(btn.h)};
+        }
+        int32_t Relayout(float v) const { return int32_t(v) / simUi * ui; }
+    };
+
+    View MakeView(const Canvas& canvas, int32_t viewUi, UiRecord* record) const;
+    void RenderView(const View& view) const;
+    void RenderView(const View& view, RenderCache& cache) const;
+
+    void UpdateMenu(const InputFrame& input);
+    void UpdateGame(const InputFrame& input);
+    void UpdateSettings(const InputFrame& input);
+    void UpdateGameOver(const InputFrame& input);
+
+    void RenderMenu(const View& v) const;
+    void RenderGame(const View& v) const;
+    void RenderSettings(const View& v) const;
+    void RenderGameOver(const View& v) const;
+    void DrawSprites(const View& v, std::vector<Rect>* drawn) const;
+    void DrawHUD(const View& v) const;
+
+    // DrawString / button drawing that also reports to the view's UI recorder
+    void Label(const View& v, int32_t x, int32_t y, std::string_view text, uint32_t color,
+               int32_t scale) const;
+    void DrawButton(const View& v, const Button& btn, uint32_t fill, uint32_t outline,
+                    int32_t textX, int32_t textY) const;
+
+    // Everything a static screen's pixels depend on
+    uint64_t ScreenKey() const;
+
+    void InitializeGame();
+
+    // Design-space (640x480) length to framebuffer pixels
+    int32_t Px(int32_t v) const { return v * ui; }
+
+    int32_t width, height;
+    int32_t ui;
+
+    State currentState = MENU;
+
+    // Game variables
+    float playerX = 50.0f, playerY = 50.0f;
+    float playerSpeed = 100.0f;
+    int score = 0;
+    int lives = 3;
+    float gameTime = 0.0f;
+
+    // Menu variables
+    int selectedMenuItem = 0;
+    std::vector<std::string> menuItems = {"Start Game", "Settings", "Exit"};
+
+    // Settings variables
+    int volume = 50;
+    bool fullscreen = false;
+    int difficulty = 1; // 0=Easy, 1=Medium, 2=Hard
+
+    // Enemies
+    std::vector<Enemy> enemies;
+
+    // UI buttons
+    std::vector<Button> menuButtons;
+    std::vector<Button> settingsButtons;
+
+    // Random engine (seeded by the caller so replays are deterministic)
+    std::mt19937 gen;
+
+    UiRecord* recorder = nullptr;
+};
+
+} // namespace ux
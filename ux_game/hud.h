@@ -0,0 +1,28 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+
+// HUD text formatting without per-frame heap allocations.
+namespace ux {
+
+// Writes "<label><value><suffix>" into buf and returns a view of it. Output is
+// truncated to the buffer if it does not fit.
+template <size_t N>
+inline std::string_view FormatLabel(char (&buf)[N], std::string_view label, int value,
+                                    std::string_view suffix = {})
+{
+    size_t len = std::min(label.size(), N);
+    if (len) std::memcpy(buf, label.data(), len);
+    auto res = std::to_chars(buf + len, buf + N, value);
+    if (res.ec != std::errc()) return std::string_view(buf, len);
+    len = size_t(res.ptr - buf);
+    size_t tail = std::min(suffix.size(), N - len);
+    if (tail) std::memcpy(buf + len, suffix.data(), tail);
+    return std::string_view(buf, len + tail);
+}
+
+} // namespace ux
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "ux_game/raster.h"
+
+// Minimal image output for headless runs (no libpng needed). 24-bit BMP is read
+// by PIL/OpenCV, so the analysis pipeline can consume frames directly.
+namespace ux {
+
+inline bool WriteBmp(const std::string& path, const Canvas& canvas)
+{
+    if (canvas.width <= 0 || canvas.height <= 0) return false;
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+
+    const uint32_t rowBytes = (uint32_t(canvas.width) * 3 + 3) & ~3u;
+    const uint32_t imageBytes = rowBytes * uint32_t(canvas.height);
+    uint8_t header[54] = {'B', 'M'};
+    auto put32 = [&](int offset, uint32_t v) {
+        for (int i = 0; i < 4; i++) header[offset + i] = uint8_t(v >> (8 * i));
+    };
+    put32(2, 54 + imageBytes);      // file size
+    put32(10, 54);                  // pixel data offset
+    put32(14, 40);                  // BITMAPINFOHEADER
+    put32(18, uint32_t(canvas.width));
+    put32(22, uint32_t(-canvas.height)); // negative height: rows top-down
+    header[26] = 1;                 // planes
+    header[28] = 24;                // bits per pixel
+    put32(34, imageBytes);
+
+    bool ok = std::fwrite(header, sizeof(header), 1, f) == 1;
+    std::vector<uint8_t> row(rowBytes, 0);
+    for (int32_t y = 0; ok && y < canvas.height; y++) {
+        const uint32_t* src = canvas.Row(y);
+        for (int32_t x = 0; x < canvas.width; x++) {
+            row[x * 3 + 0] = uint8_t(src[x] >> 16); // B
+            row[x * 3 + 1] = uint8_t(src[x] >> 8);  // G
+            row[x * 3 + 2] = uint8_t(src[x]);       // R
+        }
+        ok = std::fwrite(row.data(), rowBytes, 1, f) == 1;
+    }
+    return std::fclose(f) == 0 && ok;
+}
+
+} // namespace ux
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Per-frame input snapshot for the UX test game, plus a small replay format so
+// sessions can be recorded in the windowed game and played back headlessly
+// (ux_game_replay, PGO training runs).
+namespace ux {
+
+enum Key : uint32_t {
+    KEY_UP     = 1u << 0,
+    KEY_DOWN   = 1u << 1,
+    KEY_LEFT   = 1u << 2,
+    KEY_RIGHT  = 1u << 3,
+    KEY_W      = 1u << 4,
+    KEY_A      = 1u << 5,
+    KEY_S      = 1u << 6,
+    KEY_D      = 1u << 7,
+    KEY_ENTER  = 1u << 8,
+    KEY_SPACE  = 1u << 9,
+    KEY_ESCAPE = 1u << 10,
+};
+
+struct InputFrame {
+    float dt = 0.0f;
+    uint32_t held = 0;       // Key bits currently down
+    uint32_t pressed = 0;    // Key bits that went down this frame
+    int32_t mouseX = 0;
+    int32_t mouseY = 0;
+    bool mousePressed = false;
+
+    bool Held(Key k) const { return (held & k) != 0; }
+    bool Pressed(Key k) const { return (pressed & k) != 0; }
+
+    bool SameInput(const InputFrame& o) const
+    {
+        return dt == o.dt && held == o.held && pressed == o.pressed &&
+               mouseX == o.mouseX && mouseY == o.mouseY && mousePressed == o.mousePressed;
+    }
+};
+
+// Replay file (text):
+//   uxreplay 1 <width> <height> <seed>
+//   <repeat> <dt> <held> <pressed> <mouseX> <mouseY> <mousePressed>
+// Consecutive identical frames are run-length encoded in the repeat column.
+struct Replay {
+    int32_t width = 640;
+    int32_t height = 480;
+    uint32_t seed = 0;
+    std::vector<InputFrame> frames;
+};
+
+inline bool LoadReplay(const std::string& path, Replay& replay)
+{
+    FILE* f = std::fopen(path.c_str(), "r");
+    if (!f) return false;
+
+    int version = 0;
+    bool ok = std::fscanf(f, " uxreplay %d %d %d %u", &version, &replay.width, &replay.height, &replay.seed) == 4 &&
+              version == 1 && replay.width > 0 && replay.height > 0;
+    replay.frames.clear();
+
+    unsigned repeat, held, pressed;
+    int mouseX, mouseY, mouse;
+    float dt;
+    while (ok && std::fscanf(f, "%u %f %u %u %d %d %d", &repeat, &dt, &held, &pressed, &mouseX, &mouseY, &mouse) == 7) {
+        InputFrame frame;
+        frame.dt = dt;
+        frame.held = held;
+        frame.pressed = pressed;
+        frame.mouseX = mouseX;
+        frame.mouseY = mouseY;
+        frame.mousePressed = mouse != 0;
+        replay.frames.insert(replay.frames.end(), repeat, frame);
+    }
+    ok = ok && std::feof(f);
+    std::fclose(f);
+    return ok;
+}
+
+// Streams frames to a replay file as they are played
+class ReplayWriter {
+public:
+    ReplayWriter() = default;
+    ReplayWriter(const ReplayWriter&) = delete;
+    ReplayWriter& operator=(const ReplayWriter&) = delete;
+    ~ReplayWriter() { Close(); }
+
+    bool IsOpen() const { return file != nullptr; }
+
+    bool Open(const std::string& path, int32_t width, int32_t height, uint32_t seed)
+    {
+        Close();
+        file = std::fopen(path.c_str(), "w");
+        if (!file) return false;
+        std::fprintf(file, "uxreplay 1 %d %d %u\n", width, height, seed);
+        return true;
+    }
+
+    void Write(const InputFrame& frame)
+    {
+        if (!file) return;
+        if (repeat && frame.SameInput(last)) { repeat++; return; }
+        Flush();
+        last = frame;
+        repeat = 1;
+    }
+
+    void Close()
+    {
+        if (!file) return;
+        Flush();
+        std::fclose(file);
+        file = nullptr;
+    }
+
+private:
+    void Flush()
+    {
+        if (!repeat) return;
+        std::fprintf(file, "%u %.9g %u %u %d %d %d\n", repeat, last.dt, last.held, last.pressed,
+                     last.mouseX, last.mouseY, last.mousePressed ? 1 : 0);
+        repeat = 0;
+    }
+
+    FILE* file = nullptr;
+    InputFrame last;
+    uint32_t repeat = 0;
+};
+
+} // namespace ux
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Per-frame metrics stream published through shared memory.
+//
+// The segment is a 64-byte header followed by a ring of 64-byte slots. Each slot
+// is guarded by its own sequence counter (seqlock): the writer makes it odd while
+// the slot is being filled and even once it is complete, so readers never block
+// the game and detect torn reads by comparing the counter before and after a copy.
+// The Python side lives in src/ux_tester/game_metrics.py and must match this layout.
+namespace ux {
+
+constexpr uint32_t kMetricsMagic = 0x534D5855; // "UXMS"
+constexpr uint32_t kMetricsVersion = 1;
+constexpr const char* kDefaultMetricsName = "ux_game_metrics";
+
+struct MetricsHeader {
+    std::atomic<uint32_t> magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t slotSize;
+    std::atomic<uint64_t> head;   // number of frames published so far
+    uint64_t startTimeNs;         // steady clock at Open(), slot timestamps are relative to it
+    uint32_t writerPid;
+    uint8_t reserved[28];
+};
+
+struct MetricsSlot {
+    std::atomic<uint32_t> seq;
+    uint32_t state;
+    uint64_t frameIndex;
+    uint64_t timestampNs;
+    float frameMs;
+    float updateMs;
+    float renderMs;
+    uint32_t entityCount;
+    uint32_t allocations;
+    uint32_t allocationBytes;
+    int32_t score;
+    int32_t lives;
+    uint32_t auditViolations;     // failed checks of the in-engine UI audit (0 when off)
+    float minContrast;            // lowest text contrast ratio seen by the audit
+};
+
+static_assert(sizeof(MetricsHeader) == 64, "MetricsHeader layout is shared with Python");
+static_assert(sizeof(MetricsSlot) == 64, "MetricsSlot layout is shared with Python");
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "shared-memory counters must be lock-free");
+
+// Values for one frame; Publish() stamps the frame index and timestamp
+struct FrameSample {
+    uint32_t state = 0;
+    float frameMs = 0.0f;
+    float updateMs = 0.0f;
+    float renderMs = 0.0f;
+    uint32_t entityCount = 0;
+    uint32_t allocations = 0;
+    uint32_t allocationBytes = 0;
+    int32_t score = 0;
+    int32_t lives = 0;
+    uint32_t auditViolations = 0;
+    float minContrast = 0.0f;
+};
+
+class MetricsPublisher {
+public:
+    MetricsPublisher() = default;
+    MetricsPublisher(const MetricsPublisher&) = delete;
+    MetricsPublisher& operator=(const MetricsPublisher&) = delete;
+    ~MetricsPublisher() { Close(); }
+
+    bool IsOpen() const { return header != nullptr; }
+
+    // Creates (or recreates) the named segment with room for slotCount frames
+    bool Open(const std::string& name, uint32_t slotCount = 1024)
+    {
+        Close();
+        if (slotCount == 0) return false;
+        size = sizeof(MetricsHeader) + size_t(slotCount) * sizeof(MetricsSlot);
+
+#ifdef _WIN32
+        mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, DWORD(size), name.c_str());
+        if (!mapping) return false;
+        void* base = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+        if (!base) { CloseHandle(mapping); mapping = nullptr; return false; }
+        std::memset(base, 0, size);
+        uint32_t pid = uint32_t(GetCurrentProcessId());
+#else
+        shmName = name[0] == '/' ? name : "/" + name;
+        shm_unlink(shmName.c_str()); // drop a stale segment from a previous run
+        int fd = shm_open(shmName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) return false;
+        if (ftruncate(fd, off_t(size)) != 0) { close(fd); shm_unlink(shmName.c_str()); return false; }
+        void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED) { shm_unlink(shmName.c_str()); return false; }
+        uint32_t pid = uint32_t(getpid());
+#endif
+
+        header = static_cast<MetricsHeader*>(base);
+        slots = reinterpret_cast<MetricsSlot*>(static_cast<uint8_t*>(base) + sizeof(MetricsHeader));
+        header->version = kMetricsVersion;
+        header->slotCount = slotCount;
+        header->slotSize = sizeof(MetricsSlot);
+        header->head.store(0, std::memory_order_relaxed);
+        header->startTimeNs = NowNs();
+        header->writerPid = pid;
+        // Readers treat the segment as valid once the magic is visible
+        header->magic.store(kMetricsMagic, std::memory_order_release);
+        return true;
+    }
+
+    void Close()
+    {
+        if (!header) return;
+#ifdef _WIN32
+        UnmapViewOfFile(header);
+        CloseHandle(mapping);
+        mapping = nullptr;
+#else
+        munmap(header, size);
+        shm_unlink(shmName.c_str());
+#endif
+        header = nullptr;
+        slots = nullptr;
+    }
+
+    void Publish(const FrameSample& sample)
+    {
+        if (!header) return;
+        uint64_t index = header->head.load(std::memory_order_relaxed);
+        MetricsSlot& slot = slots[index % header->slotCount];
+
+        uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+        slot.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot.state = sample.state;
+        slot.frameIndex = index;
+        slot.timestampNs = NowNs() - header->startTimeNs;
+        slot.frameMs = sample.frameMs;
+        slot.updateMs = sample.updateMs;
+        slot.renderMs = sample.renderMs;
+        slot.entityCount = sample.entityCount;
+        slot.allocations = sample.allocations;
+        slot.allocationBytes = sample.allocationBytes;
+        slot.score = sample.score;
+        slot.lives = sample.lives;
+        slot.auditViolations = sample.auditViolations;
+        slot.minContrast = sample.minContrast;
+
+        slot.seq.store(seq + 2, std::memory_order_release);
+        header->head.store(index + 1, std::memory_order_release);
+    }
+
+    static uint64_t NowNs()
+    {
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+private:
+    MetricsHeader* header = nullptr;
+    MetricsSlot* slots = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE mapping = nullptr;
+#else
+    std::string shmName;
+#endif
+};
+
+} // namespace ux
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string_view>
+#include <utility>
+
+#include "ux_game/font.h"
+#include "ux_game/simd_fill.h"
+
+// Software rasterizer for the UX test game.
+// Works on any 32-bit RGBA framebuffer (the PGE draw target or a plain buffer),
+// so the same kernels back the window, headless runs and the benchmark suite.
+// Semantics follow olc::PixelGameEngine: FillRect covers [x, x+w) x [y, y+h),
+// DrawRect/DrawLine include both end points.
+namespace ux {
+
+// Packs a colour the same way olc::Pixel does (r in the lowest byte).
+constexpr uint32_t Rgb(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 0xFF)
+{
+    return uint32_t(r) | (uint32_t(g) << 8) | (uint32_t(b) << 16) | (uint32_t(a) << 24);
+}
+
+constexpr uint32_t WHITE = Rgb(255, 255, 255);
+constexpr uint32_t BLACK = Rgb(0, 0, 0);
+constexpr uint32_t GREY = Rgb(192, 192, 192);
+constexpr uint32_t DARK_GREY = Rgb(128, 128, 128);
+constexpr uint32_t RED = Rgb(255, 0, 0);
+constexpr uint32_t DARK_RED = Rgb(128, 0, 0);
+constexpr uint32_t YELLOW = Rgb(255, 255, 0);
+constexpr uint32_t DARK_YELLOW = Rgb(128, 128, 0);
+constexpr uint32_t GREEN = Rgb(0, 255, 0);
+constexpr uint32_t CYAN = Rgb(0, 255, 255);
+constexpr uint32_t BLUE = Rgb(0, 0, 255);
+constexpr uint32_t DARK_BLUE = Rgb(0, 0, 128);
+
+struct Rect {
+    int32_t x, y, w, h;
+};
+
+struct Canvas {
+    uint32_t* data = nullptr;
+    int32_t width = 0;
+    int32_t height = 0;
+
+    uint32_t* Row(int32_t y) const { return data + size_t(y) * size_t(width); }
+};
+
+namespace detail {
+
+// Horizontal span [x0, x1] on row y, clipped to the canvas.
+inline void HSpan(const Canvas& c, int32_t x0, int32_t x1, int32_t y, uint32_t p)
+{
+    if (y < 0 || y >= c.height) return;
+    if (x0 > x1) std::swap(x0, x1);
+    x0 = std::max(x0, 0);
+    x1 = std::min(x1, c.width - 1);
+    if (x0 > x1) return;
+    simd::Fill(c.Row(y) + x0, size_t(x1 - x0 + 1), p);
+}
+
+// Vertical span [y0, y1] on column x, clipped to the canvas.
+inline void VSpan(const Canvas& c, int32_t x, int32_t y0, int32_t y1, uint32_t p)
+{
+    if (x < 0 || x >= c.width) return;
+    if (y0 > y1) std::swap(y0, y1);
+    y0 = std::max(y0, 0);
+    y1 = std::min(y1, c.height - 1);
+    for (int32_t y = y0; y <= y1; y++) c.Row(y)[x] = p;
+}
+
+inline void Plot(const Canvas& c, int32_t x, int32_t y, uint32_t p)
+{
+    if (uint32_t(x) < uint32_t(c.width) && uint32_t(y) < uint32_t(c.height)) c.Row(y)[x] = p;
+}
+
+} // namespace detail
+
+inline void Clear(const Canvas& c, uint32_t p)
+{
+    simd::StreamFill(c.data, size_t(c.width) * size_t(c.height), p);
+}
+
+inline void FillRect(const Canvas& c, int32_t x, int32_t y, int32_t w, int32_t h, uint32_t p)
+{
+    int32_t x0 = std::max(x, 0), x1 = std::min(x + w, c.width);
+    int32_t y0 = std::max(y, 0), y1 = std::min(y + h, c.height);
+    if (x0 >= x1 || y0 >= y1) return;
+    for (int32_t row = y0; row < y1; row++) simd::Fill(c.Row(row) + x0, size_t(x1 - x0), p);
+}
+
+inline void DrawLine(const Canvas& c, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t p)
+{
+    if (y1 == y2) { detail::HSpan(c, x1, x2, y1, p); return; }
+    if (x1 == x2) { detail::VSpan(c, x1, y1, y2, p); return; }
+
+    // Bresenham for the general case
+    int32_t dx = std::abs(x2 - x1), sx = x1 < x2 ? 1 : -1;
+    int32_t dy = -std::abs(y2 - y1), sy = y1 < y2 ? 1 : -1;
+    int32_t err = dx + dy;
+    while (true) {
+        detail::Plot(c, x1, y1, p);
+        if (x1 == x2 && y1 == y2) break;
+        int32_t e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x1 += sx; }
+        if (e2 <= dx) { err += dx; y1 += sy; }
+    }
+}
+
+// Outline of thickness t grown inwards from the edges; t = 1 matches olc::DrawRect.
+inline void DrawRect(const Canvas& c, int32_t x, int32_t y, int32_t w, int32_t h, uint32_t p,
+                     int32_t t = 1)
+{
+    if (t <= 1) {
+        detail::HSpan(c, x, x + w, y, p);
+        detail::HSpan(c, x, x + w, y + h, p);
+        detail::VSpan(c, x, y, y + h, p);
+        detail::VSpan(c, x + w, y, y + h, p);
+        return;
+    }
+    FillRect(c, x, y, w + 1, t, p);
+    FillRect(c, x, y + h + 1 - t, w + 1, t, p);
+    FillRect(c, x, y + t, t, h + 1 - 2 * t, p);
+    FillRect(c, x + w + 1 - t, y + t, t, h + 1 - 2 * t, p);
+}
+
+inline void FillCircle(const Canvas& c, int32_t x, int32_t y, int32_t radius, uint32_t p)
+{
+    if (radius < 0 || x < -radius || y < -radius || x - c.width > radius || y - c.height > radius)
+        return;
+    if (radius == 0) { detail::Plot(c, x, y, p); return; }
+
+    int32_t x0 = 0, y0 = radius;
+    int32_t d = 3 - 2 * radius;
+    while (y0 >= x0) {
+        detail::HSpan(c, x - y0, x + y0, y - x0, p);
+        if (x0 > 0) detail::HSpan(c, x - y0, x + y0, y + x0, p);
+        if (d < 0) {
+            d += 4 * x0++ + 6;
+        } else {
+            if (x0 != y0) {
+                detail::HSpan(c, x - x0, x + x0, y - y0, p);
+                detail::HSpan(c, x - x0, x + x0, y + y0, p);
+            }
+            d += 4 * (x0++ - y0--) + 10;
+        }
+    }
+}
+
+inline void DrawCircle(const Canvas& c, int32_t x, int32_t y, int32_t radius, uint32_t p)
+{
+    if (radius < 0 || x < -radius || y < -radius || x - c.width > radius || y - c.height > radius)
+        return;
+    if (radius == 0) { detail::Plot(c, x, y, p); return; }
+
+    int32_t x0 = 0, y0 = radius;
+    int32_t d = 3 - 2 * radius;
+    while (y0 >= x0) {
+        detail::Plot(c, x + y0, y - x0, p);
+        detail::Plot(c, x + x0, y + y0, p);
+        detail::Plot(c, x - y0, y + x0, p);
+        detail::Plot(c, x - x0, y - y0, p);
+        if (x0 != 0 && x0 != y0) {
+            detail::Plot(c, x + x0, y - y0, p);
+            detail::Plot(c, x + y0, y + x0, p);
+            detail::Plot(c, x - x0, y + y0, p);
+            detail::Plot(c, x - y0, y - x0, p);
+        }
+        if (d < 0) d += 4 * x0++ + 6;
+        else d += 4 * (x0++ - y0--) + 10;
+    }
+}
+
+// Draws text with the built-in 8x8 font. Each run of lit glyph pixels becomes a
+// single span fill; at larger scales the run is one clipped block fill, which
+// keeps the cost per glyph row constant at high resolutions.
+inline void DrawString(const Canvas& c, int32_t x, int32_t y, std::string_view text, uint32_t p,
+                       uint32_t scale = 1)
+{
+    const int32_t s = int32_t(scale);
+    int32_t sx = 0, sy = 0;
+    for (char ch : text) {
+        if (ch == '\n') { sx = 0; sy += kGlyphSize * s; continue; }
+        if (ch == '\t') { sx += kGlyphSize * 4 * s; continue; }
+
+        int glyph = int(uint8_t(ch)) - kFirstGlyph;
+        if (glyph < 0 || glyph >= kGlyphCount) glyph = '?' - kFirstGlyph;
+        const int32_t gx = x + sx, gy = y + sy;
+
+        // Skip glyphs that are entirely off-canvas
+        if (gx < c.width && gy < c.height && gx + kGlyphSize * s > 0 && gy + kGlyphSize * s > 0) {
+            for (int32_t row = 0; row < kGlyphSize; row++) {
+                uint32_t bits = kFont8x8[glyph][row];
+                int32_t col = 0;
+                while (bits) {
+                    // Find the next run of set bits
+                    while (!(bits & 1u)) { bits >>= 1; col++; }
+                    int32_t run = 0;
+                    while (bits & 1u) { bits >>= 1; run++; }
+                    if (s == 1) detail::HSpan(c, gx + col, gx + col + run - 1, gy + row, p);
+                    else FillRect(c, gx + col * s, gy + row * s, run * s, s, p);
+                    col += run;
+                }
+            }
+        }
+        sx += kGlyphSize * s;
+    }
+}
+
+} // namespace ux
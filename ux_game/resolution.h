@@ -0,0 +1,67 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Command-line resolution specs shared by the game and the replay runner.
+namespace ux {
+
+// "WxH" or a preset: 720p, 1080p, 1440p, 4k
+inline bool ParseResolution(const std::string& text, int32_t& width, int32_t& height)
+{
+    static constexpr struct { const char* name; int32_t width, height; } kPresets[] = {
+        {"720p", 1280, 720}, {"1080p", 1920, 1080}, {"1440p", 2560, 1440}, {"4k", 3840, 2160},
+    };
+    for (const auto& preset : kPresets) {
+        if (text == preset.name) {
+            width = preset.width;
+            height = preset.height;
+            return true;
+        }
+    }
+    int w = 0, h = 0;
+    if (std::sscanf(text.c_str(), "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0) return false;
+    width = w;
+    height = h;
+    return true;
+}
+
+struct TargetSpec {
+    int32_t width = 0, height = 0;
+    int32_t ui = 0;  // UI scale; 0 derives it from the size
+};
+
+// Comma-separated "RES[@UI]" list, e.g. "720p,1080p@1,3840x2160"
+inline bool ParseTargetSpecs(const std::string& list, std::vector<TargetSpec>& specs)
+{
+    specs.clear();
+    for (size_t start = 0; start <= list.size();) {
+        size_t end = std::min(list.find(',', start), list.size());
+        std::string item = list.substr(start, end - start);
+        TargetSpec spec;
+        size_t at = item.find('@');
+        if (at != std::string::npos) {
+            spec.ui = std::atoi(item.c_str() + at + 1);
+            if (spec.ui <= 0) return false;
+            item.resize(at);
+        }
+        if (!ParseResolution(item, spec.width, spec.height)) return false;
+        specs.push_back(spec);
+        start = end + 1;
+    }
+    return !specs.empty();
+}
+
+// "1920x1080" or "1920x1080@1" when the UI scale was given
+inline std::string TargetName(const TargetSpec& spec)
+{
+    std::string name = std::to_string(spec.width) + "x" + std::to_string(spec.height);
+    if (spec.ui > 0) name += "@" + std::to_string(spec.ui);
+    return name;
+}
+
+} // namespace ux
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Gameplay kernels for the UX test game.
+// Plain data and free functions so the same code runs in the game loop and in
+// the micro-benchmarks (bench_cpp_game.cpp).
+namespace ux {
+
+struct Enemy {
+    float x, y;
+    float dx, dy;
+    int health;
+    uint32_t color;
+};
+
+// UI Button structure
+struct Button {
+    float x, y, w, h;
+    std::string text;
+    uint32_t color;
+    bool enabled;
+
+    bool IsClicked(float mouseX, float mouseY) const {
+        return mouseX >= x && mouseX <= x + w &&
+               mouseY >= y && mouseY <= y + h && enabled;
+    }
+};
+
+inline void IntegrateEnemies(std::vector<Enemy>& enemies, float fElapsedTime)
+{
+    for (auto& enemy : enemies) {
+        enemy.y += enemy.dy * fElapsedTime;
+    }
+}
+
+// Removes enemies that left the bottom of the screen, returns how many were removed
+inline int CullEnemies(std::vector<Enemy>& enemies, float screenHeight)
+{
+    auto end = std::remove_if(enemies.begin(), enemies.end(),
+        [screenHeight](const Enemy& e) { return e.y > screenHeight; });
+    int removed = int(enemies.end() - end);
+    enemies.erase(end, enemies.end());
+    return removed;
+}
+
+// Removes up to maxHits enemies within radius of the player, in order, and
+// returns the number removed. Compares squared distances to avoid the sqrt.
+inline int CollideWithPlayer(std::vector<Enemy>& enemies, float playerX, float playerY,
+                             float radius, int maxHits)
+{
+    const float r2 = radius * radius;
+    int hits = 0;
+    auto out = enemies.begin();
+    for (auto it = enemies.begin(); it != enemies.end(); ++it) {
+        float dx = it->x - playerX;
+        float dy = it->y - playerY;
+        if (hits < maxHits && dx * dx + dy * dy < r2) {
+            hits++;
+            continue;
+        }
+        if (out != it) *out = *it;
+        ++out;
+    }
+    enemies.erase(out, enemies.end());
+    return hits;
+}
+
+// Index of the first button under the cursor, or -1
+inline int HitTest(const std::vector<Button>& buttons, float mouseX, float mouseY)
+{
+    for (size_t i = 0; i < buttons.size(); i++) {
+        if (buttons[i].IsClicked(mouseX, mouseY)) return int(i);
+    }
+    return -1;
+}
+
+} // namespace ux
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define UX_SIMD_X86 1
+#include <immintrin.h>
+#define UX_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define UX_SIMD_X86 0
+#endif
+
+// 32-bit pixel fill kernels behind the rasterizer (raster.h).
+// The build targets baseline x86-64, so the AVX2 paths are compiled per function
+// and picked at runtime; other targets use the scalar loop. Full-frame clears
+// larger than the last-level cache use non-temporal stores: the frame is written
+// once and read next by the upload/capture, so pulling it through the cache only
+// costs a read-for-ownership per line and evicts everything else.
+namespace ux {
+namespace simd {
+
+enum class Level { Scalar, SSE2, AVX2 };
+
+// Fills above this size stream past the cache (a 1080p frame is ~8 MiB)
+constexpr size_t kStreamFillBytes = size_t(4) << 20;
+
+inline Level DetectLevel()
+{
+#if UX_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return Level::AVX2;
+    if (__builtin_cpu_supports("sse2")) return Level::SSE2;
+#endif
+    return Level::Scalar;
+}
+
+namespace detail {
+
+inline Level& ActiveLevel()
+{
+    static Level level = DetectLevel();
+    return level;
+}
+
+// Portable loop; the compiler may still vectorize it for the baseline ISA
+inline void FillScalar(uint32_t* dst, size_t n, uint32_t p)
+{
+    for (size_t i = 0; i < n; i++) dst[i] = p;
+}
+
+#if UX_SIMD_X86
+inline void FillSSE2(uint32_t* dst, size_t n, uint32_t p)
+{
+    if (n < 4) { FillScalar(dst, n, p); return; }
+    const __m128i v = _mm_set1_epi32(int(p));
+    // Overlapping unaligned head and tail around an aligned body
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), v);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + n - 4), v);
+    uint32_t* q = reinterpret_cast<uint32_t*>((uintptr_t(dst) + 15) & ~uintptr_t(15));
+    uint32_t* end = dst + n - 4;
+    for (; q < end; q += 4) _mm_store_si128(reinterpret_cast<__m128i*>(q), v);
+}
+
+UX_TARGET_AVX2 inline void FillAVX2(uint32_t* dst, size_t n, uint32_t p)
+{
+    if (n < 8) { FillSSE2(dst, n, p); return; }
+    const __m256i v = _mm256_set1_epi32(int(p));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), v);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + n - 8), v);
+    uint32_t* q = reinterpret_cast<uint32_t*>((uintptr_t(dst) + 31) & ~uintptr_t(31));
+    uint32_t* end = dst + n - 8;
+    for (; q + 16 <= end; q += 16) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(q), v);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(q + 8), v);
+    }
+    for (; q < end; q += 8) _mm256_store_si256(reinterpret_cast<__m256i*>(q), v);
+}
+
+// Streaming fills: scalar up to the first aligned address, then non-temporal
+// stores, then an ordinary tail. The fence makes the stores visible before the
+// frame is handed on.
+inline void StreamSSE2(uint32_t* dst, size_t n, uint32_t p)
+{
+    size_t head = std::min(n, size_t((16 - (uintptr_t(dst) & 15)) & 15) / sizeof(uint32_t));
+    FillScalar(dst, head, p);
+    dst += head;
+    n -= head;
+    const __m128i v = _mm_set1_epi32(int(p));
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i), v);
+    _mm_sfence();
+    FillScalar(dst + i, n - i, p);
+}
+
+UX_TARGET_AVX2 inline void StreamAVX2(uint32_t* dst, size_t n, uint32_t p)
+{
+    size_t head = std::min(n, size_t((32 - (uintptr_t(dst) & 31)) & 31) / sizeof(uint32_t));
+    FillScalar(dst, head, p);
+    dst += head;
+    n -= head;
+    const __m256i v = _mm256_set1_epi32(int(p));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + i), v);
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + i + 8), v);
+    }
+    for (; i + 8 <= n; i += 8) _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + i), v);
+    _mm_sfence();
+    FillScalar(dst + i, n - i, p);
+}
+#endif
+
+} // namespace detail
+
+inline Level ActiveLevel() { return detail::ActiveLevel(); }
+
+// Forces a lower level (benchmarks, equivalence checks); clamped to what the CPU supports
+inline void SetLevel(Level level) { detail::ActiveLevel() = std::min(level, DetectLevel()); }
+
+inline const char* LevelName(Level level)
+{
+    switch (level) {
+        case Level::AVX2: return "avx2";
+        case Level::SSE2: return "sse2";
+        case Level::Scalar: break;
+    }
+    return "scalar";
+}
+
+// Span fill for rect rows and horizontal lines
+inline void Fill(uint32_t* dst, size_t n, uint32_t p)
+{
+#if UX_SIMD_X86
+    switch (detail::ActiveLevel()) {
+        case Level::AVX2: detail::FillAVX2(dst, n, p); return;
+        case Level::SSE2: detail::FillSSE2(dst, n, p); return;
+        case Level::Scalar: break;
+    }
+#endif
+    detail::FillScalar(dst, n, p);
+}
+
+// Whole-buffer fill; large buffers bypass the cache
+inline void StreamFill(uint32_t* dst, size_t n, uint32_t p)
+{
+#if UX_SIMD_X86
+    if (n * sizeof(uint32_t) >= kStreamFillBytes) {
+        switch (detail::ActiveLevel()) {
+            case Level::AVX2: detail::StreamAVX2(dst, n, p); return;
+            case Level::SSE2: detail::StreamSSE2(dst, n, p); return;
+            case Level::Scalar: break;
+        }
+    }
+#endif
+    Fill(dst, n, p);
+}
+
+} // namespace simd
+} // namespace ux
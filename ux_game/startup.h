@@ -0,0 +1,81 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "ux_game/trace.h"
+
+// Startup timeline: timestamps each init step from static initialization up to
+// the first presented frame, and writes them as JSON so the harness can track
+// time-to-first-frame across relaunches.
+//
+//   {"origin": "static_init", "steps": [{"step": "main", "ms": 0.02, "delta_ms": 0.02}, ...],
+//    "time_to_first_frame_ms": 41.7}
+namespace ux {
+
+class StartupTrace {
+public:
+    static StartupTrace& Get()
+    {
+        static StartupTrace instance;
+        return instance;
+    }
+
+    // "-" writes to stderr
+    void Enable(const std::string& path) { outputPath = path; enabled = true; }
+    bool IsEnabled() const { return enabled; }
+
+    void Mark(const char* step)
+    {
+        if (!enabled) return;
+        steps.push_back({step, trace::NowNs()});
+        trace::Instant(step, "startup");
+    }
+
+    // Records the first-frame step and writes the report; later calls are no-ops
+    void FirstFrame(const char* step = "first_frame")
+    {
+        if (!enabled || finished) return;
+        Mark(step);
+        finished = true;
+        Write();
+    }
+
+    double ElapsedMs(uint64_t ns) const { return double(ns - originNs) / 1e6; }
+
+private:
+    struct Step {
+        const char* name;
+        uint64_t ns;
+    };
+
+    StartupTrace() = default;
+
+    void Write() const
+    {
+        FILE* f = outputPath == "-" ? stderr : std::fopen(outputPath.c_str(), "w");
+        if (!f) return;
+        std::fprintf(f, "{\"origin\": \"static_init\", \"steps\": [");
+        uint64_t previous = originNs;
+        for (size_t i = 0; i < steps.size(); i++) {
+            std::fprintf(f, "%s{\"step\": \"%s\", \"ms\": %.3f, \"delta_ms\": %.3f}", i ? ", " : "",
+                         steps[i].name, ElapsedMs(steps[i].ns), double(steps[i].ns - previous) / 1e6);
+            previous = steps[i].ns;
+        }
+        std::fprintf(f, "], \"time_to_first_frame_ms\": %.3f}\n", steps.empty() ? 0.0 : ElapsedMs(steps.back().ns));
+        if (f != stderr) std::fclose(f);
+    }
+
+    // Taken during static initialization of the translation unit that first
+    // touches Get(); the front end calls Get() from a static initializer.
+    uint64_t originNs = trace::NowNs();
+    std::vector<Step> steps;
+    std::string outputPath;
+    bool enabled = false;
+    bool finished = false;
+};
+
+} // namespace ux
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+// Optional timeline tracer that writes Chrome JSON traces (chrome://tracing,
+// ui.perfetto.dev).
+//
+// Each thread records into its own buffer: appending an event is a plain store
+// followed by a release increment of the buffer's count, so the hot path takes
+// no locks. The registry mutex is only taken the first time a thread records
+// and when the trace is written out. Event names and categories must be string
+// literals (or otherwise outlive the trace) because only the pointers are kept.
+namespace ux::trace {
+
+struct Event {
+    const char* name;
+    const char* category;
+    uint64_t tsNs;
+    int64_t value;      // counter value or argument for instant events
+    char phase;         // 'B', 'E', 'i' or 'C' as in the Chrome trace format
+};
+
+constexpr size_t kChunkEvents = 16384;
+
+// Single-producer event buffer. Full chunks are kept and a new one is linked in,
+// so the writer never waits for the flusher and events are never overwritten.
+struct ThreadBuffer {
+    struct Chunk {
+        Event events[kChunkEvents];
+        std::atomic<size_t> count{0};
+    };
+
+    uint32_t tid = 0;
+    std::string threadName;
+    std::vector<std::unique_ptr<Chunk>> chunks; // guarded by the registry mutex
+    Chunk* current = nullptr;
+
+    void Push(const Event& e);
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    uint32_t nextTid = 1;
+};
+
+inline std::atomic<bool> g_enabled{false};
+
+inline Registry& GetRegistry()
+{
+    static Registry registry;
+    return registry;
+}
+
+inline uint64_t NowNs()
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+inline void ThreadBuffer::Push(const Event& e)
+{
+    size_t n = current->count.load(std::memory_order_relaxed);
+    if (n == kChunkEvents) {
+        auto chunk = std::make_unique<Chunk>();
+        Registry& reg = GetRegistry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        current = chunk.get();
+        chunks.push_back(std::move(chunk));
+        n = 0;
+    }
+    current->events[n] = e;
+    current->count.store(n + 1, std::memory_order_release);
+}
+
+inline ThreadBuffer& LocalBuffer()
+{
+    thread_local ThreadBuffer* buffer = [] {
+        Registry& reg = GetRegistry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        auto owned = std::make_unique<ThreadBuffer>();
+        owned->tid = reg.nextTid++;
+        owned->chunks.push_back(std::make_unique<ThreadBuffer::Chunk>());
+        owned->current = owned->chunks.back().get();
+        ThreadBuffer* raw = owned.get();
+        reg.buffers.push_back(std::move(owned));
+        return raw;
+    }();
+    return *buffer;
+}
+
+inline void Enable(bool enabled = true) { g_enabled.store(enabled, std::memory_order_relaxed); }
+inline bool IsEnabled() { return g_enabled.load(std::memory_order_relaxed); }
+
+inline void Record(char phase, const char* name, const char* category, int64_t value = 0)
+{
+    if (!IsEnabled()) return;
+    LocalBuffer().Push({name, category, NowNs(), value, phase});
+}
+
+inline void Begin(const char* name, const char* category = "game") { Record('B', name, category); }
+inline void End(const char* name, const char* category = "game") { Record('E', name, category); }
+inline void Instant(const char* name, const char* category = "game", int64_t value = 0) { Record('i', name, category, value); }
+inline void Counter(const char* name, int64_t value, const char* category = "game") { Record('C', name, category, value); }
+
+// Names the calling thread in the viewer; the string is copied
+inline void SetThreadName(const char* name)
+{
+    ThreadBuffer& buffer = LocalBuffer();
+    std::lock_guard<std::mutex> lock(GetRegistry().mutex);
+    buffer.threadName = name;
+}
+
+// Begin/End pair for the enclosing scope
+class Scope {
+public:
+    Scope(const char* name, const char* category = "game") : name(name), category(category) { Begin(name, category); }
+    ~Scope() { End(name, category); }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const char* name;
+    const char* category;
+};
+
+namespace detail {
+
+inline void WriteJsonString(FILE* f, const char* s)
+{
+    std::fputc('"', f);
+    for (; *s; ++s) {
+        unsigned char c = static_cast<unsigned char>(*s);
+        if (c == '"' || c == '\\') { std::fputc('\\', f); std::fputc(c, f); }
+        else if (c < 0x20) std::fprintf(f, "\\u%04x", c);
+        else std::fputc(c, f);
+    }
+    std::fputc('"', f);
+}
+
+} // namespace detail
+
+// Writes every event recorded so far as a Chrome JSON trace. Timestamps are the
+// raw steady clock in microseconds so traces from other processes on the same
+// machine (e.g. the Python harness) line up when merged. Safe to call while
+// other threads are still recording; their newer events are simply not included.
+inline bool WriteChromeJson(const std::string& path, const char* processName = "ux_test_game")
+{
+#ifdef _WIN32
+    const unsigned pid = unsigned(_getpid());
+#else
+    const unsigned pid = unsigned(getpid());
+#endif
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) return false;
+
+    Registry& reg = GetRegistry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    std::fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    std::fprintf(f, "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%u,\"args\":{\"name\":", pid);
+    detail::WriteJsonString(f, processName);
+    std::fputs("}}", f);
+
+    for (const auto& buffer : reg.buffers) {
+        if (!buffer->threadName.empty()) {
+            std::fputs(",\n", f);
+            std::fprintf(f, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":", pid, buffer->tid);
+            detail::WriteJsonString(f, buffer->threadName.c_str());
+            std::fputs("}}", f);
+        }
+        for (const auto& chunk : buffer->chunks) {
+            size_t count = chunk->count.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; i++) {
+                const Event& e = chunk->events[i];
+                std::fputs(",\n", f);
+                std::fprintf(f, "{\"ph\":\"%c\",\"name\":", e.phase);
+                detail::WriteJsonString(f, e.name);
+                std::fputs(",\"cat\":", f);
+                detail::WriteJsonString(f, e.category);
+                std::fprintf(f, ",\"ts\":%llu.%03u,\"pid\":%u,\"tid\":%u",
+                             (unsigned long long)(e.tsNs / 1000), unsigned(e.tsNs % 1000), pid, buffer->tid);
+                if (e.phase == 'C')
+                    std::fprintf(f, ",\"args\":{\"value\":%lld}", (long long)e.value);
+                else if (e.phase == 'i')
+                    std::fprintf(f, ",\"s\":\"t\",\"args\":{\"value\":%lld}", (long long)e.value);
+                std::fputc('}', f);
+            }
+        }
+    }
+
+    std::fprintf(f, "\n]}\n");
+    return std::fclose(f) == 0;
+}
+
+} // namespace ux::trace
+
+#define UX_TRACE_CONCAT_(a, b) a##b
+#define UX_TRACE_CONCAT(a, b) UX_TRACE_CONCAT_(a, b)
+#define UX_TRACE_SCOPE(name) ::ux::trace::Scope UX_TRACE_CONCAT(uxTraceScope_, __LINE__)(name)
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ux_game/raster.h"
+#include "ux_game/simd_fill.h"
+#include "ux_game/widgets.h"
+
+// In-engine accessibility audit.
+//
+// Runs over the framebuffer right after Render using the widgets the game
+// recorded (widgets.h), so nothing has to be recovered from a screenshot:
+//  - each text run gets the WCAG 2.x contrast ratio between its colour and the
+//    pixels actually under its glyph bounds (the worst background pixel counts);
+//  - each clickable target is checked against the minimum size, in screen pixels
+//    (framebuffer pixels x window pixel scale).
+// Thresholds come from game_ux_config.json (contrast_ratio_minimum,
+// button_size_minimum).
+namespace ux {
+
+struct AuditConfig {
+    float minContrast = 4.5f;
+    float minTargetPx = 44.0f;
+    int32_t pixelScale = 1;
+};
+
+// Reads the thresholds from game_ux_config.json; keys that are missing keep
+// their defaults. Returns false if the file cannot be read.
+inline bool LoadAuditConfig(const std::string& path, AuditConfig& config)
+{
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    std::string json;
+    char buf[4096];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) json.append(buf, n);
+    std::fclose(f);
+
+    auto number = [&json](const char* key, float& out) {
+        size_t pos = json.find(std::string("\"") + key + "\"");
+        if (pos == std::string::npos) return;
+        pos = json.find(':', pos);
+        if (pos == std::string::npos) return;
+        char* end = nullptr;
+        float value = std::strtof(json.c_str() + pos + 1, &end);
+        if (end != json.c_str() + pos + 1) out = value;
+    };
+    number("contrast_ratio_minimum", config.minContrast);
+    number("button_size_minimum", config.minTargetPx);
+    return true;
+}
+
+namespace detail {
+
+// sRGB channel -> linear light, per WCAG 2.x
+struct LinearLut {
+    float v[256];
+    LinearLut()
+    {
+        for (int i = 0; i < 256; i++) {
+            float c = float(i) / 255.0f;
+            v[i] = c <= 0.03928f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+    }
+};
+
+inline const float* LinearTable()
+{
+    static const LinearLut lut;
+    return lut.v;
+}
+
+// Background statistics under a text run: the luminances on either side of the
+// text luminance that come closest to it (those give the lowest contrast)
+struct BackgroundScan {
+    float closestBelow = -1.0f;  // max background luminance <= text luminance
+    float closestAbove = 2.0f;   // min background luminance > text luminance
+    uint32_t count = 0;
+};
+
+inline void ScanRowScalar(const uint32_t* row, int32_t n, uint32_t textRgb, float textLum,
+                          const float* lut, BackgroundScan& scan)
+{
+    for (int32_t i = 0; i < n; i++) {
+        const uint32_t p = row[i];
+        if ((p & 0xFFFFFFu) == textRgb) continue;
+        const float l = 0.2126f * lut[p & 0xFF] + 0.7152f * lut[(p >> 8) & 0xFF] + 0.0722f * lut[(p >> 16) & 0xFF];
+        if (l <= textLum) scan.closestBelow = std::max(scan.closestBelow, l);
+        else scan.closestAbove = std::min(scan.closestAbove, l);
+        scan.count++;
+    }
+}
+
+#if UX_SIMD_X86
+// Eight pixels per step: table gathers for the three channels, text-coloured
+// pixels masked out, running max/min on either side of the text luminance.
+UX_TARGET_AVX2 inline void ScanRowAVX2(const uint32_t* row, int32_t n, uint32_t textRgb, float textLum,
+                                       const float* lut, BackgroundScan& scan)
+{
+    const __m256i rgbMask = _mm256_set1_epi32(0xFFFFFF);
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    const __m256i text = _mm256_set1_epi32(int(textRgb));
+    const __m256 textL = _mm256_set1_ps(textLum);
+    const __m256 wr = _mm256_set1_ps(0.2126f), wg = _mm256_set1_ps(0.7152f), wb = _mm256_set1_ps(0.0722f);
+    __m256 below = _mm256_set1_ps(-1.0f), above = _mm256_set1_ps(2.0f);
+    uint32_t count = 0;
+
+    int32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+        const __m256i isText = _mm256_cmpeq_epi32(_mm256_and_si256(p, rgbMask), text);
+        const __m256 r = _mm256_i32gather_ps(lut, _mm256_and_si256(p, byteMask), 4);
+        const __m256 g = _mm256_i32gather_ps(lut, _mm256_and_si256(_mm256_srli_epi32(p, 8), byteMask), 4);
+        const __m256 b = _mm256_i32gather_ps(lut, _mm256_and_si256(_mm256_srli_epi32(p, 16), byteMask), 4);
+        // Same operation order as the scalar path, so both give identical results
+        const __m256 l = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(wr, r), _mm256_mul_ps(wg, g)),
+                                       _mm256_mul_ps(wb, b));
+
+        const __m256 bg = _mm256_castsi256_ps(_mm256_xor_si256(isText, _mm256_set1_epi32(-1)));
+        const __m256 le = _mm256_and_ps(bg, _mm256_cmp_ps(l, textL, _CMP_LE_OQ));
+        const __m256 gt = _mm256_andnot_ps(le, bg);
+        below = _mm256_blendv_ps(below, _mm256_max_ps(below, l), le);
+        above = _mm256_blendv_ps(above, _mm256_min_ps(above, l), gt);
+        count += uint32_t(__builtin_popcount(_mm256_movemask_ps(bg)));
+    }
+
+    alignas(32) float lo[8], hi[8];
+    _mm256_store_ps(lo, below);
+    _mm256_store_ps(hi, above);
+    for (int k = 0; k < 8; k++) {
+        scan.closestBelow = std::max(scan.closestBelow, lo[k]);
+        scan.closestAbove = std::min(scan.closestAbove, hi[k]);
+    }
+    scan.count += count;
+    ScanRowScalar(row + i, n - i, textRgb, textLum, lut, scan);
+}
+#endif
+
+} // namespace detail
+
+// Relative luminance of an RGBA pixel (r in the low byte)
+inline float RelativeLuminance(uint32_t p)
+{
+    const float* lut = detail::LinearTable();
+    return 0.2126f * lut[p & 0xFF] + 0.7152f * lut[(p >> 8) & 0xFF] + 0.0722f * lut[(p >> 16) & 0xFF];
+}
+
+inline float ContrastRatio(float l1, float l2)
+{
+    return (std::max(l1, l2) + 0.05f) / (std::min(l1, l2) + 0.05f);
+}
+
+// Worst-case contrast of a text colour against the canvas pixels inside bounds.
+// Returns 0 if the bounds hold no background pixels.
+inline float TextContrast(const Canvas& canvas, Rect bounds, uint32_t color)
+{
+    const int32_t x0 = std::max(bounds.x, 0), x1 = std::min(bounds.x + bounds.w, canvas.width);
+    const int32_t y0 = std::max(bounds.y, 0), y1 = std::min(bounds.y + bounds.h, canvas.height);
+    if (x0 >= x1 || y0 >= y1) return 0.0f;
+
+    const float* lut = detail::LinearTable();
+    const uint32_t textRgb = color & 0xFFFFFFu;
+    const float textLum = RelativeLuminance(color);
+    detail::BackgroundScan scan;
+    for (int32_t y = y0; y < y1; y++) {
+#if UX_SIMD_X86
+        if (simd::ActiveLevel() == simd::Level::AVX2) {
+            detail::ScanRowAVX2(canvas.Row(y) + x0, x1 - x0, textRgb, textLum, lut, scan);
+            continue;
+        }
+#endif
+        detail::ScanRowScalar(canvas.Row(y) + x0, x1 - x0, textRgb, textLum, lut, scan);
+    }
+    if (scan.count == 0) return 0.0f;
+
+    float worst = 21.0f;
+    if (scan.closestBelow >= 0.0f) worst = std::min(worst, ContrastRatio(textLum, scan.closestBelow));
+    if (scan.closestAbove <= 1.0f) worst = std::min(worst, ContrastRatio(textLum, scan.closestAbove));
+    return worst;
+}
+
+struct TextAudit {
+    const UiTextRun* run;
+    float contrast;
+    bool pass;
+};
+
+struct TargetAudit {
+    const UiTarget* target;
+    float minSidePx;  // in screen pixels
+    bool pass;
+};
+
+struct AuditReport {
+    std::vector<TextAudit> text;
+    std::vector<TargetAudit> targets;
+    uint32_t violations = 0;
+    float minContrast = 0.0f;  // lowest text contrast this frame (0 if no text)
+    uint64_t generation = 0;   // UiRecord generation the report was built from
+};
+
+// Audits the widgets recorded for the frame currently in canvas. The report
+// points into record, which must outlive it.
+inline void AuditFrame(const Canvas& canvas, const UiRecord& record, const AuditConfig& config,
+                       AuditReport& report)
+{
+    report.text.clear();
+    report.targets.clear();
+    report.violations = 0;
+    report.minContrast = 0.0f;
+    report.generation = record.generation;
+
+    for (const UiTextRun& run : record.text) {
+        const float contrast = TextContrast(canvas, run.bounds, run.color);
+        if (contrast <= 0.0f) continue; // nothing visible under it
+        const bool pass = contrast >= config.minContrast;
+        report.text.push_back({&run, contrast, pass});
+        report.violations += !pass;
+        report.minContrast = report.minContrast > 0.0f ? std::min(report.minContrast, contrast) : contrast;
+    }
+    for (const UiTarget& target : record.targets) {
+        const float side = float(std::min(target.bounds.w, target.bounds.h) * config.pixelScale);
+        const bool pass = side >= config.minTargetPx;
+        report.targets.push_back({&target, side, pass});
+        report.violations += !pass;
+    }
+}
+
+// One JSON object per line, written whenever the audited frame changes
+inline void WriteAuditJsonLine(FILE* f, uint64_t frameIndex, const char* state, const AuditReport& report,
+                               const AuditConfig& config)
+{
+    auto escaped = [f](const char* s) {
+        for (; *s; s++) {
+            if (*s == '"' || *s == '\\') std::fputc('\\', f);
+            std::fputc(*s, f);
+        }
+    };
+    std::fprintf(f, "{\"frame\": %llu, \"state\": \"%s\", \"violations\": %u, \"min_contrast\": %.2f, "
+                    "\"contrast_minimum\": %.2f, \"target_minimum_px\": %.0f, \"text\": [",
+                 (unsigned long long)frameIndex, state, report.violations, report.minContrast,
+                 config.minContrast, config.minTargetPx);
+    for (size_t i = 0; i < report.text.size(); i++) {
+        const TextAudit& t = report.text[i];
+        const Rect& b = t.run->bounds;
+        std::fprintf(f, "%s{\"text\": \"", i ? ", " : "");
+        escaped(t.run->text);
+        std::fprintf(f, "\", \"bounds\": [%d, %d, %d, %d], \"contrast\": %.2f, \"pass\": %s}",
+                     b.x, b.y, b.w, b.h, t.contrast, t.pass ? "true" : "false");
+    }
+    std::fprintf(f, "], \"targets\": [");
+    for (size_t i = 0; i < report.targets.size(); i++) {
+        const TargetAudit& t = report.targets[i];
+        const Rect& b = t.target->bounds;
+        std::fprintf(f, "%s{\"text\": \"", i ? ", " : "");
+        escaped(t.target->text);
+        std::fprintf(f, "\", \"bounds\": [%d, %d, %d, %d], \"min_side_px\": %.0f, \"pass\": %s}",
+                     b.x, b.y, b.w, b.h, t.minSidePx, t.pass ? "true" : "false");
+    }
+    std::fprintf(f, "]}\n");
+}
+
+} // namespace ux
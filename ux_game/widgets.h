@@ -0,0 +1,78 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "ux_game/font.h"
+#include "ux_game/raster.h"
+
+// What the game drew this frame, as widgets rather than pixels: every text run
+// and every clickable target, in framebuffer coordinates. Filled by Game::Render
+// when a recorder is attached and consumed by the in-engine audit (ui_audit.h).
+namespace ux {
+
+constexpr size_t kWidgetTextSize = 32;
+
+inline void CopyWidgetText(char (&dst)[kWidgetTextSize], std::string_view text)
+{
+    size_t n = std::min(text.size(), kWidgetTextSize - 1);
+    std::memcpy(dst, text.data(), n);
+    dst[n] = '\0';
+}
+
+// Bounding box of DrawString output (8x8 font, '\n' starts a new line)
+inline Rect TextBounds(int32_t x, int32_t y, std::string_view text, uint32_t scale = 1)
+{
+    int32_t columns = 0, lineColumns = 0, lines = text.empty() ? 0 : 1;
+    for (char ch : text) {
+        if (ch == '\n') { lines++; lineColumns = 0; continue; }
+        lineColumns += ch == '\t' ? 4 : 1;
+        columns = std::max(columns, lineColumns);
+    }
+    const int32_t cell = kGlyphSize * int32_t(scale);
+    return {x, y, columns * cell, lines * cell};
+}
+
+struct UiTextRun {
+    Rect bounds;
+    uint32_t color;
+    char text[kWidgetTextSize];
+};
+
+struct UiTarget {
+    Rect bounds;
+    char text[kWidgetTextSize];
+};
+
+struct UiRecord {
+    std::vector<UiTextRun> text;
+    std::vector<UiTarget> targets;
+    uint64_t generation = 0;  // bumped every time the frame is redrawn
+
+    void Begin()
+    {
+        text.clear();
+        targets.clear();
+        generation++;
+    }
+
+    void AddText(Rect bounds, uint32_t color, std::string_view label)
+    {
+        UiTextRun& run = text.emplace_back();
+        run.bounds = bounds;
+        run.color = color;
+        CopyWidgetText(run.text, label);
+    }
+
+    void AddTarget(Rect bounds, std::string_view label)
+    {
+        UiTarget& target = targets.emplace_back();
+        target.bounds = bounds;
+        CopyWidgetText(target.text, label);
+    }
+};
+
+} // namespace ux
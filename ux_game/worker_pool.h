@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fork-join pool for per-frame work that splits into a handful of independent
+// tasks (one render target each). The workers are started once and parked on a
+// condition variable between frames; Run hands out task indices through an
+// atomic counter and the calling thread takes tasks as well. Run returns once
+// every worker has run out of tasks, so no worker is still touching the job when
+// the next one is posted. Run does not allocate.
+namespace ux {
+
+class WorkerPool {
+public:
+    // threads: total threads including the caller; 0 uses every hardware thread
+    explicit WorkerPool(unsigned threads = 0)
+    {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        workers.reserve(threads - 1);
+        for (unsigned i = 1; i < threads; i++) workers.emplace_back([this] { WorkerLoop(); });
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& t : workers) t.join();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    size_t Threads() const { return workers.size() + 1; }
+
+    // Calls task(i) for every i in [0, count), spread over the pool
+    template <typename F>
+    void Run(size_t count, F&& task)
+    {
+        if (count == 0) return;
+        if (workers.empty() || count == 1) {
+            for (size_t i = 0; i < count; i++) task(i);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job.call = [](void* ctx, size_t i) { (*static_cast<std::remove_reference_t<F>*>(ctx))(i); };
+            job.ctx = &task;
+            job.count = count;
+            next.store(0, std::memory_order_relaxed);
+            running = workers.size();
+            generation++;
+        }
+        wake.notify_all();
+
+        Drain();
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return running == 0; });
+    }
+
+private:
+    struct Job {
+        void (*call)(void*, size_t) = nullptr;
+        void* ctx = nullptr;
+        size_t count = 0;
+    };
+
+    void Drain()
+    {
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < job.count;) job.call(job.ctx, i);
+    }
+
+    void WorkerLoop()
+    {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+            Drain();
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--running == 0) done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    Job job;                      // written under the mutex before the generation bump
+    std::atomic<size_t> next{0};
+    size_t running = 0;           // workers still draining the current job, guarded by mutex
+    uint64_t generation = 0;
+    bool stopping = false;
+};
+
+} // namespace ux